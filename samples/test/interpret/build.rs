@@ -0,0 +1,95 @@
+// Build script run by the MIR interpreter (`mrustc -Z interpret`, as used by `minicargo --interpret-build-scripts`)
+// - Self-contained (no `std`, and marked as its own allocator crate), so it can run without libraries built with
+//   `-Z save-all-mir`
+// - Exercises the libc shims (environment, file output), enums and loops. Expected output is in `build.txt`
+#![feature(no_core,lang_items,allocator,unboxed_closures)]
+#![no_core]
+#![allocator]
+
+#[lang="sized"] trait Sized {}
+#[lang="copy"] trait Copy {}
+#[lang="drop"] trait Drop { fn drop(&mut self); }
+#[lang="unsize"] trait Unsize<T: ?Sized> {}
+#[lang="coerce_unsized"] trait CoerceUnsized<T> {}
+#[lang="fn_once"] trait FnOnce<Args> { type Output; extern "rust-call" fn call_once(self, args: Args) -> Self::Output; }
+#[lang="fn_mut"] trait FnMut<Args>: FnOnce<Args> { extern "rust-call" fn call_mut(&mut self, args: Args) -> Self::Output; }
+#[lang="index"] trait Index<Idx: ?Sized> { type Output: ?Sized; fn index(&self, index: Idx) -> &Self::Output; }
+#[lang="index_mut"] trait IndexMut<Idx: ?Sized>: Index<Idx> { fn index_mut(&mut self, index: Idx) -> &mut Self::Output; }
+#[lang="fn"] trait Fn<Args>: FnMut<Args> { extern "rust-call" fn call(&self, args: Args) -> Self::Output; }
+#[lang="add"] trait Add<RHS=Self> { type Output; fn add(self, rhs: RHS) -> Self::Output; }
+#[lang="ord"] trait PartialOrd<Rhs: ?Sized = Self> { fn lt(&self, other: &Rhs) -> bool; }
+#[lang="eq"] trait PartialEq<Rhs: ?Sized = Self> { fn eq(&self, other: &Rhs) -> bool; }
+impl Add for usize { type Output = usize; fn add(self, rhs: usize) -> usize { self + rhs } }
+impl PartialOrd for usize { fn lt(&self, o: &usize) -> bool { *self < *o } }
+impl PartialEq for usize { fn eq(&self, o: &usize) -> bool { *self == *o } }
+impl PartialOrd for i32 { fn lt(&self, o: &i32) -> bool { *self < *o } }
+#[lang="start"] fn lang_start(_main: fn(), _argc: isize, _argv: *const *const u8) -> isize { loop {} }
+
+extern "C" {
+    fn getenv(name: *const u8) -> *const u8;
+    fn write(fd: i32, buf: *const u8, len: usize) -> isize;
+    fn open(path: *const u8, flags: i32, ...) -> i32;
+    fn close(fd: i32) -> i32;
+    fn strlen(s: *const u8) -> usize;
+}
+
+/// Key/value pair output by the script
+enum Directive { Cfg(&'static [u8; 12]), Env(&'static [u8; 11], &'static [u8; 7]) }
+
+/// Write a NUL-terminated string
+fn out(fd: i32, s: *const u8) {
+    unsafe { write(fd, s, strlen(s)); }
+}
+fn emit(d: &Directive) {
+    match *d
+    {
+    Directive::Cfg(name) => {
+        out(1, b"cargo:rustc-cfg=\0" as *const u8);
+        out(1, name as *const [u8; 12] as *const u8);
+        },
+    Directive::Env(k, v) => {
+        out(1, b"cargo:rustc-env=\0" as *const u8);
+        out(1, k as *const [u8; 11] as *const u8);
+        out(1, b"=\0" as *const u8);
+        out(1, v as *const [u8; 7] as *const u8);
+        },
+    }
+    out(1, b"\n\0" as *const u8);
+}
+
+fn main() {
+    let directives = [Directive::Cfg(b"interpreted\0"), Directive::Env(b"BUILD_KIND\0", b"interp\0")];
+    let mut i = 0;
+    while i < 2 {
+        emit(&directives[i]);
+        i = i + 1;
+    }
+    unsafe {
+        // Write a generated file to `$OUT_DIR` (if set)
+        let dir = getenv(b"OUT_DIR\0" as *const u8);
+        if dir as usize != 0 {
+            let mut path = [0u8; 512];
+            let len = strlen(dir);
+            let mut j = 0;
+            while j < len && j < 400 {
+                path[j] = *((dir as usize + j) as *const u8);
+                j = j + 1;
+            }
+            let name = b"/generated.rs\0";
+            let mut k = 0;
+            while k < 14 {
+                path[j + k] = name[k];
+                k = k + 1;
+            }
+            let fd = open(&path as *const [u8; 512] as *const u8, 0o1101 /*O_WRONLY|O_CREAT|O_TRUNC*/, 0o644u32);
+            if fd < 0 {
+                out(2, b"Unable to create generated.rs\n\0" as *const u8);
+            }
+            else {
+                out(fd, b"pub const GENERATED: u32 = 42;\n\0" as *const u8);
+                close(fd);
+                out(1, b"cargo:rerun-if-changed=build.rs\n\0" as *const u8);
+            }
+        }
+    }
+}
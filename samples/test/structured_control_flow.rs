@@ -0,0 +1,120 @@
+// Control flow shapes that the structured C output (enabled with `-Z structured-c`) has to reconstruct from MIR
+// - Loops with `break`/`continue` (including labelled ones), `match` arms that fall through or return early, and
+//   `return` from within nested loops.
+
+fn find(v: &[u32], target: u32) -> Option<usize>
+{
+    for (i, &x) in v.iter().enumerate()
+    {
+        if x == target {
+            return Some(i);
+        }
+    }
+    None
+}
+
+fn classify(v: i32) -> &'static str
+{
+    match v
+    {
+    _ if v < 0 => "negative",
+    0 => return "zero",
+    1 | 2 | 3 => "small",
+    _ if v % 2 == 0 => "even",
+    _ => "odd",
+    }
+}
+
+fn first_pair_summing_to(v: &[i32], total: i32) -> Option<(usize,usize)>
+{
+    let mut rv = None;
+    'outer: for i in 0 .. v.len()
+    {
+        let mut j = i + 1;
+        while j < v.len()
+        {
+            if v[i] + v[j] == total {
+                rv = Some( (i, j) );
+                break 'outer;
+            }
+            if v[j] < 0 {
+                j += 1;
+                continue;
+            }
+            j += 1;
+        }
+    }
+    rv
+}
+
+fn collatz_steps(mut n: u64) -> u32
+{
+    let mut steps = 0;
+    loop
+    {
+        if n == 1 {
+            break;
+        }
+        n = match n % 2 {
+            0 => n / 2,
+            _ => 3 * n + 1,
+            };
+        steps += 1;
+    }
+    steps
+}
+
+fn sum_until_negative(v: &[i32]) -> i32
+{
+    let mut total = 0;
+    let mut it = v.iter();
+    while let Some(&x) = it.next()
+    {
+        match x
+        {
+        x if x < 0 => break,
+        0 => continue,
+        x => total += x,
+        }
+    }
+    total
+}
+
+#[test]
+fn early_return_from_loop()
+{
+    assert_eq!(find(&[5, 3, 8], 8), Some(2));
+    assert_eq!(find(&[5, 3, 8], 4), None);
+}
+
+#[test]
+fn match_arms()
+{
+    assert_eq!(classify(-5), "negative");
+    assert_eq!(classify(0), "zero");
+    assert_eq!(classify(2), "small");
+    assert_eq!(classify(10), "even");
+    assert_eq!(classify(11), "odd");
+}
+
+#[test]
+fn labelled_break()
+{
+    assert_eq!(first_pair_summing_to(&[1, -2, 4, 6], 10), Some((2,3)));
+    assert_eq!(first_pair_summing_to(&[1, 2], 10), None);
+}
+
+#[test]
+fn loop_with_value()
+{
+    assert_eq!(collatz_steps(1), 0);
+    assert_eq!(collatz_steps(6), 8);
+    assert_eq!(collatz_steps(27), 111);
+}
+
+#[test]
+fn while_let_break_continue()
+{
+    assert_eq!(sum_until_negative(&[1, 0, 2, 3, -1, 10]), 6);
+    assert_eq!(sum_until_negative(&[]), 0);
+}
@@ -517,6 +517,8 @@ public:
     {
         bool    controls_dir = false;
         ::std::string   path = "!";
+        /// File has been located but not yet parsed (see `Parse_Crate`'s parallel mode)
+        bool    load_pending = false;
     };
 
     FileInfo    m_file_info;
@@ -5,7 +5,7 @@
 #include "../parse/parseerror.hpp"
 #include "../expand/cfg.hpp"
 #include <hir/hir.hpp>  // HIR::Crate
-#include <hir/main_bindings.hpp>    // HIR_Deserialise
+#include <main_bindings.hpp> // CompileServer_LoadCrate, Incremental_AddInput
 #include <fstream>
 
 ::std::vector<::std::string>    AST::g_crate_load_dirs = { };
@@ -176,7 +176,8 @@ ExternCrate::ExternCrate(const ::std::string& name, const ::std::string& path):
     m_filename(path)
 {
     TRACE_FUNCTION_F("name=" << name << ", path='" << path << "'");
-    m_hir = HIR_Deserialise(path, name);
+    m_hir = CompileServer_LoadCrate(path, name);
+    Incremental_AddInput(path);
 
     m_hir->post_load_update(name);
     m_name = m_hir->m_crate_name;
@@ -14,6 +14,7 @@
 #include <string>
 #include <tagged_union.hpp>
 #include <ident.hpp>
+#include <node_pool.hpp>
 #include "path.hpp"
 
 namespace AST {
@@ -59,6 +60,8 @@ class Pattern:
     public Serialisable
 {
 public:
+    NODE_POOL_ALLOCATED()
+
     TAGGED_UNION(Value, Invalid,
         (Invalid, struct {}),
         (Integer, struct {
@@ -0,0 +1,481 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * compile_server.cpp
+ * - Persistent compiler process (keeps extern crates loaded between compilations)
+ *
+ * `mrustc --server <socket>` listens on a unix socket and handles each request by forking and running the normal
+ * compiler entrypoint in the child. Extern crates loaded by earlier requests are deserialised once by the server, so
+ * children inherit them (copy-on-write) instead of loading them again. The compiler's global state is never shared
+ * between requests, as each child exits once its compilation is done.
+ * Only the user running the server can connect (the socket is owner-only, and the peer's uid is checked).
+ *
+ * Request: `u32 argc, u32 envc, u32 data_len` then `data_len` bytes of NUL-terminated strings (cwd, argv, "KEY=VALUE")
+ * - The environment is the client's complete environment (the child's is replaced by it)
+ * - Sent along with two file descriptors (SCM_RIGHTS) to use as the child's stdout and stderr
+ * Response: `i32` wait status of the child (as returned by `waitpid`)
+ */
+#include <main_bindings.hpp>
+#include <hir/hir.hpp>
+#include <hir/main_bindings.hpp>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#ifndef _WIN32
+# include <unistd.h>
+# include <poll.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <sys/wait.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <signal.h>
+# include <cerrno>
+#endif
+
+namespace {
+    struct CachedCrate {
+        /// Hash of the file contents when it was loaded
+        uint64_t    hash;
+        ::HIR::CratePtr crate;
+    };
+    /// Crates loaded by the server, keyed by absolute path (inherited by each child)
+    ::std::map< ::std::string, CachedCrate>  g_crate_cache;
+    /// Write end of the pipe used to tell the server which crates a child had to load itself (-1 outside the server)
+    int g_report_fd = -1;
+}
+
+#ifndef _WIN32
+namespace {
+    /// A connected client whose request hasn't been fully received yet
+    struct PendingRequest {
+        int client_fd;
+        /// Header and data received so far
+        ::std::vector<char> buf;
+        /// Output file descriptors sent with the request (-1 until received)
+        int out_fds[2] = { -1, -1 };
+
+        void close_fds() {
+            for(auto& fd : out_fds) {
+                if( fd >= 0 )
+                    close(fd);
+                fd = -1;
+            }
+        }
+    };
+    struct Job {
+        pid_t   pid;
+        int client_fd;
+        /// Read end of the child's report pipe (-1 once it has hit EOF)
+        int report_fd;
+        /// Crates that the child loaded (that weren't in the cache), one `<hash> <path>` per line
+        ::std::string   reported;
+    };
+
+    const size_t HEADER_SIZE = 3 * sizeof(uint32_t);
+    /// Upper limit on a request's data, so a bad header can't make the server allocate an unbounded buffer
+    const uint32_t MAX_REQUEST_DATA = 16 << 20;
+
+    /// Self-pipe written by the SIGCHLD handler, wakes up `poll` when a child exits
+    int g_sigchld_pipe[2] = { -1, -1 };
+    void sigchld_handler(int )
+    {
+        auto saved_errno = errno;
+        char    c = 0;
+        if( write(g_sigchld_pipe[1], &c, 1) < 0 ) {
+            // Pipe full - there's already a wakeup pending
+        }
+        errno = saved_errno;
+    }
+
+    /// Check that the process on the other end of a connection is running as this user
+    bool peer_is_same_user(int fd)
+    {
+#ifdef SO_PEERCRED
+        struct ucred    cred;
+        socklen_t   len = sizeof(cred);
+        if( getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 )
+            return false;
+        return cred.uid == getuid();
+#else
+        uid_t   uid;
+        gid_t   gid;
+        if( getpeereid(fd, &uid, &gid) != 0 )
+            return false;
+        return uid == getuid();
+#endif
+    }
+
+    bool read_report(Job& job)
+    {
+        char    buf[4096];
+        auto n = read(job.report_fd, buf, sizeof(buf));
+        if( n <= 0 )
+            return false;
+        job.reported.append(buf, n);
+        return true;
+    }
+
+    /// Load a crate into the cache (if it isn't already there and unchanged)
+    /// - `loaded_hash` is the hash of the file that a child successfully loaded
+    void preload_crate(const ::std::string& path, uint64_t loaded_hash)
+    {
+        uint64_t    hash;
+        if( !Incremental_HashFile(path, hash) )
+            return ;
+        // Deserialising a corrupt or truncated file can abort, so only load exactly what a child has already loaded
+        if( hash != loaded_hash )
+        {
+            ::std::cerr << "Compile server: " << path << " changed after it was used, not caching it" << ::std::endl;
+            return ;
+        }
+        auto it = g_crate_cache.find(path);
+        if( it != g_crate_cache.end() )
+        {
+            if( it->second.hash == hash )
+                return ;
+            g_crate_cache.erase(it);
+        }
+        ::std::cout << "Loading " << path << ::std::endl;
+        g_crate_cache.insert( ::std::make_pair(path, CachedCrate { hash, HIR_Deserialise(path, "") }) );
+    }
+
+    enum class ReadResult {
+        Incomplete,
+        Complete,
+        Failed,
+    };
+    /// Read whatever is available of a request (the client socket is non-blocking)
+    ReadResult read_request(PendingRequest& req)
+    {
+        char    buf[4096];
+        char    cmsg_buf[CMSG_SPACE(sizeof(req.out_fds))];
+        struct iovec    iov = { buf, sizeof(buf) };
+        struct msghdr   msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = cmsg_buf;
+        msg.msg_controllen = sizeof(cmsg_buf);
+        auto n = recvmsg(req.client_fd, &msg, 0);
+        if( n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) )
+            return ReadResult::Incomplete;
+        if( n <= 0 )
+            return ReadResult::Failed;
+        // The descriptors arrive along with the start of the header
+        for(auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if( cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS )
+                continue ;
+            int fds[2];
+            size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg), ::std::min(count, size_t(2)) * sizeof(int));
+            if( count != 2 || req.out_fds[0] >= 0 )
+            {
+                for(size_t i = 0; i < ::std::min(count, size_t(2)); i ++)
+                    close(fds[i]);
+                ::std::cerr << "Compile server: request with unexpected file descriptors" << ::std::endl;
+                return ReadResult::Failed;
+            }
+            req.out_fds[0] = fds[0];
+            req.out_fds[1] = fds[1];
+        }
+        if( msg.msg_flags & MSG_CTRUNC )
+            return ReadResult::Failed;
+        req.buf.insert(req.buf.end(), buf, buf + n);
+
+        if( req.buf.size() < HEADER_SIZE )
+            return ReadResult::Incomplete;
+        uint32_t    hdr[3];
+        memcpy(hdr, req.buf.data(), HEADER_SIZE);
+        if( hdr[2] > MAX_REQUEST_DATA )
+        {
+            ::std::cerr << "Compile server: request too large" << ::std::endl;
+            return ReadResult::Failed;
+        }
+        if( req.buf.size() < HEADER_SIZE + hdr[2] )
+            return ReadResult::Incomplete;
+        if( req.buf.size() > HEADER_SIZE + hdr[2] )
+        {
+            ::std::cerr << "Compile server: malformed request" << ::std::endl;
+            return ReadResult::Failed;
+        }
+        return ReadResult::Complete;
+    }
+
+    /// Fork a child to handle a fully received request
+    bool start_job(int listen_fd, PendingRequest& req, int (*compile)(int argc, char* argv[]), Job& out_job)
+    {
+        if( req.out_fds[0] < 0 )
+        {
+            ::std::cerr << "Compile server: request without output file descriptors" << ::std::endl;
+            return false;
+        }
+        uint32_t    hdr[3];
+        memcpy(hdr, req.buf.data(), HEADER_SIZE);
+        char* data = req.buf.data() + HEADER_SIZE;
+        size_t data_len = hdr[2];
+        if( data_len == 0 || data[data_len-1] != '\0' )
+        {
+            ::std::cerr << "Compile server: malformed request" << ::std::endl;
+            return false;
+        }
+        ::std::vector<char*>    strings;
+        for(size_t i = 0; i < data_len; i += strlen(&data[i]) + 1)
+            strings.push_back(&data[i]);
+        if( strings.size() != 1 + size_t(hdr[0]) + hdr[1] )
+        {
+            ::std::cerr << "Compile server: malformed request" << ::std::endl;
+            return false;
+        }
+
+        int report[2];
+        if( pipe(report) != 0 )
+        {
+            perror("pipe");
+            return false;
+        }
+        ::std::cout.flush();
+        ::std::cerr.flush();
+        auto pid = fork();
+        if( pid == 0 )
+        {
+            // Child: Run the compiler as if it had been invoked directly
+            signal(SIGCHLD, SIG_DFL);
+            close(g_sigchld_pipe[0]);
+            close(g_sigchld_pipe[1]);
+            close(listen_fd);
+            close(report[0]);
+            dup2(req.out_fds[0], 1);
+            dup2(req.out_fds[1], 2);
+            req.close_fds();
+            if( chdir(strings[0]) != 0 )
+            {
+                perror("chdir");
+                ::std::_Exit(1);
+            }
+            // The request carries the client's full environment, so nothing is left over from the server's
+#ifdef __GLIBC__
+            clearenv();
+#else
+            extern char** environ;
+            static char* empty_environ[] = { nullptr };
+            environ = empty_environ;
+#endif
+            for(uint32_t i = 0; i < hdr[1]; i ++)
+                putenv(strings[1 + hdr[0] + i]);
+            g_report_fd = report[1];
+
+            int argc = static_cast<int>(hdr[0]);
+            ::std::vector<char*>    argv(strings.begin() + 1, strings.begin() + 1 + argc);
+            argv.push_back(nullptr);
+            int rv = compile(argc, argv.data());
+            ::std::cout.flush();
+            ::std::cerr.flush();
+            ::std::_Exit(rv);
+        }
+        close(report[1]);
+        if( pid < 0 )
+        {
+            perror("fork");
+            close(report[0]);
+            return false;
+        }
+        out_job.pid = pid;
+        out_job.client_fd = req.client_fd;
+        out_job.report_fd = report[0];
+        return true;
+    }
+}
+
+int CompileServer_Run(const char* socket_path, int (*compile)(int argc, char* argv[]))
+{
+    struct sockaddr_un  addr = {};
+    addr.sun_family = AF_UNIX;
+    if( strlen(socket_path) >= sizeof(addr.sun_path) )
+    {
+        ::std::cerr << "Socket path '" << socket_path << "' is too long" << ::std::endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    // Requests run arbitrary commands (e.g. via `CC`) as this user, so only this user may connect
+    // - The socket is only accessible by the owner, and the peer's uid is checked on each connection
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    // - umask covers the window between bind and chmod
+    auto old_umask = umask(0077);
+    bool bound = listen_fd >= 0 && bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+    umask(old_umask);
+    if( !bound || chmod(socket_path, 0600) != 0 || listen(listen_fd, 64) != 0 )
+    {
+        perror("Compile server");
+        return 1;
+    }
+
+    if( pipe(g_sigchld_pipe) != 0 )
+    {
+        perror("pipe");
+        return 1;
+    }
+    for(int fd : g_sigchld_pipe)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    struct sigaction    sa = {};
+    sa.sa_handler = sigchld_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa, nullptr);
+
+    ::std::cout << "Compile server listening on " << socket_path << ::std::endl;
+
+    ::std::vector<PendingRequest>   pending;
+    ::std::vector<Job>  jobs;
+    for(;;)
+    {
+        ::std::vector<struct pollfd>    pfds;
+        pfds.push_back({ listen_fd, POLLIN, 0 });
+        pfds.push_back({ g_sigchld_pipe[0], POLLIN, 0 });
+        for(const auto& r : pending)
+            pfds.push_back({ r.client_fd, POLLIN, 0 });
+        for(const auto& j : jobs)
+            pfds.push_back({ j.report_fd, POLLIN, 0 });
+        if( poll(pfds.data(), pfds.size(), -1) < 0 && errno != EINTR )
+        {
+            perror("poll");
+            return 1;
+        }
+        size_t pfd_idx = 2;
+
+        for(auto it = pending.begin(); it != pending.end(); pfd_idx ++)
+        {
+            if( !(pfds[pfd_idx].revents & (POLLIN|POLLHUP|POLLERR)) ) {
+                ++ it;
+                continue ;
+            }
+            auto res = read_request(*it);
+            if( res == ReadResult::Incomplete ) {
+                ++ it;
+                continue ;
+            }
+            Job job;
+            if( res == ReadResult::Complete && start_job(listen_fd, *it, compile, job) )
+                jobs.push_back(::std::move(job));
+            else
+                close(it->client_fd);
+            it->close_fds();
+            it = pending.erase(it);
+        }
+        for(auto& j : jobs)
+        {
+            if( pfd_idx < pfds.size() && (pfds[pfd_idx].revents & (POLLIN|POLLHUP|POLLERR)) )
+            {
+                // EOF - the child has exited (or is about to), stop polling the pipe until it's reaped
+                if( !read_report(j) )
+                {
+                    close(j.report_fd);
+                    j.report_fd = -1;
+                }
+            }
+            pfd_idx ++;
+        }
+        if( pfds[0].revents & POLLIN )
+        {
+            int client_fd = accept(listen_fd, nullptr, nullptr);
+            if( client_fd >= 0 && !peer_is_same_user(client_fd) )
+            {
+                ::std::cerr << "Compile server: rejected a connection from another user" << ::std::endl;
+                close(client_fd);
+            }
+            else if( client_fd >= 0 )
+            {
+                fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
+                PendingRequest  req;
+                req.client_fd = client_fd;
+                pending.push_back(::std::move(req));
+            }
+        }
+        if( pfds[1].revents & POLLIN )
+        {
+            char    buf[64];
+            while( read(g_sigchld_pipe[0], buf, sizeof(buf)) > 0 )
+                ;
+        }
+
+        for(auto it = jobs.begin(); it != jobs.end(); )
+        {
+            int status;
+            if( waitpid(it->pid, &status, WNOHANG) != it->pid )
+            {
+                ++ it;
+                continue ;
+            }
+            if( it->report_fd >= 0 )
+            {
+                // The pipe's write end is closed now, so this reads to EOF
+                while( read_report(*it) )
+                    ;
+                close(it->report_fd);
+            }
+            // The client socket is non-blocking, but there's room for the few bytes of the result
+            int32_t rv = status;
+            if( write(it->client_fd, &rv, sizeof(rv)) != sizeof(rv) )
+                ::std::cerr << "Compile server: client disconnected before the result was sent" << ::std::endl;
+            close(it->client_fd);
+
+            // Only load crates from a successful build (a failed one might have been given a bad file)
+            if( WIFEXITED(status) && WEXITSTATUS(status) == 0 )
+            {
+                ::std::istringstream    is(it->reported);
+                uint64_t    hash;
+                ::std::string   path;
+                while( is >> ::std::hex >> hash && is.get() == ' ' && ::std::getline(is, path) )
+                    preload_crate(path, hash);
+            }
+            it = jobs.erase(it);
+        }
+    }
+}
+#else
+int CompileServer_Run(const char* socket_path, int (*compile)(int argc, char* argv[]))
+{
+    ::std::cerr << "The compile server isn't supported on this platform" << ::std::endl;
+    return 1;
+}
+#endif
+
+::HIR::CratePtr CompileServer_LoadCrate(const ::std::string& path, const ::std::string& name)
+{
+#ifndef _WIN32
+    if( g_report_fd >= 0 )
+    {
+        char    abs_path[PATH_MAX];
+        if( realpath(path.c_str(), abs_path) )
+        {
+            uint64_t    hash;
+            if( !Incremental_HashFile(abs_path, hash) )
+                return HIR_Deserialise(path, name);
+            auto it = g_crate_cache.find(abs_path);
+            if( it != g_crate_cache.end() && hash == it->second.hash )
+            {
+                auto rv = ::std::move(it->second.crate);
+                g_crate_cache.erase(it);
+                return rv;
+            }
+            // Not cached (or changed), tell the server so it can be loaded for later requests
+            // - Along with the hash of what was loaded, so the server only loads contents that are known to be good
+            auto rv = HIR_Deserialise(path, name);
+            uint64_t    hash_after;
+            if( Incremental_HashFile(abs_path, hash_after) && hash_after == hash )
+            {
+                auto line = FMT(::std::hex << hash << " " << abs_path << "\n");
+                if( write(g_report_fd, line.data(), line.size()) != static_cast<ssize_t>(line.size()) )
+                    perror("Compile server report");
+            }
+            return rv;
+        }
+    }
+#endif
+    return HIR_Deserialise(path, name);
+}
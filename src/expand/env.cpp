@@ -10,6 +10,7 @@
 #include <parse/ttstream.hpp>
 #include <ast/expr.hpp> // ExprNode_*
 #include <synext.hpp>   // for Expand_BareExpr
+#include <main_bindings.hpp>    // Incremental_AddEnv
 
 namespace {
     // Read a string out of the input stream
@@ -41,6 +42,7 @@ class CExpanderEnv:
         ::std::string   varname = get_string(sp, crate, mod,  tt);
 
         const char* var_val_cstr = getenv(varname.c_str());
+        Incremental_AddEnv(varname, var_val_cstr);
         if( !var_val_cstr ) {
             ERROR(sp, E0000, "Environment variable '" << varname << "' not defined");
         }
@@ -58,6 +60,7 @@ class CExpanderOptionEnv:
         ::std::string   varname = get_string(sp, crate, mod,  tt);
 
         const char* var_val_cstr = getenv(varname.c_str());
+        Incremental_AddEnv(varname, var_val_cstr);
         if( !var_val_cstr ) {
             ::std::vector< TokenTree>   rv;
             rv.reserve(7);
@@ -254,6 +254,8 @@ ProcMacroInv ProcMacro_Invoke_int(const Span& sp, const ::AST::Crate& crate, con
 
     // 2. Get executable and macro name
     ::std::string   proc_macro_exe_name = (ext_crate.m_filename + "-plugin");
+    // - The expansion depends on the executable, not just the crate's metadata
+    Incremental_AddInput(proc_macro_exe_name);
 
     // 3. Create ProcMacroInv
     return ProcMacroInv(sp, proc_macro_exe_name.c_str(), *pmp);
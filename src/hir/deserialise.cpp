@@ -359,30 +359,40 @@ namespace {
         }
         ::MIR::LValue deserialise_mir_lvalue_()
         {
+            ::MIR::LValue   rv;
             switch(auto tag = m_in.read_tag())
             {
-            #define _(x, ...)    case ::MIR::LValue::TAG_##x: return ::MIR::LValue::make_##x( __VA_ARGS__ );
+            #define _(x, ...)    case ::MIR::LValue::Storage::TAG_##x: rv = ::MIR::LValue( ::MIR::LValue::Storage::make_##x( __VA_ARGS__ ) ); break;
             _(Return, {})
             _(Argument, { static_cast<unsigned int>(m_in.read_count()) } )
             _(Local,   static_cast<unsigned int>(m_in.read_count()) )
-            _(Static,  deserialise_path() )
-            _(Field, {
-                box$( deserialise_mir_lvalue() ),
-                static_cast<unsigned int>(m_in.read_count())
-                } )
-            _(Deref, { box$( deserialise_mir_lvalue() ) })
-            _(Index, {
-                box$( deserialise_mir_lvalue() ),
-                box$( deserialise_mir_lvalue() )
-                } )
-            _(Downcast, {
-                box$( deserialise_mir_lvalue() ),
-                static_cast<unsigned int>(m_in.read_count())
-                } )
+            _(Static,  box$(deserialise_path()) )
             #undef _
             default:
                 throw ::std::runtime_error(FMT("Invalid MIR LValue tag - " << tag));
             }
+            size_t n_wrappers = m_in.read_count();
+            for(size_t i = 0; i < n_wrappers; i ++)
+            {
+                switch(auto tag = m_in.read_tag())
+                {
+                case ::MIR::LValue::Wrapper::TAG_Field:
+                    rv.m_wrappers.push_back( ::MIR::LValue::Wrapper::new_Field(static_cast<unsigned int>(m_in.read_count())) );
+                    break;
+                case ::MIR::LValue::Wrapper::TAG_Deref:
+                    rv.m_wrappers.push_back( ::MIR::LValue::Wrapper::new_Deref() );
+                    break;
+                case ::MIR::LValue::Wrapper::TAG_Index:
+                    rv.m_wrappers.push_back( ::MIR::LValue::Wrapper::new_Index(static_cast<unsigned int>(m_in.read_count())) );
+                    break;
+                case ::MIR::LValue::Wrapper::TAG_Downcast:
+                    rv.m_wrappers.push_back( ::MIR::LValue::Wrapper::new_Downcast(static_cast<unsigned int>(m_in.read_count())) );
+                    break;
+                default:
+                    throw ::std::runtime_error(FMT("Invalid MIR LValue wrapper tag - " << tag));
+                }
+            }
+            return rv;
         }
         ::MIR::RValue deserialise_mir_rvalue()
         {
@@ -557,6 +567,10 @@ namespace {
                 deserialise_type(),
                 deserialise_exprptr()
                 };
+            if( m_in.read_bool() )
+            {
+                rv.m_interp_mir = deserialise_mir();
+            }
             return rv;
         }
         ::std::vector< ::std::pair< ::HIR::Pattern, ::HIR::TypeRef> >   deserialise_fcnargs()
@@ -584,13 +598,18 @@ namespace {
         {
             TRACE_FUNCTION;
 
-            return ::HIR::Static {
+            ::HIR::Static rv {
                 deserialise_linkage(),
                 m_in.read_bool(),
                 deserialise_type(),
                 ::HIR::ExprPtr {},
                 {}
                 };
+            if( m_in.read_bool() )
+            {
+                rv.m_interp_value = deserialise_literal();
+            }
+            return rv;
         }
 
         // - Type items
@@ -1014,6 +1033,16 @@ namespace {
         _(BorrowPath, deserialise_path() )
         _(BorrowData, box$(deserialise_literal()) )
         _(String,  m_in.read_string() )
+        _(Repeat, {
+            box$( deserialise_literal() ),
+            m_in.read_u64c()
+            })
+        case ::HIR::Literal::TAG_Buffer: {
+            auto ty = static_cast< ::HIR::CoreType>( m_in.read_tag() );
+            ::std::vector<uint8_t>  data( static_cast<size_t>(m_in.read_u64c()) );
+            m_in.read(data.data(), data.size());
+            return ::HIR::Literal::make_Buffer({ ty, mv$(data) });
+            }
         #undef _
         default:
             throw "";
@@ -1225,6 +1254,12 @@ namespace {
 
         rv.m_proc_macros = deserialise_vec< ::HIR::ProcMacro>();
 
+        {
+            size_t n = m_in.read_count();
+            for(size_t i = 0; i < n; i ++)
+                rv.m_exported_instances.insert( deserialise_path() );
+        }
+
         return rv;
     }
 }
@@ -6,6 +6,7 @@
 #include <hir/pattern.hpp>
 #include <hir/type.hpp>
 #include <span.hpp>
+#include <node_pool.hpp>
 #include <hir/visitor.hpp>
 
 namespace HIR {
@@ -41,6 +42,8 @@ class ExprVisitor;
 class ExprNode
 {
 public:
+    NODE_POOL_ALLOCATED()
+
     Span    m_span;
     ::HIR::TypeRef    m_res_type;
     ValueUsage  m_usage = ValueUsage::Unknown;
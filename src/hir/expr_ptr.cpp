@@ -16,6 +16,14 @@
 {
     return node.into_unique();
 }
+void HIR::ExprPtr::release_hir()
+{
+    assert(m_mir);
+    node.reset(nullptr);
+    m_bindings.clear();
+    m_bindings.shrink_to_fit();
+    m_hir_released = true;
+}
 
 
 ::HIR::ExprPtrInner::ExprPtrInner(::std::unique_ptr< ::HIR::ExprNode> v):
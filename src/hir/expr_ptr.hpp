@@ -57,6 +57,8 @@ public:
 class ExprPtr
 {
     ::HIR::ExprPtrInner node;
+    // Set once the HIR tree has been released (after MIR generation), the body still exists as MIR
+    bool    m_hir_released = false;
 
 public:
     ::std::vector< ::HIR::TypeRef>  m_bindings;
@@ -68,9 +70,16 @@ public:
     ExprPtr(::std::unique_ptr< ::HIR::ExprNode> _);
 
     ::std::unique_ptr< ::HIR::ExprNode> into_unique();
+    /// True if there's a live HIR tree (false once `release_hir` has been called)
     operator bool () const { return node; }
     ::HIR::ExprNode* get() const { return node.get(); }
-    void reset(::HIR::ExprNode* p) { node.reset(p); }
+    void reset(::HIR::ExprNode* p) { node.reset(p); m_hir_released = false; }
+
+    /// Drop the HIR expression tree (and binding types), leaving only the MIR
+    void release_hir();
+    bool hir_released() const { return m_hir_released; }
+    /// True if the item has a body in this crate (a HIR tree, or the MIR left after it was released)
+    bool has_body() const { return node || m_hir_released; }
 
           ::HIR::ExprNode& operator*()       { return *node; }
     const ::HIR::ExprNode& operator*() const { return *node; }
@@ -123,7 +123,7 @@
 
 ::HIR::Pattern LowerHIR_Pattern(const ::AST::Pattern& pat)
 {
-    TRACE_FUNCTION_F("@" << pat.span().filename << ":" << pat.span().start_line << " pat = " << pat);
+    TRACE_FUNCTION_F("@" << pat.span() << " pat = " << pat);
 
     ::HIR::PatternBinding   binding;
     if( pat.binding().is_valid() )
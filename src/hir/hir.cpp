@@ -41,6 +41,15 @@ namespace HIR {
             ),
         (String,
             os << "\"" << e << "\"";
+            ),
+        (Repeat,
+            os << "[" << *e.val << "; " << e.count << "]";
+            ),
+        (Buffer,
+            os << "[";
+            for(size_t i = 0; i < v.list_size(); i ++)
+                os << " " << v.list_get(i).as_Integer() << ",";
+            os << " ]" << e.ty;
             )
         )
         return os;
@@ -49,7 +58,19 @@ namespace HIR {
     bool operator==(const Literal& l, const Literal& r)
     {
         if( l.tag() != r.tag() )
+        {
+            // Arrays can be stored in different forms, compare the entries
+            if( l.is_array_like() && r.is_array_like() )
+            {
+                if( l.list_size() != r.list_size() )
+                    return false;
+                for(size_t i = 0; i < l.list_size(); i ++)
+                    if( l.list_get(i) != r.list_get(i) )
+                        return false;
+                return true;
+            }
             return false;
+        }
         TU_MATCH(::HIR::Literal, (l,r), (le,re),
         (Invalid,
             ),
@@ -79,10 +100,204 @@ namespace HIR {
             ),
         (String,
             return le == re;
+            ),
+        (Repeat,
+            return le.count == re.count && *le.val == *re.val;
+            ),
+        (Buffer,
+            return le.ty == re.ty && le.data == re.data;
             )
         )
         return true;
     }
+
+    namespace {
+        /// Size of a packed Buffer entry for the given type (zero if the type can't be packed)
+        unsigned int literal_buffer_entry_size(::HIR::CoreType ct)
+        {
+            switch(ct)
+            {
+            case ::HIR::CoreType::U8:   case ::HIR::CoreType::I8:
+            case ::HIR::CoreType::Bool:
+                return 1;
+            case ::HIR::CoreType::U16:  case ::HIR::CoreType::I16:
+                return 2;
+            case ::HIR::CoreType::U32:  case ::HIR::CoreType::I32:
+            case ::HIR::CoreType::Char:
+                return 4;
+            case ::HIR::CoreType::U64:  case ::HIR::CoreType::I64:
+            case ::HIR::CoreType::Usize:    case ::HIR::CoreType::Isize:
+                return 8;
+            default:
+                return 0;
+            }
+        }
+        bool literal_buffer_is_signed(::HIR::CoreType ct)
+        {
+            switch(ct)
+            {
+            case ::HIR::CoreType::I8:
+            case ::HIR::CoreType::I16:
+            case ::HIR::CoreType::I32:
+            case ::HIR::CoreType::I64:
+            case ::HIR::CoreType::Isize:
+                return true;
+            default:
+                return false;
+            }
+        }
+        uint64_t literal_buffer_get(::HIR::CoreType ct, const ::std::vector<uint8_t>& data, size_t idx)
+        {
+            auto size = literal_buffer_entry_size(ct);
+            const uint8_t* p = data.data() + idx * size;
+            uint64_t rv = 0;
+            for(unsigned int i = 0; i < size; i ++)
+                rv |= static_cast<uint64_t>(p[i]) << (i * 8);
+            if( literal_buffer_is_signed(ct) && size < 8 && (rv >> (size * 8 - 1)) != 0 )
+                rv |= ~0ull << (size * 8);
+            return rv;
+        }
+    }
+
+    Literal Literal::clone() const
+    {
+        TU_MATCH(::HIR::Literal, (*this), (e),
+        (Invalid,
+            return ::HIR::Literal();
+            ),
+        (List,
+            ::std::vector< ::HIR::Literal>  vals;
+            vals.reserve( e.size() );
+            for(const auto& val : e) {
+                vals.push_back( val.clone() );
+            }
+            return ::HIR::Literal( mv$(vals) );
+            ),
+        (Variant,
+            return ::HIR::Literal::make_Variant({ e.idx, box$(e.val->clone()) });
+            ),
+        (Integer,
+            return ::HIR::Literal(e);
+            ),
+        (Float,
+            return ::HIR::Literal(e);
+            ),
+        (BorrowPath,
+            return ::HIR::Literal(e.clone());
+            ),
+        (BorrowData,
+            return ::HIR::Literal(box$( e->clone() ));
+            ),
+        (String,
+            return ::HIR::Literal(e);
+            ),
+        (Repeat,
+            return ::HIR::Literal::make_Repeat({ box$(e.val->clone()), e.count });
+            ),
+        (Buffer,
+            return ::HIR::Literal::make_Buffer({ e.ty, e.data });
+            )
+        )
+        throw "";
+    }
+
+    Literal Literal::new_array(::std::vector<Literal> vals, const ::HIR::TypeRef& inner_ty)
+    {
+        if( vals.size() > 1 && inner_ty.m_data.is_Primitive() )
+        {
+            auto ct = inner_ty.m_data.as_Primitive();
+            auto size = literal_buffer_entry_size(ct);
+            if( size > 0 )
+            {
+                ::std::vector<uint8_t>  data;
+                data.reserve( vals.size() * size );
+                bool valid = true;
+                for(const auto& v : vals)
+                {
+                    if( !v.is_Integer() ) {
+                        valid = false;
+                        break;
+                    }
+                    auto iv = v.as_Integer();
+                    for(unsigned int i = 0; i < size; i ++)
+                        data.push_back( static_cast<uint8_t>(iv >> (i * 8)) );
+                    // Only pack if the value is reproduced exactly when unpacked
+                    if( literal_buffer_get(ct, data, data.size() / size - 1) != iv ) {
+                        valid = false;
+                        break;
+                    }
+                }
+                if( valid )
+                {
+                    return ::HIR::Literal::make_Buffer({ ct, mv$(data) });
+                }
+            }
+        }
+        return ::HIR::Literal::make_List( mv$(vals) );
+    }
+    Literal Literal::new_repeat(Literal val, uint64_t count)
+    {
+        if( count == 0 )
+            return ::HIR::Literal::make_List({});
+        if( count == 1 )
+        {
+            ::std::vector<Literal>  vals;
+            vals.push_back( mv$(val) );
+            return ::HIR::Literal::make_List( mv$(vals) );
+        }
+        return ::HIR::Literal::make_Repeat({ box$(val), count });
+    }
+
+    size_t Literal::list_size() const
+    {
+        TU_MATCH_DEF(::HIR::Literal, (*this), (e),
+        (
+            throw ::std::runtime_error(FMT("Literal::list_size on non-array literal - " << *this));
+            ),
+        (List,
+            return e.size();
+            ),
+        (Repeat,
+            return static_cast<size_t>(e.count);
+            ),
+        (Buffer,
+            return e.data.size() / literal_buffer_entry_size(e.ty);
+            )
+        )
+        throw "";
+    }
+    Literal Literal::list_get(size_t idx) const
+    {
+        assert(idx < this->list_size());
+        TU_MATCH_DEF(::HIR::Literal, (*this), (e),
+        (
+            throw ::std::runtime_error(FMT("Literal::list_get on non-array literal - " << *this));
+            ),
+        (List,
+            return e[idx].clone();
+            ),
+        (Repeat,
+            return e.val->clone();
+            ),
+        (Buffer,
+            return ::HIR::Literal::make_Integer( literal_buffer_get(e.ty, e.data, idx) );
+            )
+        )
+        throw "";
+    }
+    ::std::vector<Literal>& Literal::expand_list()
+    {
+        if( !this->is_List() )
+        {
+            ::std::vector<Literal>  vals;
+            auto len = this->list_size();
+            vals.reserve(len);
+            for(size_t i = 0; i < len; i ++)
+                vals.push_back( this->list_get(i) );
+            *this = ::HIR::Literal::make_List( mv$(vals) );
+        }
+        return this->as_List();
+    }
 }
 
 size_t HIR::Enum::find_variant(const ::std::string& name) const
@@ -1074,10 +1289,20 @@ const ::HIR::TypeItem& ::HIR::Crate::get_typeitem_by_path(const Span& sp, const
     ASSERT_BUG(sp, path.m_components.size() > 0u, "get_typeitem_by_path received invalid path - " << path);
     ASSERT_BUG(sp, path.m_components.size() > (ignore_last_node ? 1u : 0u), "get_typeitem_by_path received invalid path - " << path);
 
+    // Only plain lookups are cached (the other forms are rare)
+    bool use_cache = !ignore_crate_name && !ignore_last_node;
+    if( use_cache )
+    {
+        auto cit = m_typeitem_cache.find(path);
+        if( cit != m_typeitem_cache.end() )
+            return *cit->second;
+    }
+
     const ::HIR::Module* mod;
     if( !ignore_crate_name && path.m_crate_name != m_crate_name ) {
-        ASSERT_BUG(sp, m_ext_crates.count(path.m_crate_name) > 0, "Crate '" << path.m_crate_name << "' not loaded for " << path);
-        mod = &m_ext_crates.at(path.m_crate_name).m_data->m_root_module;
+        auto ec_it = m_ext_crates.find(path.m_crate_name);
+        ASSERT_BUG(sp, ec_it != m_ext_crates.end(), "Crate '" << path.m_crate_name << "' not loaded for " << path);
+        mod = &ec_it->second.m_data->m_root_module;
     }
     else {
         mod =  &this->m_root_module;
@@ -1101,6 +1326,10 @@ const ::HIR::TypeItem& ::HIR::Crate::get_typeitem_by_path(const Span& sp, const
         BUG(sp, "Could not find type name in " << path);
     }
 
+    if( use_cache )
+    {
+        m_typeitem_cache.insert( ::std::make_pair(path.clone(), &it->second->ent) );
+    }
     return it->second->ent;
 }
 
@@ -1179,10 +1408,17 @@ const ::HIR::ValueItem& ::HIR::Crate::get_valitem_by_path(const Span& sp, const
     if( path.m_components.size() == 0) {
         BUG(sp, "get_valitem_by_path received invalid path");
     }
+    if( !ignore_crate_name )
+    {
+        auto cit = m_valitem_cache.find(path);
+        if( cit != m_valitem_cache.end() )
+            return *cit->second;
+    }
     const ::HIR::Module* mod;
     if( !ignore_crate_name && path.m_crate_name != m_crate_name ) {
-        ASSERT_BUG(sp, m_ext_crates.count(path.m_crate_name) > 0, "Crate '" << path.m_crate_name << "' not loaded");
-        mod = &m_ext_crates.at(path.m_crate_name).m_data->m_root_module;
+        auto ec_it = m_ext_crates.find(path.m_crate_name);
+        ASSERT_BUG(sp, ec_it != m_ext_crates.end(), "Crate '" << path.m_crate_name << "' not loaded");
+        mod = &ec_it->second.m_data->m_root_module;
     }
     else {
         mod =  &this->m_root_module;
@@ -1206,6 +1442,10 @@ const ::HIR::ValueItem& ::HIR::Crate::get_valitem_by_path(const Span& sp, const
         BUG(sp, "Could not find value name " << path);
     }
 
+    if( !ignore_crate_name )
+    {
+        m_valitem_cache.insert( ::std::make_pair(path.clone(), &it->second->ent) );
+    }
     return it->second->ent;
 }
 const ::HIR::Function& ::HIR::Crate::get_function_by_path(const Span& sp, const ::HIR::SimplePath& path) const
@@ -1279,3 +1519,103 @@ bool ::HIR::Crate::find_type_impls(const ::HIR::TypeRef& type, t_cb_resolve_type
     }
     return false;
 }
+namespace {
+    /// Get the head of a type (returns false if the head isn't known, e.g. for generics and ivars)
+    bool get_type_head(const ::HIR::TypeRef& ty, ::HIR::Crate::t_type_head& out)
+    {
+        out = ::HIR::Crate::t_type_head(ty.m_data.tag(), 0);
+        TU_MATCH_DEF(::HIR::TypeRef::Data, (ty.m_data), (te),
+        (
+            return true;
+            ),
+        (Infer,
+            return false;
+            ),
+        (Generic,
+            return false;
+            ),
+        (ErasedType,
+            return false;
+            ),
+        (Primitive,
+            out.second = static_cast<uintptr_t>(te);
+            return true;
+            ),
+        (Path,
+            // Only nominal types are distinguished (by the item they point to)
+            TU_MATCH_DEF(::HIR::TypeRef::TypePathBinding, (te.binding), (be),
+            (
+                return false;
+                ),
+            (Struct,
+                out.second = reinterpret_cast<uintptr_t>(be);
+                return true;
+                ),
+            (Enum,
+                out.second = reinterpret_cast<uintptr_t>(be);
+                return true;
+                ),
+            (Union,
+                out.second = reinterpret_cast<uintptr_t>(be);
+                return true;
+                )
+            )
+            )
+        )
+    }
+}
+bool ::HIR::Crate::find_type_impls_with_method(const ::std::string& method_name, const ::HIR::TypeRef& type, t_cb_resolve_type ty_res, ::std::function<bool(const ::HIR::TypeImpl&)> callback) const
+{
+    // NOTE: Impl blocks are only added during lowering, so the index can be built once and never invalidated
+    if( !m_type_impls_by_method_valid )
+    {
+        for( const auto& impl : this->m_type_impls )
+        {
+            for( const auto& m : impl.m_methods )
+                m_type_impls_by_method[m.first].impls.push_back(&impl);
+        }
+        m_type_impls_by_method_valid = true;
+    }
+    // Visit in the same order as `find_type_impls` (local impls in definition order, then extern crates)
+    auto it = m_type_impls_by_method.find(method_name);
+    if( it != m_type_impls_by_method.end() )
+    {
+        // If the head of the type is known, only check impls that could match it (impls on a generic or an unexpanded
+        // associated type can match anything, and are always checked).
+        const auto* impls = &it->second.impls;
+        ::HIR::Crate::t_type_head   head;
+        if( get_type_head(type.m_data.is_Infer() ? ty_res(type) : type, head) )
+        {
+            auto hit = it->second.by_head.find(head);
+            if( hit == it->second.by_head.end() )
+            {
+                ::std::vector<const ::HIR::TypeImpl*>   list;
+                for( const auto* impl : it->second.impls )
+                {
+                    const auto& impl_ty = impl->m_type;
+                    ::HIR::Crate::t_type_head   impl_head;
+                    bool is_wildcard = impl_ty.m_data.is_Generic() || TU_TEST1(impl_ty.m_data, Path, .path.m_data.is_UfcsKnown());
+                    if( is_wildcard || !get_type_head(impl_ty, impl_head) || impl_head == head )
+                        list.push_back(impl);
+                }
+                hit = it->second.by_head.insert( ::std::make_pair(head, mv$(list)) ).first;
+            }
+            impls = &hit->second;
+        }
+        for( const auto* impl : *impls )
+        {
+            if( impl->matches_type(type, ty_res) ) {
+                if( callback(*impl) ) {
+                    return true;
+                }
+            }
+        }
+    }
+    for( const auto& ec : this->m_ext_crates )
+    {
+        if( ec.second.m_data->find_type_impls_with_method(method_name, type, ty_res, callback) ) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -13,6 +13,7 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <set>
 
 #include <tagged_union.hpp>
 
@@ -47,10 +48,10 @@ struct VisEnt
 
 /// Literal type used for constant evaluation
 /// NOTE: Intentionally minimal, just covers the values (not the types)
-TAGGED_UNION(Literal, Invalid,
+TAGGED_UNION_EX(Literal, (), Invalid, (
     (Invalid, struct {}),
     // List = Array, Tuple, struct literal
-    (List, ::std::vector<Literal>), // TODO: Have a variant for repetition lists
+    (List, ::std::vector<Literal>),
     // Variant = Enum variant
     (Variant, struct {
         unsigned int    idx;
@@ -64,7 +65,34 @@ TAGGED_UNION(Literal, Invalid,
     // Borrow of inline data
     (BorrowData, ::std::unique_ptr<Literal>),
     // String = &'static str or &[u8; N]
-    (String, ::std::string)
+    (String, ::std::string),
+    // Repeat = Array of `count` copies of the same value (`[val; count]`)
+    (Repeat, struct {
+        ::std::unique_ptr<Literal>  val;
+        uint64_t    count;
+        }),
+    // Buffer = Array of integer primitives, packed little-endian using the size of `ty`
+    (Buffer, struct {
+        ::HIR::CoreType ty;
+        ::std::vector<uint8_t>  data;
+        })
+    ), (), (), (
+        Literal clone() const;
+
+        /// Create an array literal, packing into a Buffer if all entries are integers of a suitable type
+        static Literal new_array(::std::vector<Literal> vals, const ::HIR::TypeRef& inner_ty);
+        /// Create an array literal from a repeated value
+        static Literal new_repeat(Literal val, uint64_t count);
+
+        /// Returns true for any of the array-like variants (List, Repeat, Buffer)
+        bool is_array_like() const { return is_List() || is_Repeat() || is_Buffer(); }
+        /// Number of entries in an array-like literal
+        size_t list_size() const;
+        /// Obtain (a copy of) an entry in an array-like literal
+        Literal list_get(size_t idx) const;
+        /// Convert Repeat/Buffer into a List (for when individual entries need to be modified)
+        ::std::vector<Literal>& expand_list();
+    )
     );
 extern ::std::ostream& operator<<(::std::ostream& os, const Literal& v);
 extern bool operator==(const Literal& l, const Literal& r);
@@ -99,6 +127,8 @@ public:
     ExprPtr m_value;
 
     Literal   m_value_res;
+    /// Value loaded from a crate built with `-Z save-all-mir` (used by the interpreter and whole-program builds)
+    Literal   m_interp_value;
 };
 class Constant
 {
@@ -141,6 +171,9 @@ public:
     TypeRef m_return;
 
     ExprPtr m_code;
+    /// MIR loaded from a crate built with `-Z save-all-mir` when `m_code` wasn't saved (used by the interpreter and
+    /// whole-program builds)
+    ::MIR::FunctionPointer  m_interp_mir;
 
     //::HIR::TypeRef make_ty(const Span& sp, const ::HIR::PathParams& params) const;
 };
@@ -492,6 +525,33 @@ public:
     ::std::vector<ExternLibrary>    m_ext_libs;
     /// Extra paths for the linker
     ::std::vector<::std::string>    m_link_paths;
+    /// Monomorphised instances of generic items that this crate's object code exports
+    ::std::set< ::HIR::Path>    m_exported_instances;
+
+    /// Outermost part of a type, used to narrow impl searches (see `find_type_impls_with_method`)
+    typedef ::std::pair<unsigned int, uintptr_t>  t_type_head;
+    struct MethodImpls {
+        /// All impls defining the method
+        ::std::vector<const ::HIR::TypeImpl*>   impls;
+        /// Subsets of `impls` that can match a type with the given head (populated on first use)
+        ::std::map< t_type_head, ::std::vector<const ::HIR::TypeImpl*> >    by_head;
+    };
+    /// Index of `m_type_impls` by method name (populated on first use by `find_type_impls_with_method`)
+    mutable ::std::unordered_map< ::std::string, MethodImpls >  m_type_impls_by_method;
+    mutable bool    m_type_impls_by_method_valid = false;
+
+    /// Result of looking up a method name in a trait and its parent traits (see `TraitResolution::find_method`)
+    struct TraitMethodEnt {
+        bool    found;
+        ::HIR::Function::Receiver   receiver;
+        /// Trait (or parent trait) that defines the method
+        ::HIR::GenericPath  trait_path;
+    };
+    mutable ::std::map< ::std::pair<const ::HIR::Trait*, ::std::string>, TraitMethodEnt>  m_trait_method_cache;
+
+    /// Results of `get_typeitem_by_path`/`get_valitem_by_path` (items are never removed, and are boxed, so the pointers stay valid)
+    mutable ::std::unordered_map< ::HIR::SimplePath, const ::HIR::TypeItem*, ::HIR::SimplePath::Hash>   m_typeitem_cache;
+    mutable ::std::unordered_map< ::HIR::SimplePath, const ::HIR::ValueItem*, ::HIR::SimplePath::Hash>  m_valitem_cache;
 
     /// Method called to populate runtime state after deserialisation
     /// See hir/crate_post_load.cpp
@@ -531,6 +591,8 @@ public:
     bool find_trait_impls(const ::HIR::SimplePath& path, const ::HIR::TypeRef& type, t_cb_resolve_type ty_res, ::std::function<bool(const ::HIR::TraitImpl&)> callback) const;
     bool find_auto_trait_impls(const ::HIR::SimplePath& path, const ::HIR::TypeRef& type, t_cb_resolve_type ty_res, ::std::function<bool(const ::HIR::MarkerImpl&)> callback) const;
     bool find_type_impls(const ::HIR::TypeRef& type, t_cb_resolve_type ty_res, ::std::function<bool(const ::HIR::TypeImpl&)> callback) const;
+    /// Same as `find_type_impls`, but only visits impls that define a method called `method_name`
+    bool find_type_impls_with_method(const ::std::string& method_name, const ::HIR::TypeRef& type, t_cb_resolve_type ty_res, ::std::function<bool(const ::HIR::TypeImpl&)> callback) const;
 };
 
 }   // namespace HIR
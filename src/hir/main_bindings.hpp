@@ -17,5 +17,7 @@ namespace AST {
 
 extern void HIR_Dump(::std::ostream& sink, const ::HIR::Crate& crate);
 extern ::HIR::CratePtr  LowerHIR_FromAST(::AST::Crate crate);
-extern void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate);
+/// Save the crate's metadata
+/// - `save_all_mir` saves the MIR of every function (not just generic/inline ones), for use by `-Z interpret`
+extern void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate, bool save_all_mir=false);
 extern ::HIR::CratePtr HIR_Deserialise(const ::std::string& filename, const ::std::string& loaded_name);
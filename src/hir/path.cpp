@@ -104,6 +104,14 @@ namespace HIR {
 {
     return SimplePath( m_crate_name, m_components );
 }
+size_t HIR::SimplePath::Hash::operator()(const ::HIR::SimplePath& x) const
+{
+    ::std::hash< ::std::string>   h;
+    size_t  rv = h(x.m_crate_name);
+    for(const auto& c : x.m_components)
+        rv = rv * 31 + h(c);
+    return rv;
+}
 
 ::HIR::PathParams::PathParams()
 {
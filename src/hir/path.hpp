@@ -92,6 +92,11 @@ struct SimplePath
         return rv;
     }
     friend ::std::ostream& operator<<(::std::ostream& os, const SimplePath& x);
+
+    /// Hash functor, for use as the key of unordered containers
+    struct Hash {
+        size_t operator()(const SimplePath& x) const;
+    };
 };
 
 
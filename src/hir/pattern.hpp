@@ -10,6 +10,7 @@
 #include <memory>
 #include <vector>
 #include <tagged_union.hpp>
+#include <node_pool.hpp>
 #include <hir/path.hpp>
 #include <hir/type.hpp>
 
@@ -50,6 +51,8 @@ struct PatternBinding
 
 struct Pattern
 {
+    NODE_POOL_ALLOCATED()
+
     TAGGED_UNION(Value, String,
         (Integer, struct {
             ::HIR::CoreType type;  // Str == _
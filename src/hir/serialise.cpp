@@ -16,9 +16,11 @@ namespace {
     class HirSerialiser
     {
         ::HIR::serialise::Writer&   m_out;
+        bool    m_save_all_mir;
     public:
-        HirSerialiser(::HIR::serialise::Writer& out):
-            m_out( out )
+        HirSerialiser(::HIR::serialise::Writer& out, bool save_all_mir):
+            m_out( out ),
+            m_save_all_mir( save_all_mir )
         {}
 
         template<typename V>
@@ -284,6 +286,10 @@ namespace {
             serialise_vec(crate.m_link_paths);
 
             serialise_vec(crate.m_proc_macros);
+
+            m_out.write_count(crate.m_exported_instances.size());
+            for(const auto& p : crate.m_exported_instances)
+                serialise_path(p);
         }
         void serialise(const ::HIR::ExternLibrary& lib)
         {
@@ -468,6 +474,15 @@ namespace {
                 ),
             (String,
                 m_out.write_string(e);
+                ),
+            (Repeat,
+                serialise(*e.val);
+                m_out.write_u64c(e.count);
+                ),
+            (Buffer,
+                m_out.write_tag( static_cast<int>(e.ty) );
+                m_out.write_u64c(e.data.size());
+                m_out.write(e.data.data(), e.data.size());
                 )
             )
         }
@@ -615,8 +630,8 @@ namespace {
         void serialise(const ::MIR::LValue& lv)
         {
             TRACE_FUNCTION_F("LValue = "<<lv);
-            m_out.write_tag( static_cast<int>(lv.tag()) );
-            TU_MATCHA( (lv), (e),
+            m_out.write_tag( static_cast<int>(lv.m_root.tag()) );
+            TU_MATCHA( (lv.m_root), (e),
             (Return,
                 ),
             (Argument,
@@ -626,24 +641,21 @@ namespace {
                 m_out.write_count(e);
                 ),
             (Static,
-                serialise_path(e);
-                ),
-            (Field,
-                serialise(e.val);
-                m_out.write_count(e.field_index);
-                ),
-            (Deref,
-                serialise(e.val);
-                ),
-            (Index,
-                serialise(e.val);
-                serialise(e.idx);
-                ),
-            (Downcast,
-                serialise(e.val);
-                m_out.write_count(e.variant_index);
+                serialise_path(*e);
                 )
             )
+            m_out.write_count(lv.m_wrappers.size());
+            for(const auto& w : lv.m_wrappers)
+            {
+                m_out.write_tag( static_cast<int>(w.tag()) );
+                switch(w.tag())
+                {
+                case ::MIR::LValue::Wrapper::TAG_Field:     m_out.write_count(w.as_Field());    break;
+                case ::MIR::LValue::Wrapper::TAG_Deref:     break;
+                case ::MIR::LValue::Wrapper::TAG_Index:     m_out.write_count(w.as_Index());    break;
+                case ::MIR::LValue::Wrapper::TAG_Downcast:  m_out.write_count(w.as_Downcast()); break;
+                }
+            }
         }
         void serialise(const ::MIR::RValue& val)
         {
@@ -834,6 +846,12 @@ namespace {
             DEBUG("m_args = " << fcn.m_args);
 
             serialise(fcn.m_code, fcn.m_save_code || fcn.m_const);
+            // MIR that isn't needed by codegen, only by the interpreter
+            bool save_interp_mir = m_save_all_mir && fcn.m_code.m_mir && !(fcn.m_save_code || fcn.m_const);
+            m_out.write_bool(save_interp_mir);
+            if( save_interp_mir ) {
+                serialise(*fcn.m_code.m_mir);
+            }
         }
         void serialise(const ::HIR::Constant& item)
         {
@@ -853,7 +871,13 @@ namespace {
             m_out.write_bool(item.m_is_mut);
             serialise(item.m_type);
 
-            // NOTE: Value not stored (What if the static is generic? It can't be.)
+            // NOTE: Value is only stored for the interpreter (and whole-program builds), otherwise the defining crate
+            // is the only one that needs it.
+            bool save_value = m_save_all_mir && !item.m_value_res.is_Invalid();
+            m_out.write_bool(save_value);
+            if( save_value ) {
+                serialise(item.m_value_res);
+            }
         }
 
         // - Type items
@@ -997,10 +1021,10 @@ namespace {
     };
 }
 
-void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate)
+void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate, bool save_all_mir)
 {
     ::HIR::serialise::Writer    out { filename };
-    HirSerialiser  s { out };
+    HirSerialiser  s { out, save_all_mir };
     s.serialise_crate(crate);
 }
 
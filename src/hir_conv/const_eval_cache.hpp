@@ -0,0 +1,104 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir_conv/const_eval_cache.hpp
+ * - State shared between constant evaluations (memoised const fn results, step limit, profiling)
+ * - Used by both `hir_conv/constant_evaluation.cpp` and `hir_expand/const_eval_full.cpp`
+ */
+#pragma once
+#include <hir/hir.hpp>
+#include "main_bindings.hpp"    // ConstEvalOptions
+#include <map>
+#include <algorithm>
+#include <iostream>
+
+class ConstEvalCache
+{
+    struct Ent {
+        ::std::vector< ::HIR::Literal>  args;
+        ::HIR::Literal  value;
+    };
+    const ConstEvalOptions& m_options;
+
+    /// Results of previous calls, keyed by (monomorphised) path
+    ::std::map< ::HIR::Path, ::std::vector<Ent> >   m_results;
+    size_t  m_hits = 0;
+
+    /// Name and step count of the current top-level item
+    ::std::string   m_cur_item;
+    uint64_t    m_steps = 0;
+    unsigned int    m_call_depth = 0;
+    ::std::vector< ::std::pair<uint64_t, ::std::string> >   m_profile;
+
+public:
+    ConstEvalCache(const ConstEvalOptions& options):
+        m_options(options)
+    {}
+
+    /// Start evaluating a top-level item (constant, static, array size, ...) - resets the step counter
+    void start_item(::std::string name) {
+        m_cur_item = mv$(name);
+        m_steps = 0;
+        m_call_depth = 0;
+    }
+    void end_item() {
+        if( m_options.profile )
+            m_profile.push_back( ::std::make_pair(m_steps, mv$(m_cur_item)) );
+    }
+
+    /// Count one interpreter step, erroring if the budget is exhausted
+    void step(const Span& sp) {
+        m_steps ++;
+        if( m_options.step_limit != 0 && m_steps > m_options.step_limit ) {
+            ERROR(sp, E0000, "Constant evaluation of `" << m_cur_item << "` exceeded the step limit of " << m_options.step_limit
+                << " (raise it with -Z const-eval-limit=N, 0 disables the limit)");
+        }
+    }
+
+    /// Track const fn call nesting (runaway recursion would otherwise overflow the stack before hitting the step limit)
+    void enter_call(const Span& sp) {
+        m_call_depth ++;
+        if( m_options.call_depth_limit != 0 && m_call_depth > m_options.call_depth_limit ) {
+            ERROR(sp, E0000, "Constant evaluation of `" << m_cur_item << "` exceeded the maximum call depth of " << m_options.call_depth_limit
+                << " (raise it with -Z const-eval-depth=N, 0 disables the limit)");
+        }
+    }
+    void leave_call() {
+        m_call_depth --;
+    }
+
+    /// Look up a memoised call result
+    const ::HIR::Literal* get(const ::HIR::Path& path, const ::std::vector< ::HIR::Literal>& args) {
+        auto it = m_results.find(path);
+        if( it == m_results.end() )
+            return nullptr;
+        for(const auto& ent : it->second)
+        {
+            if( ent.args == args ) {
+                m_hits ++;
+                return &ent.value;
+            }
+        }
+        return nullptr;
+    }
+    /// Save the result of a call (only valid if the call had no side-effects, i.e. didn't create new statics)
+    void insert(const ::HIR::Path& path, ::std::vector< ::HIR::Literal> args, const ::HIR::Literal& value) {
+        auto it = m_results.find(path);
+        if( it == m_results.end() )
+            it = m_results.insert( ::std::make_pair(path.clone(), ::std::vector<Ent>()) ).first;
+        it->second.push_back(Ent { mv$(args), value.clone() });
+    }
+
+    /// Print the most expensive items (if profiling is enabled)
+    void dump_profile(const char* phase) {
+        if( !m_options.profile )
+            return ;
+        ::std::sort(m_profile.begin(), m_profile.end(), [](const auto& a, const auto& b){ return a.first > b.first; });
+        ::std::cout << phase << " - " << m_profile.size() << " items, " << m_hits << " memoised calls" << ::std::endl;
+        for(size_t i = 0; i < ::std::min(m_profile.size(), size_t(20)); i ++)
+        {
+            ::std::cout << "  " << m_profile[i].first << " steps - " << m_profile[i].second << ::std::endl;
+        }
+    }
+};
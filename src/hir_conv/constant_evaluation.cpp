@@ -13,6 +13,7 @@
 #include <mir/mir.hpp>
 #include <hir_typeck/common.hpp>    // Monomorph
 #include <mir/helpers.hpp>
+#include "const_eval_cache.hpp"
 
 namespace {
     typedef ::std::vector< ::std::pair< ::std::string, ::HIR::Static> > t_new_values;
@@ -22,12 +23,17 @@ namespace {
         const ::HIR::ItemPath&  mod_path;
         ::std::string   name_prefix;
         unsigned int next_item_idx;
+        ConstEvalCache& cache;
+        /// Generic parameters of the const fn being evaluated (null for top-level items)
+        const MonomorphState*   fcn_params;
 
-        NewvalState(t_new_values& newval_output, const ::HIR::ItemPath& mod_path, ::std::string prefix):
+        NewvalState(t_new_values& newval_output, const ::HIR::ItemPath& mod_path, ::std::string prefix, ConstEvalCache& cache):
             newval_output(newval_output),
             mod_path(mod_path),
             name_prefix(prefix),
-            next_item_idx(0)
+            next_item_idx(0),
+            cache(cache),
+            fcn_params(nullptr)
         {
         }
 
@@ -51,37 +57,7 @@ namespace {
 
     ::HIR::Literal clone_literal(const ::HIR::Literal& v)
     {
-        TU_MATCH(::HIR::Literal, (v), (e),
-        (Invalid,
-            return ::HIR::Literal();
-            ),
-        (List,
-            ::std::vector< ::HIR::Literal>  vals;
-            for(const auto& val : e) {
-                vals.push_back( clone_literal(val) );
-            }
-            return ::HIR::Literal( mv$(vals) );
-            ),
-        (Variant,
-            return ::HIR::Literal::make_Variant({ e.idx, box$(clone_literal(*e.val)) });
-            ),
-        (Integer,
-            return ::HIR::Literal(e);
-            ),
-        (Float,
-            return ::HIR::Literal(e);
-            ),
-        (BorrowPath,
-            return ::HIR::Literal(e.clone());
-            ),
-        (BorrowData,
-            return ::HIR::Literal(box$( clone_literal(*e) ));
-            ),
-        (String,
-            return ::HIR::Literal(e);
-            )
-        )
-        throw "";
+        return v.clone();
     }
 
     TAGGED_UNION(EntPtr, NotFound,
@@ -244,6 +220,75 @@ namespace {
         }
     }
 
+    /// Evaluate a call to a const fn, re-using the result of an identical previous call if possible
+    ::HIR::Literal evaluate_const_fn(const Span& sp, const ::HIR::Crate& crate, NewvalState newval_state, const ::HIR::Path& path_raw, const ::HIR::Function& fcn, ::std::vector< ::HIR::Literal> args)
+    {
+        // Generic parameters in the path belong to the calling const fn, replace them so the memo key is the same
+        // for identical calls (and differs between instantiations of the caller)
+        ::std::unique_ptr< ::HIR::Path>    path_mono;
+        const ::HIR::Path* path_p = &path_raw;
+        if( newval_state.fcn_params && monomorphise_path_needed(path_raw) )
+        {
+            const auto& ms = *newval_state.fcn_params;
+            path_mono = box$( monomorphise_path_with(sp, path_raw, [&](const ::HIR::TypeRef& gt)->const ::HIR::TypeRef& {
+                const auto& ge = gt.m_data.as_Generic();
+                if( ge.binding == 0xFFFF )
+                    return ms.self_ty ? *ms.self_ty : gt;
+                const ::HIR::PathParams* pp = ((ge.binding >> 8) == 0 ? ms.pp_impl : (ge.binding >> 8) == 1 ? ms.pp_method : nullptr);
+                if( pp && (ge.binding & 0xFF) < pp->m_types.size() )
+                    return pp->m_types[ge.binding & 0xFF];
+                // Not known (e.g. impl parameters of a trait impl's method), left as-is
+                return gt;
+                }, false) );
+            path_p = &*path_mono;
+        }
+        const auto& path = *path_p;
+        // A path that still has generics could stand for several different instantiations, so it can't be a memo key
+        bool can_memoise = !monomorphise_path_needed(path);
+
+        if( const auto* rv = can_memoise ? newval_state.cache.get(path, args) : nullptr ) {
+            DEBUG("Memoised " << path << " = " << *rv);
+            return rv->clone();
+        }
+        MonomorphState  fcn_ms;
+        TU_MATCHA( (path.m_data), (pe),
+        (Generic,
+            fcn_ms.pp_method = &pe.m_params;
+            ),
+        (UfcsInherent,
+            fcn_ms.self_ty = &*pe.type;
+            fcn_ms.pp_impl = &pe.impl_params;
+            fcn_ms.pp_method = &pe.params;
+            ),
+        (UfcsKnown,
+            fcn_ms.self_ty = &*pe.type;
+            fcn_ms.pp_method = &pe.params;
+            ),
+        (UfcsUnknown,
+            fcn_ms.self_ty = &*pe.type;
+            fcn_ms.pp_method = &pe.params;
+            )
+        )
+        newval_state.fcn_params = &fcn_ms;
+        ::std::vector< ::HIR::Literal>  saved_args;
+        if( can_memoise )
+        {
+            saved_args.reserve( args.size() );
+            for(const auto& a : args)
+                saved_args.push_back( a.clone() );
+        }
+
+        auto n_statics = newval_state.newval_output.size();
+        newval_state.cache.enter_call(sp);
+        auto rv = evaluate_constant(sp, crate, newval_state, fcn.m_code, fcn.m_return.clone(), mv$(args));
+        newval_state.cache.leave_call();
+        // Only pure calls can be memoised (new statics are named for the item being evaluated)
+        if( can_memoise && newval_state.newval_output.size() == n_statics ) {
+            newval_state.cache.insert(path, mv$(saved_args), rv);
+        }
+        return rv;
+    }
+
     ::HIR::Literal evaluate_constant_hir(const Span& sp, const ::HIR::Crate& crate, NewvalState newval_state, const ::HIR::ExprNode& expr, ::HIR::TypeRef exp_type, ::std::vector< ::HIR::Literal> args)
     {
         struct Visitor:
@@ -273,6 +318,7 @@ namespace {
 
                 for(const auto& e : node.m_nodes)
                 {
+                    m_newval_state.cache.step(node.span());
                     e->visit(*this);
                 }
                 if( node.m_value_node )
@@ -546,14 +592,13 @@ namespace {
                 // Value
                 m_exp_type = ::HIR::TypeRef::new_slice( mv$(exp_ty) );
                 node.m_value->visit(*this);
-                if( !m_rv.is_List() )
+                if( !m_rv.is_array_like() )
                     ERROR(node.span(), E0000, "Indexed value isn't a list - got " << m_rv.tag_str());
-                auto v = mv$( m_rv.as_List() );
 
                 // -> Perform
-                if( idx >= v.size() )
-                    ERROR(node.span(), E0000, "Constant array index " << idx << " out of range " << v.size());
-                m_rv = mv$(v[idx]);
+                if( idx >= m_rv.list_size() )
+                    ERROR(node.span(), E0000, "Constant array index " << idx << " out of range " << m_rv.list_size());
+                m_rv = m_rv.list_get(idx);
 
                 TU_MATCH_DEF( ::HIR::TypeRef::Data, (m_rv_type.m_data), (e),
                 (
@@ -612,6 +657,7 @@ namespace {
             {
 
                 TRACE_FUNCTION_FR("_CallPath - " << node.m_path, m_rv);
+                m_newval_state.cache.step(node.span());
                 auto& fcn = get_function(node.span(), m_crate, node.m_path);
 
                 // TODO: Set m_const during parse
@@ -622,7 +668,8 @@ namespace {
                 if( fcn.m_args.size() != node.m_args.size() ) {
                     ERROR(node.span(), E0000, "Incorrect argument count for " << node.m_path << " - expected " << fcn.m_args.size() << ", got " << node.m_args.size());
                 }
-                auto exp_ret_type = mv$( m_exp_type );
+                // NOTE: The return type is taken from the function
+                m_exp_type = ::HIR::TypeRef();
 
                 ::std::vector< ::HIR::Literal>  args;
                 args.reserve( fcn.m_args.size() );
@@ -646,12 +693,10 @@ namespace {
                     args.push_back( mv$(m_rv) );
                 }
 
-                exp_ret_type = fcn.m_return.clone();
-
                 // Call by invoking evaluate_constant on the function
                 {
                     TRACE_FUNCTION_F("Call const fn " << node.m_path << " args={ " << args << " }");
-                    m_rv = evaluate_constant(node.span(), m_crate, m_newval_state,  fcn.m_code, mv$(exp_ret_type), mv$(args));
+                    m_rv = evaluate_const_fn(node.span(), m_crate, m_newval_state, node.m_path, fcn, mv$(args));
                 }
             }
             void visit(::HIR::ExprNode_CallValue& node) override {
@@ -958,8 +1003,9 @@ namespace {
                     vals.push_back( mv$(m_rv) );
                 }
 
-                m_rv_type = ::HIR::TypeRef::new_array( mv$(m_rv_type), vals.size() );
-                m_rv = ::HIR::Literal::make_List(mv$(vals));
+                auto size = vals.size();
+                m_rv = ::HIR::Literal::new_array(mv$(vals), m_rv_type);
+                m_rv_type = ::HIR::TypeRef::new_array( mv$(m_rv_type), size );
             }
             void visit(::HIR::ExprNode_ArraySized& node) override
             {
@@ -983,20 +1029,17 @@ namespace {
                 assert( m_rv.is_Integer() );
                 unsigned int count = static_cast<unsigned int>(m_rv.as_Integer());
 
-                ::std::vector< ::HIR::Literal>  vals;
-                vals.reserve( count );
                 if( count > 0 )
                 {
                     m_exp_type = mv$(exp_inner_ty);
                     node.m_val->visit(*this);
                     assert( !m_rv.is_Invalid() );
-                    for(unsigned int i = 0; i < count-1; i ++)
-                    {
-                        vals.push_back( clone_literal(m_rv) );
-                    }
-                    vals.push_back( mv$(m_rv) );
+                    m_rv = ::HIR::Literal::new_repeat(mv$(m_rv), count);
+                }
+                else
+                {
+                    m_rv = ::HIR::Literal::make_List({});
                 }
-                m_rv = ::HIR::Literal::make_List(mv$(vals));
                 m_rv_type = ::HIR::TypeRef::new_array( mv$(m_rv_type), count );
             }
 
@@ -1029,7 +1072,17 @@ namespace {
         ::std::vector< ::HIR::Literal>  locals( fcn.locals.size() );
 
         auto get_lval = [&](const ::MIR::LValue& lv) -> ::HIR::Literal& {
-            TU_MATCHA( (lv), (e),
+            if( !lv.m_wrappers.empty() )
+            {
+                switch(lv.m_wrappers.back().tag())
+                {
+                case ::MIR::LValue::Wrapper::TAG_Field:     TODO(sp, "LValue::Field");
+                case ::MIR::LValue::Wrapper::TAG_Deref:     TODO(sp, "LValue::Deref");
+                case ::MIR::LValue::Wrapper::TAG_Index:     TODO(sp, "LValue::Index");
+                case ::MIR::LValue::Wrapper::TAG_Downcast:  TODO(sp, "LValue::Downcast");
+                }
+            }
+            TU_MATCHA( (lv.m_root), (e),
             (Return,
                 return retval;
                 ),
@@ -1044,18 +1097,6 @@ namespace {
                 ),
             (Static,
                 TODO(sp, "LValue::Static");
-                ),
-            (Field,
-                TODO(sp, "LValue::Field");
-                ),
-            (Deref,
-                TODO(sp, "LValue::Deref");
-                ),
-            (Index,
-                TODO(sp, "LValue::Index");
-                ),
-            (Downcast,
-                TODO(sp, "LValue::Downcast");
                 )
             )
             throw "";
@@ -1131,6 +1172,7 @@ namespace {
             for(const auto& stmt : block.statements)
             {
                 state.set_cur_stmt(cur_block, next_stmt_idx++);
+                newval_state.cache.step(sp);
 
                 if( ! stmt.is_Assign() ) {
                     //BUG(sp, "Non-assign statement - drop " << stmt.as_Drop().slot);
@@ -1147,16 +1189,10 @@ namespace {
                     val = const_to_lit(e);
                     ),
                 (SizedArray,
-                    ::std::vector< ::HIR::Literal>  vals;
                     if( e.count > 0 )
-                    {
-                        vals.reserve( e.count );
-                        val = read_param(e.val);
-                        for(unsigned int i = 1; i < e.count; i++)
-                            vals.push_back( clone_literal(val) );
-                        vals.push_back( mv$(val) );
-                    }
-                    val = ::HIR::Literal::make_List( mv$(vals) );
+                        val = ::HIR::Literal::new_repeat( read_param(e.val), e.count );
+                    else
+                        val = ::HIR::Literal::make_List({});
                     ),
                 (Borrow,
                     if( e.type != ::HIR::BorrowType::Shared ) {
@@ -1363,7 +1399,13 @@ namespace {
                     vals.reserve( e.vals.size() );
                     for(const auto& v : e.vals)
                         vals.push_back( read_param(v) );
-                    val = ::HIR::Literal::make_List( mv$(vals) );
+                    // The element type is needed to pack into a Buffer
+                    ::HIR::TypeRef  tmp;
+                    const auto& ty = state.get_lvalue_type(tmp, sa.dst);
+                    if( ty.m_data.is_Array() )
+                        val = ::HIR::Literal::new_array( mv$(vals), *ty.m_data.as_Array().inner );
+                    else
+                        val = ::HIR::Literal::make_List( mv$(vals) );
                     ),
                 (Variant,
                     TODO(sp, "MIR _Variant");
@@ -1381,6 +1423,7 @@ namespace {
                 dst = mv$(val);
             }
             state.set_cur_stmt_term(cur_block);
+            newval_state.cache.step(sp);
             TU_MATCH_DEF( ::MIR::Terminator, (block.terminator), (e),
             (
                 BUG(sp, "Unexpected terminator - " << block.terminator);
@@ -1448,7 +1491,7 @@ namespace {
                 // Call by invoking evaluate_constant on the function
                 {
                     TRACE_FUNCTION_F("Call const fn " << fcnp << " args={ " << call_args << " }");
-                    dst = evaluate_constant(sp, crate, newval_state,  fcn.m_code, fcn.m_return.clone(), mv$(call_args));
+                    dst = evaluate_const_fn(sp, crate, newval_state, fcnp, fcn, mv$(call_args));
                 }
 
                 cur_block = e.ret_block;
@@ -1544,10 +1587,12 @@ namespace {
         const ::HIR::Crate& m_crate;
         const ::HIR::ItemPath*  m_mod_path;
         t_new_values    m_new_values;
-
     public:
-        Expander(const ::HIR::Crate& crate):
-            m_crate(crate)
+        ConstEvalCache  m_cache;
+
+        Expander(const ::HIR::Crate& crate, const ConstEvalOptions& options):
+            m_crate(crate),
+            m_cache(options)
         {}
 
         void visit_module(::HIR::ItemPath p, ::HIR::Module& mod) override
@@ -1579,8 +1624,10 @@ namespace {
                     assert(e.size);
                     assert(*e.size);
                     const auto& expr_ptr = *e.size;
-                    auto nvs = NewvalState { m_new_values, *m_mod_path, FMT("ty_" << &ty << "$") };
+                    auto nvs = NewvalState { m_new_values, *m_mod_path, FMT("ty_" << &ty << "$"), m_cache };
+                    m_cache.start_item(FMT("array size in " << *m_mod_path));
                     auto val = evaluate_constant(expr_ptr->span(), m_crate, nvs, expr_ptr, ::HIR::CoreType::Usize);
+                    m_cache.end_item();
                     if( !val.is_Integer() )
                         ERROR(expr_ptr->span(), E0000, "Array size isn't an integer");
                     e.size_val = static_cast<size_t>(val.as_Integer());
@@ -1601,8 +1648,10 @@ namespace {
                 //else
                 //    return ;
 
-                auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$") };
+                auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$"), m_cache };
+                m_cache.start_item(FMT(p));
                 item.m_value_res = evaluate_constant(item.m_value->span(), m_crate, nvs, item.m_value, item.m_type.clone(), {});
+                m_cache.end_item();
 
                 check_lit_type(item.m_value->span(), item.m_type, item.m_value_res);
 
@@ -1617,7 +1666,9 @@ namespace {
                 {
                     if( var.expr )
                     {
-                        auto val = evaluate_constant(var.expr->span(), m_crate, NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$" << var.name << "$") }, var.expr, {});
+                        m_cache.start_item(FMT(p << "::" << var.name));
+                        auto val = evaluate_constant(var.expr->span(), m_crate, NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$" << var.name << "$"), m_cache }, var.expr, {});
+                        m_cache.end_item();
                         DEBUG("enum variant: " << p << "::" << var.name << " = " << val);
                         i = val.as_Integer();
                     }
@@ -1661,8 +1712,10 @@ namespace {
 
                 void visit(::HIR::ExprNode_ArraySized& node) override {
                     assert( node.m_size );
-                    NewvalState nvs { m_exp.m_new_values, *m_exp.m_mod_path, FMT("array_" << &node << "$") };
+                    NewvalState nvs { m_exp.m_new_values, *m_exp.m_mod_path, FMT("array_" << &node << "$"), m_exp.m_cache };
+                    m_exp.m_cache.start_item(FMT("array size in " << *m_exp.m_mod_path));
                     auto val = evaluate_constant_hir(node.span(), m_exp.m_crate, mv$(nvs), *node.m_size, ::HIR::CoreType::Usize, {});
+                    m_exp.m_cache.end_item();
                     if( !val.is_Integer() )
                         ERROR(node.span(), E0000, "Array size isn't an integer");
                     node.m_size_val = static_cast<size_t>(val.as_Integer());
@@ -1688,8 +1741,9 @@ namespace {
     };
 }   // namespace
 
-void ConvertHIR_ConstantEvaluate(::HIR::Crate& crate)
+void ConvertHIR_ConstantEvaluate(::HIR::Crate& crate, const ConstEvalOptions& options)
 {
-    Expander    exp { crate };
+    Expander    exp { crate, options };
     exp.visit_crate( crate );
+    exp.m_cache.dump_profile("Constant Evaluate");
 }
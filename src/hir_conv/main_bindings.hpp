@@ -6,8 +6,18 @@ namespace HIR {
     class Crate;
 };
 
+struct ConstEvalOptions
+{
+    /// Maximum number of interpreter steps for a single item (0 = unlimited, `-Z const-eval-limit=N`)
+    unsigned int    step_limit = 0;
+    /// Maximum nesting of const fn calls (0 = unlimited, `-Z const-eval-depth=N`)
+    unsigned int    call_depth_limit = 0;
+    /// Print the most expensive constants after evaluation
+    bool    profile = false;
+};
+
 extern void ConvertHIR_ExpandAliases(::HIR::Crate& crate);
 extern void ConvertHIR_Bind(::HIR::Crate& crate);
 extern void ConvertHIR_ResolveUFCS(::HIR::Crate& crate);
 extern void ConvertHIR_Markings(::HIR::Crate& crate);
-extern void ConvertHIR_ConstantEvaluate(::HIR::Crate& hir_crate);
+extern void ConvertHIR_ConstantEvaluate(::HIR::Crate& hir_crate, const ConstEvalOptions& options);
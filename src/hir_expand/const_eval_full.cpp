@@ -16,6 +16,7 @@
 #include <mir/mir.hpp>
 #include <hir_typeck/common.hpp>    // Monomorph
 #include <mir/helpers.hpp>
+#include <hir_conv/const_eval_cache.hpp>
 
 namespace {
     typedef ::std::vector< ::std::pair< ::std::string, ::HIR::Static> > t_new_values;
@@ -25,12 +26,14 @@ namespace {
         const ::HIR::ItemPath&  mod_path;
         ::std::string   name_prefix;
         unsigned int next_item_idx;
+        ConstEvalCache& cache;
 
-        NewvalState(t_new_values& newval_output, const ::HIR::ItemPath& mod_path, ::std::string prefix):
+        NewvalState(t_new_values& newval_output, const ::HIR::ItemPath& mod_path, ::std::string prefix, ConstEvalCache& cache):
             newval_output(newval_output),
             mod_path(mod_path),
             name_prefix(prefix),
-            next_item_idx(0)
+            next_item_idx(0),
+            cache(cache)
         {
         }
         NewvalState(const NewvalState&) = delete;
@@ -56,37 +59,31 @@ namespace {
 
     ::HIR::Literal clone_literal(const ::HIR::Literal& v)
     {
-        TU_MATCH(::HIR::Literal, (v), (e),
-        (Invalid,
-            return ::HIR::Literal();
-            ),
-        (List,
-            ::std::vector< ::HIR::Literal>  vals;
-            for(const auto& val : e) {
-                vals.push_back( clone_literal(val) );
-            }
-            return ::HIR::Literal( mv$(vals) );
-            ),
-        (Variant,
-            return ::HIR::Literal::make_Variant({ e.idx, box$(clone_literal(*e.val)) });
-            ),
-        (Integer,
-            return ::HIR::Literal(e);
-            ),
-        (Float,
-            return ::HIR::Literal(e);
-            ),
-        (BorrowPath,
-            return ::HIR::Literal(e.clone());
-            ),
-        (BorrowData,
-            return ::HIR::Literal(box$(clone_literal(*e)));
-            ),
-        (String,
-            return ::HIR::Literal(e);
-            )
-        )
-        throw "";
+        return v.clone();
+    }
+
+    /// Evaluate a const fn call (or a constant), re-using the result of an identical previous evaluation if possible
+    /// - `path` must be fully monomorphised, as it's used as the key
+    ::HIR::Literal evaluate_constant_cached(const Span& sp, const ::StaticTraitResolve& resolve, NewvalState& newval_state, const ::HIR::Path& path, const ::HIR::ExprPtr& expr, MonomorphState ms, ::std::vector< ::HIR::Literal> args)
+    {
+        if( const auto* rv = newval_state.cache.get(path, args) ) {
+            DEBUG("Memoised " << path << " = " << *rv);
+            return rv->clone();
+        }
+        ::std::vector< ::HIR::Literal>  saved_args;
+        saved_args.reserve( args.size() );
+        for(const auto& a : args)
+            saved_args.push_back( a.clone() );
+
+        auto n_statics = newval_state.newval_output.size();
+        newval_state.cache.enter_call(sp);
+        auto rv = evaluate_constant(sp, resolve, newval_state, FMT_CB(ss, ss << path;), expr, mv$(ms), mv$(args));
+        newval_state.cache.leave_call();
+        // Only pure evaluations can be memoised (new statics are named for the item being evaluated)
+        if( newval_state.newval_output.size() == n_statics ) {
+            newval_state.cache.insert(path, mv$(saved_args), rv);
+        }
+        return rv;
     }
 
     void monomorph_literal_inplace(const Span& sp, ::HIR::Literal& lit, const MonomorphState& ms)
@@ -115,6 +112,11 @@ namespace {
             monomorph_literal_inplace(sp, *e, ms);
             ),
         (String,
+            ),
+        (Repeat,
+            monomorph_literal_inplace(sp, *e.val, ms);
+            ),
+        (Buffer,
             )
         )
     }
@@ -310,85 +312,152 @@ namespace {
                 locals(locals)
             {}
 
-            ::HIR::Literal& get_lval(const ::MIR::LValue& lv)
+            ::HIR::Literal& get_root(const ::MIR::LValue& lv)
             {
-                TU_MATCHA( (lv), (e),
+                ::HIR::Literal* val_p = nullptr;
+                TU_MATCHA( (lv.m_root), (e),
                 (Return,
-                    return retval;
+                    val_p = &retval;
                     ),
                 (Local,
                     if( e >= locals.size() )
                         MIR_BUG(state, "Local index out of range - " << e << " >= " << locals.size());
-                    return locals[e];
+                    val_p = &locals[e];
                     ),
                 (Argument,
                     if( e.idx >= args.size() )
                         MIR_BUG(state, "Local index out of range - " << e.idx << " >= " << args.size());
-                    return args[e.idx];
+                    val_p = &args[e.idx];
                     ),
                 (Static,
-                    MIR_TODO(state, "LValue::Static - " << e);
-                    ),
-                (Field,
-                    auto& val = get_lval(*e.val);
-                    MIR_ASSERT(state, val.is_List(), "LValue::Field on non-list literal - " << val.tag_str() << " - " << lv);
-                    auto& vals = val.as_List();
-                    MIR_ASSERT(state, e.field_index < vals.size(), "LValue::Field index out of range");
-                    return vals[ e.field_index ];
+                    MIR_TODO(state, "LValue::Static - " << *e);
+                    )
+                )
+                MIR_ASSERT(state, val_p, "Unhandled root in " << lv);
+                return *val_p;
+            }
+            /// Entry index for a Field/Index wrapper applied to `val`
+            size_t get_entry_index(const ::HIR::Literal& val, const ::MIR::LValue::Wrapper& w, const ::MIR::LValue& lv)
+            {
+                size_t  idx_v;
+                if( w.is_Field() )
+                {
+                    MIR_ASSERT(state, val.is_array_like(), "LValue::Field on non-list literal - " << val.tag_str() << " - " << lv);
+                    idx_v = w.as_Field();
+                }
+                else
+                {
+                    MIR_ASSERT(state, val.is_array_like(), "LValue::Index on non-list literal - " << val.tag_str() << " - " << lv);
+                    MIR_ASSERT(state, w.as_Index() < locals.size(), "Local index out of range - " << w.as_Index() << " >= " << locals.size());
+                    auto& idx = locals[w.as_Index()];
+                    MIR_ASSERT(state, idx.is_Integer(), "LValue::Index with non-integer index literal - " << idx.tag_str() << " - " << lv);
+                    idx_v = static_cast<size_t>( idx.as_Integer() );
+                }
+                MIR_ASSERT(state, idx_v < val.list_size(), "LValue::" << (w.is_Field() ? "Field" : "Index") << " index out of range - " << idx_v << " >= " << val.list_size());
+                return idx_v;
+            }
+            void check_deref(const ::HIR::Literal& val, const ::MIR::LValue& lv)
+            {
+                TU_MATCH_DEF( ::HIR::Literal, (val), (ve),
+                (
+                    MIR_TODO(state, "LValue::Deref - " << lv << " { " << val << " }");
                     ),
-                (Deref,
-                    auto& val = get_lval(*e.val);
-                    TU_MATCH_DEF( ::HIR::Literal, (val), (ve),
-                    (
-                        MIR_TODO(state, "LValue::Deref - " << lv << " { " << val << " }");
-                        ),
-                    (String,
-                        // Just clone the string (hack)
-                        // - TODO: Create a list?
-                        return val;
-                        )
+                (String,
+                    // Just clone the string (hack)
+                    // - TODO: Create a list?
                     )
+                )
+            }
+
+            /// Obtain a lvalue for writing
+            ::HIR::Literal& get_lval(const ::MIR::LValue& lv)
+            {
+                ::HIR::Literal* val_p = &get_root(lv);
+                for(const auto& w : lv.m_wrappers)
+                {
+                    auto& val = *val_p;
+                    switch(w.tag())
+                    {
+                    case ::MIR::LValue::Wrapper::TAG_Field:
+                    case ::MIR::LValue::Wrapper::TAG_Index: {
+                        auto idx_v = get_entry_index(val, w, lv);
+                        // NOTE: Compact array forms are expanded, as the entry may be written
+                        val_p = &val.expand_list()[idx_v];
+                        } break;
+                    case ::MIR::LValue::Wrapper::TAG_Deref:
+                        check_deref(val, lv);
+                        break;
+                    case ::MIR::LValue::Wrapper::TAG_Downcast:
+                        MIR_TODO(state, "LValue::Downcast - " << lv);
+                    }
+                }
+                return *val_p;
+            }
+            /// Read the value of a lvalue (moving out of it, unless it's within a shared value)
+            /// - Entries of Repeat/Buffer arrays are read in place, leaving the compact form intact
+            ::HIR::Literal read_lval(const ::MIR::LValue& lv)
+            {
+                ::HIR::Literal* val_p = &get_root(lv);
+                // Set once the value is within a Repeat (the entry is shared, so can't be moved out)
+                bool is_shared = false;
+                for(size_t i = 0; i < lv.m_wrappers.size(); i ++)
+                {
+                    const auto& w = lv.m_wrappers[i];
+                    auto& val = *val_p;
+                    switch(w.tag())
+                    {
+                    case ::MIR::LValue::Wrapper::TAG_Field:
+                    case ::MIR::LValue::Wrapper::TAG_Index: {
+                        auto idx_v = get_entry_index(val, w, lv);
+                        TU_MATCH_DEF( ::HIR::Literal, (val), (ve),
+                        (
+                            MIR_BUG(state, "Array-like literal with unexpected form - " << val.tag_str());
+                            ),
+                        (List,
+                            val_p = &ve[idx_v];
+                            ),
+                        (Repeat,
+                            val_p = &*ve.val;
+                            is_shared = true;
+                            ),
+                        (Buffer,
+                            // Entries are integers, nothing can be within them
+                            MIR_ASSERT(state, i + 1 == lv.m_wrappers.size(), "Wrapper applied to integer entry of a buffer - " << lv);
+                            return val.list_get(idx_v);
+                            )
+                        )
+                        } break;
+                    case ::MIR::LValue::Wrapper::TAG_Deref:
+                        check_deref(val, lv);
+                        break;
+                    case ::MIR::LValue::Wrapper::TAG_Downcast:
+                        MIR_TODO(state, "LValue::Downcast - " << lv);
+                    }
+                }
+                auto& v = *val_p;
+                TU_MATCH_DEF(::HIR::Literal, (v), (e),
+                (
+                    return is_shared ? v.clone() : mv$(v);
                     ),
-                (Index,
-                    auto& val = get_lval(*e.val);
-                    MIR_ASSERT(state, val.is_List(), "LValue::Index on non-list literal - " << val.tag_str() << " - " << lv);
-                    auto& idx = get_lval(*e.idx);
-                    MIR_ASSERT(state, idx.is_Integer(), "LValue::Index with non-integer index literal - " << idx.tag_str() << " - " << lv);
-                    auto& vals = val.as_List();
-                    auto idx_v = static_cast<size_t>( idx.as_Integer() );
-                    MIR_ASSERT(state, idx_v < vals.size(), "LValue::Index index out of range");
-                    return vals[ idx_v ];
+                (Invalid,
+                    MIR_BUG(state, "Read of lvalue with Literal::Invalid - " << lv);
+                    ),
+                (BorrowPath,
+                    return ::HIR::Literal(e.clone());
+                    ),
+                (Integer,
+                    return ::HIR::Literal(e);
                     ),
-                (Downcast,
-                    MIR_TODO(state, "LValue::Downcast - " << lv);
+                (Float,
+                    return ::HIR::Literal(e);
                     )
                 )
-                throw "";
             }
         };
         LocalState  local_state( state, retval, args, locals );
 
         auto get_lval = [&](const ::MIR::LValue& lv) -> ::HIR::Literal& { return local_state.get_lval(lv); };
-        auto read_lval = [&](const ::MIR::LValue& lv) -> ::HIR::Literal {
-            auto& v = get_lval(lv);
-            TU_MATCH_DEF(::HIR::Literal, (v), (e),
-            (
-                return mv$(v);
-                ),
-            (Invalid,
-                BUG(sp, "Read of lvalue with Literal::Invalid - " << lv);
-                ),
-            (BorrowPath,
-                return ::HIR::Literal(e.clone());
-                ),
-            (Integer,
-                return ::HIR::Literal(e);
-                ),
-            (Float,
-                return ::HIR::Literal(e);
-                )
-            )
-            };
+        auto read_lval = [&](const ::MIR::LValue& lv) -> ::HIR::Literal { return local_state.read_lval(lv); };
         auto const_to_lit = [&](const ::MIR::Constant& c)->::HIR::Literal {
             TU_MATCH(::MIR::Constant, (c), (e2),
             (Int,
@@ -420,7 +489,7 @@ namespace {
                 //   effectively the same thing.
                 // Avoids _BorrowData leftovers.
                 if( c.m_value ) {
-                    return evaluate_constant(sp, resolve, newval_state, FMT_CB(ss, ss << e2.p;), ent.as_Constant()->m_value, {}, {});
+                    return evaluate_constant_cached(sp, resolve, newval_state, e2.p, ent.as_Constant()->m_value, {}, {});
                 }
                 else {
                     auto val = clone_literal( ent.as_Constant()->m_value_res );
@@ -456,6 +525,7 @@ namespace {
             for(const auto& stmt : block.statements)
             {
                 state.set_cur_stmt(cur_block, next_stmt_idx++);
+                newval_state.cache.step(sp);
 
                 if( ! stmt.is_Assign() ) {
                     //BUG(sp, "Non-assign statement - drop " << stmt.as_Drop().slot);
@@ -473,29 +543,23 @@ namespace {
                     val = const_to_lit(e);
                     ),
                 (SizedArray,
-                    ::std::vector< ::HIR::Literal>  vals;
                     if( e.count > 0 )
-                    {
-                        vals.reserve( e.count );
-                        val = read_param(e.val);
-                        for(unsigned int i = 1; i < e.count; i++)
-                            vals.push_back( clone_literal(val) );
-                        vals.push_back( mv$(val) );
-                    }
-                    val = ::HIR::Literal::make_List( mv$(vals) );
+                        val = ::HIR::Literal::new_repeat( read_param(e.val), e.count );
+                    else
+                        val = ::HIR::Literal::make_List({});
                     ),
                 (Borrow,
                     if( e.type != ::HIR::BorrowType::Shared ) {
                         MIR_BUG(state, "Only shared borrows are allowed in constants");
                     }
-                    if( const auto* p = e.val.opt_Deref() ) {
-                        if( p->val->is_Deref() )
-                            MIR_TODO(state, "Undo nested deref coercion - " << *p->val);
-                        val = read_lval(*p->val);
+                    if( e.val.is_Deref() ) {
+                        if( e.val.inner_ref().is_Deref() )
+                            MIR_TODO(state, "Undo nested deref coercion - " << e.val.inner_ref());
+                        val = read_lval(e.val.clone_unwrapped());
                     }
-                    else if( const auto* p = e.val.opt_Static() ) {
+                    else if( e.val.is_Static() ) {
                         // Borrow of a static, emit BorrowPath with the same path
-                        val = ::HIR::Literal::make_BorrowPath( p->clone() );
+                        val = ::HIR::Literal::make_BorrowPath( e.val.as_Static().clone() );
                     }
                     else {
                         auto inner_val = read_lval(e.val);
@@ -715,7 +779,12 @@ namespace {
                     vals.reserve( e.vals.size() );
                     for(const auto& v : e.vals)
                         vals.push_back( read_param(v) );
-                    val = ::HIR::Literal::make_List( mv$(vals) );
+                    // Only direct assignments to locals have a known element type (needed to pack into a Buffer)
+                    const auto* ty = (sa.dst.is_Local() ? &fcn.locals[sa.dst.as_Local()] : nullptr);
+                    if( ty && ty->m_data.is_Array() )
+                        val = ::HIR::Literal::new_array( mv$(vals), *ty->m_data.as_Array().inner );
+                    else
+                        val = ::HIR::Literal::make_List( mv$(vals) );
                     ),
                 (Variant,
                     auto ival = read_param(e.val);
@@ -735,6 +804,7 @@ namespace {
                 dst = mv$(val);
             }
             state.set_cur_stmt_term(cur_block);
+            newval_state.cache.step(sp);
             DEBUG("> " << block.terminator);
             TU_MATCH_DEF( ::MIR::Terminator, (block.terminator), (e),
             (
@@ -765,7 +835,7 @@ namespace {
                 // Call by invoking evaluate_constant on the function
                 {
                     TRACE_FUNCTION_F("Call const fn " << fcnp << " args={ " << call_args << " }");
-                    dst = evaluate_constant(sp, resolve, newval_state, FMT_CB(ss, ss << fcnp;),  fcn.m_code, mv$(fcn_ms), mv$(call_args));
+                    dst = evaluate_constant_cached(sp, resolve, newval_state, fcnp, fcn.m_code, mv$(fcn_ms), mv$(call_args));
                 }
 
                 DEBUG("= " << dst);
@@ -808,7 +878,9 @@ namespace {
             // List
             ),
         (Array,
-            // List
+            // List - integer arrays built where the element type wasn't known are packed here
+            if( lit.is_List() )
+                lit = ::HIR::Literal::new_array( mv$(lit.as_List()), *te.inner );
             ),
         (Tuple,
             // List
@@ -863,9 +935,12 @@ namespace {
         t_new_values    m_new_values;
 
     public:
-        Expander(const ::HIR::Crate& crate):
+        ConstEvalCache  m_cache;
+
+        Expander(const ::HIR::Crate& crate, const ConstEvalOptions& options):
             m_crate(crate),
-            m_resolve(crate)
+            m_resolve(crate),
+            m_cache(options)
         {}
 
         void visit_module(::HIR::ItemPath p, ::HIR::Module& mod) override
@@ -906,8 +981,10 @@ namespace {
             visit_type(item.m_type);
             if( item.m_value )
             {
-                auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$") };
+                auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$"), m_cache };
+                m_cache.start_item(FMT(p));
                 item.m_value_res = evaluate_constant(item.m_value->span(), m_resolve, nvs, FMT_CB(ss, ss << p;), item.m_value, {}, {});
+                m_cache.end_item();
 
                 check_lit_type(item.m_value->span(), item.m_type, item.m_value_res);
                 DEBUG("constant: " << item.m_type <<  " = " << item.m_value_res);
@@ -919,8 +996,11 @@ namespace {
             visit_type(item.m_type);
             if( item.m_value )
             {
-                auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$") };
+                auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$"), m_cache };
+                m_cache.start_item(FMT(p));
                 item.m_value_res = evaluate_constant(item.m_value->span(), m_resolve, nvs, FMT_CB(ss, ss << p;), item.m_value, {}, {});
+                m_cache.end_item();
+                check_lit_type(item.m_value->span(), item.m_type, item.m_value_res);
                 DEBUG("static: " << item.m_type <<  " = " << item.m_value_res);
                 visit_expr(item.m_value);
             }
@@ -932,8 +1012,10 @@ namespace {
                 {
                     if( var.expr )
                     {
-                        auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$" << var.name << "$") };
+                        auto nvs = NewvalState { m_new_values, *m_mod_path, FMT(p.get_name() << "$" << var.name << "$"), m_cache };
+                        m_cache.start_item(FMT(p << "::" << var.name));
                         auto val = evaluate_constant(var.expr->span(), m_resolve, nvs, FMT_CB(ss, ss << p;), var.expr, {}, {});
+                        m_cache.end_item();
                         DEBUG("Enum value " << p << " - " << var.name << " = " << val);
                         // TODO: Save this value? Or just do the above to
                         // validate?
@@ -945,8 +1027,9 @@ namespace {
     };
 }   // namespace
 
-void ConvertHIR_ConstantEvaluateFull(::HIR::Crate& crate)
+void ConvertHIR_ConstantEvaluateFull(::HIR::Crate& crate, const ConstEvalOptions& options)
 {
-    Expander    exp { crate };
+    Expander    exp { crate, options };
     exp.visit_crate( crate );
+    exp.m_cache.dump_profile("Constant Evaluate Full");
 }
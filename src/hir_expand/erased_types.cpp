@@ -10,6 +10,7 @@
 #include <hir_typeck/static.hpp>
 #include <algorithm>
 #include "main_bindings.hpp"
+#include "operations.hpp"
 
 const ::HIR::Function& HIR_Expand_ErasedType_GetFunction(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::Path& origin_path, t_cb_generic& monomorph_cb, ::HIR::PathParams& impl_params)
 {
@@ -134,14 +135,17 @@ namespace {
     {
         StaticTraitResolve  m_resolve;
         const ::HIR::ItemPath* m_fcn_path = nullptr;
+        // If false, only types outside of expressions are expanded
+        bool    m_expand_bodies;
     public:
-        OuterVisitor(const ::HIR::Crate& crate):
-            m_resolve(crate)
+        OuterVisitor(const ::HIR::Crate& crate, bool expand_bodies):
+            m_resolve(crate),
+            m_expand_bodies(expand_bodies)
         {}
 
         void visit_expr(::HIR::ExprPtr& exp) override
         {
-            if( exp )
+            if( exp && m_expand_bodies )
             {
                 ExprVisitor_Extract    ev(m_resolve);
                 ev.visit_root( exp );
@@ -157,47 +161,8 @@ namespace {
 
         void visit_type(::HIR::TypeRef& ty) override
         {
-            static const Span   sp;
-            if( ty.m_data.is_ErasedType() )
+            if( ty.m_data.is_ErasedType() && HIR_Expand_ErasedType_Type(m_resolve, m_fcn_path, ty) )
             {
-                //ASSERT_BUG(sp, m_fcn_path, "Erased type outside of a function - " << ty);
-
-                const auto& e = ty.m_data.as_ErasedType();
-
-                TU_MATCHA( (e.m_origin.m_data), (pe),
-                (Generic,
-                    if( m_fcn_path && *m_fcn_path == pe.m_path ) {
-                        ::HIR::Visitor::visit_type(ty);
-                        return ;
-                    }
-                    ),
-                (UfcsUnknown,
-                    BUG(sp, "UfcsUnknown unexpected");
-                    ),
-                (UfcsKnown,
-                    BUG(sp, "UfcsKnown not supported");
-                    ),
-                (UfcsInherent,
-                    if( m_fcn_path && m_fcn_path->parent && m_fcn_path->parent->ty && !m_fcn_path->parent->trait && *m_fcn_path->parent->ty == *pe.type && m_fcn_path->name == pe.item ) {
-                        ::HIR::Visitor::visit_type(ty);
-                        return ;
-                    }
-                    )
-                )
-
-                TRACE_FUNCTION_FR(ty, ty);
-
-                ::HIR::PathParams   impl_params;
-                t_cb_generic    monomorph_cb;
-                const auto& fcn = HIR_Expand_ErasedType_GetFunction(sp, m_resolve, e.m_origin, monomorph_cb, impl_params);
-                const auto& erased_types = fcn.m_code.m_erased_types;
-
-                ASSERT_BUG(sp, e.m_index < erased_types.size(), "Erased type index out of range for " << e.m_origin << " - " << e.m_index << " >= " << erased_types.size());
-                const auto& tpl = erased_types[e.m_index];
-
-                auto new_ty = monomorphise_type_with(sp, tpl, monomorph_cb);
-                DEBUG("> " << ty << " => " << new_ty);
-                ty = mv$(new_ty);
                 // Recurse (TODO: Cleanly prevent infinite recursion - TRACE_FUNCTION does crude prevention)
                 visit_type(ty);
             }
@@ -209,9 +174,65 @@ namespace {
     };
 }
 
+bool HIR_Expand_ErasedType_Type(const StaticTraitResolve& resolve, const ::HIR::ItemPath* fcn_path, ::HIR::TypeRef& ty)
+{
+    static const Span   sp;
+    //ASSERT_BUG(sp, fcn_path, "Erased type outside of a function - " << ty);
+
+    const auto& e = ty.m_data.as_ErasedType();
+
+    TU_MATCHA( (e.m_origin.m_data), (pe),
+    (Generic,
+        if( fcn_path && *fcn_path == pe.m_path ) {
+            return false;
+        }
+        ),
+    (UfcsUnknown,
+        BUG(sp, "UfcsUnknown unexpected");
+        ),
+    (UfcsKnown,
+        BUG(sp, "UfcsKnown not supported");
+        ),
+    (UfcsInherent,
+        if( fcn_path && fcn_path->parent && fcn_path->parent->ty && !fcn_path->parent->trait && *fcn_path->parent->ty == *pe.type && fcn_path->name == pe.item ) {
+            return false;
+        }
+        )
+    )
+
+    TRACE_FUNCTION_FR(ty, ty);
+
+    ::HIR::PathParams   impl_params;
+    t_cb_generic    monomorph_cb;
+    const auto& fcn = HIR_Expand_ErasedType_GetFunction(sp, resolve, e.m_origin, monomorph_cb, impl_params);
+    const auto& erased_types = fcn.m_code.m_erased_types;
+
+    ASSERT_BUG(sp, e.m_index < erased_types.size(), "Erased type index out of range for " << e.m_origin << " - " << e.m_index << " >= " << erased_types.size());
+    const auto& tpl = erased_types[e.m_index];
+
+    auto new_ty = monomorphise_type_with(sp, tpl, monomorph_cb);
+    DEBUG("> " << ty << " => " << new_ty);
+    ty = mv$(new_ty);
+    return true;
+}
+
+void HIR_Expand_ErasedType_Expr(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp)
+{
+    if( exp )
+    {
+        ExprVisitor_Extract    ev(resolve);
+        ev.visit_root( exp );
+    }
+}
+
 void HIR_Expand_ErasedType(::HIR::Crate& crate)
 {
-    OuterVisitor    ov(crate);
+    OuterVisitor    ov(crate, true);
+    ov.visit_crate( crate );
+}
+void HIR_Expand_ErasedType_Items(::HIR::Crate& crate)
+{
+    OuterVisitor    ov(crate, false);
     ov.visit_crate( crate );
 }
 
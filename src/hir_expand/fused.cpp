@@ -0,0 +1,190 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir_expand/fused.cpp
+ * - Item-at-a-time driver for the per-expression expansion passes
+ *
+ * Runs UfcsEverything, Reborrows, ErasedType, expression validation and MIR lowering on each body in turn, instead
+ * of walking the crate once for each pass. The crate-structural passes (AnnotateUsage, Closures, VTables) must have
+ * already run.
+ *
+ * `impl Trait` types outside of bodies (e.g. in the fields of closure structs) are replaced by a separate crate-wide
+ * walk first, so every body is lowered with the same types as in the unfused pipeline.
+ */
+#include <hir/visitor.hpp>
+#include <hir/expr.hpp>
+#include <hir_typeck/static.hpp>
+#include <hir_typeck/main_bindings.hpp>
+#include <mir/operations.hpp>
+#include "main_bindings.hpp"
+#include "operations.hpp"
+
+namespace {
+    class OuterVisitor:
+        public ::HIR::Visitor
+    {
+        StaticTraitResolve  m_resolve;
+        bool    m_generate_mir;
+    public:
+        OuterVisitor(const ::HIR::Crate& crate, bool generate_mir):
+            m_resolve(crate),
+            m_generate_mir(generate_mir)
+        {}
+
+        /// Run the expansion passes and validation on one body
+        void expand_body(::HIR::ExprPtr& exp, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type)
+        {
+            const auto& crate = m_resolve.m_crate;
+            HIR_Expand_UfcsEverything_Expr(crate, exp);
+            HIR_Expand_Reborrows_Expr(crate, exp);
+            HIR_Expand_ErasedType_Expr(m_resolve, exp);
+            Typecheck_Expressions_ValidateOne(m_resolve, args, ret_type, exp);
+        }
+        void lower_body(const ::HIR::ItemPath& ip, ::HIR::ExprPtr& exp, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type)
+        {
+            if( m_generate_mir )
+            {
+                exp.m_mir = LowerMIR(m_resolve, ip, exp, ret_type, args);
+            }
+        }
+
+        // NOTE: This is left here to ensure that any expressions that aren't handled by higher code cause a failure
+        void visit_expr(::HIR::ExprPtr& exp) override {
+            BUG(Span(), "visit_expr hit in OuterVisitor");
+        }
+
+        void visit_type(::HIR::TypeRef& ty) override
+        {
+            if( ty.m_data.is_Array() )
+            {
+                auto& e = ty.m_data.as_Array();
+                this->visit_type( *e.inner );
+                DEBUG("Array size " << ty);
+                if( e.size ) {
+                    auto ty_usize = ::HIR::TypeRef(::HIR::CoreType::Usize);
+                    expand_body(*e.size, {}, ty_usize);
+                    lower_body(::HIR::ItemPath(""), *e.size, {}, ty_usize);
+                }
+            }
+            else
+            {
+                ::HIR::Visitor::visit_type(ty);
+            }
+        }
+
+        // ------
+        // Code-containing items
+        // ------
+        void visit_function(::HIR::ItemPath p, ::HIR::Function& item) override {
+            auto _ = this->m_resolve.set_item_generics(item.m_params);
+
+            // Signature (same as ::HIR::Visitor::visit_function, minus the body)
+            this->visit_params(item.m_params);
+            for(auto& arg : item.m_args)
+            {
+                this->visit_pattern(arg.first);
+                this->visit_type(arg.second);
+            }
+            this->visit_type(item.m_return);
+
+            if( item.m_code )
+            {
+                DEBUG("Function code " << p);
+                expand_body(item.m_code, item.m_args, item.m_return);
+                if( m_generate_mir )
+                {
+                    // TODO: Get span without needing hir/expr.hpp
+                    static Span sp;
+                    // Replace ErasedType instances in the return type (now that the body's erased types are expanded)
+                    auto ret_type_v = clone_ty_with(sp, item.m_return, [&](const auto& tpl, auto& rv) {
+                        if( tpl.m_data.is_ErasedType() )
+                        {
+                            const auto& e = tpl.m_data.as_ErasedType();
+                            assert(e.m_index < item.m_code.m_erased_types.size());
+                            rv = item.m_code.m_erased_types[e.m_index].clone();
+                            return true;
+                        }
+                        return false;
+                        });
+                    this->m_resolve.expand_associated_types(sp, ret_type_v);
+                    lower_body(p, item.m_code, item.m_args, ret_type_v);
+                }
+            }
+            else
+            {
+                DEBUG("Function code " << p << " (none)");
+            }
+        }
+        void visit_static(::HIR::ItemPath p, ::HIR::Static& item) override {
+            this->visit_type(item.m_type);
+            if( item.m_value )
+            {
+                DEBUG("`static` value " << p);
+                expand_body(item.m_value, {}, item.m_type);
+                lower_body(p, item.m_value, {}, item.m_type);
+            }
+        }
+        void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
+            this->visit_params(item.m_params);
+            this->visit_type(item.m_type);
+            if( item.m_value )
+            {
+                DEBUG("`const` value " << p);
+                expand_body(item.m_value, {}, item.m_type);
+                lower_body(p, item.m_value, {}, item.m_type);
+            }
+        }
+        void visit_enum(::HIR::ItemPath p, ::HIR::Enum& item) override {
+            auto _ = this->m_resolve.set_item_generics(item.m_params);
+            this->visit_params(item.m_params);
+            TU_MATCHA( (item.m_data), (e),
+            (Value,
+                // TODO: Use a different type depding on repr()
+                auto enum_type = ::HIR::TypeRef(::HIR::CoreType::Isize);
+                for(auto& var : e.variants)
+                {
+                    DEBUG("Enum value " << p << " - " << var.name);
+                    if( var.expr )
+                    {
+                        expand_body(var.expr, {}, enum_type);
+                        lower_body(p + var.name, var.expr, {}, enum_type);
+                    }
+                }
+                ),
+            (Data,
+                for(auto& var : e)
+                {
+                    this->visit_type(var.type);
+                }
+                )
+            )
+        }
+
+        void visit_trait(::HIR::ItemPath p, ::HIR::Trait& item) override
+        {
+            auto _ = this->m_resolve.set_impl_generics(item.m_params);
+            ::HIR::Visitor::visit_trait(p, item);
+        }
+        void visit_type_impl(::HIR::TypeImpl& impl) override
+        {
+            TRACE_FUNCTION_F("impl " << impl.m_type);
+            auto _ = this->m_resolve.set_impl_generics(impl.m_params);
+            ::HIR::Visitor::visit_type_impl(impl);
+        }
+        void visit_trait_impl(const ::HIR::SimplePath& trait_path, ::HIR::TraitImpl& impl) override
+        {
+            TRACE_FUNCTION_F("impl" << impl.m_params.fmt_args() << " " << trait_path << " for " << impl.m_type);
+            auto _ = this->m_resolve.set_impl_generics(impl.m_params);
+            ::HIR::Visitor::visit_trait_impl(trait_path, impl);
+        }
+    };
+}
+
+void HIR_Expand_Fused(::HIR::Crate& crate, bool generate_mir)
+{
+    HIR_Expand_ErasedType_Items(crate);
+
+    OuterVisitor    ov(crate, generate_mir);
+    ov.visit_crate( crate );
+}
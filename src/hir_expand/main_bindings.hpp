@@ -10,6 +10,7 @@
 namespace HIR {
     class Crate;
 };
+struct ConstEvalOptions;
 
 extern void HIR_Expand_AnnotateUsage(::HIR::Crate& crate);
 extern void HIR_Expand_VTables(::HIR::Crate& crate);
@@ -17,4 +18,6 @@ extern void HIR_Expand_Closures(::HIR::Crate& crate);
 extern void HIR_Expand_UfcsEverything(::HIR::Crate& crate);
 extern void HIR_Expand_Reborrows(::HIR::Crate& crate);
 extern void HIR_Expand_ErasedType(::HIR::Crate& crate);
-extern void ConvertHIR_ConstantEvaluateFull(::HIR::Crate& crate);
+/// Run UfcsEverything, Reborrows, ErasedType, validation and (optionally) MIR lowering one item at a time
+extern void HIR_Expand_Fused(::HIR::Crate& crate, bool generate_mir);
+extern void ConvertHIR_ConstantEvaluateFull(::HIR::Crate& crate, const ConstEvalOptions& options);
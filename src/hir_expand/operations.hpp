@@ -0,0 +1,21 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir_expand/operations.hpp
+ * - Per-expression entry points for the expansion passes (used by the fused driver in `fused.cpp`)
+ */
+#pragma once
+#include <hir_typeck/static.hpp>
+#include <hir/item_path.hpp>
+
+// Expand method calls/operators into `_CallPath` (see ufcs_everything.cpp)
+extern void HIR_Expand_UfcsEverything_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& exp);
+// Insert reborrows for moved `&mut` values
+extern void HIR_Expand_Reborrows_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& exp);
+// Replace `impl Trait` types within an expression
+extern void HIR_Expand_ErasedType_Expr(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp);
+// Replace `impl Trait` types outside of expressions (item signatures, struct fields, ...)
+extern void HIR_Expand_ErasedType_Items(::HIR::Crate& crate);
+// Replace a single `impl Trait` type (outside an expression), returns false if it's the return type of `fcn_path` (which is left in place)
+extern bool HIR_Expand_ErasedType_Type(const StaticTraitResolve& resolve, const ::HIR::ItemPath* fcn_path, ::HIR::TypeRef& ty);
@@ -10,6 +10,7 @@
 #include <hir_typeck/static.hpp>
 #include <algorithm>
 #include "main_bindings.hpp"
+#include "operations.hpp"
 
 namespace {
     inline HIR::ExprNodeP mk_exprnodep(HIR::ExprNode* en, ::HIR::TypeRef ty){ en->m_res_type = mv$(ty); return HIR::ExprNodeP(en); }
@@ -231,3 +232,8 @@ void HIR_Expand_Reborrows(::HIR::Crate& crate)
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
 }
+void HIR_Expand_Reborrows_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& exp)
+{
+    ExprVisitor_Mutate  ev(crate);
+    ev.visit_node_ptr( exp );
+}
@@ -1215,4 +1215,8 @@ void Typecheck_Expressions_Validate(::HIR::Crate& crate)
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
 }
-
+void Typecheck_Expressions_ValidateOne(const StaticTraitResolve& resolve, const t_args& args, const ::HIR::TypeRef& ret_type, ::HIR::ExprPtr& expr)
+{
+    ExprVisitor_Validate    ev(resolve, args, ret_type);
+    ev.visit_root(expr);
+}
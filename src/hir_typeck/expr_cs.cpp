@@ -394,7 +394,7 @@ namespace {
         const ::HIR::TypeImpl* impl_ptr = nullptr;
         // Detect multiple applicable methods and get the caller to try again later if there are multiple
         unsigned int count = 0;
-        context.m_crate.find_type_impls(*e.type, context.m_ivars.callback_resolve_infer(),
+        context.m_crate.find_type_impls_with_method(e.item, *e.type, context.m_ivars.callback_resolve_infer(),
             [&](const auto& impl) {
                 DEBUG("- impl" << impl.m_params.fmt_args() << " " << impl.m_type);
                 auto it = impl.m_methods.find(e.item);
@@ -3895,6 +3895,7 @@ bool TraitResolution::find_method(const Span& sp,
     DEBUG("> Inherent methods");
     {
         const ::HIR::TypeRef*   cur_check_ty = &ty;
+        // NOTE: `find_type_impls_with_method` only visits impls that contain `method_name`
         auto find_type_impls_cb = [&](const auto& impl) {
             // TODO: Should this take into account the actual suitability of this method? Or just that the name exists?
             // - If this impl matches fuzzily, it may not actually match
@@ -3914,17 +3915,17 @@ bool TraitResolution::find_method(const Span& sp,
             DEBUG("[find_method] Method was present in `impl" << impl.m_params.fmt_args() << " " << impl.m_type << "` but receiver mismatched");
             return false;
             };
-        if( m_crate.find_type_impls(ty, m_ivars.callback_resolve_infer(), find_type_impls_cb) )
+        if( m_crate.find_type_impls_with_method(method_name, ty, m_ivars.callback_resolve_infer(), find_type_impls_cb) )
         {
             rv = true;
         }
         cur_check_ty = (ty.m_data.is_Borrow() ? &*ty.m_data.as_Borrow().inner : nullptr);
-        if( cur_check_ty && m_crate.find_type_impls(*cur_check_ty, m_ivars.callback_resolve_infer(), find_type_impls_cb) )
+        if( cur_check_ty && m_crate.find_type_impls_with_method(method_name, *cur_check_ty, m_ivars.callback_resolve_infer(), find_type_impls_cb) )
         {
             rv = true;
         }
         cur_check_ty = this->type_is_owned_box(sp, ty);
-        if( cur_check_ty && m_crate.find_type_impls(*cur_check_ty, m_ivars.callback_resolve_infer(), find_type_impls_cb) )
+        if( cur_check_ty && m_crate.find_type_impls_with_method(method_name, *cur_check_ty, m_ivars.callback_resolve_infer(), find_type_impls_cb) )
         {
             rv = true;
         }
@@ -3937,10 +3938,21 @@ bool TraitResolution::find_method(const Span& sp,
         if( trait_ref.first == nullptr )
             break;
 
-        ::HIR::GenericPath final_trait_path;
-        ::HIR::Function::Receiver   receiver;
-        if( !this->trait_contains_method(sp, *trait_ref.first, *trait_ref.second, ::HIR::TypeRef("Self", 0xFFFF), method_name,  receiver, final_trait_path) )
+        // The result only depends on the trait and the name, so is cached (this runs for every in-scope trait on
+        // every method call, on each typecheck pass)
+        auto cache_key = ::std::make_pair(trait_ref.second, method_name);
+        auto cache_it = m_crate.m_trait_method_cache.find(cache_key);
+        if( cache_it == m_crate.m_trait_method_cache.end() )
+        {
+            ::HIR::Crate::TraitMethodEnt    ent;
+            ent.receiver = ::HIR::Function::Receiver::Free;
+            ent.found = this->trait_contains_method(sp, *trait_ref.first, *trait_ref.second, ::HIR::TypeRef("Self", 0xFFFF), method_name,  ent.receiver, ent.trait_path);
+            cache_it = m_crate.m_trait_method_cache.insert( ::std::make_pair(mv$(cache_key), mv$(ent)) ).first;
+        }
+        if( !cache_it->second.found )
             continue ;
+        const auto& final_trait_path = cache_it->second.trait_path;
+        auto receiver = cache_it->second.receiver;
         DEBUG("- Found trait " << final_trait_path);
 
         if( const auto* self_ty_p = check_method_receiver(sp, receiver, ty, access) )
@@ -2,10 +2,18 @@
  */
 #pragma once
 
+#include <vector>
+
 namespace HIR {
     class Crate;
+    class TypeRef;
+    class ExprPtr;
+    struct Pattern;
 };
+class StaticTraitResolve;
 
 extern void Typecheck_ModuleLevel(::HIR::Crate& crate);
 extern void Typecheck_Expressions(::HIR::Crate& crate);
 extern void Typecheck_Expressions_Validate(::HIR::Crate& crate);
+/// Validate a single expression tree (as done by `Typecheck_Expressions_Validate`), generics must be set in `resolve`
+extern void Typecheck_Expressions_ValidateOne(const StaticTraitResolve& resolve, const ::std::vector< ::std::pair< ::HIR::Pattern, ::HIR::TypeRef> >& args, const ::HIR::TypeRef& ret_type, ::HIR::ExprPtr& expr);
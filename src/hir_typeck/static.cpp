@@ -8,6 +8,119 @@
 #include "static.hpp"
 #include <algorithm>
 
+TypePropertyCache& TypePropertyCache::for_crate(const ::HIR::Crate& crate)
+{
+    static ::std::mutex s_lock;
+    static ::std::map<const ::HIR::Crate*, ::std::unique_ptr<TypePropertyCache>>  s_caches;
+    ::std::lock_guard< ::std::mutex>    lh(s_lock);
+    auto& rv = s_caches[&crate];
+    if( !rv )
+        rv.reset(new TypePropertyCache());
+    return *rv;
+}
+bool TypePropertyCache::is_cacheable(const ::HIR::TypeRef& ty)
+{
+    // Primitives, pointers, etc are cheap enough to not bother
+    switch(ty.m_data.tag())
+    {
+    case ::HIR::TypeRef::Data::TAG_Path:
+    case ::HIR::TypeRef::Data::TAG_Tuple:
+    case ::HIR::TypeRef::Data::TAG_Array:
+        break;
+    default:
+        return false;
+    }
+    // Anything that depends on the generic context (or hasn't been fully resolved yet) can't be shared
+    return !visit_ty_with(ty, [](const ::HIR::TypeRef& t) {
+        TU_MATCH_DEF(::HIR::TypeRef::Data, (t.m_data), (te),
+        (
+            return false;
+            ),
+        (Generic, return true; ),
+        (Infer, return true; ),
+        (ErasedType, return true; ),
+        (Closure, return true; ),   // Closure types are replaced by structs during expansion
+        (Path,
+            return !te.path.m_data.is_Generic() || te.binding.is_Unbound();
+            )
+        )
+        });
+}
+TypePropertyCache::Props& TypePropertyCache::get_entry(const ::HIR::TypeRef& ty)
+{
+    auto it = m_entries.find(ty);
+    if( it == m_entries.end() )
+        it = m_entries.insert( ::std::make_pair(ty.clone(), Props()) ).first;
+    return it->second;
+}
+int TypePropertyCache::get_flag(const ::HIR::TypeRef& ty, Flag flag)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto it = m_entries.find(ty);
+    if( it == m_entries.end() )
+        return -1;
+    return it->second.flags[static_cast<int>(flag)];
+}
+void TypePropertyCache::set_flag(const ::HIR::TypeRef& ty, Flag flag, bool value)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    get_entry(ty).flags[static_cast<int>(flag)] = value ? 1 : 0;
+}
+bool TypePropertyCache::get_layout(const ::HIR::TypeRef& ty, bool& out_valid, size_t& out_size, size_t& out_align)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto it = m_entries.find(ty);
+    if( it == m_entries.end() || !it->second.layout_known )
+        return false;
+    out_valid = it->second.layout_valid;
+    out_size = it->second.size;
+    out_align = it->second.align;
+    return true;
+}
+void TypePropertyCache::set_layout(const ::HIR::TypeRef& ty, bool valid, size_t size, size_t align)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto& e = get_entry(ty);
+    e.layout_known = true;
+    e.layout_valid = valid;
+    e.size = size;
+    e.align = align;
+}
+const StructRepr* TypePropertyCache::get_struct_repr(const ::HIR::TypeRef& ty)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto it = m_entries.find(ty);
+    if( it == m_entries.end() )
+        return nullptr;
+    return it->second.struct_repr.get();
+}
+const StructRepr* TypePropertyCache::set_struct_repr(const ::HIR::TypeRef& ty, ::std::shared_ptr<const StructRepr> repr)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto& e = get_entry(ty);
+    if( !e.struct_repr )
+        e.struct_repr = mv$(repr);
+    return e.struct_repr.get();
+}
+const ::std::vector<unsigned int>* TypePropertyCache::get_enum_repr(const ::HIR::TypeRef& ty)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto it = m_entries.find(ty);
+    if( it == m_entries.end() || !it->second.enum_repr_known )
+        return nullptr;
+    return &it->second.enum_nonzero_path;
+}
+void TypePropertyCache::set_enum_repr(const ::HIR::TypeRef& ty, ::std::vector<unsigned int> nonzero_path)
+{
+    ::std::lock_guard< ::std::mutex>    lh(m_lock);
+    auto& e = get_entry(ty);
+    if( !e.enum_repr_known )
+    {
+        e.enum_repr_known = true;
+        e.enum_nonzero_path = mv$(nonzero_path);
+    }
+}
+
 void StaticTraitResolve::prep_indexes()
 {
     static Span sp_AAA;
@@ -1346,6 +1459,14 @@ bool StaticTraitResolve::trait_contains_type(const Span& sp, const ::HIR::Generi
 }
 
 bool StaticTraitResolve::type_is_copy(const Span& sp, const ::HIR::TypeRef& ty) const
+{
+    if( TypePropertyCache::is_cacheable(ty) )
+    {
+        return m_type_props.flag(ty, TypePropertyCache::Flag::Copy, [&](){ return this->type_is_copy_inner(sp, ty); });
+    }
+    return this->type_is_copy_inner(sp, ty);
+}
+bool StaticTraitResolve::type_is_copy_inner(const Span& sp, const ::HIR::TypeRef& ty) const
 {
     TU_MATCH(::HIR::TypeRef::Data, (ty.m_data), (e),
     (Generic,
@@ -1432,6 +1553,14 @@ bool StaticTraitResolve::type_is_copy(const Span& sp, const ::HIR::TypeRef& ty)
 }
 
 bool StaticTraitResolve::type_is_sized(const Span& sp, const ::HIR::TypeRef& ty) const
+{
+    if( TypePropertyCache::is_cacheable(ty) )
+    {
+        return m_type_props.flag(ty, TypePropertyCache::Flag::Sized, [&](){ return this->type_is_sized_inner(sp, ty); });
+    }
+    return this->type_is_sized_inner(sp, ty);
+}
+bool StaticTraitResolve::type_is_sized_inner(const Span& sp, const ::HIR::TypeRef& ty) const
 {
     TU_MATCH(::HIR::TypeRef::Data, (ty.m_data), (e),
     (Generic,
@@ -1721,6 +1850,14 @@ bool StaticTraitResolve::can_unsize(const Span& sp, const ::HIR::TypeRef& dst_ty
 }
 
 bool StaticTraitResolve::type_needs_drop_glue(const Span& sp, const ::HIR::TypeRef& ty) const
+{
+    if( TypePropertyCache::is_cacheable(ty) )
+    {
+        return m_type_props.flag(ty, TypePropertyCache::Flag::NeedsDrop, [&](){ return this->type_needs_drop_glue_inner(sp, ty); });
+    }
+    return this->type_needs_drop_glue_inner(sp, ty);
+}
+bool StaticTraitResolve::type_needs_drop_glue_inner(const Span& sp, const ::HIR::TypeRef& ty) const
 {
     // If `T: Copy`, then it can't need drop glue
     if( type_is_copy(sp, ty) )
@@ -10,6 +10,75 @@
 #include <hir/hir.hpp>
 #include "common.hpp"
 #include "impl_ref.hpp"
+#include <mutex>
+
+struct StructRepr;
+
+/// Crate-global store of properties of concrete (fully monomorphised) types
+/// - Shared by every `StaticTraitResolve` for a crate, so MIR cleanup/optimisation, enumeration and codegen don't
+///   recompute the same results for each function.
+/// - Entries are never removed, so returned pointers stay valid. Thread-safe.
+class TypePropertyCache
+{
+public:
+    enum class Flag {
+        Copy,
+        Sized,
+        NeedsDrop,
+    };
+private:
+    struct Props {
+        // -1 = not yet known
+        int8_t  flags[3] = { -1, -1, -1 };
+
+        bool    layout_known = false;
+        bool    layout_valid = false;
+        size_t  size = 0;
+        size_t  align = 0;
+
+        ::std::shared_ptr<const StructRepr> struct_repr;
+
+        bool    enum_repr_known = false;
+        /// Path to the field used as the niche for a NonZero-optimised enum (empty if not optimised)
+        ::std::vector<unsigned int> enum_nonzero_path;
+    };
+    mutable ::std::mutex    m_lock;
+    ::std::map< ::HIR::TypeRef, Props>  m_entries;
+
+    Props& get_entry(const ::HIR::TypeRef& ty);
+
+    int get_flag(const ::HIR::TypeRef& ty, Flag flag);
+    void set_flag(const ::HIR::TypeRef& ty, Flag flag, bool value);
+public:
+    static TypePropertyCache& for_crate(const ::HIR::Crate& crate);
+
+    /// Returns true if the properties of `ty` don't depend on the current generic context (and are worth caching)
+    static bool is_cacheable(const ::HIR::TypeRef& ty);
+
+    /// Get a cached flag, calling `calc` (without the lock held) if it's not yet known
+    template<typename Fcn>
+    bool flag(const ::HIR::TypeRef& ty, Flag flag, Fcn calc)
+    {
+        auto v = get_flag(ty, flag);
+        if( v >= 0 )
+            return v > 0;
+        bool rv = calc();
+        set_flag(ty, flag, rv);
+        return rv;
+    }
+
+    /// Size and alignment (as returned by `Target_GetSizeAndAlignOf`)
+    bool get_layout(const ::HIR::TypeRef& ty, bool& out_valid, size_t& out_size, size_t& out_align);
+    void set_layout(const ::HIR::TypeRef& ty, bool valid, size_t size, size_t align);
+
+    const StructRepr* get_struct_repr(const ::HIR::TypeRef& ty);
+    /// Save a struct representation (if another thread got there first, that version is kept and returned)
+    const StructRepr* set_struct_repr(const ::HIR::TypeRef& ty, ::std::shared_ptr<const StructRepr> repr);
+
+    /// NonZero optimisation path for an enum (nullptr if not yet known)
+    const ::std::vector<unsigned int>* get_enum_repr(const ::HIR::TypeRef& ty);
+    void set_enum_repr(const ::HIR::TypeRef& ty, ::std::vector<unsigned int> nonzero_path);
+};
 
 class StaticTraitResolve
 {
@@ -32,14 +101,19 @@ public:
     ::HIR::SimplePath   m_lang_Box;
     ::HIR::SimplePath   m_lang_PhantomData;
 
+    /// Properties of concrete types (shared between all resolvers for the crate)
+    TypePropertyCache&  m_type_props;
+
 private:
+    // Copy results for types that depend on the current generics
     mutable ::std::map< ::HIR::TypeRef, bool >  m_copy_cache;
 
 public:
     StaticTraitResolve(const ::HIR::Crate& crate):
         m_crate(crate),
         m_impl_generics(nullptr),
-        m_item_generics(nullptr)
+        m_item_generics(nullptr),
+        m_type_props( TypePropertyCache::for_crate(crate) )
     {
         m_lang_Copy = m_crate.get_lang_item_path_opt("copy");
         m_lang_Drop = m_crate.get_lang_item_path_opt("drop");
@@ -186,6 +260,12 @@ public:
 
     const ::HIR::TypeRef* is_type_owned_box(const ::HIR::TypeRef& ty) const;
     const ::HIR::TypeRef* is_type_phantom_data(const ::HIR::TypeRef& ty) const;
+private:
+    // Uncached versions of the above (results are cached in `m_type_props` by the public versions)
+    bool type_is_copy_inner(const Span& sp, const ::HIR::TypeRef& ty) const;
+    bool type_is_sized_inner(const Span& sp, const ::HIR::TypeRef& ty) const;
+    bool type_needs_drop_glue_inner(const Span& sp, const ::HIR::TypeRef& ty) const;
+public:
 
 
     TAGGED_UNION(ValuePtr, NotFound,
@@ -6,26 +6,81 @@
  * - Identifiers with hygiene
  */
 #include <iostream>
+#include <mutex>
+#include <atomic>
+#include <cassert>
+#include <algorithm>
 #include <ident.hpp>
+#include <chunked_store.hpp>
 #include <debug.hpp>
 #include <common.hpp>   // vector print
 
-unsigned int Ident::Hygiene::g_next_scope = 0;
+namespace {
+    /// Global tree of hygiene scopes, stored as parent links
+    /// - Lookups need no lock while other threads (parallel module parsing) add scopes (see `ChunkedStore`)
+    class ScopeTree
+    {
+        struct Node {
+            uint32_t    parent;
+            uint32_t    depth;
+        };
+        ::std::mutex    m_lock;
+        // NOTE: Index 0 is the root/empty scope
+        // - One scope is created per macro expansion (and a few per function), 2^24 is far more than even large crates
+        //   need, and keeps the chunk table small (32KiB).
+        ChunkedStore<Node, 12, 24>  m_nodes;
+
+    public:
+        static ScopeTree& get() {
+            static ScopeTree    s_tree;
+            return s_tree;
+        }
+        uint32_t add(uint32_t parent)
+        {
+            uint32_t depth = (parent == 0 ? 0 : (*this)[parent].depth) + 1;
+            ::std::lock_guard< ::std::mutex>    lh(m_lock);
+            uint32_t idx = m_nodes.push(Node { parent, depth });
+            if( idx == 0 ) {
+                ::std::cerr << "BUG: Hygiene scope overflow" << ::std::endl;
+                abort();
+            }
+            return idx;
+        }
+        const Node& operator[](uint32_t idx) const
+        {
+            assert(idx != 0);
+            return m_nodes[idx];
+        }
+    };
+}
+
+uint32_t Ident::Hygiene::alloc_scope(uint32_t parent)
+{
+    return ScopeTree::get().add(parent);
+}
+Ident::Hygiene Ident::Hygiene::get_parent() const
+{
+    if( this->scope_index == 0 )
+        return Hygiene();
+    return Hygiene( ScopeTree::get()[this->scope_index].parent );
+}
 
 bool Ident::Hygiene::is_visible(const Hygiene& src) const
 {
     // HACK: Disable hygiene for now
     //return true;
 
-    if( this->contexts.size() == 0 ) {
-        return src.contexts.size() == 0;
+    if( this->scope_index == 0 ) {
+        return src.scope_index == 0;
     }
 
-    auto des = this->contexts.back();
-    for(const auto& c : src.contexts)
-        if( des == c )
-            return true;
-    return false;
+    // Visible if this scope is `src`'s scope or one of its ancestors
+    const auto& tree = ScopeTree::get();
+    auto des_depth = tree[this->scope_index].depth;
+    auto idx = src.scope_index;
+    while( idx != 0 && tree[idx].depth > des_depth )
+        idx = tree[idx].parent;
+    return idx == this->scope_index;
 }
 
 ::std::ostream& operator<<(::std::ostream& os, const Ident& x) {
@@ -34,7 +89,12 @@ bool Ident::Hygiene::is_visible(const Hygiene& src) const
 }
 
 ::std::ostream& operator<<(::std::ostream& os, const Ident::Hygiene& x) {
-    os << "{" << x.contexts << "}";
+    // Print the full chain (outermost first)
+    ::std::vector<uint32_t> chain;
+    for(auto idx = x.scope_index; idx != 0; idx = ScopeTree::get()[idx].parent)
+        chain.push_back(idx);
+    ::std::reverse(chain.begin(), chain.end());
+    os << "{" << chain << "}";
     return os;
 }
 
@@ -0,0 +1,60 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/chunked_store.hpp
+ * - Append-only store indexed by 32-bit ids, readable without locking
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// Append-only array of `T`, indexed by ids starting at 1 (0 is reserved for the owner's "none" value)
+/// - Entries are stored in fixed-size chunks so they never move. Chunk pointers are published with release ordering,
+///   so readers need no lock (an entry itself is visible to any thread that was handed its id).
+/// - Appending must be serialised by the owner, and entries are only freed when the store is destroyed.
+/// - The chunk table is a fixed array, `INDEX_BITS` limits the number of entries (and the size of the table)
+template<typename T, unsigned CHUNK_BITS, unsigned INDEX_BITS>
+class ChunkedStore
+{
+    static_assert(CHUNK_BITS < INDEX_BITS && INDEX_BITS <= 32, "Bad ChunkedStore parameters");
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = size_t(1) << (INDEX_BITS - CHUNK_BITS);
+
+    ::std::atomic<T*>   m_chunks[MAX_CHUNKS] = {};
+    uint64_t    m_next_id = 1;
+
+public:
+    ChunkedStore() {}
+    ChunkedStore(const ChunkedStore&) = delete;
+    ~ChunkedStore()
+    {
+        for(auto& c : m_chunks)
+            delete[] c.load(::std::memory_order_relaxed);
+    }
+
+    /// Append an entry, returning its id (or 0 if the store is full)
+    /// NOTE: The caller must hold the owner's lock
+    uint32_t push(T value)
+    {
+        if( m_next_id >> INDEX_BITS )
+            return 0;
+        uint32_t id = static_cast<uint32_t>(m_next_id);
+        m_next_id += 1;
+        auto& chunk = m_chunks[id >> CHUNK_BITS];
+        T* c = chunk.load(::std::memory_order_relaxed);
+        if( !c )
+        {
+            c = new T[CHUNK_SIZE];
+            chunk.store(c, ::std::memory_order_release);
+        }
+        c[id & (CHUNK_SIZE-1)] = ::std::move(value);
+        return id;
+    }
+
+    const T& operator[](uint32_t id) const
+    {
+        return m_chunks[id >> CHUNK_BITS].load(::std::memory_order_acquire)[id & (CHUNK_SIZE-1)];
+    }
+};
@@ -8,42 +8,35 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
 
 struct Ident
 {
     class Hygiene
     {
-        static unsigned g_next_scope;
+        /// Index of this scope in the global scope tree (0 = no scope)
+        /// - A macro expansion's scope is a child of the scope the macro was invoked from
+        uint32_t    scope_index;
 
-        ::std::vector<unsigned int> contexts;
-
-        Hygiene(unsigned int index):
-            contexts({index})
+        Hygiene(uint32_t index):
+            scope_index(index)
         {}
+        /// Allocate a new node in the scope tree (thread-safe, as module files can be lexed in parallel)
+        static uint32_t alloc_scope(uint32_t parent);
     public:
         Hygiene():
-            contexts({})
+            scope_index(0)
         {}
 
         static Hygiene new_scope()
         {
-            return Hygiene(++g_next_scope);
+            return Hygiene(alloc_scope(0));
         }
         static Hygiene new_scope_chained(const Hygiene& parent)
         {
-            Hygiene rv;
-            rv.contexts.reserve( parent.contexts.size() + 1 );
-            rv.contexts.insert( rv.contexts.begin(),  parent.contexts.begin(), parent.contexts.end() );
-            rv.contexts.push_back( ++g_next_scope );
-            return rv;
-        }
-        Hygiene get_parent() const
-        {
-            //assert(this->contexts.size() > 1);
-            Hygiene rv;
-            rv.contexts.insert(rv.contexts.begin(),  this->contexts.begin(), this->contexts.end()-1);
-            return rv;
+            return Hygiene(alloc_scope(parent.scope_index));
         }
+        Hygiene get_parent() const;
 
         Hygiene(Hygiene&& x) = default;
         Hygiene(const Hygiene& x) = default;
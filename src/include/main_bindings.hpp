@@ -5,14 +5,19 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 namespace AST {
     class Crate;
     class Flat;
 }
+namespace HIR {
+    class CratePtr;
+}
 
 /// Parse a crate from the given file
-extern AST::Crate Parse_Crate(::std::string mainfile);
+extern AST::Crate Parse_Crate(::std::string mainfile, unsigned int num_threads);
 
 
 extern void Expand(::AST::Crate& crate);
@@ -26,6 +31,31 @@ extern void Process_Decorators(AST::Crate& crate);
 extern AST::Flat Convert_Flatten(const AST::Crate& crate);
 
 
+/// Run as a compile server listening on a unix socket (`mrustc --server <path>`)
+/// - `compile` is called in a forked child for each request
+extern int CompileServer_Run(const char* socket_path, int (*compile)(int argc, char* argv[]));
+/// Load an extern crate's metadata, using the compile server's copy if there is one and the file hasn't changed
+extern ::HIR::CratePtr CompileServer_LoadCrate(const ::std::string& path, const ::std::string& name);
+
+/// Hash a file's contents (returns false if it can't be read)
+extern bool Incremental_HashFile(const ::std::string& path, uint64_t& out);
+/// Start recording inputs (only done for `-Z incremental`, the `Incremental_Add*` functions do nothing otherwise)
+extern void Incremental_Enable();
+/// Record a file that the output depends on
+extern void Incremental_AddInput(const ::std::string& path);
+/// Record a file that was looked for but doesn't exist (the output would change if it's created)
+extern void Incremental_AddMissing(const ::std::string& path);
+/// Record the files that the linker could use for `-l<name>` (and the ones it would look for first)
+/// NOTE: Only the given directories are checked, not the system's default library paths
+extern void Incremental_AddLinkLibrary(const ::std::string& name, const ::std::vector< ::std::string>& dirs);
+/// Record an environment variable that the output depends on (`value` is null if it isn't set)
+extern void Incremental_AddEnv(const ::std::string& name, const char* value);
+/// Check if the inputs recorded by the last `-Z incremental` build of `outfile` (and its outputs) are unchanged
+extern bool Incremental_IsFresh(const ::std::string& outfile, const ::std::string& options);
+/// Record the current inputs and the given outputs for the next build
+extern void Incremental_Save(const ::std::string& outfile, const ::std::string& options, const ::std::vector< ::std::string>& outputs);
+
+
 /// Dump the crate as annotated rust
 extern void Dump_Rust(const char *Filename, const AST::Crate& crate);
 
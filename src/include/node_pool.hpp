@@ -0,0 +1,30 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/node_pool.hpp
+ * - Size-class pool allocator for AST/HIR tree nodes
+ */
+#pragma once
+#include <cstddef>
+
+/// Bump/free-list allocator used for expression tree nodes (and patterns)
+///
+/// Nodes are allocated from large chunks split into fixed size classes, freeing a node pushes it onto the free list
+/// for that class. This turns the per-node malloc/free traffic of the lowering passes into a pointer bump/pop, and
+/// keeps the nodes of a tree close together in memory. Chunks with no live nodes are returned to the system by `trim`.
+namespace NodePool
+{
+    void* allocate(::std::size_t size);
+    void deallocate(void* ptr, ::std::size_t size);
+    /// Release chunks that no longer contain any nodes (called between compiler phases)
+    /// NOTE: The free lists of all threads are pruned, so no other thread may be allocating or freeing nodes at the time
+    void trim();
+}
+
+/// Adds class-specific `operator new`/`operator delete` that use `NodePool`
+/// NOTE: The class must have a virtual destructor if instances are deleted through a base pointer (so the sized
+/// delete gets the dynamic size)
+#define NODE_POOL_ALLOCATED()  \
+    static void* operator new(::std::size_t size) { return ::NodePool::allocate(size); } \
+    static void operator delete(void* ptr, ::std::size_t size) { ::NodePool::deallocate(ptr, size); }
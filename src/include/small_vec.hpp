@@ -0,0 +1,152 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/small_vec.hpp
+ * - Vector with inline storage for a small number of items
+ */
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <new>
+
+/// Vector of trivially-copyable items, storing up to `N` items inline (only spills to the heap when larger)
+template<typename T, unsigned N>
+class SmallVec
+{
+    static_assert(::std::is_trivially_copyable<T>::value, "SmallVec only supports trivially copyable types");
+    union {
+        T   m_inline[N];
+        T*  m_heap;
+    };
+    uint32_t    m_size;
+    uint32_t    m_cap;  // 0 = inline
+
+    T* data_ptr() { return m_cap == 0 ? m_inline : m_heap; }
+    const T* data_ptr() const { return m_cap == 0 ? m_inline : m_heap; }
+
+    void grow(size_t min_cap) {
+        size_t  new_cap = ::std::max(min_cap, static_cast<size_t>(capacity() * 2));
+        T* new_ptr = new T[new_cap];
+        ::std::memcpy(new_ptr, data_ptr(), m_size * sizeof(T));
+        if( m_cap != 0 )
+            delete[] m_heap;
+        m_heap = new_ptr;
+        m_cap = static_cast<uint32_t>(new_cap);
+    }
+public:
+    SmallVec():
+        m_size(0),
+        m_cap(0)
+    {}
+    SmallVec(const T* first, const T* last):
+        SmallVec()
+    {
+        this->insert(this->end(), first, last);
+    }
+    SmallVec(const SmallVec& x):
+        SmallVec(x.begin(), x.end())
+    {}
+    SmallVec(SmallVec&& x):
+        m_size(x.m_size),
+        m_cap(x.m_cap)
+    {
+        if( x.m_cap == 0 ) {
+            ::std::memcpy(m_inline, x.m_inline, m_size * sizeof(T));
+        }
+        else {
+            m_heap = x.m_heap;
+        }
+        x.m_size = 0;
+        x.m_cap = 0;
+    }
+    SmallVec& operator=(const SmallVec& x) {
+        if( this != &x ) {
+            this->clear();
+            this->insert(this->end(), x.begin(), x.end());
+        }
+        return *this;
+    }
+    SmallVec& operator=(SmallVec&& x) {
+        if( this != &x ) {
+            this->~SmallVec();
+            new(this) SmallVec(::std::move(x));
+        }
+        return *this;
+    }
+    ~SmallVec() {
+        if( m_cap != 0 )
+            delete[] m_heap;
+        m_cap = 0;
+        m_size = 0;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_cap == 0 ? N : m_cap; }
+
+    T* begin() { return data_ptr(); }
+    T* end() { return data_ptr() + m_size; }
+    const T* begin() const { return data_ptr(); }
+    const T* end() const { return data_ptr() + m_size; }
+
+    T& operator[](size_t i) { assert(i < m_size); return data_ptr()[i]; }
+    const T& operator[](size_t i) const { assert(i < m_size); return data_ptr()[i]; }
+    T& front() { assert(m_size > 0); return data_ptr()[0]; }
+    const T& front() const { assert(m_size > 0); return data_ptr()[0]; }
+    T& back() { assert(m_size > 0); return data_ptr()[m_size-1]; }
+    const T& back() const { assert(m_size > 0); return data_ptr()[m_size-1]; }
+
+    void clear() { m_size = 0; }
+    void push_back(T v) {
+        if( m_size == capacity() )
+            grow(m_size + 1);
+        data_ptr()[m_size++] = v;
+    }
+    void pop_back() { assert(m_size > 0); m_size -= 1; }
+    /// Shrink to `new_size` (which must not be larger than the current size)
+    void truncate(size_t new_size) { assert(new_size <= m_size); m_size = static_cast<uint32_t>(new_size); }
+
+    T* insert(T* pos, const T* first, const T* last) {
+        size_t  ofs = pos - begin();
+        size_t  count = last - first;
+        assert(ofs <= m_size);
+        if( count == 0 )
+            return begin() + ofs;
+        if( m_size + count > capacity() )
+        {
+            // `first`/`last` could point into this vector, so take a copy before growing
+            if( first >= begin() && first < end() ) {
+                SmallVec   tmp(first, last);
+                return this->insert(begin() + ofs, tmp.begin(), tmp.end());
+            }
+            grow(m_size + count);
+        }
+        T* p = begin() + ofs;
+        ::std::memmove(p + count, p, (m_size - ofs) * sizeof(T));
+        ::std::memcpy(p, first, count * sizeof(T));
+        m_size += static_cast<uint32_t>(count);
+        return p;
+    }
+    T* erase(T* first, T* last) {
+        size_t  ofs = first - begin();
+        size_t  count = last - first;
+        assert(ofs + count <= m_size);
+        ::std::memmove(first, last, (end() - last) * sizeof(T));
+        m_size -= static_cast<uint32_t>(count);
+        return begin() + ofs;
+    }
+
+    bool operator==(const SmallVec& x) const {
+        return m_size == x.m_size && ::std::equal(begin(), end(), x.begin());
+    }
+    bool operator!=(const SmallVec& x) const {
+        return !(*this == x);
+    }
+    bool operator<(const SmallVec& x) const {
+        return ::std::lexicographical_compare(begin(), end(), x.begin(), x.end());
+    }
+};
@@ -10,6 +10,9 @@
 #include <rc_string.hpp>
 #include <functional>
 #include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <sstream>
 
 enum ErrorType
 {
@@ -29,34 +32,91 @@ struct ProtoSpan
     unsigned int start_line;
     unsigned int start_ofs;
 };
+struct SpanData;
+
+/// Source location of an AST/HIR item
+///
+/// A span is just an index into the global (append-only) source map, so it's cheap to copy and store. The full location
+/// (file, line/column range and macro expansion chain) is looked up when needed, usually only when printing a message.
 struct Span
 {
-    ::std::shared_ptr<Span> outer_span; // Expansion target for macros
-    RcString    filename;
-
-    unsigned int start_line;
-    unsigned int start_ofs;
-    unsigned int end_line;
-    unsigned int end_ofs;
+    /// Index into the source map (0 = empty span)
+    uint32_t    m_id;
 
-    Span(RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs):
-        filename( ::std::move(filename) ),
-        start_line(start_line),
-        start_ofs(start_ofs),
-        end_line(end_line),
-        end_ofs(end_ofs)
-    {}
-    Span(const Span& x);
+    Span(RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs);
+    /// Span within a macro expansion (`outer` is the invocation)
+    Span(const Span& outer, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs);
     Span(const Position& position);
+    Span(const Position& position, const Span& outer);
     Span();
 
+    bool is_empty() const { return m_id == 0; }
+
+    /// Look up the full span information
+    const SpanData& get() const;
+    const RcString& filename() const;
+    unsigned int start_line() const;
+    unsigned int start_ofs() const;
+    unsigned int end_line() const;
+    unsigned int end_ofs() const;
+    /// Expansion target for macros (empty if not within a macro expansion)
+    const Span& outer_span() const;
+
     void bug(::std::function<void(::std::ostream&)> msg) const;
     void error(ErrorType tag, ::std::function<void(::std::ostream&)> msg) const;
     void warning(WarningType tag, ::std::function<void(::std::ostream&)> msg) const;
     void note(::std::function<void(::std::ostream&)> msg) const;
 
+    /// Stop merging identical spans (and free the lookup used to do so), once spans are no longer created in bulk
+    static void release_dedup_index();
+
     friend ::std::ostream& operator<<(::std::ostream& os, const Span& sp);
+private:
+    explicit Span(uint32_t id): m_id(id) {}
+};
+
+/// An error/bug raised on a thread that is collecting errors (see `SpanErrorCollector`)
+/// - `what()` is the full message, as `Span::error`/`Span::bug` would have printed it
+struct CollectedError:
+    public ::std::runtime_error
+{
+    using ::std::runtime_error::runtime_error;
+
+    /// Print the message and terminate, as the original `Span::error` call would have
+    [[noreturn]] void report() const;
+};
+/// While alive, `Span::error` and `Span::bug` on the current thread throw `CollectedError` instead of printing and
+/// terminating, so worker threads can hand their errors back to the main thread (which reports them in a fixed order)
+class SpanErrorCollector
+{
+    SpanErrorCollector* m_saved;
+    ::std::stringstream m_output;
+public:
+    SpanErrorCollector();
+    ~SpanErrorCollector();
+
+    /// Stream for diagnostics printed before an error is thrown (e.g. by `ParseError`), buffered while collecting
+    static ::std::ostream& output(::std::ostream& fallback);
+    /// Take the buffered diagnostic output
+    ::std::string take_output();
+};
+/// Source map entry
+struct SpanData
+{
+    Span    outer_span;
+    RcString    filename;
+
+    unsigned int start_line;
+    unsigned int start_ofs;
+    unsigned int end_line;
+    unsigned int end_ofs;
 };
+inline const RcString& Span::filename() const { return get().filename; }
+inline unsigned int Span::start_line() const { return get().start_line; }
+inline unsigned int Span::start_ofs() const { return get().start_ofs; }
+inline unsigned int Span::end_line() const { return get().end_line; }
+inline unsigned int Span::end_ofs() const { return get().end_ofs; }
+inline const Span& Span::outer_span() const { return get().outer_span; }
 
 template<typename T>
 struct Spanned
@@ -0,0 +1,268 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * incremental.cpp
+ * - Fingerprints of a compilation's inputs (for skipping compilations that would produce the same output)
+ *
+ * `-Z incremental` saves `<outfile>.inc` after a successful build, listing a hash of the options and of every file that
+ * was read (source files, included files, proc macro executables, and the metadata of extern crates - plus their
+ * objects and the native libraries they link for executables), and of the environment variables read by
+ * `env!`/`option_env!`. Files that were looked for but didn't exist (e.g. the `foo/mod.rs` alternative to `foo.rs`, or
+ * a library in an earlier search directory) are also listed, so creating one makes the build stale.
+ * The next build with the same output checks these hashes before parsing, and leaves the outputs alone if nothing
+ * changed. As only the contents are compared, rebuilding a dependency without changing its metadata (e.g. when just
+ * a private function body changed) doesn't cause dependent libraries to be rebuilt.
+ *
+ * NOTE: This is all-or-nothing for the crate, if anything changed the whole crate is compiled again.
+ *
+ * Format: One entry per line
+ * - `mrustc-incremental 2`
+ * - `options <hash>`
+ * - `input <hash> <path>`
+ * - `missing <path>`
+ * - `env <hash> <name>` (hash of the value, with unset distinct from empty)
+ * - `output <hash> <path>`
+ */
+#include <main_bindings.hpp>
+#include <debug.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <map>
+#include <cstring>
+#include <vector>
+
+namespace {
+    /// Set (before any inputs are read) by `-Z incremental`, recording is skipped otherwise
+    bool    g_enabled = false;
+    ::std::mutex    g_inputs_lock;
+    ::std::set< ::std::string>  g_inputs;
+    /// Paths that were probed and didn't exist
+    ::std::set< ::std::string>  g_missing;
+    /// Environment variables read by the crate, and the hash of the value that was used
+    ::std::map< ::std::string, uint64_t>    g_env;
+
+    uint64_t hash_bytes(uint64_t h, const char* data, size_t len)
+    {
+        for(size_t i = 0; i < len; i ++)
+        {
+            h ^= static_cast<uint8_t>(data[i]);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+    const uint64_t HASH_INIT = 0xcbf29ce484222325ull;
+    const char* const FORMAT_HEADER = "mrustc-incremental 2";
+
+    uint64_t hash_env(const char* value)
+    {
+        if( !value )
+            return HASH_INIT;
+        // Prefixed so an empty value doesn't match an unset variable
+        return hash_bytes(hash_bytes(HASH_INIT, "=", 1), value, strlen(value));
+    }
+
+    struct Entry {
+        uint64_t    hash;
+        ::std::string   path;
+    };
+    bool parse_entry(::std::istream& is, Entry& out)
+    {
+        is >> ::std::hex >> out.hash;
+        if( is.get() != ' ' )
+            return false;
+        ::std::getline(is, out.path);
+        return !is.fail() && out.path != "";
+    }
+    /// Returns true if the file still has the recorded hash
+    bool entry_matches(const Entry& e)
+    {
+        uint64_t    h;
+        if( !Incremental_HashFile(e.path, h) )
+            return false;
+        if( h != e.hash )
+        {
+            DEBUG(e.path << " changed");
+            return false;
+        }
+        return true;
+    }
+}
+
+bool Incremental_HashFile(const ::std::string& path, uint64_t& out)
+{
+    ::std::ifstream is(path, ::std::ios::binary);
+    if( !is.good() )
+        return false;
+    uint64_t    h = HASH_INIT;
+    char    buf[1 << 16];
+    do {
+        is.read(buf, sizeof(buf));
+        h = hash_bytes(h, buf, static_cast<size_t>(is.gcount()));
+    } while( is.gcount() > 0 );
+    out = h;
+    return true;
+}
+
+void Incremental_Enable()
+{
+    g_enabled = true;
+}
+
+void Incremental_AddInput(const ::std::string& path)
+{
+    if( !g_enabled )
+        return ;
+    ::std::lock_guard< ::std::mutex>    lh(g_inputs_lock);
+    g_inputs.insert(path);
+}
+
+void Incremental_AddMissing(const ::std::string& path)
+{
+    if( !g_enabled )
+        return ;
+    ::std::lock_guard< ::std::mutex>    lh(g_inputs_lock);
+    g_missing.insert(path);
+}
+
+void Incremental_AddLinkLibrary(const ::std::string& name, const ::std::vector< ::std::string>& dirs)
+{
+    if( !g_enabled )
+        return ;
+    // The linker takes the first directory with either a shared or a static library, so record every candidate up to
+    // (and including) that directory
+    for(const auto& dir : dirs)
+    {
+        bool found = false;
+        for(const char* ext : { ".so", ".a" })
+        {
+            auto path = dir + "/lib" + name + ext;
+            if( ::std::ifstream(path).good() ) {
+                Incremental_AddInput(path);
+                found = true;
+            }
+            else {
+                Incremental_AddMissing(path);
+            }
+        }
+        if( found )
+            break;
+    }
+}
+
+void Incremental_AddEnv(const ::std::string& name, const char* value)
+{
+    if( !g_enabled )
+        return ;
+    ::std::lock_guard< ::std::mutex>    lh(g_inputs_lock);
+    g_env.insert( ::std::make_pair(name, hash_env(value)) );
+}
+
+bool Incremental_IsFresh(const ::std::string& outfile, const ::std::string& options)
+{
+    ::std::ifstream is(outfile + ".inc");
+    if( !is.good() )
+        return false;
+    ::std::string   line;
+    if( !::std::getline(is, line) || line != FORMAT_HEADER )
+        return false;
+
+    bool options_seen = false;
+    bool have_output = false;
+    while( ::std::getline(is, line) )
+    {
+        ::std::istringstream    ls(line);
+        ::std::string   kind;
+        ls >> kind;
+        if( kind == "options" )
+        {
+            uint64_t    h;
+            ls >> ::std::hex >> h;
+            if( ls.fail() || h != hash_bytes(HASH_INIT, options.data(), options.size()) )
+            {
+                DEBUG("Options changed");
+                return false;
+            }
+            options_seen = true;
+        }
+        else if( kind == "input" || kind == "output" )
+        {
+            Entry   e;
+            if( ls.get() != ' ' || !parse_entry(ls, e) )
+                return false;
+            if( !entry_matches(e) )
+                return false;
+            have_output |= (kind == "output");
+        }
+        else if( kind == "env" )
+        {
+            Entry   e;
+            if( ls.get() != ' ' || !parse_entry(ls, e) )
+                return false;
+            if( hash_env(getenv(e.path.c_str())) != e.hash )
+            {
+                DEBUG("Environment variable " << e.path << " changed");
+                return false;
+            }
+        }
+        else if( kind == "missing" )
+        {
+            ::std::string   path;
+            if( ls.get() != ' ' || !::std::getline(ls, path) )
+                return false;
+            if( ::std::ifstream(path).good() )
+            {
+                DEBUG(path << " now exists");
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options_seen && have_output;
+}
+
+void Incremental_Save(const ::std::string& outfile, const ::std::string& options, const ::std::vector< ::std::string>& outputs)
+{
+    ::std::stringstream ss;
+    ss << FORMAT_HEADER << "\n";
+    ss << "options " << ::std::hex << hash_bytes(HASH_INIT, options.data(), options.size()) << "\n";
+    {
+        ::std::lock_guard< ::std::mutex>    lh(g_inputs_lock);
+        for(const auto& path : g_inputs)
+        {
+            uint64_t    h;
+            if( !Incremental_HashFile(path, h) ) {
+                // An input that can't be read again can't be checked, so the next build won't be skipped
+                ::std::cerr << "Incremental: Unable to read input " << path << ::std::endl;
+                return ;
+            }
+            ss << "input " << ::std::hex << h << " " << path << "\n";
+        }
+        for(const auto& path : g_missing)
+        {
+            ss << "missing " << path << "\n";
+        }
+        for(const auto& e : g_env)
+        {
+            ss << "env " << ::std::hex << e.second << " " << e.first << "\n";
+        }
+    }
+    for(const auto& path : outputs)
+    {
+        uint64_t    h;
+        if( !Incremental_HashFile(path, h) ) {
+            ::std::cerr << "Incremental: Unable to read output " << path << ::std::endl;
+            return ;
+        }
+        ss << "output " << ::std::hex << h << " " << path << "\n";
+    }
+    ::std::ofstream os(outfile + ".inc");
+    os << ss.str();
+}
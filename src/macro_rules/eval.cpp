@@ -23,6 +23,8 @@ class ParameterMappings
         unsigned int    num_uses;   // Number of times this var will be used
         unsigned int    num_used;   // Number of times it has been used
         InterpolatedFragment    frag;
+        /// `tt` captures, once first read (moved out of `frag`, and shared with the streams reading it)
+        ::std::shared_ptr<TokenTree>    shared_tt;
     };
 
     /// A single layer of the capture set
@@ -65,6 +67,8 @@ public:
     void insert(unsigned int name_index, const ::std::vector<unsigned int>& iterations, InterpolatedFragment data);
 
     InterpolatedFragment* get(const ::std::vector<unsigned int>& iterations, unsigned int name_idx);
+    /// Get a shared reference to a `tt` capture (after the last use, the caller holds the only reference)
+    ::std::shared_ptr<TokenTree> get_tt(const ::std::vector<unsigned int>& iterations, unsigned int name_idx, bool is_last_use);
     unsigned int count_in(const ::std::vector<unsigned int>& iterations, unsigned int name_idx) const;
 
     /// Increment the number of times a particular fragment will be used
@@ -74,7 +78,10 @@ public:
 
 
     friend ::std::ostream& operator<<(::std::ostream& os, const CapturedVal& x) {
-        os << x.frag;
+        if( x.shared_tt )
+            os << *x.shared_tt;
+        else
+            os << x.frag;
         return os;
     }
     friend ::std::ostream& operator<<(::std::ostream& os, const CaptureLayer& x) {
@@ -255,6 +262,23 @@ InterpolatedFragment* ParameterMappings::get(const ::std::vector<unsigned int>&
 {
     return &get_cap(iterations, name_idx).frag;
 }
+::std::shared_ptr<TokenTree> ParameterMappings::get_tt(const ::std::vector<unsigned int>& iterations, unsigned int name_idx, bool is_last_use)
+{
+    auto& cap = get_cap(iterations, name_idx);
+    assert(cap.frag.m_type == InterpolatedFragment::TT);
+    if( !cap.shared_tt )
+    {
+        cap.shared_tt = ::std::make_shared<TokenTree>( mv$(cap.frag.as_tt()) );
+    }
+    if( is_last_use )
+    {
+        return mv$(cap.shared_tt);
+    }
+    else
+    {
+        return cap.shared_tt;
+    }
+}
 unsigned int ParameterMappings::count_in(const ::std::vector<unsigned int>& iterations, unsigned int name_idx) const
 {
     DEBUG("(iterations=[" << iterations << "], name_idx=" << name_idx << ")");
@@ -571,19 +595,40 @@ private:
     const ::std::vector<MacroExpansionEnt>* getCurLayer() const;
 };
 // ----------------------------------------------------------------
+/// Token stream over a `tt` capture that is shared with other uses (keeps the capture alive while it's read)
+class SharedTTStream:
+    public TokenStream
+{
+    ::std::shared_ptr<TokenTree>    m_tt;
+    TTStream    m_inner;
+public:
+    SharedTTStream(Span parent, ::std::shared_ptr<TokenTree> tt):
+        m_tt( mv$(tt) ),
+        m_inner( mv$(parent), *m_tt )
+    {
+    }
+
+    Position getPosition() const override { return m_inner.getPosition(); }
+    Span outerSpan() const override { return m_inner.outerSpan(); }
+
+protected:
+    Ident::Hygiene realGetHygiene() const override { return m_inner.getHygiene(); }
+    Token realGetToken() override { return m_inner.getToken(); }
+};
+// ----------------------------------------------------------------
 class MacroExpander:
     public TokenStream
 {
     const RcString  m_macro_filename;
 
     const ::std::string m_crate_name;
-    ::std::shared_ptr<Span> m_invocation_span;
+    Span    m_invocation_span;
 
     ParameterMappings m_mappings;
     MacroExpandState    m_state;
 
     Token   m_next_token;   // used for inserting a single token into the stream
-    ::std::unique_ptr<TTStreamO> m_ttstream;
+    ::std::unique_ptr<TokenStream> m_ttstream;
     Ident::Hygiene  m_hygiene;
 
 public:
@@ -592,7 +637,7 @@ public:
     MacroExpander(const ::std::string& macro_name, const Span& sp, const Ident::Hygiene& parent_hygiene, const ::std::vector<MacroExpansionEnt>& contents, ParameterMappings mappings, ::std::string crate_name):
         m_macro_filename( FMT("Macro:" << macro_name) ),
         m_crate_name( mv$(crate_name) ),
-        m_invocation_span( new Span(sp) ),
+        m_invocation_span( sp ),
         m_mappings( mv$(mappings) ),
         m_state( contents, m_mappings ),
         m_hygiene( Ident::Hygiene::new_scope_chained(parent_hygiene) )
@@ -600,7 +645,7 @@ public:
     }
 
     Position getPosition() const override;
-    ::std::shared_ptr<Span> outerSpan() const override;
+    Span outerSpan() const override;
     Ident::Hygiene realGetHygiene() const override;
     Token realGetToken() override;
 };
@@ -1834,19 +1879,85 @@ namespace
     }
 }
 
+namespace
+{
+    /// Add the possible first tokens of `pats` (starting at `ofs`) to `out`, returns true if the sequence can be empty
+    bool macro_pat_first_set(const ::std::vector<MacroPatEnt>& pats, size_t ofs, MacroArmFirstSet& out)
+    {
+        for(size_t i = ofs; i < pats.size(); i ++)
+        {
+            const auto& pat = pats[i];
+            switch(pat.type)
+            {
+            case MacroPatEnt::PAT_TOKEN:
+                out.tokens.push_back( pat.tok.clone() );
+                return false;
+            case MacroPatEnt::PAT_LOOP:
+                // `$( ... )+` must match at least once, `$( ... )*` can be skipped entirely
+                if( !macro_pat_first_set(pat.subpats, 0, out) && pat.name == "+" )
+                    return false;
+                break;
+            case MacroPatEnt::PAT_IDENT:
+                out.ident = true;
+                return false;
+            case MacroPatEnt::PAT_BLOCK:
+                out.types.push_back(TOK_BRACE_OPEN);
+                out.types.push_back(TOK_INTERPOLATED_BLOCK);
+                return false;
+            case MacroPatEnt::PAT_META:
+                out.types.push_back(TOK_IDENT);
+                out.types.push_back(TOK_INTERPOLATED_META);
+                return false;
+            default:
+                // Other fragments have complex first sets
+                out.any = true;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+bool MacroArmFirstSet::may_start_with(const Token& tok) const
+{
+    if( this->any )
+        return true;
+    if( tok.type() == TOK_EOF )
+        return this->empty;
+    if( this->ident && (tok.type() == TOK_IDENT || is_reserved_word(tok.type())) )
+        return true;
+    if( ::std::find(this->types.begin(), this->types.end(), tok.type()) != this->types.end() )
+        return true;
+    for(const auto& t : this->tokens)
+        if( t == tok )
+            return true;
+    return false;
+}
+
 unsigned int Macro_InvokeRules_MatchPattern(const Span& sp, const MacroRules& rules, TokenTree input, AST::Module& mod,  ParameterMappings& bound_tts)
 {
     TRACE_FUNCTION;
 
-    struct ActiveArm {
-        unsigned int    index;
-        MacroPatternStream  pat_stream;
-        TokenStreamRO   in_stream;
-    };
+    if( rules.m_arm_first.size() != rules.m_rules.size() )
+    {
+        rules.m_arm_first.clear();
+        rules.m_arm_first.resize( rules.m_rules.size() );
+        for(size_t i = 0; i < rules.m_rules.size(); i ++)
+        {
+            auto& fs = rules.m_arm_first[i];
+            fs.empty = macro_pat_first_set(rules.m_rules[i].m_pattern, 0, fs);
+        }
+    }
+    // Get the first token of the input, used to skip arms that can't match
+    const Token& first_tok = TokenStreamRO(input).next_tok();
 
     ::std::vector<size_t>   matches;
     for(size_t i = 0; i < rules.m_rules.size(); i ++)
     {
+        if( !rules.m_arm_first[i].may_start_with(first_tok) )
+        {
+            DEBUG(i << " SKIPPED (can't start with " << first_tok << ")");
+            continue ;
+        }
         auto lex = TokenStreamRO(input);
         auto arm_stream = MacroPatternStream(rules.m_rules[i].m_pattern);
 
@@ -2327,7 +2438,7 @@ Position MacroExpander::getPosition() const
     // TODO: Return the attached position of the last fetched token
     return Position(m_macro_filename, 0, m_state.top_pos());
 }
-::std::shared_ptr<Span> MacroExpander::outerSpan() const
+Span MacroExpander::outerSpan() const
 {
     return m_invocation_span;
 }
@@ -2390,21 +2501,24 @@ Token MacroExpander::realGetToken()
                 ASSERT_BUG(this->getPosition(), frag, "Cannot find '" << e << "' for " << m_state.iterations());
 
                 bool can_steal = ( m_mappings.dec_count(m_state.iterations(), e) == false );
-                DEBUG("Insert replacement #" << e << " = " << *frag);
                 if( frag->m_type == InterpolatedFragment::TT )
                 {
-                    if( can_steal )
+                    // `tt` captures are shared between their uses instead of being cloned
+                    auto tt = m_mappings.get_tt(m_state.iterations(), e, can_steal);
+                    DEBUG("Insert replacement #" << e << " = " << *tt);
+                    if( tt.use_count() == 1 )
                     {
-                        m_ttstream.reset( new TTStreamO(*this->outerSpan(), mv$(frag->as_tt()) ) );
+                        m_ttstream.reset( new TTStreamO(this->outerSpan(), mv$(*tt)) );
                     }
                     else
                     {
-                        m_ttstream.reset( new TTStreamO(*this->outerSpan(), frag->as_tt().clone() ) );
+                        m_ttstream.reset( new SharedTTStream(this->outerSpan(), mv$(tt)) );
                     }
                     return m_ttstream->getToken();
                 }
                 else
                 {
+                    DEBUG("Insert replacement #" << e << " = " << *frag);
                     if( can_steal )
                     {
                         return Token(Token::TagTakeIP(), mv$(*frag) );
@@ -2412,6 +2526,8 @@ Token MacroExpander::realGetToken()
                     else
                     {
                         // Clones
+                        // - Unlike `tt` captures, these can't be read in place: the parser takes ownership of the node
+                        //   (and later passes modify it), so each use needs its own copy.
                         return Token( *frag );
                     }
                 }
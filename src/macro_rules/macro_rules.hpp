@@ -130,6 +130,24 @@ struct MacroRulesArm:
     SERIALISABLE_PROTOTYPES();
 };
 
+/// Set of tokens that can start the input of a macro arm
+/// - Used to skip arms that can't match without running the full pattern matcher
+struct MacroArmFirstSet
+{
+    /// The arm can't be filtered (e.g. starts with an `:expr` fragment)
+    bool    any = false;
+    /// The arm can match an empty input
+    bool    empty = false;
+    /// The arm can start with any identifier/keyword (`:ident`)
+    bool    ident = false;
+    /// Token types that can start the arm (from fragments)
+    ::std::vector<eTokenType>   types;
+    /// Exact tokens that can start the arm
+    ::std::vector<Token>    tokens;
+
+    bool may_start_with(const Token& tok) const;
+};
+
 /// A sigle 'macro_rules!' block
 class MacroRules:
     public Serialisable
@@ -147,6 +165,9 @@ public:
     /// Expansion rules
     ::std::vector<MacroRulesArm>  m_rules;
 
+    /// First-token sets for each arm in `m_rules` (calculated on first invocation, see `Macro_InvokeRules`)
+    mutable ::std::vector<MacroArmFirstSet> m_arm_first;
+
     MacroRules()
     {
     }
@@ -7,15 +7,19 @@
  */
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <string>
 #include <set>
+#include <chrono>
 #include "parse/lex.hpp"
 #include "parse/parseerror.hpp"
 #include "ast/ast.hpp"
 #include "ast/crate.hpp"
 #include <serialiser_texttree.hpp>
 #include <cstring>
+#include <cstdlib>  // _Exit
 #include <main_bindings.hpp>
+#include <node_pool.hpp>
 #include "resolve/main_bindings.hpp"
 #include "hir/main_bindings.hpp"
 #include "hir_conv/main_bindings.hpp"
@@ -42,7 +46,7 @@
 #define DEFAULT_TARGET_NAME "x86_64-linux-gnu"
 #endif
 
-int g_debug_indent_level = 0;
+thread_local int g_debug_indent_level = 0;
 bool g_debug_enabled = true;
 ::std::string g_cur_phase;
 ::std::set< ::std::string>    g_debug_disable_map;
@@ -79,6 +83,7 @@ void init_debug_list()
     g_debug_disable_map.insert( "Typecheck Expressions (validate)" );
 
     g_debug_disable_map.insert( "Dump HIR" );
+    g_debug_disable_map.insert( "Expand HIR + Lower MIR" );
     g_debug_disable_map.insert( "Lower MIR" );
     g_debug_disable_map.insert( "MIR Validate" );
     g_debug_disable_map.insert( "MIR Validate Full Early" );
@@ -88,10 +93,12 @@ void init_debug_list()
     g_debug_disable_map.insert( "MIR Optimise" );
     g_debug_disable_map.insert( "MIR Validate PO" );
     g_debug_disable_map.insert( "MIR Validate Full" );
+    g_debug_disable_map.insert( "Release HIR Expressions" );
 
     g_debug_disable_map.insert( "HIR Serialise" );
     g_debug_disable_map.insert( "Trans Enumerate" );
     g_debug_disable_map.insert( "Trans Codegen" );
+    g_debug_disable_map.insert( "Interpret" );
 
     // Mutate this map using an environment variable
     const char* debug_string = ::std::getenv("MRUSTC_DEBUG");
@@ -163,11 +170,31 @@ struct ProgramParams
 
     ::std::set< ::std::string> features;
 
+    ConstEvalOptions    const_eval;
+    /// Number of threads used to parse module files (1 = parse inline)
+    unsigned int parse_threads = 1;
+    CodegenBackend  codegen_backend = CodegenBackend::C;
+    /// Run the crate's `main` with the MIR interpreter instead of generating an executable
+    bool interpret = false;
+    /// Save MIR for every function in the crate metadata (so the interpreter can run it from other crates)
+    bool save_all_mir = false;
+    /// Only generate code for a library's exported functions, other functions are emitted by the crates that use them
+    bool lib_on_demand = false;
+    /// Generate all code for an executable from MIR (dependencies need `-Z save-all-mir`), and don't link their objects
+    bool whole_program = false;
+    /// Skip the build if the inputs recorded by the last one are unchanged (see incremental.cpp)
+    bool incremental = false;
 
     struct {
         bool disable_mir_optimisations = false;
         bool full_validate = false;
         bool full_validate_early = false;
+        bool full_teardown = false;
+        bool split_expand = false;
+        // Emit C function bodies as structured code (instead of labels+gotos)
+        bool structured_c = false;
+        // Annotate the generated C with comments (item paths, local types, MIR statements)
+        bool verbose_c = false;
     } debug;
 
     ProgramParams(int argc, char *argv[]);
@@ -178,13 +205,16 @@ Rv CompilePhase(const char *name, Fcn f) {
     ::std::cout << name << ": V V V" << ::std::endl;
     g_cur_phase = name;
     g_debug_enabled = debug_enabled_update();
-    auto start = clock();
+    // Wall time (`clock()` is CPU time summed over all threads, so over-counts phases that use worker threads)
+    auto start = ::std::chrono::steady_clock::now();
     auto rv = f();
-    auto end = clock();
+    auto end = ::std::chrono::steady_clock::now();
+    // Return the memory of trees freed by this phase (e.g. AST after lowering, HIR expressions after MIR generation)
+    NodePool::trim();
     g_cur_phase = "";
     g_debug_enabled = debug_enabled_update();
 
-    ::std::cout <<"(" << ::std::fixed << ::std::setprecision(2) << static_cast<double>(end - start) / static_cast<double>(CLOCKS_PER_SEC) << " s) ";
+    ::std::cout <<"(" << ::std::fixed << ::std::setprecision(2) << ::std::chrono::duration<double>(end - start).count() << " s) ";
     ::std::cout << name << ": DONE";
     ::std::cout << ::std::endl;
     return rv;
@@ -194,8 +224,8 @@ void CompilePhaseV(const char *name, Fcn f) {
     CompilePhase<int>(name, [&]() { f(); return 0; });
 }
 
-/// main!
-int main(int argc, char *argv[])
+/// Compile a single crate (the body of `main`, also run by the compile server for each request)
+int compile_main(int argc, char *argv[])
 {
     init_debug_list();
     ProgramParams   params(argc, argv);
@@ -213,11 +243,43 @@ int main(int argc, char *argv[])
         Cfg_SetFlag("test");
     }
 
+    // Everything (other than the input files) that can change the output of an incremental build
+    ::std::string   incremental_opts;
+    if( params.incremental )
+    {
+        if( params.outfile == "" )
+        {
+            ::std::cerr << "`-Z incremental` requires an output file (`-o`)" << ::std::endl;
+            return 1;
+        }
+        for(int i = 1; i < argc; i ++)
+        {
+            incremental_opts += argv[i];
+            incremental_opts += '\0';
+        }
+        incremental_opts += ::std::string("CC=") + (getenv("CC") ? getenv("CC") : "");
+        #ifdef __linux__
+        // The compiler itself
+        uint64_t    compiler_hash = 0;
+        Incremental_HashFile("/proc/self/exe", compiler_hash);
+        incremental_opts += FMT('\0' << compiler_hash);
+        #endif
+
+        if( Incremental_IsFresh(params.outfile, incremental_opts) )
+        {
+            DEBUG(params.outfile << " is up to date");
+            return 0;
+        }
+        // Stale record, removed so a failed build isn't mistaken for a complete one
+        remove( (params.outfile + ".inc").c_str() );
+        Incremental_Enable();
+    }
+
     try
     {
         // Parse the crate into AST
         AST::Crate crate = CompilePhase<AST::Crate>("Parse", [&]() {
-            return Parse_Crate(params.infile);
+            return Parse_Crate(params.infile, params.parse_threads);
             });
         crate.m_test_harness = params.test_harness;
         crate.m_crate_name_suffix = params.crate_name_suffix;
@@ -334,7 +396,8 @@ int main(int argc, char *argv[])
             }
             if( crate.m_crate_type == ::AST::Crate::Type::Executable || params.test_harness || crate.m_crate_type == ::AST::Crate::Type::ProcMacro )
             {
-                bool allocator_crate_loaded = false;
+                // NOTE: A crate can be its own allocator (e.g. self-contained `#![no_core]` programs)
+                bool allocator_crate_loaded = crate.m_lang_items.count("mrustc-allocator") > 0;
                 bool panic_runtime_loaded = false;
                 bool panic_runtime_needed = false;
                 for(const auto& ec : crate.m_extern_crates)
@@ -410,6 +473,8 @@ int main(int argc, char *argv[])
             });
         // Deallocate the original crate
         crate = ::AST::Crate();
+        // Parsing and expansion are done, so few new spans will be created from here on
+        Span::release_dedup_index();
 
         // Replace type aliases (`type`) into the actual type
         // - Also inserts defaults in trait impls
@@ -430,7 +495,7 @@ int main(int argc, char *argv[])
             });
         // Basic constant evalulation (intergers/floats only)
         CompilePhaseV("Constant Evaluate", [&]() {
-            ConvertHIR_ConstantEvaluate(*hir_crate);
+            ConvertHIR_ConstantEvaluate(*hir_crate, params.const_eval);
             });
 
         CompilePhaseV("Dump HIR", [&]() {
@@ -461,33 +526,51 @@ int main(int argc, char *argv[])
             });
         // - Construct VTables for all traits and impls.
         CompilePhaseV("Expand HIR VTables", [&]() { HIR_Expand_VTables(*hir_crate); });
-        // - And calls can be turned into UFCS
-        CompilePhaseV("Expand HIR Calls", [&]() {
-            HIR_Expand_UfcsEverything(*hir_crate);
-            });
-        CompilePhaseV("Expand HIR Reborrows", [&]() {
-            HIR_Expand_Reborrows(*hir_crate);
-            });
-        CompilePhaseV("Expand HIR ErasedType", [&]() {
-            HIR_Expand_ErasedType(*hir_crate);
-            });
-        CompilePhaseV("Dump HIR", [&]() {
-            ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
-            HIR_Dump( os, *hir_crate );
-            });
-        // - Ensure that typeck worked (including Fn trait call insertion etc)
-        CompilePhaseV("Typecheck Expressions (validate)", [&]() {
-            Typecheck_Expressions_Validate(*hir_crate);
-            });
+        if( params.debug.split_expand )
+        {
+            // - And calls can be turned into UFCS
+            CompilePhaseV("Expand HIR Calls", [&]() {
+                HIR_Expand_UfcsEverything(*hir_crate);
+                });
+            CompilePhaseV("Expand HIR Reborrows", [&]() {
+                HIR_Expand_Reborrows(*hir_crate);
+                });
+            CompilePhaseV("Expand HIR ErasedType", [&]() {
+                HIR_Expand_ErasedType(*hir_crate);
+                });
+            CompilePhaseV("Dump HIR", [&]() {
+                ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
+                HIR_Dump( os, *hir_crate );
+                });
+            // - Ensure that typeck worked (including Fn trait call insertion etc)
+            CompilePhaseV("Typecheck Expressions (validate)", [&]() {
+                Typecheck_Expressions_Validate(*hir_crate);
+                });
 
-        if( params.last_stage == ProgramParams::STAGE_TYPECK ) {
-            return 0;
+            if( params.last_stage == ProgramParams::STAGE_TYPECK ) {
+                return 0;
+            }
+
+            // Lower expressions into MIR
+            CompilePhaseV("Lower MIR", [&]() {
+                HIR_GenerateMIR(*hir_crate);
+                });
         }
+        else
+        {
+            // - UFCS calls, reborrows, `impl Trait` expansion, validation and MIR lowering, done one body at a time
+            CompilePhaseV("Expand HIR + Lower MIR", [&]() {
+                HIR_Expand_Fused(*hir_crate, params.last_stage != ProgramParams::STAGE_TYPECK);
+                });
+            CompilePhaseV("Dump HIR", [&]() {
+                ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
+                HIR_Dump( os, *hir_crate );
+                });
 
-        // Lower expressions into MIR
-        CompilePhaseV("Lower MIR", [&]() {
-            HIR_GenerateMIR(*hir_crate);
-            });
+            if( params.last_stage == ProgramParams::STAGE_TYPECK ) {
+                return 0;
+            }
+        }
 
         CompilePhaseV("Dump MIR", [&]() {
             ::std::ofstream os (FMT(params.outfile << "_3_mir.rs"));
@@ -501,7 +584,7 @@ int main(int argc, char *argv[])
 
         // Second shot of constant evaluation (with full type information)
         CompilePhaseV("Constant Evaluate Full", [&]() {
-            ConvertHIR_ConstantEvaluateFull(*hir_crate);
+            ConvertHIR_ConstantEvaluateFull(*hir_crate, params.const_eval);
             });
         CompilePhaseV("Dump HIR", [&]() {
             ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
@@ -542,6 +625,11 @@ int main(int argc, char *argv[])
             return 0;
         }
 
+        // Nothing after this point reads HIR expressions (constant evaluation, trans, and serialisation only use MIR)
+        CompilePhaseV("Release HIR Expressions", [&]() {
+            HIR_ReleaseExprTrees(*hir_crate);
+            });
+
         // TODO: Pass to mark items that are
         // - Signature Exportable (public)
         // - MIR Exportable (public generic, #[inline], or used by a either of those)
@@ -556,6 +644,10 @@ int main(int argc, char *argv[])
             hir_crate->m_ext_libs.push_back(::HIR::ExternLibrary { libname });
         }
         trans_opt.emit_debug_info = params.emit_debug_info;
+        trans_opt.structured_c = params.debug.structured_c;
+        trans_opt.verbose_c = params.debug.verbose_c;
+        trans_opt.backend = params.codegen_backend;
+        trans_opt.whole_program = params.whole_program;
 
         // Generate code for non-generic public items (if requested)
         if( params.test_harness )
@@ -571,14 +663,14 @@ int main(int argc, char *argv[])
         case ::AST::Crate::Type::RustLib: {
             #if 1
             // Generate a .o
-            TransList   items = CompilePhase<TransList>("Trans Enumerate", [&]() { return Trans_Enumerate_Public(*hir_crate); });
+            TransList   items = CompilePhase<TransList>("Trans Enumerate", [&]() { return Trans_Enumerate_Public(*hir_crate, params.lib_on_demand); });
             CompilePhaseV("Trans Codegen", [&]() { Trans_Codegen(params.outfile + ".o", trans_opt, *hir_crate, items, false); });
             #endif
 
             // Save a loadable HIR dump
             CompilePhaseV("HIR Serialise", [&]() {
                 //HIR_Serialise(params.outfile + ".meta", *hir_crate);
-                HIR_Serialise(params.outfile, *hir_crate);
+                HIR_Serialise(params.outfile, *hir_crate, params.save_all_mir);
                 });
 
             // Link metatdata and object into a .rlib
@@ -586,11 +678,11 @@ int main(int argc, char *argv[])
         case ::AST::Crate::Type::RustDylib: {
             #if 1
             // Generate a .o
-            TransList   items = CompilePhase<TransList>("Trans Enumerate", [&]() { return Trans_Enumerate_Public(*hir_crate); });
+            TransList   items = CompilePhase<TransList>("Trans Enumerate", [&]() { return Trans_Enumerate_Public(*hir_crate, params.lib_on_demand); });
             CompilePhaseV("Trans Codegen", [&]() { Trans_Codegen(params.outfile + ".o", trans_opt, *hir_crate, items, false); });
             #endif
             // Save a loadable HIR dump
-            CompilePhaseV("HIR Serialise", [&]() { HIR_Serialise(params.outfile, *hir_crate); });
+            CompilePhaseV("HIR Serialise", [&]() { HIR_Serialise(params.outfile, *hir_crate, params.save_all_mir); });
 
             // Generate a .so/.dll
             // TODO: Codegen and include the metadata in a non-loadable segment
@@ -609,17 +701,82 @@ int main(int argc, char *argv[])
             CompilePhaseV("Trans Codegen", [&]() { Trans_Codegen(params.outfile + "-plugin", trans_opt, *hir_crate, items2, true); });
 
             hir_crate->m_lang_items.clear();    // Make sure that we're not exporting any lang items
-            CompilePhaseV("HIR Serialise", [&]() { HIR_Serialise(params.outfile, *hir_crate); });
+            CompilePhaseV("HIR Serialise", [&]() { HIR_Serialise(params.outfile, *hir_crate, params.save_all_mir); });
             break; }
         case ::AST::Crate::Type::Executable:
+            if( params.interpret )
+            {
+                // Run `main` directly, the process exit code is the program's
+                int rv = CompilePhase<int>("Interpret", [&]() { return Trans_Interpret_Main(*hir_crate, params.infile); });
+                ::std::cout.flush();
+                ::std::cerr.flush();
+                ::std::_Exit(rv);
+            }
             // Generate a binary
+            if( params.whole_program )
+            {
+                CompilePhaseV("Trans Load Saved Code", [&]() { Trans_Enumerate_LoadSavedCode(*hir_crate); });
+            }
             // - Enumerate items for translation
-            TransList items = CompilePhase<TransList>("Trans Enumerate", [&]() { return Trans_Enumerate_Main(*hir_crate); });
+            TransList items = CompilePhase<TransList>("Trans Enumerate", [&]() { return Trans_Enumerate_Main(*hir_crate, params.whole_program); });
             // - Perform codegen
             CompilePhaseV("Trans Codegen", [&]() { Trans_Codegen(params.outfile, trans_opt, *hir_crate, items, true); });
             // - Invoke linker?
             break;
         }
+
+        if( params.incremental )
+        {
+            ::std::vector< ::std::string>   outputs;
+            switch( crate_type )
+            {
+            case ::AST::Crate::Type::Unknown:
+            case ::AST::Crate::Type::CDylib:
+                break;
+            case ::AST::Crate::Type::ProcMacro:
+                outputs.push_back(params.outfile + "-plugin");
+                // Fall through (also has the library outputs)
+            case ::AST::Crate::Type::RustLib:
+            case ::AST::Crate::Type::RustDylib:
+                outputs.push_back(params.outfile);
+                outputs.push_back(params.outfile + ".o");
+                break;
+            case ::AST::Crate::Type::Executable:
+                outputs.push_back(params.outfile);
+                // Executables also depend on the code of the crates they link (libraries only need the metadata)
+                if( !params.whole_program )
+                {
+                    for(const auto& ec : hir_crate->m_ext_crates)
+                        Incremental_AddInput(ec.second.m_path + ".o");
+                }
+                // - And the native libraries (`-l` and `#[link]`), as found in the same search paths as the linker
+                {
+                    ::std::vector< ::std::string>   link_dirs = hir_crate->m_link_paths;
+                    for(const auto& ec : hir_crate->m_ext_crates)
+                        link_dirs.insert(link_dirs.end(), ec.second.m_data->m_link_paths.begin(), ec.second.m_data->m_link_paths.end());
+                    for(const auto& lib : hir_crate->m_ext_libs)
+                        Incremental_AddLinkLibrary(lib.name, link_dirs);
+                    for(const auto& ec : hir_crate->m_ext_crates)
+                        for(const auto& lib : ec.second.m_data->m_ext_libs)
+                            Incremental_AddLinkLibrary(lib.name, link_dirs);
+                }
+                break;
+            }
+            if( !outputs.empty() )
+            {
+                Incremental_Save(params.outfile, incremental_opts, outputs);
+            }
+        }
+
+        // All outputs have been written and closed by this point.
+        // - Skip destruction of the crate (and all loaded extern crates), the OS reclaims it much faster.
+        // - Full teardown can be requested for leak checking (`-Z full-teardown` or MRUSTC_FULL_TEARDOWN)
+        if( !params.debug.full_teardown && !getenv("MRUSTC_FULL_TEARDOWN") )
+        {
+            ::std::cout.flush();
+            ::std::cerr.flush();
+            ::std::_Exit(0);
+        }
     }
     catch(unsigned int) {}
     //catch(const CompileError::Base& e)
@@ -641,6 +798,21 @@ int main(int argc, char *argv[])
     return 0;
 }
 
+/// main!
+int main(int argc, char *argv[])
+{
+    // Persistent server mode (see compile_server.cpp)
+    if( argc == 3 && ::std::strcmp(argv[1], "--server") == 0 )
+    {
+        // Crates are loaded outside of any compile phase, so disable debug like the "LoadCrates" phase
+        init_debug_list();
+        g_cur_phase = "LoadCrates";
+        g_debug_enabled = debug_enabled_update();
+        return CompileServer_Run(argv[2], compile_main);
+    }
+    return compile_main(argc, argv);
+}
+
 ProgramParams::ProgramParams(int argc, char *argv[])
 {
     // Hacky command-line parsing
@@ -713,6 +885,58 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                 else if( optname == "full-validate-early" ) {
                     this->debug.full_validate_early = true;
                 }
+                else if( optname == "full-teardown" ) {
+                    this->debug.full_teardown = true;
+                }
+                else if( optname == "split-expand" ) {
+                    this->debug.split_expand = true;
+                }
+                else if( optname == "structured-c" ) {
+                    this->debug.structured_c = true;
+                }
+                else if( optname == "verbose-c" ) {
+                    this->debug.verbose_c = true;
+                }
+                else if( optname.compare(0, 17, "const-eval-limit=") == 0 ) {
+                    this->const_eval.step_limit = static_cast<unsigned int>( ::std::strtoul(optname.c_str() + 17, nullptr, 10) );
+                }
+                else if( optname.compare(0, 17, "const-eval-depth=") == 0 ) {
+                    this->const_eval.call_depth_limit = static_cast<unsigned int>( ::std::strtoul(optname.c_str() + 17, nullptr, 10) );
+                }
+                else if( optname.compare(0, 14, "parse-threads=") == 0 ) {
+                    this->parse_threads = ::std::max(1u, static_cast<unsigned int>( ::std::strtoul(optname.c_str() + 14, nullptr, 10) ));
+                }
+                else if( optname.compare(0, 16, "codegen-backend=") == 0 ) {
+                    auto name = optname.substr(16);
+                    if( name == "c" ) {
+                        this->codegen_backend = CodegenBackend::C;
+                    }
+                    else if( name == "x86_64" ) {
+                        this->codegen_backend = CodegenBackend::X86_64;
+                    }
+                    else {
+                        ::std::cerr << "Unknown codegen backend: '" << name << "'" << ::std::endl;
+                        exit(1);
+                    }
+                }
+                else if( optname == "interpret" ) {
+                    this->interpret = true;
+                }
+                else if( optname == "save-all-mir" ) {
+                    this->save_all_mir = true;
+                }
+                else if( optname == "lib-on-demand" ) {
+                    this->lib_on_demand = true;
+                }
+                else if( optname == "whole-program" ) {
+                    this->whole_program = true;
+                }
+                else if( optname == "incremental" ) {
+                    this->incremental = true;
+                }
+                else if( optname == "const-eval-profile" ) {
+                    this->const_eval.profile = true;
+                }
                 else {
                     ::std::cerr << "Unknown debug option: '" << optname << "'" << ::std::endl;
                     exit(1);
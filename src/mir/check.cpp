@@ -182,7 +182,9 @@ void MIR_Validate_ValState(::MIR::TypeResolve& state, const ::MIR::Function& fcn
 
         void mark_validity(const ::MIR::TypeResolve& state, const ::MIR::LValue& lv, bool is_valid)
         {
-            TU_MATCH_DEF( ::MIR::LValue, (lv), (e),
+            if( !lv.m_wrappers.empty() )
+                return ;
+            TU_MATCH_DEF( ::MIR::LValue::Storage, (lv.m_root), (e),
             (
                 ),
             (Return,
@@ -202,7 +204,7 @@ void MIR_Validate_ValState(::MIR::TypeResolve& state, const ::MIR::Function& fcn
         }
         void ensure_valid(const ::MIR::TypeResolve& state, const ::MIR::LValue& lv)
         {
-            TU_MATCH( ::MIR::LValue, (lv), (e),
+            TU_MATCHA( (lv.m_root), (e),
             (Return,
                 if( this->ret_state != State::Valid )
                     MIR_BUG(state, "Use of non-valid lvalue - " << lv);
@@ -218,21 +220,13 @@ void MIR_Validate_ValState(::MIR::TypeResolve& state, const ::MIR::Function& fcn
                     MIR_BUG(state, "Use of non-valid lvalue - " << lv);
                 ),
             (Static,
-                ),
-            (Field,
-                ensure_valid(state, *e.val);
-                ),
-            (Deref,
-                ensure_valid(state, *e.val);
-                ),
-            (Index,
-                ensure_valid(state, *e.val);
-                ensure_valid(state, *e.idx);
-                ),
-            (Downcast,
-                ensure_valid(state, *e.val);
                 )
             )
+            lv.for_each_index([&](unsigned idx) {
+                MIR_ASSERT(state, idx < this->locals.size(), "Local index out of range");
+                if( this->locals[idx] != State::Valid )
+                    MIR_BUG(state, "Use of non-valid lvalue - " << ::MIR::LValue::new_Local(idx) << " (index in " << lv << ")");
+                });
         }
         void move_val(const ::MIR::TypeResolve& state, const ::MIR::LValue& lv)
         {
@@ -413,7 +407,7 @@ void MIR_Validate_ValState(::MIR::TypeResolve& state, const ::MIR::Function& fcn
             ),
         (Return,
             // Check if the return value has been set
-            val_state.ensure_valid( state, ::MIR::LValue::make_Return({}) );
+            val_state.ensure_valid( state, ::MIR::LValue::new_Return() );
             // Ensure that no other non-Copy values are valid
             for(unsigned int i = 0; i < val_state.locals.size(); i ++)
             {
@@ -154,7 +154,7 @@ namespace
             return true;
         }
 
-        StateFmt fmt_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue& lv) const {
+        StateFmt fmt_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue::CRef& lv) const {
             return StateFmt(*this, get_lvalue_state(mir_res, lv));
         }
 
@@ -444,9 +444,63 @@ namespace
             MIR_ASSERT(mir_res, vs.index-1 < this->inner_states.size(), "");
             return this->inner_states.at( vs.index - 1 );
         }
-        const State& get_lvalue_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue& lv) const
+        const State& get_lvalue_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue::CRef& lv) const
         {
-            TU_MATCHA( (lv), (e),
+            if( const auto* w = lv.outer_wrapper() )
+            {
+                const auto inner = lv.inner_ref();
+                switch(w->tag())
+                {
+                case ::MIR::LValue::Wrapper::TAG_Field: {
+                    const auto& vs = get_lvalue_state(mir_res, inner);
+                    if( vs.is_composite() )
+                    {
+                        const auto& states = this->get_composite(mir_res, vs);
+                        MIR_ASSERT(mir_res, w->as_Field() < states.size(), "Field index out of range");
+                        return states[w->as_Field()];
+                    }
+                    else
+                    {
+                        return vs;
+                    }
+                    }
+                case ::MIR::LValue::Wrapper::TAG_Deref: {
+                    const auto& vs = get_lvalue_state(mir_res, inner);
+                    if( vs.is_composite() )
+                    {
+                        MIR_TODO(mir_res, "Deref with composite state");
+                    }
+                    else
+                    {
+                        return vs;
+                    }
+                    }
+                case ::MIR::LValue::Wrapper::TAG_Index: {
+                    const auto& vs_v = get_lvalue_state(mir_res, inner);
+                    const auto& vs_i = locals.at(w->as_Index());
+                    MIR_ASSERT(mir_res, !vs_v.is_composite(), "");
+                    MIR_ASSERT(mir_res, !vs_i.is_composite(), "");
+                    //return State(vs_v.is_valid() && vs_i.is_valid());
+                    MIR_ASSERT(mir_res, vs_i.is_valid(), "Indexing with an invalidated value");
+                    return vs_v;
+                    }
+                case ::MIR::LValue::Wrapper::TAG_Downcast: {
+                    const auto& vs_v = get_lvalue_state(mir_res, inner);
+                    if( vs_v.is_composite() )
+                    {
+                        const auto& states = this->get_composite(mir_res, vs_v);
+                        MIR_ASSERT(mir_res, states.size() == 1, "Downcast on composite of invalid size - " << StateFmt(*this, vs_v));
+                        return states[0];
+                    }
+                    else
+                    {
+                        return vs_v;
+                    }
+                    }
+                }
+                throw "";
+            }
+            TU_MATCHA( (lv.root()), (e),
             (Return,
                 return return_value;
                 ),
@@ -459,52 +513,6 @@ namespace
             (Static,
                 static State    state_of_static(true);
                 return state_of_static;
-                ),
-            (Field,
-                const auto& vs = get_lvalue_state(mir_res, *e.val);
-                if( vs.is_composite() )
-                {
-                    const auto& states = this->get_composite(mir_res, vs);
-                    MIR_ASSERT(mir_res, e.field_index < states.size(), "Field index out of range");
-                    return states[e.field_index];
-                }
-                else
-                {
-                    return vs;
-                }
-                ),
-            (Deref,
-                const auto& vs = get_lvalue_state(mir_res, *e.val);
-                if( vs.is_composite() )
-                {
-                    MIR_TODO(mir_res, "Deref with composite state");
-                }
-                else
-                {
-                    return vs;
-                }
-                ),
-            (Index,
-                const auto& vs_v = get_lvalue_state(mir_res, *e.val);
-                const auto& vs_i = get_lvalue_state(mir_res, *e.idx);
-                MIR_ASSERT(mir_res, !vs_v.is_composite(), "");
-                MIR_ASSERT(mir_res, !vs_i.is_composite(), "");
-                //return State(vs_v.is_valid() && vs_i.is_valid());
-                MIR_ASSERT(mir_res, vs_i.is_valid(), "Indexing with an invalidated value");
-                return vs_v;
-                ),
-            (Downcast,
-                const auto& vs_v = get_lvalue_state(mir_res, *e.val);
-                if( vs_v.is_composite() )
-                {
-                    const auto& states = this->get_composite(mir_res, vs_v);
-                    MIR_ASSERT(mir_res, states.size() == 1, "Downcast on composite of invalid size - " << StateFmt(*this, vs_v));
-                    return states[0];
-                }
-                else
-                {
-                    return vs_v;
-                }
                 )
             )
             throw "";
@@ -519,146 +527,154 @@ namespace
             }
         }
 
-        void set_lvalue_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue& lv, State new_vs)
+        void set_lvalue_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue::CRef& lv, State new_vs)
         {
             TRACE_FUNCTION_F(lv << " = " << StateFmt(*this, new_vs) << " (from " << StateFmt(*this, get_lvalue_state(mir_res, lv)) << ")");
-            TU_MATCHA( (lv), (e),
-            (Return,
-                this->clear_state(mir_res, return_value);
-                return_value = mv$(new_vs);
-                ),
-            (Argument,
-                auto& slot = args.at(e.idx);
-                this->clear_state(mir_res, slot);
-                slot = mv$(new_vs);
-                ),
-            (Local,
-                auto& slot = locals.at(e);
-                this->clear_state(mir_res, slot);
-                slot = mv$(new_vs);
-                ),
-            (Static,
-                // Ignore.
-                ),
-            (Field,
-                const auto& cur_vs = get_lvalue_state(mir_res, *e.val);
-                if( !cur_vs.is_composite() && cur_vs == new_vs )
-                {
-                    // Not a composite, and no state change
-                }
-                else
+            if( const auto* w = lv.outer_wrapper() )
+            {
+                const auto inner = lv.inner_ref();
+                switch(w->tag())
                 {
-                    ::std::vector<State>* states_p;
-                    if( !cur_vs.is_composite() )
+                case ::MIR::LValue::Wrapper::TAG_Field: {
+                    const auto& cur_vs = get_lvalue_state(mir_res, inner);
+                    if( !cur_vs.is_composite() && cur_vs == new_vs )
                     {
-                        ::HIR::TypeRef    tmp;
-                        const auto& ty = mir_res.get_lvalue_type(tmp, *e.val);
-                        unsigned int n_fields = 0;
-                        if( const auto* e = ty.m_data.opt_Tuple() )
-                        {
-                            n_fields = e->size();
-                        }
-                        else if( ty.m_data.is_Path() && ty.m_data.as_Path().binding.is_Struct() )
+                        // Not a composite, and no state change
+                    }
+                    else
+                    {
+                        ::std::vector<State>* states_p;
+                        if( !cur_vs.is_composite() )
                         {
-                            const auto& e = ty.m_data.as_Path().binding.as_Struct();
-                            TU_MATCHA( (e->m_data), (se),
-                            (Unit,
-                                n_fields = 0;
-                                ),
-                            (Tuple,
-                                n_fields = se.size();
-                                ),
-                            (Named,
-                                n_fields = se.size();
+                            ::HIR::TypeRef    tmp;
+                            const auto& ty = mir_res.get_lvalue_type(tmp, inner);
+                            unsigned int n_fields = 0;
+                            if( const auto* e = ty.m_data.opt_Tuple() )
+                            {
+                                n_fields = e->size();
+                            }
+                            else if( ty.m_data.is_Path() && ty.m_data.as_Path().binding.is_Struct() )
+                            {
+                                const auto& e = ty.m_data.as_Path().binding.as_Struct();
+                                TU_MATCHA( (e->m_data), (se),
+                                (Unit,
+                                    n_fields = 0;
+                                    ),
+                                (Tuple,
+                                    n_fields = se.size();
+                                    ),
+                                (Named,
+                                    n_fields = se.size();
+                                    )
                                 )
-                            )
+                            }
+                            else {
+                                MIR_BUG(mir_res, "Unknown type being accessed with Field - " << ty);
+                            }
+
+                            auto new_cur_vs = this->allocate_composite(n_fields, cur_vs);
+                            set_lvalue_state(mir_res, inner, State(new_cur_vs));
+                            states_p = &this->get_composite(mir_res, new_cur_vs);
                         }
-                        else {
-                            MIR_BUG(mir_res, "Unknown type being accessed with Field - " << ty);
+                        else
+                        {
+                            states_p = &this->get_composite(mir_res, cur_vs);
                         }
-
-                        auto new_cur_vs = this->allocate_composite(n_fields, cur_vs);
-                        set_lvalue_state(mir_res, *e.val, State(new_cur_vs));
-                        states_p = &this->get_composite(mir_res, new_cur_vs);
-                    }
-                    else
-                    {
-                        states_p = &this->get_composite(mir_res, cur_vs);
+                        // Get composite state and assign into it
+                        auto& states = *states_p;
+                        MIR_ASSERT(mir_res, w->as_Field() < states.size(), "Field index out of range");
+                        this->clear_state(mir_res, states[w->as_Field()]);
+                        states[w->as_Field()] = mv$(new_vs);
                     }
-                    // Get composite state and assign into it
-                    auto& states = *states_p;
-                    MIR_ASSERT(mir_res, e.field_index < states.size(), "Field index out of range");
-                    this->clear_state(mir_res, states[e.field_index]);
-                    states[e.field_index] = mv$(new_vs);
-                }
-                ),
-            (Deref,
-                const auto& cur_vs = get_lvalue_state(mir_res, *e.val);
-                if( !cur_vs.is_composite() && cur_vs == new_vs )
-                {
-                    // Not a composite, and no state change
-                }
-                else
-                {
-                    ::std::vector<State>* states_p;
-                    if( !cur_vs.is_composite() )
+                    } break;
+                case ::MIR::LValue::Wrapper::TAG_Deref: {
+                    const auto& cur_vs = get_lvalue_state(mir_res, inner);
+                    if( !cur_vs.is_composite() && cur_vs == new_vs )
                     {
-                        //::HIR::TypeRef    tmp;
-                        //const auto& ty = mir_res.get_lvalue_type(tmp, *e.val);
-                        // TODO: Should this check if the type is Box?
-
-                        auto new_cur_vs = this->allocate_composite(2, cur_vs);
-                        set_lvalue_state(mir_res, *e.val, State(new_cur_vs));
-                        states_p = &this->get_composite(mir_res, new_cur_vs);
+                        // Not a composite, and no state change
                     }
                     else
                     {
-                        states_p = &this->get_composite(mir_res, cur_vs);
-                    }
-                    // Get composite state and assign into it
-                    auto& states = *states_p;
-                    MIR_ASSERT(mir_res, states.size() == 2, "Deref with invalid state list size");
-                    this->clear_state(mir_res, states[1]);
-                    states[1] = mv$(new_vs);
-                }
-                ),
-            (Index,
-                const auto& vs_v = get_lvalue_state(mir_res, *e.val);
-                const auto& vs_i = get_lvalue_state(mir_res, *e.idx);
-                MIR_ASSERT(mir_res, !vs_v.is_composite(), "");
-                MIR_ASSERT(mir_res, !vs_i.is_composite(), "");
-
-                MIR_ASSERT(mir_res, vs_v.is_valid(), "Indexing an invalid value");
-                MIR_ASSERT(mir_res, vs_i.is_valid(), "Indexing with an invalid index");
+                        ::std::vector<State>* states_p;
+                        if( !cur_vs.is_composite() )
+                        {
+                            //::HIR::TypeRef    tmp;
+                            //const auto& ty = mir_res.get_lvalue_type(tmp, inner);
+                            // TODO: Should this check if the type is Box?
 
-                // NOTE: Ignore
-                ),
-            (Downcast,
-                const auto& cur_vs = get_lvalue_state(mir_res, *e.val);
-                if( !cur_vs.is_composite() && cur_vs == new_vs )
-                {
-                    // Not a composite, and no state change
-                }
-                else
-                {
-                    ::std::vector<State>* states_p;
-                    if( !cur_vs.is_composite() )
+                            auto new_cur_vs = this->allocate_composite(2, cur_vs);
+                            set_lvalue_state(mir_res, inner, State(new_cur_vs));
+                            states_p = &this->get_composite(mir_res, new_cur_vs);
+                        }
+                        else
+                        {
+                            states_p = &this->get_composite(mir_res, cur_vs);
+                        }
+                        // Get composite state and assign into it
+                        auto& states = *states_p;
+                        MIR_ASSERT(mir_res, states.size() == 2, "Deref with invalid state list size");
+                        this->clear_state(mir_res, states[1]);
+                        states[1] = mv$(new_vs);
+                    }
+                    } break;
+                case ::MIR::LValue::Wrapper::TAG_Index: {
+                    const auto& vs_v = get_lvalue_state(mir_res, inner);
+                    const auto& vs_i = locals.at(w->as_Index());
+                    MIR_ASSERT(mir_res, !vs_v.is_composite(), "");
+                    MIR_ASSERT(mir_res, !vs_i.is_composite(), "");
+
+                    MIR_ASSERT(mir_res, vs_v.is_valid(), "Indexing an invalid value");
+                    MIR_ASSERT(mir_res, vs_i.is_valid(), "Indexing with an invalid index");
+
+                    // NOTE: Ignore
+                    } break;
+                case ::MIR::LValue::Wrapper::TAG_Downcast: {
+                    const auto& cur_vs = get_lvalue_state(mir_res, inner);
+                    if( !cur_vs.is_composite() && cur_vs == new_vs )
                     {
-                        auto new_cur_vs = this->allocate_composite(1, cur_vs);
-                        set_lvalue_state(mir_res, *e.val, State(new_cur_vs));
-                        states_p = &this->get_composite(mir_res, new_cur_vs);
+                        // Not a composite, and no state change
                     }
                     else
                     {
-                        states_p = &this->get_composite(mir_res, cur_vs);
-                    }
+                        ::std::vector<State>* states_p;
+                        if( !cur_vs.is_composite() )
+                        {
+                            auto new_cur_vs = this->allocate_composite(1, cur_vs);
+                            set_lvalue_state(mir_res, inner, State(new_cur_vs));
+                            states_p = &this->get_composite(mir_res, new_cur_vs);
+                        }
+                        else
+                        {
+                            states_p = &this->get_composite(mir_res, cur_vs);
+                        }
 
-                    // Get composite state and assign into it
-                    auto& states = *states_p;
-                    MIR_ASSERT(mir_res, states.size() == 1, "Downcast on composite of invalid size - " << *e.val << " - " << this->fmt_state(mir_res, *e.val));
-                    this->clear_state(mir_res, states[0]);
-                    states[0] = mv$(new_vs);
+                        // Get composite state and assign into it
+                        auto& states = *states_p;
+                        MIR_ASSERT(mir_res, states.size() == 1, "Downcast on composite of invalid size - " << inner << " - " << this->fmt_state(mir_res, inner));
+                        this->clear_state(mir_res, states[0]);
+                        states[0] = mv$(new_vs);
+                    }
+                    } break;
                 }
+                return ;
+            }
+            TU_MATCHA( (lv.root()), (e),
+            (Return,
+                this->clear_state(mir_res, return_value);
+                return_value = mv$(new_vs);
+                ),
+            (Argument,
+                auto& slot = args.at(e.idx);
+                this->clear_state(mir_res, slot);
+                slot = mv$(new_vs);
+                ),
+            (Local,
+                auto& slot = locals.at(e);
+                this->clear_state(mir_res, slot);
+                slot = mv$(new_vs);
+                ),
+            (Static,
+                // Ignore.
                 )
             )
         }
@@ -962,7 +978,7 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
         (Incomplete,
             ),
         (Return,
-            state.ensure_lvalue_valid(mir_res, ::MIR::LValue::make_Return({}));
+            state.ensure_lvalue_valid(mir_res, ::MIR::LValue::new_Return());
             if( ENABLE_LEAK_DETECTOR )
             {
                 auto ensure_dropped = [&](const State& s, const ::MIR::LValue& lv) {
@@ -978,10 +994,10 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
                     }
                     };
                 for(unsigned i = 0; i < state.locals.size(); i ++ ) {
-                    ensure_dropped(state.locals[i], ::MIR::LValue::make_Local(i));
+                    ensure_dropped(state.locals[i], ::MIR::LValue::new_Local(i));
                 }
                 for(unsigned i = 0; i < state.args.size(); i ++ ) {
-                    ensure_dropped(state.args[i], ::MIR::LValue::make_Argument({i}));
+                    ensure_dropped(state.args[i], ::MIR::LValue::new_Argument(i));
                 }
             }
             ),
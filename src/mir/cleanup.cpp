@@ -32,7 +32,7 @@ struct MirMutator
 
     ::MIR::LValue new_temporary(::HIR::TypeRef ty)
     {
-        auto rv = ::MIR::LValue::make_Local( static_cast<unsigned int>(m_fcn.locals.size()) );
+        auto rv = ::MIR::LValue::new_Local( static_cast<unsigned int>(m_fcn.locals.size()) );
         m_fcn.locals.push_back( mv$(ty) );
         return rv;
     }
@@ -219,38 +219,60 @@ const ::HIR::Literal* MIR_Cleanup_GetConstant(const Span& sp, const StaticTraitR
         return ::MIR::RValue::make_Tuple({ mv$(lvals) });
         ),
     (Array,
-        MIR_ASSERT(state, lit.is_List(), "Non-list literal for Array - " << lit);
-        const auto& vals = lit.as_List();
+        MIR_ASSERT(state, lit.is_array_like(), "Non-list literal for Array - " << lit);
+        auto len = lit.list_size();
 
-        MIR_ASSERT(state, vals.size() == te.size_val, "Literal size mismatched with array size");
+        MIR_ASSERT(state, len == te.size_val, "Literal size mismatched with array size");
 
-        bool is_all_same = false;
-        if( vals.size() > 1 )
+        // Get the repeated value (if all entries are the same)
+        ::HIR::Literal  tmp_lit;
+        const ::HIR::Literal* same_val = nullptr;
+        if( const auto* le = lit.opt_Repeat() )
         {
-            is_all_same = true;
-            for(unsigned int i = 1; i < vals.size(); i ++) {
-
-                if( vals[i] != vals[0] ) {
-                    is_all_same = false;
-                    break ;
+            same_val = &*le->val;
+        }
+        else if( len > 1 )
+        {
+            if( const auto* le = lit.opt_List() )
+            {
+                same_val = &(*le)[0];
+                for(unsigned int i = 1; i < le->size(); i ++) {
+                    if( (*le)[i] != *same_val ) {
+                        same_val = nullptr;
+                        break ;
+                    }
+                }
+            }
+            else
+            {
+                tmp_lit = lit.list_get(0);
+                same_val = &tmp_lit;
+                for(unsigned int i = 1; i < len; i ++) {
+                    if( lit.list_get(i) != tmp_lit ) {
+                        same_val = nullptr;
+                        break ;
+                    }
                 }
             }
         }
 
-        if( is_all_same )
+        if( same_val )
         {
-            auto rval = MIR_Cleanup_LiteralToRValue(state, mutator, vals[0], te.inner->clone(), ::HIR::GenericPath());
+            auto rval = MIR_Cleanup_LiteralToRValue(state, mutator, *same_val, te.inner->clone(), ::HIR::GenericPath());
             auto data_lval = mutator.in_temporary(te.inner->clone(), mv$(rval));
             return ::MIR::RValue::make_SizedArray({ mv$(data_lval), static_cast<unsigned int>(te.size_val) });
         }
         else
         {
             ::std::vector< ::MIR::Param>   lvals;
-            lvals.reserve( vals.size() );
+            lvals.reserve( len );
 
-            for(const auto& val: vals)
+            for(unsigned int i = 0; i < len; i ++)
             {
-                auto rval = MIR_Cleanup_LiteralToRValue(state, mutator, val, te.inner->clone(), ::HIR::GenericPath());
+                auto rval = lit.is_List()
+                    ? MIR_Cleanup_LiteralToRValue(state, mutator, lit.as_List()[i], te.inner->clone(), ::HIR::GenericPath())
+                    : MIR_Cleanup_LiteralToRValue(state, mutator, lit.list_get(i), te.inner->clone(), ::HIR::GenericPath())
+                    ;
                 lvals.push_back( mutator.in_temporary(te.inner->clone(), mv$(rval)) );
             }
 
@@ -393,8 +415,8 @@ const ::HIR::Literal* MIR_Cleanup_GetConstant(const Span& sp, const StaticTraitR
             // 2. Borrow that slot
             if( const auto* tie = te.inner->m_data.opt_Slice() )
             {
-                MIR_ASSERT(state, inner_lit.is_List(), "BorrowData of non-list resulting in &[T]");
-                auto size = inner_lit.as_List().size();
+                MIR_ASSERT(state, inner_lit.is_array_like(), "BorrowData of non-list resulting in &[T]");
+                auto size = inner_lit.list_size();
                 auto inner_ty = ::HIR::TypeRef::new_array(tie->inner->clone(), size);
                 auto size_val = ::MIR::Param( ::MIR::Constant::make_Uint({ size, ::HIR::CoreType::Usize }) );
                 auto ptr_ty = ::HIR::TypeRef::new_borrow(te.type, inner_ty.clone());
@@ -470,12 +492,13 @@ const ::HIR::Literal* MIR_Cleanup_GetConstant(const Span& sp, const StaticTraitR
     // Allocate a temporary for the vtable pointer itself
     auto vtable_lv = mutator.new_temporary( mv$(vtable_ty) );
     // - Load the vtable and store it
-    auto ptr_lv = ::MIR::LValue::make_Deref({ box$(receiver_lvp.clone()) });
+    auto ptr_lv = ::MIR::LValue::new_Deref(receiver_lvp.clone());
     MIR_Cleanup_LValue(state, mutator,  ptr_lv);
-    auto vtable_rval = ::MIR::RValue::make_DstMeta({ mv$(*ptr_lv.as_Deref().val) });
+    ptr_lv.pop_wrapper();
+    auto vtable_rval = ::MIR::RValue::make_DstMeta({ mv$(ptr_lv) });
     mutator.push_statement( ::MIR::Statement::make_Assign({ vtable_lv.clone(), mv$(vtable_rval) }) );
 
-    auto fcn_lval = ::MIR::LValue::make_Field({ box$(::MIR::LValue::make_Deref({ box$(vtable_lv) })), vtable_idx });
+    auto fcn_lval = ::MIR::LValue::new_Field(::MIR::LValue::new_Deref(mv$(vtable_lv)), vtable_idx);
 
     ::HIR::TypeRef  tmp;
     const auto& ty = state.get_lvalue_type(tmp, fcn_lval);
@@ -505,10 +528,10 @@ const ::HIR::Literal* MIR_Cleanup_GetConstant(const Span& sp, const StaticTraitR
                         for(unsigned int i = 0; i < se.size(); i ++ ) {
                             auto val = (i == se.size() - 1 ? mv$(lv) : lv.clone());
                             if( i == str.m_struct_markings.coerce_unsized_index ) {
-                                vals.push_back( H::get_unit_ptr(state, mutator, monomorph(se[i].ent), ::MIR::LValue::make_Field({ box$(val), i }) ) );
+                                vals.push_back( H::get_unit_ptr(state, mutator, monomorph(se[i].ent), ::MIR::LValue::new_Field(mv$(val), i) ) );
                             }
                             else {
-                                vals.push_back( ::MIR::LValue::make_Field({ box$(val), i }) );
+                                vals.push_back( ::MIR::LValue::new_Field(mv$(val), i) );
                             }
                         }
                         ),
@@ -516,10 +539,10 @@ const ::HIR::Literal* MIR_Cleanup_GetConstant(const Span& sp, const StaticTraitR
                         for(unsigned int i = 0; i < se.size(); i ++ ) {
                             auto val = (i == se.size() - 1 ? mv$(lv) : lv.clone());
                             if( i == str.m_struct_markings.coerce_unsized_index ) {
-                                vals.push_back( H::get_unit_ptr(state, mutator, monomorph(se[i].second.ent), ::MIR::LValue::make_Field({ box$(val), i }) ) );
+                                vals.push_back( H::get_unit_ptr(state, mutator, monomorph(se[i].second.ent), ::MIR::LValue::new_Field(mv$(val), i) ) );
                             }
                             else {
-                                vals.push_back( ::MIR::LValue::make_Field({ box$(val), i }) );
+                                vals.push_back( ::MIR::LValue::new_Field(mv$(val), i) );
                             }
                         }
                         )
@@ -755,7 +778,7 @@ bool MIR_Cleanup_Unsize_GetMetadata(const ::MIR::TypeResolve& state, MirMutator&
                     auto ty_d = monomorphise_type_with(state.sp, se[i].ent, monomorph_cb_d, false);
                     auto ty_s = monomorphise_type_with(state.sp, se[i].ent, monomorph_cb_s, false);
 
-                    auto new_rval = MIR_Cleanup_CoerceUnsized(state, mutator, ty_d, ty_s,  ::MIR::LValue::make_Field({ box$(value.clone()), i }));
+                    auto new_rval = MIR_Cleanup_CoerceUnsized(state, mutator, ty_d, ty_s,  ::MIR::LValue::new_Field(value.clone(), i));
                     auto new_lval = mutator.in_temporary( mv$(ty_d), mv$(new_rval) );
 
                     ents.push_back( mv$(new_lval) );
@@ -764,14 +787,14 @@ bool MIR_Cleanup_Unsize_GetMetadata(const ::MIR::TypeResolve& state, MirMutator&
                 {
                     auto ty_d = monomorphise_type_with(state.sp, se[i].ent, monomorph_cb_d, false);
 
-                    auto new_rval = ::MIR::RValue::make_Cast({ ::MIR::LValue::make_Field({ box$(value.clone()), i }), ty_d.clone() });
+                    auto new_rval = ::MIR::RValue::make_Cast({ ::MIR::LValue::new_Field(value.clone(), i), ty_d.clone() });
                     auto new_lval = mutator.in_temporary( mv$(ty_d), mv$(new_rval) );
 
                     ents.push_back( mv$(new_lval) );
                 }
                 else
                 {
-                    ents.push_back( ::MIR::LValue::make_Field({ box$(value.clone()), i}) );
+                    ents.push_back( ::MIR::LValue::new_Field(value.clone(), i) );
                 }
             }
             ),
@@ -784,7 +807,7 @@ bool MIR_Cleanup_Unsize_GetMetadata(const ::MIR::TypeResolve& state, MirMutator&
                     auto ty_d = monomorphise_type_with(state.sp, se[i].second.ent, monomorph_cb_d, false);
                     auto ty_s = monomorphise_type_with(state.sp, se[i].second.ent, monomorph_cb_s, false);
 
-                    auto new_rval = MIR_Cleanup_CoerceUnsized(state, mutator, ty_d, ty_s,  ::MIR::LValue::make_Field({ box$(value.clone()), i }));
+                    auto new_rval = MIR_Cleanup_CoerceUnsized(state, mutator, ty_d, ty_s,  ::MIR::LValue::new_Field(value.clone(), i));
                     auto new_lval = mutator.new_temporary( mv$(ty_d) );
                     mutator.push_statement( ::MIR::Statement::make_Assign({ new_lval.clone(), mv$(new_rval) }) );
 
@@ -794,14 +817,14 @@ bool MIR_Cleanup_Unsize_GetMetadata(const ::MIR::TypeResolve& state, MirMutator&
                 {
                     auto ty_d = monomorphise_type_with(state.sp, se[i].second.ent, monomorph_cb_d, false);
 
-                    auto new_rval = ::MIR::RValue::make_Cast({ ::MIR::LValue::make_Field({ box$(value.clone()), i }), ty_d.clone() });
+                    auto new_rval = ::MIR::RValue::make_Cast({ ::MIR::LValue::new_Field(value.clone(), i), ty_d.clone() });
                     auto new_lval = mutator.in_temporary( mv$(ty_d), mv$(new_rval) );
 
                     ents.push_back( mv$(new_lval) );
                 }
                 else
                 {
-                    ents.push_back( ::MIR::LValue::make_Field({ box$(value.clone()), i}) );
+                    ents.push_back( ::MIR::LValue::new_Field(value.clone(), i) );
                 }
             }
             )
@@ -844,36 +867,13 @@ bool MIR_Cleanup_Unsize_GetMetadata(const ::MIR::TypeResolve& state, MirMutator&
 
 void MIR_Cleanup_LValue(const ::MIR::TypeResolve& state, MirMutator& mutator, ::MIR::LValue& lval)
 {
-    TU_MATCHA( (lval), (le),
-    (Return,
-        ),
-    (Argument,
-        ),
-    (Local,
-        ),
-    (Static,
-        ),
-    (Field,
-        MIR_Cleanup_LValue(state, mutator,  *le.val);
-        ),
-    (Deref,
-        MIR_Cleanup_LValue(state, mutator,  *le.val);
-        ),
-    (Index,
-        MIR_Cleanup_LValue(state, mutator,  *le.val);
-        MIR_Cleanup_LValue(state, mutator,  *le.idx);
-        ),
-    (Downcast,
-        MIR_Cleanup_LValue(state, mutator,  *le.val);
-        )
-    )
-
-    // If this is a deref of Box, unpack and deref the inner pointer
-    if( lval.is_Deref() )
+    // If this contains a deref of Box, unpack and deref the inner pointer
+    for(size_t i = 0; i < lval.m_wrappers.size(); i ++)
     {
-        auto& le = lval.as_Deref();
+        if( !lval.m_wrappers[i].is_Deref() )
+            continue ;
         ::HIR::TypeRef  tmp;
-        const auto& ty = state.get_lvalue_type(tmp, *le.val);
+        const auto& ty = state.get_lvalue_type(tmp, lval, lval.m_wrappers.size() - i);
         if( state.m_resolve.is_type_owned_box(ty) )
         {
             // Handle Box by extracting it to its pointer.
@@ -903,8 +903,10 @@ void MIR_Cleanup_LValue(const ::MIR::TypeResolve& state, MirMutator& mutator, ::
                 tmp = monomorphise_type(state.sp, str.m_params, te.path.m_data.as_Generic().m_params, *ty_tpl);
                 typ = &tmp;
 
-                auto new_lval = ::MIR::LValue::make_Field({ mv$(le.val), 0 });
-                le.val = box$(new_lval);
+                // Insert a `Field(0)` before the deref
+                auto w = ::MIR::LValue::Wrapper::new_Field(0);
+                lval.m_wrappers.insert(lval.m_wrappers.begin() + i, &w, &w + 1);
+                i ++;
             }
             MIR_ASSERT(state, typ->m_data.is_Pointer(), "First non-path field in Box wasn't a pointer - " << *typ);
             // We have reached the pointer. Good.
@@ -992,9 +994,10 @@ void MIR_Cleanup(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path,
                     ),
                 (DstMeta,
                     // HACK: Ensure that the box Deref conversion fires here.
-                    auto v = ::MIR::LValue::make_Deref({ box$(re.val) });
+                    auto v = ::MIR::LValue::new_Deref(mv$(re.val));
                     MIR_Cleanup_LValue(state, mutator,  v);
-                    re.val = mv$( *v.as_Deref().val );
+                    v.pop_wrapper();
+                    re.val = mv$(v);
 
                     // If the type is an array (due to a monomorpised generic?) then replace.
                     ::HIR::TypeRef  tmp;
@@ -1015,9 +1018,10 @@ void MIR_Cleanup(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path,
                     ),
                 (DstPtr,
                     // HACK: Ensure that the box Deref conversion fires here.
-                    auto v = ::MIR::LValue::make_Deref({ box$(re.val) });
+                    auto v = ::MIR::LValue::new_Deref(mv$(re.val));
                     MIR_Cleanup_LValue(state, mutator,  v);
-                    re.val = mv$( *v.as_Deref().val );
+                    v.pop_wrapper();
+                    re.val = mv$(v);
                     ),
                 (MakeDst,
                     MIR_Cleanup_Param(state, mutator,  re.ptr_val);
@@ -1183,13 +1187,13 @@ void MIR_Cleanup(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path,
                         e.args.reserve( fcn_ty.m_arg_types.size() );
                         for(unsigned int i = 0; i < fcn_ty.m_arg_types.size(); i ++)
                         {
-                            e.args.push_back( ::MIR::LValue::make_Field({ box$(args_lvalue.clone()), i }) );
+                            e.args.push_back( ::MIR::LValue::new_Field(args_lvalue.clone(), i) );
                         }
                         // If the trait is Fn/FnMut, dereference the input value.
                         if( pe.trait.m_path == resolve.m_lang_FnOnce )
                             e.fcn = mv$(fcn_lvalue);
                         else
-                            e.fcn = ::MIR::LValue::make_Deref({ box$(fcn_lvalue) });
+                            e.fcn = ::MIR::LValue::new_Deref(mv$(fcn_lvalue));
                     }
                 }
             )
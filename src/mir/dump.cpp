@@ -176,7 +176,37 @@ namespace {
             #undef FMT
         }
         void fmt_val(::std::ostream& os, const ::MIR::LValue& lval) {
-            TU_MATCHA( (lval), (e),
+            fmt_val(os, ::MIR::LValue::CRef(lval));
+        }
+        void fmt_val(::std::ostream& os, const ::MIR::LValue::CRef& lval) {
+            if( const auto* w = lval.outer_wrapper() )
+            {
+                switch(w->tag())
+                {
+                case ::MIR::LValue::Wrapper::TAG_Field:
+                    os << "(";
+                    fmt_val(os, lval.inner_ref());
+                    os << ")." << w->as_Field();
+                    break;
+                case ::MIR::LValue::Wrapper::TAG_Deref:
+                    os << "*";
+                    fmt_val(os, lval.inner_ref());
+                    break;
+                case ::MIR::LValue::Wrapper::TAG_Index:
+                    os << "(";
+                    fmt_val(os, lval.inner_ref());
+                    os << ")[";
+                    fmt_val(os, ::MIR::LValue::new_Local(w->as_Index()));
+                    os << "]";
+                    break;
+                case ::MIR::LValue::Wrapper::TAG_Downcast:
+                    fmt_val(os, lval.inner_ref());
+                    os << " as variant" << w->as_Downcast();
+                    break;
+                }
+                return ;
+            }
+            TU_MATCHA( (lval.root()), (e),
             (Return,
                 os << "RETURN";
                 ),
@@ -187,27 +217,7 @@ namespace {
                 os << "_$" << e;
                 ),
             (Static,
-                os << e;
-                ),
-            (Field,
-                os << "(";
-                fmt_val(os, *e.val);
-                os << ")." << e.field_index;
-                ),
-            (Deref,
-                os << "*";
-                fmt_val(os, *e.val);
-                ),
-            (Index,
-                os << "(";
-                fmt_val(os, *e.val);
-                os << ")[";
-                fmt_val(os, *e.idx);
-                os << "]";
-                ),
-            (Downcast,
-                fmt_val(os, *e.val);
-                os << " as variant" << e.variant_index;
+                os << *e;
                 )
             )
         }
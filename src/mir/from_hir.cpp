@@ -210,28 +210,28 @@ namespace {
             (Any,
                 ),
             (Box,
-                destructure_from_ex(sp, *e.sub, ::MIR::LValue::make_Deref({ box$( mv$(lval) ) }), allow_refutable);
+                destructure_from_ex(sp, *e.sub, ::MIR::LValue::new_Deref(mv$(lval)), allow_refutable);
                 ),
             (Ref,
-                destructure_from_ex(sp, *e.sub, ::MIR::LValue::make_Deref({ box$( mv$(lval) ) }), allow_refutable);
+                destructure_from_ex(sp, *e.sub, ::MIR::LValue::new_Deref(mv$(lval)), allow_refutable);
                 ),
             (Tuple,
                 for(unsigned int i = 0; i < e.sub_patterns.size(); i ++ )
                 {
-                    destructure_from_ex(sp, e.sub_patterns[i], ::MIR::LValue::make_Field({ box$( lval.clone() ), i}), allow_refutable);
+                    destructure_from_ex(sp, e.sub_patterns[i], ::MIR::LValue::new_Field(lval.clone(), i), allow_refutable);
                 }
                 ),
             (SplitTuple,
                 assert(e.total_size >= e.leading.size() + e.trailing.size());
                 for(unsigned int i = 0; i < e.leading.size(); i ++ )
                 {
-                    destructure_from_ex(sp, e.leading[i], ::MIR::LValue::make_Field({ box$( lval.clone() ), i}), allow_refutable);
+                    destructure_from_ex(sp, e.leading[i], ::MIR::LValue::new_Field(lval.clone(), i), allow_refutable);
                 }
                 // TODO: Is there a binding in the middle?
                 unsigned int ofs = e.total_size - e.trailing.size();
                 for(unsigned int i = 0; i < e.trailing.size(); i ++ )
                 {
-                    destructure_from_ex(sp, e.trailing[i], ::MIR::LValue::make_Field({ box$( lval.clone() ), ofs+i}), allow_refutable);
+                    destructure_from_ex(sp, e.trailing[i], ::MIR::LValue::new_Field(lval.clone(), ofs+i), allow_refutable);
                 }
                 ),
             (StructValue,
@@ -240,7 +240,7 @@ namespace {
             (StructTuple,
                 for(unsigned int i = 0; i < e.sub_patterns.size(); i ++ )
                 {
-                    destructure_from_ex(sp, e.sub_patterns[i], ::MIR::LValue::make_Field({ box$( lval.clone() ), i}), allow_refutable);
+                    destructure_from_ex(sp, e.sub_patterns[i], ::MIR::LValue::new_Field(lval.clone(), i), allow_refutable);
                 }
                 ),
             (Struct,
@@ -249,7 +249,7 @@ namespace {
                 for(const auto& fld_pat : e.sub_patterns)
                 {
                     unsigned idx = ::std::find_if( fields.begin(), fields.end(), [&](const auto&x){ return x.first == fld_pat.first; } ) - fields.begin();
-                    destructure_from_ex(sp, fld_pat.second, ::MIR::LValue::make_Field({ box$( lval.clone() ), idx}), allow_refutable);
+                    destructure_from_ex(sp, fld_pat.second, ::MIR::LValue::new_Field(lval.clone(), idx), allow_refutable);
                 }
                 ),
             // Refutable
@@ -269,10 +269,10 @@ namespace {
             (EnumTuple,
                 const auto& enm = *e.binding_ptr;
                 ASSERT_BUG(sp, enm.num_variants() == 1 || allow_refutable, "Refutable pattern not expected - " << pat);
-                auto lval_var = ::MIR::LValue::make_Downcast({ box$(mv$(lval)), e.binding_idx });
+                auto lval_var = ::MIR::LValue::new_Downcast(mv$(lval), e.binding_idx);
                 for(unsigned int i = 0; i < e.sub_patterns.size(); i ++ )
                 {
-                    destructure_from_ex(sp, e.sub_patterns[i], ::MIR::LValue::make_Field({ box$( lval_var.clone() ), i}), allow_refutable);
+                    destructure_from_ex(sp, e.sub_patterns[i], ::MIR::LValue::new_Field(lval_var.clone(), i), allow_refutable);
                 }
                 ),
             (EnumStruct,
@@ -282,11 +282,11 @@ namespace {
                 const auto& var = enm.m_data.as_Data()[e.binding_idx];;
                 const auto& str = *var.type.m_data.as_Path().binding.as_Struct();
                 const auto& fields = str.m_data.as_Named();
-                auto lval_var = ::MIR::LValue::make_Downcast({ box$(mv$(lval)), e.binding_idx });
+                auto lval_var = ::MIR::LValue::new_Downcast(mv$(lval), e.binding_idx);
                 for(const auto& fld_pat : e.sub_patterns)
                 {
                     unsigned idx = ::std::find_if( fields.begin(), fields.end(), [&](const auto&x){ return x.first == fld_pat.first; } ) - fields.begin();
-                    destructure_from_ex(sp, fld_pat.second, ::MIR::LValue::make_Field({ box$( lval_var.clone() ), idx}), allow_refutable);
+                    destructure_from_ex(sp, fld_pat.second, ::MIR::LValue::new_Field(lval_var.clone(), idx), allow_refutable);
                 }
                 ),
             (Slice,
@@ -301,7 +301,7 @@ namespace {
                     for(unsigned int i = 0; i < e.sub_patterns.size(); i ++)
                     {
                         const auto& subpat = e.sub_patterns[i];
-                        destructure_from_ex(sp, subpat, ::MIR::LValue::make_Field({ box$(lval.clone()), i }), allow_refutable );
+                        destructure_from_ex(sp, subpat, ::MIR::LValue::new_Field(lval.clone(), i), allow_refutable );
                     }
                 }
                 else
@@ -312,7 +312,7 @@ namespace {
                     for(unsigned int i = 0; i < e.sub_patterns.size(); i ++)
                     {
                         const auto& subpat = e.sub_patterns[i];
-                        destructure_from_ex(sp, subpat, ::MIR::LValue::make_Field({ box$(lval.clone()), i }), allow_refutable );
+                        destructure_from_ex(sp, subpat, ::MIR::LValue::new_Field(lval.clone(), i), allow_refutable );
                     }
                 }
                 ),
@@ -340,7 +340,7 @@ namespace {
                     for(unsigned int i = 0; i < e.leading.size(); i ++)
                     {
                         unsigned int idx = 0 + i;
-                        destructure_from_ex(sp, e.leading[i], ::MIR::LValue::make_Field({ box$(lval.clone()), idx }), allow_refutable );
+                        destructure_from_ex(sp, e.leading[i], ::MIR::LValue::new_Field(lval.clone(), idx), allow_refutable );
                     }
                     if( e.extra_bind.is_valid() )
                     {
@@ -349,7 +349,7 @@ namespace {
                     for(unsigned int i = 0; i < e.trailing.size(); i ++)
                     {
                         unsigned int idx = array_size - e.trailing.size() + i;
-                        destructure_from_ex(sp, e.trailing[i], ::MIR::LValue::make_Field({ box$(lval.clone()), idx }), allow_refutable );
+                        destructure_from_ex(sp, e.trailing[i], ::MIR::LValue::new_Field(lval.clone(), idx), allow_refutable );
                     }
                 }
                 else
@@ -375,13 +375,13 @@ namespace {
                     ::MIR::LValue   len_lval;
                     if( e.extra_bind.is_valid() || e.trailing.size() > 0 )
                     {
-                        len_lval = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(sp, lval).clone() }));
+                        len_lval = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(sp, lval) }));
                     }
 
                     for(unsigned int i = 0; i < e.leading.size(); i ++)
                     {
                         unsigned int idx = i;
-                        destructure_from_ex(sp, e.leading[i], ::MIR::LValue::make_Field({ box$(lval.clone()), idx }), allow_refutable );
+                        destructure_from_ex(sp, e.leading[i], ::MIR::LValue::new_Field(lval.clone(), idx), allow_refutable );
                     }
                     if( e.extra_bind.is_valid() )
                     {
@@ -393,7 +393,7 @@ namespace {
                         ::HIR::BorrowType   bt = H::get_borrow_type(sp, e.extra_bind);
                         ::MIR::LValue ptr_val = m_builder.lvalue_or_temp(sp,
                             ::HIR::TypeRef::new_pointer( bt, inner_type.clone() ),
-                            ::MIR::RValue::make_Borrow({ 0, bt, ::MIR::LValue::make_Field({ box$(lval.clone()), static_cast<unsigned int>(e.leading.size()) }) })
+                            ::MIR::RValue::make_Borrow({ 0, bt, ::MIR::LValue::new_Field(lval.clone(), static_cast<unsigned int>(e.leading.size())) })
                             );
 
                         // Construct fat pointer
@@ -407,7 +407,7 @@ namespace {
                             auto sub_val = ::MIR::Param(::MIR::Constant::make_Uint({ e.trailing.size() - i, ::HIR::CoreType::Usize }));
                             ::MIR::LValue ofs_val = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_BinOp({ len_lval.clone(), ::MIR::eBinOp::SUB, mv$(sub_val) }) );
                             // Recurse with the indexed value
-                            destructure_from_ex(sp, e.trailing[i], ::MIR::LValue::make_Index({ box$(lval.clone()), box$(ofs_val) }), allow_refutable);
+                            destructure_from_ex(sp, e.trailing[i], ::MIR::LValue::new_Index(lval.clone(), mv$(ofs_val)), allow_refutable);
                         }
                     }
                 }
@@ -539,7 +539,7 @@ namespace {
             TRACE_FUNCTION_F("_Return");
             this->visit_node_ptr(node.m_value);
 
-            m_builder.push_stmt_assign( node.span(), ::MIR::LValue::make_Return({}),  m_builder.get_result(node.span()) );
+            m_builder.push_stmt_assign( node.span(), ::MIR::LValue::new_Return(),  m_builder.get_result(node.span()) );
             m_builder.terminate_scope_early( node.span(), m_builder.fcn_scope() );
             m_builder.end_block( ::MIR::Terminator::make_Return({}) );
         }
@@ -1416,6 +1416,13 @@ namespace {
             const auto& ty_idx = node.m_index->m_res_type;
             this->visit_node_ptr(node.m_index);
             auto index = m_builder.get_result_in_lvalue(node.m_index->span(), ty_idx);
+            // NOTE: `LValue::Index` can only refer to a local, so copy anything else (e.g. an argument or field) to a temporary
+            if( !index.is_Local() )
+            {
+                auto tmp = m_builder.new_temporary(ty_idx);
+                m_builder.push_stmt_assign(node.m_index->span(), tmp.clone(), mv$(index));
+                index = mv$(tmp);
+            }
 
             const auto& ty_val = node.m_value->m_res_type;
             this->visit_node_ptr(node.m_value);
@@ -1430,7 +1437,7 @@ namespace {
                 limit_val = ::MIR::Constant::make_Uint({ e.size_val, ::HIR::CoreType::Usize });
                 ),
             (Slice,
-                limit_val = ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(node.m_value->span(), value).clone() });
+                limit_val = ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(node.m_value->span(), value) });
                 )
             )
 
@@ -1464,7 +1471,7 @@ namespace {
                 m_builder.set_cur_block( arm_continue );
             }
 
-            m_builder.set_result( node.span(), ::MIR::LValue::make_Index({ box$(value), box$(index) }) );
+            m_builder.set_result( node.span(), ::MIR::LValue::new_Index(mv$(value), mv$(index)) );
         }
 
         void visit(::HIR::ExprNode_Deref& node) override
@@ -1547,7 +1554,7 @@ namespace {
                 )
             )
 
-            m_builder.set_result( node.span(), ::MIR::LValue::make_Deref({ box$(val) }) );
+            m_builder.set_result( node.span(), ::MIR::LValue::new_Deref(mv$(val)) );
         }
 
         void visit(::HIR::ExprNode_Emplace& node) override
@@ -1647,7 +1654,7 @@ namespace {
             // 3. Get the value and assign it into `place_raw`
             node.m_value->visit(*this);
             auto val = m_builder.get_result(node.span());
-            m_builder.push_stmt_assign( node.span(), ::MIR::LValue::make_Deref({ box$(place_raw.clone()) }), mv$(val) );
+            m_builder.push_stmt_assign( node.span(), ::MIR::LValue::new_Deref(place_raw.clone()), mv$(val) );
 
             // 3. Return a call to `finalize`
             ::HIR::Path  finalize_path(::HIR::GenericPath {});
@@ -1905,20 +1912,20 @@ namespace {
             unsigned int idx;
             if( '0' <= node.m_field[0] && node.m_field[0] <= '9' ) {
                 ::std::stringstream(node.m_field) >> idx;
-                m_builder.set_result( node.span(), ::MIR::LValue::make_Field({ box$(val), idx }) );
+                m_builder.set_result( node.span(), ::MIR::LValue::new_Field(mv$(val), idx) );
             }
             else if( const auto* bep = val_ty.m_data.as_Path().binding.opt_Struct() ) {
                 const auto& str = **bep;
                 const auto& fields = str.m_data.as_Named();
                 idx = ::std::find_if( fields.begin(), fields.end(), [&](const auto& x){ return x.first == node.m_field; } ) - fields.begin();
-                m_builder.set_result( node.span(), ::MIR::LValue::make_Field({ box$(val), idx }) );
+                m_builder.set_result( node.span(), ::MIR::LValue::new_Field(mv$(val), idx) );
             }
             else if( const auto* bep = val_ty.m_data.as_Path().binding.opt_Union() ) {
                 const auto& unm = **bep;
                 const auto& fields = unm.m_variants;
                 idx = ::std::find_if( fields.begin(), fields.end(), [&](const auto& x){ return x.first == node.m_field; } ) - fields.begin();
 
-                m_builder.set_result( node.span(), ::MIR::LValue::make_Downcast({ box$(val), idx }) );
+                m_builder.set_result( node.span(), ::MIR::LValue::new_Downcast(mv$(val), idx) );
             }
             else {
                 BUG(node.span(), "Field access on non-union/struct - " << val_ty);
@@ -2051,7 +2058,7 @@ namespace {
                     m_builder.set_result( node.span(), mv$(tmp) );
                     ),
                 (Static,
-                    m_builder.set_result( node.span(), ::MIR::LValue::make_Static(node.m_path.clone()) );
+                    m_builder.set_result( node.span(), ::MIR::LValue::new_Static(node.m_path.clone()) );
                     ),
                 (StructConstant,
                     // TODO: Why is this still a PathValue?
@@ -2211,7 +2218,7 @@ namespace {
                     if( !node.m_base_value) {
                         ERROR(node.span(), E0000, "Field '" << fields[i].first << "' not specified");
                     }
-                    values[i] = ::MIR::LValue::make_Field({ box$( base_val.clone() ), i });
+                    values[i] = ::MIR::LValue::new_Field(base_val.clone(), i);
                 }
                 else {
                     // Partial move support will handle dropping the rest?
@@ -2386,7 +2393,7 @@ namespace {
             else
             {
                 ev.define_vars_from(ptr->span(), arg.first);
-                ev.destructure_from(ptr->span(), arg.first, ::MIR::LValue::make_Argument({i}));
+                ev.destructure_from(ptr->span(), arg.first, ::MIR::LValue::new_Argument(i));
             }
             i ++;
         }
@@ -2417,3 +2424,22 @@ void HIR_GenerateMIR(::HIR::Crate& crate)
     ov.visit_crate(crate);
 }
 
+
+// Once MIR has been generated (and all consumers of the HIR expression trees have run), the trees are dead weight
+void HIR_ReleaseExprTrees(::HIR::Crate& crate)
+{
+    struct Releaser:
+        public ::HIR::Visitor
+    {
+        void visit_expr(::HIR::ExprPtr& exp) override
+        {
+            // Only release trees that have been lowered, anything else is left for later phases to complain about
+            if( exp.m_mir && exp.get() )
+            {
+                exp.release_hir();
+            }
+        }
+    };
+    Releaser    rel;
+    rel.visit_crate(crate);
+}
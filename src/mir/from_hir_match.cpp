@@ -841,32 +841,31 @@ void PatternRulesetBuilder::append_from_lit(const Span& sp, const ::HIR::Literal
         TODO(sp, "Match erased type with literal?");
         ),
     (Array,
-        ASSERT_BUG(sp, lit.is_List(), "Matching array with non-list literal - " << lit);
-        const auto& list = lit.as_List();
-        ASSERT_BUG(sp, e.size_val == list.size(), "Matching array with mismatched literal size - " << e.size_val << " != " << list.size());
+        ASSERT_BUG(sp, lit.is_array_like(), "Matching array with non-list literal - " << lit);
+        ASSERT_BUG(sp, e.size_val == lit.list_size(), "Matching array with mismatched literal size - " << e.size_val << " != " << lit.list_size());
 
         // Sequential match just like tuples.
         m_field_path.push_back(0);
         for(unsigned int i = 0; i < e.size_val; i ++) {
-            this->append_from_lit(sp, list[i], *e.inner);
+            this->append_from_lit(sp, lit.list_get(i), *e.inner);
             m_field_path.back() ++;
         }
         m_field_path.pop_back();
         ),
     (Slice,
-        ASSERT_BUG(sp, lit.is_List(), "Matching array with non-list literal - " << lit);
-        const auto& list = lit.as_List();
+        ASSERT_BUG(sp, lit.is_array_like(), "Matching array with non-list literal - " << lit);
+        auto len = lit.list_size();
 
         PatternRulesetBuilder   sub_builder { this->m_resolve };
         sub_builder.m_field_path = m_field_path;
         sub_builder.m_field_path.push_back(0);
-        for(const auto& val : list)
+        for(size_t i = 0; i < len; i ++)
         {
-            sub_builder.append_from_lit( sp, val, *e.inner );
+            sub_builder.append_from_lit( sp, lit.list_get(i), *e.inner );
             sub_builder.m_field_path.back() ++;
         }
         // Encodes length check and sub-pattern rules
-        this->push_rule( PatternRule::make_Slice({ static_cast<unsigned int>(list.size()), mv$(sub_builder.m_rules) }) );
+        this->push_rule( PatternRule::make_Slice({ static_cast<unsigned int>(len), mv$(sub_builder.m_rules) }) );
         ),
     (Borrow,
         m_field_path.push_back( FIELD_DEREF );
@@ -1697,13 +1696,13 @@ namespace {
                 ),
             (Tuple,
                 ASSERT_BUG(sp, idx < e.size(), "Tuple index out of range");
-                lval = ::MIR::LValue::make_Field({ box$(lval), idx });
+                lval = ::MIR::LValue::new_Field(mv$(lval), idx);
                 cur_ty = &e[idx];
                 ),
             (Path,
                 if( idx == FIELD_DEREF ) {
                     // TODO: Check that the path is Box
-                    lval = ::MIR::LValue::make_Deref({ box$(lval) });
+                    lval = ::MIR::LValue::new_Deref(mv$(lval));
                     cur_ty = &e.path.m_data.as_Generic().m_params.m_types.at(0);
                     break;
                 }
@@ -1735,7 +1734,7 @@ namespace {
                         else {
                             cur_ty = &fld.ent;
                         }
-                        lval = ::MIR::LValue::make_Field({ box$(lval), idx });
+                        lval = ::MIR::LValue::new_Field(mv$(lval), idx);
                         ),
                     (Named,
                         assert( idx < fields.size() );
@@ -1747,7 +1746,7 @@ namespace {
                         else {
                             cur_ty = &fld.ent;
                         }
-                        lval = ::MIR::LValue::make_Field({ box$(lval), idx });
+                        lval = ::MIR::LValue::new_Field(mv$(lval), idx);
                         )
                     )
                     ),
@@ -1766,7 +1765,7 @@ namespace {
                     else {
                         cur_ty = &fld.second.ent;
                     }
-                    lval = ::MIR::LValue::make_Downcast({ box$(lval), idx });
+                    lval = ::MIR::LValue::new_Downcast(mv$(lval), idx);
                     ),
                 (Enum,
                     auto monomorph_to_ptr = [&](const auto& ty)->const auto* {
@@ -1786,7 +1785,7 @@ namespace {
                     const auto& var = variants[idx];
 
                     cur_ty = monomorph_to_ptr(var.type);
-                    lval = ::MIR::LValue::make_Downcast({ box$(lval), idx });
+                    lval = ::MIR::LValue::new_Downcast(mv$(lval), idx);
                     )
                 )
                 ),
@@ -1803,7 +1802,7 @@ namespace {
                 assert(idx < e.size_val);
                 cur_ty = &*e.inner;
                 if( idx < FIELD_INDEX_MAX )
-                    lval = ::MIR::LValue::make_Field({ box$(lval), idx });
+                    lval = ::MIR::LValue::new_Field(mv$(lval), idx);
                 else {
                     idx -= FIELD_INDEX_MAX;
                     idx = FIELD_INDEX_MAX - idx;
@@ -1813,16 +1812,16 @@ namespace {
             (Slice,
                 cur_ty = &*e.inner;
                 if( idx < FIELD_INDEX_MAX )
-                    lval = ::MIR::LValue::make_Field({ box$(lval), idx });
+                    lval = ::MIR::LValue::new_Field(mv$(lval), idx);
                 else {
                     idx -= FIELD_INDEX_MAX;
                     idx = FIELD_INDEX_MAX - idx;
                     // 1. Create an LValue containing the size of this slice subtract `idx`
-                    auto len_lval = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ builder.get_ptr_to_dst(sp, lval).clone() }));
+                    auto len_lval = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ builder.get_ptr_to_dst(sp, lval) }));
                     auto sub_val = ::MIR::Param(::MIR::Constant::make_Uint({ idx, ::HIR::CoreType::Usize }));
                     auto ofs_val = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_BinOp({ mv$(len_lval), ::MIR::eBinOp::SUB, mv$(sub_val) }) );
                     // 2. Return _Index with that value
-                    lval = ::MIR::LValue::make_Index({ box$(lval), box$(ofs_val) });
+                    lval = ::MIR::LValue::new_Index(mv$(lval), mv$(ofs_val));
                 }
                 ),
             (Borrow,
@@ -1836,7 +1835,7 @@ namespace {
                     cur_ty = &*e.inner;
                 }
                 DEBUG(i << " " << *cur_ty);
-                lval = ::MIR::LValue::make_Deref({ box$(lval) });
+                lval = ::MIR::LValue::new_Deref(mv$(lval));
                 ),
             (Pointer,
                 ERROR(sp, E0000, "Attempting to match over a pointer");
@@ -2118,7 +2117,8 @@ int MIR_LowerHIR_Match_Simple__GeneratePattern(MirBuilder& builder, const Span&
                 auto succ_bb = builder.new_bb_unlinked();
 
                 auto test_val = ::MIR::Param(::MIR::Constant( v.as_StaticString() ));
-                auto cmp_lval = builder.lvalue_or_temp(sp, ::HIR::CoreType::Bool, ::MIR::RValue::make_BinOp({ mv$(*val.as_Deref().val), ::MIR::eBinOp::EQ, mv$(test_val) }));
+                ASSERT_BUG(sp, val.is_Deref(), "Matching on str without a deref - " << val);
+                auto cmp_lval = builder.lvalue_or_temp(sp, ::HIR::CoreType::Bool, ::MIR::RValue::make_BinOp({ val.clone_unwrapped(), ::MIR::eBinOp::EQ, mv$(test_val) }));
                 builder.end_block( ::MIR::Terminator::make_If({ mv$(cmp_lval), succ_bb, fail_bb }) );
                 builder.set_cur_block(succ_bb);
                 } break;
@@ -2180,7 +2180,7 @@ int MIR_LowerHIR_Match_Simple__GeneratePattern(MirBuilder& builder, const Span&
                     // Recurse with the new ruleset
                     MIR_LowerHIR_Match_Simple__GeneratePattern(builder, sp,
                         re.sub_rules.data(), re.sub_rules.size(),
-                        var_ty_m, ::MIR::LValue::make_Downcast({ box$(val.clone()), var_idx }), rule.field_path.size()+1,
+                        var_ty_m, ::MIR::LValue::new_Downcast(val.clone(), var_idx), rule.field_path.size()+1,
                         fail_bb
                         );
                 }
@@ -2208,7 +2208,8 @@ int MIR_LowerHIR_Match_Simple__GeneratePattern(MirBuilder& builder, const Span&
 
                 auto succ_bb = builder.new_bb_unlinked();
 
-                auto inner_val = val.as_Deref().val->clone();
+                ASSERT_BUG(sp, val.is_Deref(), "Matching on slice without a deref - " << val);
+                auto inner_val = val.clone_unwrapped();
 
                 auto slice_rval = ::MIR::RValue::make_MakeDst({ mv$(cloned_val), mv$(size_val) });
                 auto test_lval = builder.lvalue_or_temp(sp, ::HIR::TypeRef::new_borrow(::HIR::BorrowType::Shared, ty.clone()), mv$(slice_rval));
@@ -2221,7 +2222,7 @@ int MIR_LowerHIR_Match_Simple__GeneratePattern(MirBuilder& builder, const Span&
 
                 // Compare length
                 auto test_val = ::MIR::Param( ::MIR::Constant::make_Uint({ re.len, ::HIR::CoreType::Usize }) );
-                auto len_val = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ builder.get_ptr_to_dst(sp, val).clone() }));
+                auto len_val = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ builder.get_ptr_to_dst(sp, val) }));
                 auto cmp_lval = builder.lvalue_or_temp(sp, ::HIR::CoreType::Bool, ::MIR::RValue::make_BinOp({ mv$(len_val), ::MIR::eBinOp::EQ, mv$(test_val) }));
 
                 auto len_succ_bb = builder.new_bb_unlinked();
@@ -2240,7 +2241,7 @@ int MIR_LowerHIR_Match_Simple__GeneratePattern(MirBuilder& builder, const Span&
 
                 // Compare length
                 auto test_val = ::MIR::Param( ::MIR::Constant::make_Uint({ re.min_len, ::HIR::CoreType::Usize}) );
-                auto len_val = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ builder.get_ptr_to_dst(sp, val).clone() }));
+                auto len_val = builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ builder.get_ptr_to_dst(sp, val) }));
                 auto cmp_lval = builder.lvalue_or_temp(sp, ::HIR::CoreType::Bool, ::MIR::RValue::make_BinOp({ mv$(len_val), ::MIR::eBinOp::LT, mv$(test_val) }));
 
                 auto len_succ_bb = builder.new_bb_unlinked();
@@ -2996,8 +2997,10 @@ void MatchGenGrouped::gen_dispatch__primitive(::HIR::TypeRef ty, ::MIR::LValue v
         } break;
     case ::HIR::CoreType::Str:
         // Remove the deref on the &str
+        ASSERT_BUG(sp, val.is_Deref(), "Matching on str without a deref - " << val);
         auto oval = mv$(val);
-        auto val = mv$(*oval.as_Deref().val);
+        oval.pop_wrapper();
+        auto val = mv$(oval);
 
         ::std::vector< ::MIR::BasicBlockId> targets;
         ::std::vector< ::std::string>   values;
@@ -3059,7 +3062,7 @@ void MatchGenGrouped::gen_dispatch__enum(::HIR::TypeRef ty, ::MIR::LValue val, c
 
 void MatchGenGrouped::gen_dispatch__slice(::HIR::TypeRef ty, ::MIR::LValue val, const ::std::vector<t_rules_subset>& rules, size_t ofs, const ::std::vector<::MIR::BasicBlockId>& arm_targets, ::MIR::BasicBlockId def_blk)
 {
-    auto val_len = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(sp, val).clone() }));
+    auto val_len = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(sp, val) }));
 
     // TODO: Re-sort the rules list to interleve Constant::Bytes and Slice
 
@@ -3122,7 +3125,7 @@ void MatchGenGrouped::gen_dispatch__slice(::HIR::TypeRef ty, ::MIR::LValue val,
 
                 // TODO: What if `val` isn't a Deref?
                 ASSERT_BUG(sp, val.is_Deref(), "TODO: Handle non-Deref matches of byte strings");
-                cmp_lval_eq = this->push_compare( val.as_Deref().val->clone(), ::MIR::eBinOp::EQ, mv$(cmp_slice_val) );
+                cmp_lval_eq = this->push_compare( val.clone_unwrapped(), ::MIR::eBinOp::EQ, mv$(cmp_slice_val) );
                 m_builder.end_block( ::MIR::Terminator::make_If({ mv$(cmp_lval_eq), arm_targets[tgt_ofs], def_blk }) );
 
                 m_builder.set_cur_block(next_cmp_blk);
@@ -3232,7 +3235,7 @@ void MatchGenGrouped::gen_dispatch_splitslice(const field_path_t& field_path, co
     ASSERT_BUG(sp, ty.m_data.is_Slice(), "SplitSlice pattern on non-slice - " << ty);
 
     // Obtain slice length
-    auto val_len = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(sp, val).clone() }));
+    auto val_len = m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Usize, ::MIR::RValue::make_DstMeta({ m_builder.get_ptr_to_dst(sp, val) }));
 
     // 1. Check that length is sufficient for the pattern to be used
     // `IF len < min_len : def_blk, next
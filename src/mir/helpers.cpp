@@ -67,174 +67,186 @@ const ::HIR::TypeRef& ::MIR::TypeResolve::get_static_type(::HIR::TypeRef& tmp, c
     )
     throw "";
 }
-const ::HIR::TypeRef& ::MIR::TypeResolve::get_lvalue_type(::HIR::TypeRef& tmp, const ::MIR::LValue& val) const
+const ::HIR::TypeRef& ::MIR::TypeResolve::get_lvalue_type(::HIR::TypeRef& tmp, const ::MIR::LValue& val, unsigned wrapper_skip_count/*=0*/) const
 {
-    TU_MATCH(::MIR::LValue, (val), (e),
+    const ::HIR::TypeRef* typ = nullptr;
+    TU_MATCHA( (val.m_root), (e),
     (Return,
-        return m_ret_type;
+        typ = &m_ret_type;
         ),
     (Argument,
         MIR_ASSERT(*this, e.idx < m_args.size(), "Argument " << val << " out of range (" << m_args.size() << ")");
-        return m_args.at(e.idx).second;
+        typ = &m_args.at(e.idx).second;
         ),
     (Local,
         MIR_ASSERT(*this, e < m_fcn.locals.size(), "Local " << val << " out of range (" << m_fcn.locals.size() << ")");
-        return m_fcn.locals.at(e);
+        typ = &m_fcn.locals.at(e);
         ),
     (Static,
-        return get_static_type(tmp,  e);
-        ),
-    (Field,
-        const auto& ty = this->get_lvalue_type(tmp, *e.val);
-        TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
-        (
-            MIR_BUG(*this, "Field access on unexpected type - " << ty);
-            ),
-        // Array and Slice use LValue::Field when the index is constant and known-good
-        (Array,
-            return *te.inner;
-            ),
-        (Slice,
-            return *te.inner;
-            ),
-        (Tuple,
-            MIR_ASSERT(*this, e.field_index < te.size(), "Field index out of range in tuple " << e.field_index << " >= " << te.size());
-            return te[e.field_index];
-            ),
-        (Path,
-            if( const auto* tep = te.binding.opt_Struct() )
-            {
-                const auto& str = **tep;
-                auto monomorph = [&](const auto& ty)->const auto& {
-                    if( monomorphise_type_needed(ty) ) {
-                        tmp = monomorphise_type(sp, str.m_params, te.path.m_data.as_Generic().m_params, ty);
+        typ = &get_static_type(tmp, *e);
+        )
+    )
+    MIR_ASSERT(*this, typ, "Unhandled root in " << val);
+    MIR_ASSERT(*this, wrapper_skip_count <= val.m_wrappers.size(), "Skipping more wrappers than present in " << val);
+    for(size_t i = 0; i < val.m_wrappers.size() - wrapper_skip_count; i ++)
+    {
+        typ = &get_unwrapped_type(tmp, val.m_wrappers[i], *typ);
+    }
+    return *typ;
+}
+const ::HIR::TypeRef& ::MIR::TypeResolve::get_unwrapped_type(::HIR::TypeRef& tmp, const ::MIR::LValue::Wrapper& w, const ::HIR::TypeRef& ty) const
+{
+    switch(w.tag())
+    {
+    case ::MIR::LValue::Wrapper::TAG_Field: {
+        auto field_index = w.as_Field();
+            TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+            (
+                MIR_BUG(*this, "Field access on unexpected type - " << ty);
+                ),
+            // Array and Slice use LValue::Field when the index is constant and known-good
+            (Array,
+                return *te.inner;
+                ),
+            (Slice,
+                return *te.inner;
+                ),
+            (Tuple,
+                MIR_ASSERT(*this, field_index < te.size(), "Field index out of range in tuple " << field_index << " >= " << te.size());
+                return te[field_index];
+                ),
+            (Path,
+                if( const auto* tep = te.binding.opt_Struct() )
+                {
+                    const auto& str = **tep;
+                    auto monomorph = [&](const auto& ty)->const auto& {
+                        if( monomorphise_type_needed(ty) ) {
+                            tmp = monomorphise_type(sp, str.m_params, te.path.m_data.as_Generic().m_params, ty);
+                            m_resolve.expand_associated_types(sp, tmp);
+                            return tmp;
+                        }
+                        else {
+                            return ty;
+                        }
+                        };
+                    TU_MATCHA( (str.m_data), (se),
+                    (Unit,
+                        MIR_BUG(*this, "Field on unit-like struct - " << ty);
+                        ),
+                    (Tuple,
+                        MIR_ASSERT(*this, field_index < se.size(), "Field index out of range in tuple-struct " << te.path);
+                        return monomorph(se[field_index].ent);
+                        ),
+                    (Named,
+                        MIR_ASSERT(*this, field_index < se.size(), "Field index out of range in struct " << te.path);
+                        return monomorph(se[field_index].second.ent);
+                        )
+                    )
+                }
+                else if( const auto* tep = te.binding.opt_Union() )
+                {
+                    const auto& unm = **tep;
+                    auto maybe_monomorph = [&](const ::HIR::TypeRef& t)->const ::HIR::TypeRef& {
+                        if( monomorphise_type_needed(t) ) {
+                            tmp = monomorphise_type(sp, unm.m_params, te.path.m_data.as_Generic().m_params, t);
+                            m_resolve.expand_associated_types(sp, tmp);
+                            return tmp;
+                        }
+                        else {
+                            return t;
+                        }
+                        };
+                    MIR_ASSERT(*this, field_index < unm.m_variants.size(), "Field index out of range for union");
+                    return maybe_monomorph(unm.m_variants.at(field_index).second.ent);
+                }
+                else
+                {
+                    MIR_BUG(*this, "Field access on invalid type - " << ty);
+                }
+                )
+            )
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Deref:
+            TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+            (
+                MIR_BUG(*this, "Deref on unexpected type - " << ty);
+                ),
+            (Path,
+                if( const auto* inner_ptr = this->is_type_owned_box(ty) )
+                {
+                    return *inner_ptr;
+                }
+                else {
+                    MIR_BUG(*this, "Deref on unexpected type - " << ty);
+                }
+                ),
+            (Pointer,
+                return *te.inner;
+                ),
+            (Borrow,
+                return *te.inner;
+                )
+            )
+        break;
+    case ::MIR::LValue::Wrapper::TAG_Index:
+            TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+            (
+                MIR_BUG(*this, "Index on unexpected type - " << ty);
+                ),
+            (Slice,
+                return *te.inner;
+                ),
+            (Array,
+                return *te.inner;
+                )
+            )
+        break;
+    case ::MIR::LValue::Wrapper::TAG_Downcast: {
+        auto variant_index = w.as_Downcast();
+            TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+            (
+                MIR_BUG(*this, "Downcast on unexpected type - " << ty);
+                ),
+            (Path,
+                MIR_ASSERT(*this, te.binding.is_Enum() || te.binding.is_Union(), "Downcast on non-Enum");
+                if( te.binding.is_Enum() )
+                {
+                    const auto& enm = *te.binding.as_Enum();
+                    MIR_ASSERT(*this, enm.m_data.is_Data(), "Downcast on non-data enum - " << ty);
+                    const auto& variants = enm.m_data.as_Data();
+                    MIR_ASSERT(*this, variant_index < variants.size(), "Variant index out of range for " << ty);
+                    const auto& variant = variants[variant_index];
+
+                    const auto& var_ty = variant.type;
+                    if( monomorphise_type_needed(var_ty) ) {
+                        tmp = monomorphise_type(sp, enm.m_params, te.path.m_data.as_Generic().m_params, var_ty);
                         m_resolve.expand_associated_types(sp, tmp);
                         return tmp;
                     }
                     else {
-                        return ty;
+                        return var_ty;
                     }
-                    };
-                TU_MATCHA( (str.m_data), (se),
-                (Unit,
-                    MIR_BUG(*this, "Field on unit-like struct - " << ty);
-                    ),
-                (Tuple,
-                    MIR_ASSERT(*this, e.field_index < se.size(), "Field index out of range in tuple-struct " << te.path);
-                    return monomorph(se[e.field_index].ent);
-                    ),
-                (Named,
-                    MIR_ASSERT(*this, e.field_index < se.size(), "Field index out of range in struct " << te.path);
-                    return monomorph(se[e.field_index].second.ent);
-                    )
-                )
-            }
-            else if( const auto* tep = te.binding.opt_Union() )
-            {
-                const auto& unm = **tep;
-                auto maybe_monomorph = [&](const ::HIR::TypeRef& t)->const ::HIR::TypeRef& {
-                    if( monomorphise_type_needed(t) ) {
-                        tmp = monomorphise_type(sp, unm.m_params, te.path.m_data.as_Generic().m_params, t);
+                }
+                else
+                {
+                    const auto& unm = *te.binding.as_Union();
+                    MIR_ASSERT(*this, variant_index < unm.m_variants.size(), "Variant index out of range");
+                    const auto& variant = unm.m_variants[variant_index];
+                    const auto& var_ty = variant.second.ent;
+
+                    if( monomorphise_type_needed(var_ty) ) {
+                        tmp = monomorphise_type(sp, unm.m_params, te.path.m_data.as_Generic().m_params, variant.second.ent);
                         m_resolve.expand_associated_types(sp, tmp);
                         return tmp;
                     }
                     else {
-                        return t;
+                        return var_ty;
                     }
-                    };
-                MIR_ASSERT(*this, e.field_index < unm.m_variants.size(), "Field index out of range for union");
-                return maybe_monomorph(unm.m_variants.at(e.field_index).second.ent);
-            }
-            else
-            {
-                MIR_BUG(*this, "Field access on invalid type - " << ty);
-            }
-            )
-        )
-        ),
-    (Deref,
-        const auto& ty = this->get_lvalue_type(tmp, *e.val);
-        TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
-        (
-            MIR_BUG(*this, "Deref on unexpected type - " << ty);
-            ),
-        (Path,
-            if( const auto* inner_ptr = this->is_type_owned_box(ty) )
-            {
-                return *inner_ptr;
-            }
-            else {
-                MIR_BUG(*this, "Deref on unexpected type - " << ty);
-            }
-            ),
-        (Pointer,
-            return *te.inner;
-            ),
-        (Borrow,
-            return *te.inner;
-            )
-        )
-        ),
-    (Index,
-        const auto& ty = this->get_lvalue_type(tmp, *e.val);
-        TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
-        (
-            MIR_BUG(*this, "Index on unexpected type - " << ty);
-            ),
-        (Slice,
-            return *te.inner;
-            ),
-        (Array,
-            return *te.inner;
-            )
-        )
-        ),
-    (Downcast,
-        const auto& ty = this->get_lvalue_type(tmp, *e.val);
-        TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
-        (
-            MIR_BUG(*this, "Downcast on unexpected type - " << ty);
-            ),
-        (Path,
-            MIR_ASSERT(*this, te.binding.is_Enum() || te.binding.is_Union(), "Downcast on non-Enum");
-            if( te.binding.is_Enum() )
-            {
-                const auto& enm = *te.binding.as_Enum();
-                MIR_ASSERT(*this, enm.m_data.is_Data(), "Downcast on non-data enum - " << ty);
-                const auto& variants = enm.m_data.as_Data();
-                MIR_ASSERT(*this, e.variant_index < variants.size(), "Variant index out of range for " << ty);
-                const auto& variant = variants[e.variant_index];
-
-                const auto& var_ty = variant.type;
-                if( monomorphise_type_needed(var_ty) ) {
-                    tmp = monomorphise_type(sp, enm.m_params, te.path.m_data.as_Generic().m_params, var_ty);
-                    m_resolve.expand_associated_types(sp, tmp);
-                    return tmp;
-                }
-                else {
-                    return var_ty;
                 }
-            }
-            else
-            {
-                const auto& unm = *te.binding.as_Union();
-                MIR_ASSERT(*this, e.variant_index < unm.m_variants.size(), "Variant index out of range");
-                const auto& variant = unm.m_variants[e.variant_index];
-                const auto& var_ty = variant.second.ent;
-
-                if( monomorphise_type_needed(var_ty) ) {
-                    tmp = monomorphise_type(sp, unm.m_params, te.path.m_data.as_Generic().m_params, variant.second.ent);
-                    m_resolve.expand_associated_types(sp, tmp);
-                    return tmp;
-                }
-                else {
-                    return var_ty;
-                }
-            }
+                )
             )
-        )
-        )
-    )
+        } break;
+    }
     throw "";
 }
 const ::HIR::TypeRef& MIR::TypeResolve::get_param_type(::HIR::TypeRef& tmp, const ::MIR::Param& val) const
@@ -332,36 +344,31 @@ using namespace MIR::visit;
 // --------------------------------------------------------------------
 namespace MIR {
 namespace visit {
+    // Visit the values contained within the first `count` wrappers of `lv`
+    static bool visit_mir_lvalue_inner(const ::MIR::LValue& lv, size_t count, ValUsage u, const ::std::function<bool(const ::MIR::LValue& , ValUsage)>& cb)
+    {
+        if( count == 0 )
+            return false;
+        const auto& w = lv.m_wrappers[count-1];
+        if( w.is_Deref() )
+            u = ValUsage::Read;
+
+        bool rv;
+        if( cb(::MIR::LValue::CRef(lv, count-1).clone(), u) )
+            rv = true;
+        else
+            rv = visit_mir_lvalue_inner(lv, count-1, u, cb);
+        if( w.is_Index() )
+        {
+            rv |= cb(::MIR::LValue::new_Local(w.as_Index()), ValUsage::Read);
+        }
+        return rv;
+    }
     bool visit_mir_lvalue(const ::MIR::LValue& lv, ValUsage u, ::std::function<bool(const ::MIR::LValue& , ValUsage)> cb)
     {
         if( cb(lv, u) )
             return true;
-        TU_MATCHA( (lv), (e),
-        (Return,
-            ),
-        (Argument,
-            ),
-        (Local,
-            ),
-        (Static,
-            ),
-        (Field,
-            return visit_mir_lvalue(*e.val, u, cb);
-            ),
-        (Deref,
-            return visit_mir_lvalue(*e.val, ValUsage::Read, cb);
-            ),
-        (Index,
-            bool rv = false;
-            rv |= visit_mir_lvalue(*e.val, u, cb);
-            rv |= visit_mir_lvalue(*e.idx, ValUsage::Read, cb);
-            return rv;
-            ),
-        (Downcast,
-            return visit_mir_lvalue(*e.val, u, cb);
-            )
-        )
-        return false;
+        return visit_mir_lvalue_inner(lv, lv.m_wrappers.size(), u, cb);
     }
 
     bool visit_mir_lvalue(const ::MIR::Param& p, ValUsage u, ::std::function<bool(const ::MIR::LValue& , ValUsage)> cb)
@@ -9,6 +9,7 @@
 #include <vector>
 #include <functional>
 #include <hir_typeck/static.hpp>
+#include <mir/mir.hpp>   // LValue::Wrapper
 
 namespace HIR {
 class Crate;
@@ -100,7 +101,13 @@ public:
     const ::MIR::BasicBlock& get_block(::MIR::BasicBlockId id) const;
 
     const ::HIR::TypeRef& get_static_type(::HIR::TypeRef& tmp, const ::HIR::Path& path) const;
-    const ::HIR::TypeRef& get_lvalue_type(::HIR::TypeRef& tmp, const ::MIR::LValue& val) const;
+    /// Obtain the type of an lvalue, ignoring the outermost `wrapper_skip_count` wrappers
+    const ::HIR::TypeRef& get_lvalue_type(::HIR::TypeRef& tmp, const ::MIR::LValue& val, unsigned wrapper_skip_count=0) const;
+    const ::HIR::TypeRef& get_lvalue_type(::HIR::TypeRef& tmp, const ::MIR::LValue::CRef& val) const {
+        return get_lvalue_type(tmp, val.lv(), val.lv().m_wrappers.size() - val.wrapper_count());
+    }
+    /// Obtain the type of `ty` after applying a single wrapper (field/deref/index/downcast)
+    const ::HIR::TypeRef& get_unwrapped_type(::HIR::TypeRef& tmp, const ::MIR::LValue::Wrapper& w, const ::HIR::TypeRef& ty) const;
     const ::HIR::TypeRef& get_param_type(::HIR::TypeRef& tmp, const ::MIR::Param& val) const;
 
     ::HIR::TypeRef get_const_type(const ::MIR::Constant& c) const;
@@ -13,6 +13,7 @@ class Crate;
 }
 
 extern void HIR_GenerateMIR(::HIR::Crate& crate);
+extern void HIR_ReleaseExprTrees(::HIR::Crate& crate);
 extern void MIR_Dump(::std::ostream& sink, const ::HIR::Crate& crate);
 extern void MIR_CheckCrate(/*const*/ ::HIR::Crate& crate);
 extern void MIR_CheckCrate_Full(/*const*/ ::HIR::Crate& crate);
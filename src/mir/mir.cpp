@@ -89,9 +89,39 @@ namespace MIR {
         throw "";
     }
 
-    ::std::ostream& operator<<(::std::ostream& os, const LValue& x)
+    ::std::ostream& operator<<(::std::ostream& os, const LValue::Wrapper& x)
     {
-        TU_MATCHA( (x), (e),
+        switch(x.tag())
+        {
+        case LValue::Wrapper::TAG_Field:    os << "." << x.as_Field();  break;
+        case LValue::Wrapper::TAG_Deref:    os << "*";  break;
+        case LValue::Wrapper::TAG_Index:    os << "[" << x.as_Index() << "]";  break;
+        case LValue::Wrapper::TAG_Downcast: os << "#" << x.as_Downcast();  break;
+        }
+        return os;
+    }
+    ::std::ostream& operator<<(::std::ostream& os, const LValue::CRef& x)
+    {
+        if( const auto* w = x.outer_wrapper() )
+        {
+            switch(w->tag())
+            {
+            case LValue::Wrapper::TAG_Field:
+                os << "Field(" << w->as_Field() << ", " << x.inner_ref() << ")";
+                break;
+            case LValue::Wrapper::TAG_Deref:
+                os << "Deref(" << x.inner_ref() << ")";
+                break;
+            case LValue::Wrapper::TAG_Index:
+                os << "Index(" << x.inner_ref() << ", Local(" << w->as_Index() << "))";
+                break;
+            case LValue::Wrapper::TAG_Downcast:
+                os << "Downcast(" << w->as_Downcast() << ", " << x.inner_ref() << ")";
+                break;
+            }
+            return os;
+        }
+        TU_MATCHA( (x.root()), (e),
         (Return,
             os << "Return";
             ),
@@ -102,106 +132,79 @@ namespace MIR {
             os << "Local(" << e << ")";
             ),
         (Static,
-            os << "Static(" << e << ")";
-            ),
-        (Field,
-            os << "Field(" << e.field_index << ", " << *e.val << ")";
-            ),
-        (Deref,
-            os << "Deref(" << *e.val << ")";
-            ),
-        (Index,
-            os << "Index(" << *e.val << ", " << *e.idx << ")";
-            ),
-        (Downcast,
-            os << "Downcast(" << e.variant_index << ", " << *e.val << ")";
+            os << "Static(" << *e << ")";
             )
         )
         return os;
     }
-    bool operator<(const LValue& a, const LValue& b)
+    ::std::ostream& operator<<(::std::ostream& os, const LValue& x)
     {
-        if( a.tag() != b.tag() )
-            return a.tag() < b.tag();
-        TU_MATCHA( (a, b), (ea, eb),
+        return os << LValue::CRef(x);
+    }
+
+    ::Ordering LValue::Storage::ord(const LValue::Storage& x) const
+    {
+        if( this->tag() != x.tag() )
+            return ::ord( static_cast<unsigned>(this->tag()), static_cast<unsigned>(x.tag()) );
+        TU_MATCHA( (*this, x), (ea, eb),
         (Return,
-            return false;
+            return OrdEqual;
             ),
         (Argument,
-            return ea.idx < eb.idx;
+            return ::ord(ea.idx, eb.idx);
             ),
         (Local,
-            return ea < eb;
+            return ::ord(ea, eb);
             ),
         (Static,
-            return ea < eb;
-            ),
-        (Field,
-            if( *ea.val != *eb.val )
-                return *ea.val < *eb.val;
-            if( ea.field_index != eb.field_index )
-                return ea.field_index < eb.field_index;
-            return true;
-            ),
-        (Deref,
-            return *ea.val < *eb.val;
-            ),
-        (Index,
-            if( *ea.val != *eb.val )
-                return *ea.val < *eb.val;
-            return *ea.idx < *eb.idx;
-            ),
-        (Downcast,
-            if( *ea.val != *eb.val )
-                return *ea.val < *eb.val;
-            return ea.variant_index < eb.variant_index;
+            return ::ord(*ea, *eb);
             )
         )
         throw "";
     }
+    bool operator<(const LValue& a, const LValue& b)
+    {
+        auto rv = a.m_root.ord(b.m_root);
+        if( rv != OrdEqual )
+            return rv == OrdLess;
+        return a.m_wrappers < b.m_wrappers;
+    }
     bool operator==(const LValue& a, const LValue& b)
     {
-        if( a.tag() != b.tag() )
+        return a.m_root == b.m_root && a.m_wrappers == b.m_wrappers;
+    }
+    bool LValue::CRef::operator==(const LValue::CRef& x) const
+    {
+        if( m_wrapper_count != x.m_wrapper_count )
             return false;
-        TU_MATCHA( (a, b), (ea, eb),
-        (Return,
-            return true;
-            ),
-        (Argument,
-            return ea.idx == eb.idx;
-            ),
-        (Local,
-            return ea == eb;
-            ),
-        (Static,
-            return ea == eb;
-            ),
-        (Field,
-            if( *ea.val != *eb.val )
-                return false;
-            if( ea.field_index != eb.field_index )
-                return false;
-            return true;
-            ),
-        (Deref,
-            return *ea.val == *eb.val;
-            ),
-        (Index,
-            if( *ea.val != *eb.val )
-                return false;
-            if( *ea.idx != *eb.idx )
-                return false;
-            return true;
-            ),
-        (Downcast,
-            if( *ea.val != *eb.val )
-                return false;
-            if( ea.variant_index != eb.variant_index )
-                return false;
-            return true;
-            )
-        )
-        throw "";
+        if( root() != x.root() )
+            return false;
+        return ::std::equal(wrappers_begin(), wrappers_end(), x.wrappers_begin());
+    }
+
+    bool LValue::is_prefix_of(const LValue& x) const
+    {
+        if( m_wrappers.size() > x.m_wrappers.size() )
+            return false;
+        if( m_root != x.m_root )
+            return false;
+        return ::std::equal(m_wrappers.begin(), m_wrappers.end(), x.m_wrappers.begin());
+    }
+    bool LValue::has_deref() const
+    {
+        for(const auto& w : m_wrappers)
+            if( w.is_Deref() )
+                return true;
+        return false;
+    }
+
+    void LValue::MRef::replace(LValue new_val)
+    {
+        auto& lv = this->lv();
+        // Outer wrappers (the ones not covered by this reference) are appended to the new value
+        new_val.m_wrappers.insert(new_val.m_wrappers.end(), lv.m_wrappers.begin() + m_wrapper_count, lv.m_wrappers.end());
+        m_wrapper_count = new_val.m_wrappers.size() - (lv.m_wrappers.size() - m_wrapper_count);
+        lv = mv$(new_val);
     }
 
     ::std::ostream& operator<<(::std::ostream& os, const Param& x)
@@ -502,31 +505,29 @@ namespace MIR {
     }
 }
 
-::MIR::LValue MIR::LValue::clone() const
+::MIR::LValue::Storage MIR::LValue::Storage::clone() const
 {
     TU_MATCHA( (*this), (e),
-    (Return, return LValue(e); ),
-    (Argument, return LValue(e); ),
-    (Local,  return LValue(e); ),
-    (Static, return LValue(e.clone()); ),
-    (Field, return LValue::make_Field({
-        box$( e.val->clone() ),
-        e.field_index
-        }); ),
-    (Deref, return LValue::make_Deref({
-        box$( e.val->clone() )
-        }); ),
-    (Index, return LValue::make_Index({
-        box$( e.val->clone() ),
-        box$( e.idx->clone() )
-        }); ),
-    (Downcast, return LValue::make_Downcast({
-        box$( e.val->clone() ),
-        e.variant_index
-        }); )
+    (Return, return Storage(e); ),
+    (Argument, return Storage(e); ),
+    (Local,  return Storage(e); ),
+    (Static, return Storage(box$(e->clone())); )
     )
     throw "";
 }
+::MIR::LValue MIR::LValue::clone() const
+{
+    return LValue(m_root.clone(), m_wrappers);
+}
+::MIR::LValue MIR::LValue::clone_unwrapped(unsigned int count) const
+{
+    assert(count <= m_wrappers.size());
+    return LValue(m_root.clone(), t_wrappers(m_wrappers.begin(), m_wrappers.end() - count));
+}
+::MIR::LValue MIR::LValue::CRef::clone() const
+{
+    return LValue(root().clone(), t_wrappers(wrappers_begin(), wrappers_end()));
+}
 ::MIR::Constant MIR::Constant::clone() const
 {
     TU_MATCHA( (*this), (e2),
@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include <hir/type.hpp>
+#include <small_vec.hpp>
 
 namespace MIR {
 
@@ -17,46 +18,236 @@ typedef unsigned int    RegionId;
 typedef unsigned int    BasicBlockId;
 
 // "LVALUE" - Assignable values
-TAGGED_UNION_EX(LValue, (), Return, (
-    // Function return
-    (Return, struct{}),
-    // Function argument (input)
-    (Argument, struct { unsigned int idx; }),
-    // Variable/Temporary
-    (Local, unsigned int),
-    // `static` or `static mut`
-    (Static, ::HIR::Path),
-    // Field access (tuple, struct, tuple struct, enum field, ...)
-    // NOTE: Also used to index an array/slice by a compile-time known index (e.g. in destructuring)
-    (Field, struct {
-        ::std::unique_ptr<LValue>   val;
-        unsigned int    field_index;
-        }),
-    // Dereference a value
-    (Deref, struct {
-        ::std::unique_ptr<LValue>   val;
-        }),
-    // Index an array or slice (typeof(val) == [T; n] or [T])
-    // NOTE: This is not bounds checked!
-    (Index, struct {
-        ::std::unique_ptr<LValue>   val;
-        ::std::unique_ptr<LValue>   idx;
-        }),
-    // Interpret an enum as a particular variant
-    (Downcast, struct {
-        ::std::unique_ptr<LValue>   val;
-        unsigned int    variant_index;
-        })
-    ), (),(), (
-        LValue clone() const;
-    )
-    );
-extern ::std::ostream& operator<<(::std::ostream& os, const LValue& x);
+//
+// Stored flat, as a root storage location followed by a list of wrappers (innermost first)
+// e.g. `(*a.1)[i]` is `Local(a)` with wrappers `[Field(1), Deref, Index(i)]`
+class LValue
+{
+public:
+    // Root storage location
+    TAGGED_UNION_EX(Storage, (), Return, (
+        // Function return
+        (Return, struct{}),
+        // Function argument (input)
+        (Argument, struct { unsigned int idx; }),
+        // Variable/Temporary
+        (Local, unsigned int),
+        // `static` or `static mut`
+        (Static, ::std::unique_ptr<::HIR::Path>)
+        ), (),(), (
+            Storage clone() const;
+            ::Ordering ord(const Storage& x) const;
+            bool operator==(const Storage& x) const { return ord(x) == OrdEqual; }
+            bool operator!=(const Storage& x) const { return ord(x) != OrdEqual; }
+        )
+        );
+
+    // Projection applied to an inner value
+    class Wrapper
+    {
+        uint32_t    val;
+
+        static const uint32_t MAX_VAL = (1u << 30) - 1;
+        Wrapper(uint32_t v): val(v) {}
+    public:
+        Wrapper() = default;
+        enum Tag {
+            // Field access (tuple, struct, tuple struct, enum field, ...)
+            // NOTE: Also used to index an array/slice by a compile-time known index (e.g. in destructuring)
+            TAG_Field,
+            // Dereference a value
+            TAG_Deref,
+            // Index an array or slice (typeof(val) == [T; n] or [T]) using the value of a local
+            // NOTE: This is not bounds checked!
+            TAG_Index,
+            // Interpret an enum as a particular variant
+            TAG_Downcast,
+        };
+
+        static Wrapper new_Field(unsigned int idx)   { assert(idx < MAX_VAL); return Wrapper( (idx << 2) | TAG_Field ); }
+        static Wrapper new_Deref()                   { return Wrapper( TAG_Deref ); }
+        // NOTE: `~0u` is used by codegen as a placeholder local (e.g. for array drop loops)
+        static Wrapper new_Index(unsigned int local) { if(local == ~0u) local = MAX_VAL; assert(local <= MAX_VAL); return Wrapper( (local << 2) | TAG_Index ); }
+        static Wrapper new_Downcast(unsigned int idx){ assert(idx < MAX_VAL); return Wrapper( (idx << 2) | TAG_Downcast ); }
+
+        Tag tag() const { return static_cast<Tag>(val & 3); }
+        bool is_Field() const { return tag() == TAG_Field; }
+        bool is_Deref() const { return tag() == TAG_Deref; }
+        bool is_Index() const { return tag() == TAG_Index; }
+        bool is_Downcast() const { return tag() == TAG_Downcast; }
+        unsigned int as_Field() const { assert(is_Field()); return val >> 2; }
+        unsigned int as_Index() const { assert(is_Index()); return (val >> 2) == MAX_VAL ? ~0u : val >> 2; }
+        unsigned int as_Downcast() const { assert(is_Downcast()); return val >> 2; }
+        void set_Field(unsigned int idx) { assert(is_Field()); *this = new_Field(idx); }
+        void set_Index(unsigned int local) { assert(is_Index()); *this = new_Index(local); }
+        void set_Downcast(unsigned int idx) { assert(is_Downcast()); *this = new_Downcast(idx); }
+
+        bool operator==(const Wrapper& x) const { return val == x.val; }
+        bool operator!=(const Wrapper& x) const { return val != x.val; }
+        bool operator<(const Wrapper& x) const { return val < x.val; }
+        friend ::std::ostream& operator<<(::std::ostream& os, const Wrapper& x);
+    };
+    typedef SmallVec<Wrapper, 4>  t_wrappers;
+
+    class CRef;
+    class MRef;
+
+    Storage     m_root;
+    t_wrappers  m_wrappers;
+
+    LValue()
+    {}
+    LValue(Storage root, t_wrappers wrappers={}):
+        m_root(mv$(root)),
+        m_wrappers(mv$(wrappers))
+    {}
+    LValue(LValue&& x) = default;
+    LValue& operator=(LValue&& x) = default;
+
+    static LValue new_Return()                  { return LValue(Storage::make_Return({})); }
+    static LValue new_Argument(unsigned int idx){ return LValue(Storage::make_Argument({ idx })); }
+    static LValue new_Local(unsigned int idx)   { return LValue(Storage::make_Local(idx)); }
+    static LValue new_Static(::HIR::Path p)     { return LValue(Storage::make_Static(box$(p))); }
+
+    static LValue new_Field(LValue lv, unsigned int idx)    { lv.m_wrappers.push_back(Wrapper::new_Field(idx)); return lv; }
+    static LValue new_Deref(LValue lv)                      { lv.m_wrappers.push_back(Wrapper::new_Deref()); return lv; }
+    static LValue new_Index(LValue lv, unsigned int local)  { lv.m_wrappers.push_back(Wrapper::new_Index(local)); return lv; }
+    // NOTE: The index value must be a local
+    static LValue new_Index(LValue lv, const LValue& idx)   { assert(idx.is_Local()); return new_Index(mv$(lv), idx.as_Local()); }
+    static LValue new_Downcast(LValue lv, unsigned int idx) { lv.m_wrappers.push_back(Wrapper::new_Downcast(idx)); return lv; }
+
+    LValue clone() const;
+    // Clone with the outermost `count` wrappers removed
+    LValue clone_unwrapped(unsigned int count=1) const;
+    // Remove the outermost wrapper (in-place version of `clone_unwrapped`)
+    void pop_wrapper() { assert(!m_wrappers.empty()); m_wrappers.pop_back(); }
+    // Clone with an extra wrapper applied
+    LValue clone_wrapped(Wrapper w) const { auto rv = clone(); rv.m_wrappers.push_back(w); return rv; }
+
+    // Queries on the outermost level (roots only match if there are no wrappers)
+    bool is_Return() const { return m_wrappers.empty() && m_root.is_Return(); }
+    bool is_Argument() const { return m_wrappers.empty() && m_root.is_Argument(); }
+    bool is_Local() const { return m_wrappers.empty() && m_root.is_Local(); }
+    bool is_Static() const { return m_wrappers.empty() && m_root.is_Static(); }
+    unsigned int as_Argument() const { assert(is_Argument()); return m_root.as_Argument().idx; }
+    unsigned int as_Local() const { assert(is_Local()); return m_root.as_Local(); }
+    const ::HIR::Path& as_Static() const { assert(is_Static()); return *m_root.as_Static(); }
+    const unsigned int* opt_Local() const { return is_Local() ? &m_root.as_Local() : nullptr; }
+    unsigned int* opt_Local() { return is_Local() ? &m_root.as_Local() : nullptr; }
+
+    bool is_Field() const { return !m_wrappers.empty() && m_wrappers.back().is_Field(); }
+    bool is_Deref() const { return !m_wrappers.empty() && m_wrappers.back().is_Deref(); }
+    bool is_Index() const { return !m_wrappers.empty() && m_wrappers.back().is_Index(); }
+    bool is_Downcast() const { return !m_wrappers.empty() && m_wrappers.back().is_Downcast(); }
+    unsigned int as_Field() const { assert(!m_wrappers.empty()); return m_wrappers.back().as_Field(); }
+    unsigned int as_Index() const { assert(!m_wrappers.empty()); return m_wrappers.back().as_Index(); }
+    unsigned int as_Downcast() const { assert(!m_wrappers.empty()); return m_wrappers.back().as_Downcast(); }
+
+    // Reference to the value the outermost wrapper applies to (e.g. `a` for `a.0`)
+    CRef inner_ref() const;
+    MRef inner_ref();
+
+    // Returns true if `x` is this value, or is this value with extra wrappers (i.e. `x` is contained within this value)
+    bool is_prefix_of(const LValue& x) const;
+    // Returns true if there is a `Deref` wrapper anywhere in this value
+    bool has_deref() const;
+    // Locals used for indexing
+    template<typename Fcn>
+    void for_each_index(Fcn cb) const {
+        for(const auto& w : m_wrappers)
+            if( w.is_Index() )
+                cb(w.as_Index());
+    }
+
+    friend ::std::ostream& operator<<(::std::ostream& os, const LValue& x);
+};
+
+/// Borrowed view of an LValue with some of its outer wrappers ignored
+class LValue::CRef
+{
+protected:
+    const LValue*   m_lv;
+    size_t  m_wrapper_count;
+public:
+    CRef(const LValue& lv):
+        m_lv(&lv),
+        m_wrapper_count(lv.m_wrappers.size())
+    {}
+    CRef(const LValue& lv, size_t wrapper_count):
+        m_lv(&lv),
+        m_wrapper_count(wrapper_count)
+    {
+        assert(wrapper_count <= lv.m_wrappers.size());
+    }
+
+    const LValue& lv() const { return *m_lv; }
+    size_t wrapper_count() const { return m_wrapper_count; }
+    const Storage& root() const { return m_lv->m_root; }
+    const Wrapper* wrappers_begin() const { return m_lv->m_wrappers.begin(); }
+    const Wrapper* wrappers_end() const { return m_lv->m_wrappers.begin() + m_wrapper_count; }
+
+    bool is_Return() const { return m_wrapper_count == 0 && root().is_Return(); }
+    bool is_Argument() const { return m_wrapper_count == 0 && root().is_Argument(); }
+    bool is_Local() const { return m_wrapper_count == 0 && root().is_Local(); }
+    bool is_Static() const { return m_wrapper_count == 0 && root().is_Static(); }
+    unsigned int as_Argument() const { assert(is_Argument()); return root().as_Argument().idx; }
+    unsigned int as_Local() const { assert(is_Local()); return root().as_Local(); }
+    const ::HIR::Path& as_Static() const { assert(is_Static()); return *root().as_Static(); }
+
+    const Wrapper* outer_wrapper() const { return m_wrapper_count > 0 ? &m_lv->m_wrappers[m_wrapper_count-1] : nullptr; }
+    bool is_Field() const { return m_wrapper_count > 0 && outer_wrapper()->is_Field(); }
+    bool is_Deref() const { return m_wrapper_count > 0 && outer_wrapper()->is_Deref(); }
+    bool is_Index() const { return m_wrapper_count > 0 && outer_wrapper()->is_Index(); }
+    bool is_Downcast() const { return m_wrapper_count > 0 && outer_wrapper()->is_Downcast(); }
+    unsigned int as_Field() const { return outer_wrapper()->as_Field(); }
+    unsigned int as_Index() const { return outer_wrapper()->as_Index(); }
+    unsigned int as_Downcast() const { return outer_wrapper()->as_Downcast(); }
+
+    CRef inner_ref() const { assert(m_wrapper_count > 0); return CRef(*m_lv, m_wrapper_count-1); }
+    LValue clone() const;
+
+    bool operator==(const CRef& x) const;
+    bool operator!=(const CRef& x) const { return !(*this == x); }
+    friend ::std::ostream& operator<<(::std::ostream& os, const CRef& x);
+};
+/// Mutable view (allows replacing the referenced part of the value)
+class LValue::MRef:
+    public LValue::CRef
+{
+public:
+    MRef(LValue& lv):
+        CRef(lv)
+    {}
+    MRef(LValue& lv, size_t wrapper_count):
+        CRef(lv, wrapper_count)
+    {}
+
+    LValue& lv() { return *const_cast<LValue*>(m_lv); }
+    MRef inner_ref() { assert(m_wrapper_count > 0); return MRef(lv(), m_wrapper_count-1); }
+    // Replace the referenced part of the value with `new_val` (the outer wrappers are kept)
+    void replace(LValue new_val);
+};
+
+inline LValue::CRef LValue::inner_ref() const { return CRef(*this).inner_ref(); }
+inline LValue::MRef LValue::inner_ref() { return MRef(*this).inner_ref(); }
+
 extern bool operator<(const LValue& a, const LValue& b);
 extern bool operator==(const LValue& a, const LValue& b);
 static inline bool operator!=(const LValue& a, const LValue& b) {
     return !(a == b);
 }
+static inline bool operator==(const LValue& a, const LValue::CRef& b) {
+    return LValue::CRef(a) == b;
+}
+static inline bool operator==(const LValue::CRef& a, const LValue& b) {
+    return a == LValue::CRef(b);
+}
+static inline bool operator!=(const LValue& a, const LValue::CRef& b) {
+    return !(a == b);
+}
+static inline bool operator!=(const LValue::CRef& a, const LValue& b) {
+    return !(a == b);
+}
 
 enum class eBinOp
 {
@@ -68,7 +68,7 @@ MirBuilder::~MirBuilder()
         {
             if( has_result() )
             {
-                push_stmt_assign( sp, ::MIR::LValue::make_Return({}), get_result(sp) );
+                push_stmt_assign( sp, ::MIR::LValue::new_Return(), get_result(sp) );
             }
 
             terminate_scope_early(sp, fcn_scope());
@@ -176,7 +176,7 @@ void MirBuilder::define_variable(unsigned int idx)
     auto& tmp_scope = top_scope->data.as_Owning();
     assert(tmp_scope.is_temporary);
     tmp_scope.slots.push_back( rv );
-    return ::MIR::LValue::make_Local(rv);
+    return ::MIR::LValue::new_Local(rv);
 }
 ::MIR::LValue MirBuilder::lvalue_or_temp(const Span& sp, const ::HIR::TypeRef& ty, ::MIR::RValue val)
 {
@@ -262,7 +262,7 @@ void MirBuilder::push_stmt_assign(const Span& sp, ::MIR::LValue dst, ::MIR::RVal
 {
     DEBUG(dst << " = " << val);
     ASSERT_BUG(sp, m_block_active, "Pushing statement with no active block");
-    ASSERT_BUG(sp, dst.tag() != ::MIR::LValue::TAGDEAD, "");
+    ASSERT_BUG(sp, dst.m_root.tag() != ::MIR::LValue::Storage::TAGDEAD, "");
     ASSERT_BUG(sp, val.tag() != ::MIR::RValue::TAGDEAD, "");
 
     auto moved_param = [&](const ::MIR::Param& p) {
@@ -346,7 +346,7 @@ void MirBuilder::push_stmt_assign(const Span& sp, ::MIR::LValue dst, ::MIR::RVal
 void MirBuilder::push_stmt_drop(const Span& sp, ::MIR::LValue val, unsigned int flag/*=~0u*/)
 {
     ASSERT_BUG(sp, m_block_active, "Pushing statement with no active block");
-    ASSERT_BUG(sp, val.tag() != ::MIR::LValue::TAGDEAD, "");
+    ASSERT_BUG(sp, val.m_root.tag() != ::MIR::LValue::Storage::TAGDEAD, "");
 
     if( lvalue_is_copy(sp, val) ) {
         // Don't emit a drop for Copy values
@@ -358,7 +358,7 @@ void MirBuilder::push_stmt_drop(const Span& sp, ::MIR::LValue val, unsigned int
 void MirBuilder::push_stmt_drop_shallow(const Span& sp, ::MIR::LValue val, unsigned int flag/*=~0u*/)
 {
     ASSERT_BUG(sp, m_block_active, "Pushing statement with no active block");
-    ASSERT_BUG(sp, val.tag() != ::MIR::LValue::TAGDEAD, "");
+    ASSERT_BUG(sp, val.m_root.tag() != ::MIR::LValue::Storage::TAGDEAD, "");
 
     // TODO: Ensure that the type is a Box?
 
@@ -397,20 +397,15 @@ void MirBuilder::push_stmt(const Span& sp, ::MIR::Statement stmt)
 void MirBuilder::mark_value_assigned(const Span& sp, const ::MIR::LValue& dst)
 {
     VarState*   state_p = nullptr;
-    TU_MATCH_DEF(::MIR::LValue, (dst), (e),
-    (
-        ),
-    (Return,
-        // Don't drop.
-        // No state tracking for the return value
-        ),
-    (Argument,
-        state_p = &get_slot_state_mut(sp, e.idx, SlotType::Argument);
-        ),
-    (Local,
-        state_p = &get_slot_state_mut(sp, e, SlotType::Local);
-        )
-    )
+    // NOTE: Return isn't tracked (it's not dropped), neither are wrapped values
+    if( dst.is_Argument() )
+    {
+        state_p = &get_slot_state_mut(sp, dst.as_Argument(), SlotType::Argument);
+    }
+    else if( dst.is_Local() )
+    {
+        state_p = &get_slot_state_mut(sp, dst.as_Local(), SlotType::Local);
+    }
 
     if( state_p )
     {
@@ -425,34 +420,20 @@ void MirBuilder::mark_value_assigned(const Span& sp, const ::MIR::LValue& dst)
 void MirBuilder::raise_temporaries(const Span& sp, const ::MIR::LValue& val, const ScopeHandle& scope, bool to_above/*=false*/)
 {
     TRACE_FUNCTION_F(val);
-    TU_MATCH_DEF(::MIR::LValue, (val), (e),
-    (
-        // No raising of these source values?
-        return ;
-        ),
     // TODO: This may not be correct, because it can change the drop points and ordering
     // HACK: Working around cases where values are dropped while the result is not yet used.
-    (Index,
-        raise_temporaries(sp, *e.val, scope, to_above);
-        raise_temporaries(sp, *e.idx, scope, to_above);
-        return ;
-        ),
-    (Deref,
-        raise_temporaries(sp, *e.val, scope, to_above);
-        return ;
-        ),
-    (Field,
-        raise_temporaries(sp, *e.val, scope, to_above);
+    if( !val.m_wrappers.empty() )
+    {
+        if( val.m_root.is_Local() )
+            raise_temporaries(sp, ::MIR::LValue::new_Local(val.m_root.as_Local()), scope, to_above);
+        val.for_each_index([&](unsigned idx) {
+            raise_temporaries(sp, ::MIR::LValue::new_Local(idx), scope, to_above);
+            });
         return ;
-        ),
-    (Downcast,
-        raise_temporaries(sp, *e.val, scope, to_above);
+    }
+    // No raising of these source values?
+    if( !val.m_root.is_Local() )
         return ;
-        ),
-    // Actual value types
-    (Local,
-        )
-    )
     ASSERT_BUG(sp, val.is_Local(), "Hit value raising code with non-variable value - " << val);
     const auto idx = val.as_Local();
     bool is_temp = (idx >= m_first_temp_idx);
@@ -833,7 +814,7 @@ void MirBuilder::raise_all(const Span& sp, ScopeHandle source, const ScopeHandle
     auto& src_list = src_scope_def.data.as_Owning().slots;
     for(auto idx : src_list)
     {
-        DEBUG("> Raising " << ::MIR::LValue::make_Local(idx));
+        DEBUG("> Raising " << ::MIR::LValue::new_Local(idx));
         assert(idx >= m_first_temp_idx);
     }
 
@@ -973,7 +954,7 @@ void MirBuilder::terminate_scope_early(const Span& sp, const ScopeHandle& scope,
         for(size_t i = 0; i < m_arg_states.size(); i ++)
         {
             const auto& state = get_slot_state(sp, i, SlotType::Argument);
-            this->drop_value_from_state(sp, state, ::MIR::LValue::make_Argument({ static_cast<unsigned>(i) }));
+            this->drop_value_from_state(sp, state, ::MIR::LValue::new_Argument(static_cast<unsigned>(i)));
         }
     }
 }
@@ -1054,7 +1035,7 @@ namespace
                         });
                 if( is_box )
                 {
-                    merge_state(sp, builder, ::MIR::LValue::make_Deref({ box$(lv.clone()) }), *ose.inner_state, *nse.inner_state);
+                    merge_state(sp, builder, ::MIR::LValue::new_Deref(lv.clone()), *ose.inner_state, *nse.inner_state);
                 }
                 else
                 {
@@ -1080,13 +1061,13 @@ namespace
                 if( is_enum ) {
                     for(size_t i = 0; i < ose.inner_states.size(); i ++)
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Downcast({ box$(lv.clone()), static_cast<unsigned int>(i) }), ose.inner_states[i], nse.inner_states[i]);
+                        merge_state(sp, builder, ::MIR::LValue::new_Downcast(lv.clone(), static_cast<unsigned int>(i)), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 else {
                     for(unsigned int i = 0; i < ose.inner_states.size(); i ++ )
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Field({ box$(lv.clone()), i }), ose.inner_states[i], nse.inner_states[i]);
+                        merge_state(sp, builder, ::MIR::LValue::new_Field(lv.clone(), i), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 } return;
@@ -1162,7 +1143,7 @@ namespace
                         });
 
                 if( is_box ) {
-                    merge_state(sp, builder, ::MIR::LValue::make_Deref({ box$(lv.clone()) }), *ose.inner_state, *nse.inner_state);
+                    merge_state(sp, builder, ::MIR::LValue::new_Deref(lv.clone()), *ose.inner_state, *nse.inner_state);
                 }
                 else {
                     BUG(sp, "MovedOut on non-Box");
@@ -1186,19 +1167,15 @@ namespace
                 }
                 auto& ose = old_state.as_Partial();
                 if( is_enum ) {
-                    auto ilv = ::MIR::LValue::make_Downcast({ box$(lv.clone()), 0 });
                     for(size_t i = 0; i < ose.inner_states.size(); i ++)
                     {
-                        merge_state(sp, builder, ilv, ose.inner_states[i], nse.inner_states[i]);
-                        ilv.as_Downcast().variant_index ++;
+                        merge_state(sp, builder, ::MIR::LValue::new_Downcast(lv.clone(), static_cast<unsigned int>(i)), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 else {
-                    auto ilv = ::MIR::LValue::make_Field({ box$(lv.clone()), 0 });
                     for(unsigned int i = 0; i < ose.inner_states.size(); i ++ )
                     {
-                        merge_state(sp, builder, ilv, ose.inner_states[i], nse.inner_states[i]);
-                        ilv.as_Field().field_index ++;
+                        merge_state(sp, builder, ::MIR::LValue::new_Field(lv.clone(), i), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 } return;
@@ -1262,13 +1239,13 @@ namespace
                 if( is_enum ) {
                     for(size_t i = 0; i < ose.inner_states.size(); i ++)
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Downcast({ box$(lv.clone()), static_cast<unsigned int>(i) }), ose.inner_states[i], nse.inner_states[i]);
+                        merge_state(sp, builder, ::MIR::LValue::new_Downcast(lv.clone(), static_cast<unsigned int>(i)), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 else {
                     for(unsigned int i = 0; i < ose.inner_states.size(); i ++ )
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Field({ box$(lv.clone()), i }), ose.inner_states[i], nse.inner_states[i]);
+                        merge_state(sp, builder, ::MIR::LValue::new_Field(lv.clone(), i), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 return; }
@@ -1303,7 +1280,7 @@ namespace
                     builder.push_stmt_set_dropflag_val(sp, ose.outer_flag, is_valid);
                 }
 
-                merge_state(sp, builder, ::MIR::LValue::make_Deref({ box$(lv.clone()) }), *ose.inner_state, new_state);
+                merge_state(sp, builder, ::MIR::LValue::new_Deref(lv.clone()), *ose.inner_state, new_state);
                 return ; }
             case VarState::TAG_Optional: {
                 const auto& nse = new_state.as_Optional();
@@ -1328,7 +1305,7 @@ namespace
                     builder.push_stmt_set_dropflag_other(sp, ose.outer_flag, nse);
                     builder.push_stmt_set_dropflag_default(sp, nse);
                 }
-                merge_state(sp, builder, ::MIR::LValue::make_Deref({ box$(lv.clone()) }), *ose.inner_state, new_state);
+                merge_state(sp, builder, ::MIR::LValue::new_Deref(lv.clone()), *ose.inner_state, new_state);
                 return; }
             case VarState::TAG_MovedOut: {
                 const auto& nse = new_state.as_MovedOut();
@@ -1336,7 +1313,7 @@ namespace
                 {
                     TODO(sp, "Handle mismatched flags in MovedOut");
                 }
-                merge_state(sp, builder, ::MIR::LValue::make_Deref({ box$(lv.clone()) }), *ose.inner_state, *nse.inner_state);
+                merge_state(sp, builder, ::MIR::LValue::new_Deref(lv.clone()), *ose.inner_state, *nse.inner_state);
                 return; }
             case VarState::TAG_Partial:
                 BUG(sp, "MovedOut->Partial not valid");
@@ -1360,13 +1337,13 @@ namespace
                 if( is_enum ) {
                     for(size_t i = 0; i < ose.inner_states.size(); i ++)
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Downcast({ box$(lv.clone()), static_cast<unsigned int>(i) }), ose.inner_states[i], new_state);
+                        merge_state(sp, builder, ::MIR::LValue::new_Downcast(lv.clone(), static_cast<unsigned int>(i)), ose.inner_states[i], new_state);
                     }
                 }
                 else {
                     for(unsigned int i = 0; i < ose.inner_states.size(); i ++ )
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Field({ box$(lv.clone()), i }), ose.inner_states[i], new_state);
+                        merge_state(sp, builder, ::MIR::LValue::new_Field(lv.clone(), i), ose.inner_states[i], new_state);
                     }
                 }
                 return ;
@@ -1378,13 +1355,13 @@ namespace
                 if( is_enum ) {
                     for(size_t i = 0; i < ose.inner_states.size(); i ++)
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Downcast({ box$(lv.clone()), static_cast<unsigned int>(i) }), ose.inner_states[i], nse.inner_states[i]);
+                        merge_state(sp, builder, ::MIR::LValue::new_Downcast(lv.clone(), static_cast<unsigned int>(i)), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 else {
                     for(unsigned int i = 0; i < ose.inner_states.size(); i ++ )
                     {
-                        merge_state(sp, builder, ::MIR::LValue::make_Field({ box$(lv.clone()), i }), ose.inner_states[i], nse.inner_states[i]);
+                        merge_state(sp, builder, ::MIR::LValue::new_Field(lv.clone(), i), ose.inner_states[i], nse.inner_states[i]);
                     }
                 }
                 } return ;
@@ -1413,8 +1390,8 @@ void MirBuilder::terminate_loop_early(const Span& sp, ScopeType::Data_Loop& sd_l
                 merge_state(sp, *this, val_cb(idx), old_state,  get_slot_state(sp, idx, type));
             }
             };
-        merge_list(sd_loop.changed_slots, sd_loop.exit_state.states, ::MIR::LValue::make_Local, SlotType::Local);
-        merge_list(sd_loop.changed_args, sd_loop.exit_state.arg_states, [](auto v){ return ::MIR::LValue::make_Argument({v}); }, SlotType::Argument);
+        merge_list(sd_loop.changed_slots, sd_loop.exit_state.states, [](auto v){ return ::MIR::LValue::new_Local(v); }, SlotType::Local);
+        merge_list(sd_loop.changed_args, sd_loop.exit_state.arg_states, [](auto v){ return ::MIR::LValue::new_Argument(v); }, SlotType::Argument);
     }
     else
     {
@@ -1469,7 +1446,7 @@ void MirBuilder::end_split_arm(const Span& sp, const ScopeHandle& handle, bool r
                     auto it = states.find(idx);
                     const auto& src_state = (it != states.end() ? it->second : get_slot_state(sp, idx, type, 1));
 
-                    auto lv = (type == SlotType::Local ? ::MIR::LValue::make_Local(idx) : ::MIR::LValue::make_Argument({idx}));
+                    auto lv = (type == SlotType::Local ? ::MIR::LValue::new_Local(idx) : ::MIR::LValue::new_Argument(idx));
                     merge_state(sp, *this, mv$(lv), out_state, src_state);
                 }
                 };
@@ -1560,7 +1537,7 @@ void MirBuilder::complete_scope(ScopeDef& sd)
                 auto& vs = builder.get_slot_state_mut(sp, ent.first, SlotType::Local);
                 if( vs != ent.second )
                 {
-                    DEBUG(::MIR::LValue::make_Local(ent.first) << " " << vs << " => " << ent.second);
+                    DEBUG(::MIR::LValue::new_Local(ent.first) << " " << vs << " => " << ent.second);
                     vs = ::std::move(ent.second);
                 }
             }
@@ -1569,7 +1546,7 @@ void MirBuilder::complete_scope(ScopeDef& sd)
                 auto& vs = builder.get_slot_state_mut(sp, ent.first, SlotType::Argument);
                 if( vs != ent.second )
                 {
-                    DEBUG(::MIR::LValue::make_Argument({ent.first}) << " " << vs << " => " << ent.second);
+                    DEBUG(::MIR::LValue::new_Argument(ent.first) << " " << vs << " => " << ent.second);
                     vs = ::std::move(ent.second);
                 }
             }
@@ -1603,38 +1580,47 @@ void MirBuilder::complete_scope(ScopeDef& sd)
     }
 }
 
-void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::function<void(const ::HIR::TypeRef&)> cb) const
+void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue::CRef& val, ::std::function<void(const ::HIR::TypeRef&)> cb) const
 {
-    TU_MATCH(::MIR::LValue, (val), (e),
-    (Return,
-        TODO(sp, "Return");
-        ),
-    (Argument,
-        cb( m_args.at(e.idx).second );
-        ),
-    (Local,
-        cb( m_output.locals.at(e) );
-        ),
-    (Static,
-        TU_MATCHA( (e.m_data), (pe),
-        (Generic,
-            ASSERT_BUG(sp, pe.m_params.m_types.empty(), "Path params on static");
-            const auto& s = m_resolve.m_crate.get_static_by_path(sp, pe.m_path);
-            cb( s.m_type );
+    if( !val.outer_wrapper() )
+    {
+        TU_MATCHA( (val.root()), (e),
+        (Return,
+            TODO(sp, "Return");
             ),
-        (UfcsKnown,
-            TODO(sp, "Static - UfcsKnown - " << e);
+        (Argument,
+            cb( m_args.at(e.idx).second );
             ),
-        (UfcsUnknown,
-            BUG(sp, "Encountered UfcsUnknown in Static - " << e);
+        (Local,
+            cb( m_output.locals.at(e) );
             ),
-        (UfcsInherent,
-            TODO(sp, "Static - UfcsInherent - " << e);
+        (Static,
+            TU_MATCHA( (e->m_data), (pe),
+            (Generic,
+                ASSERT_BUG(sp, pe.m_params.m_types.empty(), "Path params on static");
+                const auto& s = m_resolve.m_crate.get_static_by_path(sp, pe.m_path);
+                cb( s.m_type );
+                ),
+            (UfcsKnown,
+                TODO(sp, "Static - UfcsKnown - " << *e);
+                ),
+            (UfcsUnknown,
+                BUG(sp, "Encountered UfcsUnknown in Static - " << *e);
+                ),
+            (UfcsInherent,
+                TODO(sp, "Static - UfcsInherent - " << *e);
+                )
+            )
             )
         )
-        ),
-    (Field,
-        with_val_type(sp, *e.val, [&](const auto& ty){
+        return ;
+    }
+    const auto inner = val.inner_ref();
+    switch(val.outer_wrapper()->tag())
+    {
+    case ::MIR::LValue::Wrapper::TAG_Field: {
+        const auto field_index = val.outer_wrapper()->as_Field();
+        with_val_type(sp, inner, [&](const auto& ty){
             TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
             (
                 BUG(sp, "Field access on unexpected type - " << ty);
@@ -1665,15 +1651,15 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                         BUG(sp, "Field on unit-like struct - " << ty);
                         ),
                     (Tuple,
-                        ASSERT_BUG(sp, e.field_index < se.size(),
-                            "Field index out of range in tuple-struct " << ty << " - " << e.field_index << " > " << se.size());
-                        const auto& fld = se[e.field_index];
+                        ASSERT_BUG(sp, field_index < se.size(),
+                            "Field index out of range in tuple-struct " << ty << " - " << field_index << " > " << se.size());
+                        const auto& fld = se[field_index];
                         cb( maybe_monomorph(fld.ent) );
                         ),
                     (Named,
-                        ASSERT_BUG(sp, e.field_index < se.size(),
-                            "Field index out of range in struct " << ty << " - " << e.field_index << " > " << se.size());
-                        const auto& fld = se[e.field_index].second;
+                        ASSERT_BUG(sp, field_index < se.size(),
+                            "Field index out of range in struct " << ty << " - " << field_index << " > " << se.size());
+                        const auto& fld = se[field_index].second;
                         cb( maybe_monomorph(fld.ent) );
                         )
                     )
@@ -1692,8 +1678,8 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                             return t;
                         }
                         };
-                    ASSERT_BUG(sp, e.field_index < unm.m_variants.size(), "Field index out of range for union");
-                    cb( maybe_monomorph(unm.m_variants.at(e.field_index).second.ent) );
+                    ASSERT_BUG(sp, field_index < unm.m_variants.size(), "Field index out of range for union");
+                    cb( maybe_monomorph(unm.m_variants.at(field_index).second.ent) );
                 }
                 else
                 {
@@ -1701,14 +1687,14 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                 }
                 ),
             (Tuple,
-                ASSERT_BUG(sp, e.field_index < te.size(), "Field index out of range in tuple " << e.field_index << " >= " << te.size());
-                cb( te[e.field_index] );
+                ASSERT_BUG(sp, field_index < te.size(), "Field index out of range in tuple " << field_index << " >= " << te.size());
+                cb( te[field_index] );
                 )
             )
             });
-        ),
-    (Deref,
-        with_val_type(sp, *e.val, [&](const auto& ty){
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Deref: {
+        with_val_type(sp, inner, [&](const auto& ty){
             TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
             (
                 BUG(sp, "Deref on unexpected type - " << ty);
@@ -1730,9 +1716,9 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                 )
             )
             });
-        ),
-    (Index,
-        with_val_type(sp, *e.val, [&](const auto& ty){
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Index: {
+        with_val_type(sp, inner, [&](const auto& ty){
             TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
             (
                 BUG(sp, "Index on unexpected type - " << ty);
@@ -1745,9 +1731,10 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                 )
             )
             });
-        ),
-    (Downcast,
-        with_val_type(sp, *e.val, [&](const auto& ty){
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Downcast: {
+        const auto variant_index = val.outer_wrapper()->as_Downcast();
+        with_val_type(sp, inner, [&](const auto& ty){
             TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
             (
                 BUG(sp, "Downcast on unexpected type - " << ty);
@@ -1758,8 +1745,8 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                     const auto& enm = **pbe;
                     ASSERT_BUG(sp, enm.m_data.is_Data(), "Downcast on non-data enum");
                     const auto& variants = enm.m_data.as_Data();
-                    ASSERT_BUG(sp, e.variant_index < variants.size(), "Variant index out of range");
-                    const auto& variant = variants[e.variant_index];
+                    ASSERT_BUG(sp, variant_index < variants.size(), "Variant index out of range");
+                    const auto& variant = variants[variant_index];
 
                     if( monomorphise_type_needed(variant.type) ) {
                         auto tmp = monomorphise_type(sp, enm.m_params, te.path.m_data.as_Generic().m_params, variant.type);
@@ -1773,8 +1760,8 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                 else if( const auto* pbe = te.binding.opt_Union() )
                 {
                     const auto& unm = **pbe;
-                    ASSERT_BUG(sp, e.variant_index < unm.m_variants.size(), "Variant index out of range");
-                    const auto& variant = unm.m_variants.at(e.variant_index);
+                    ASSERT_BUG(sp, variant_index < unm.m_variants.size(), "Variant index out of range");
+                    const auto& variant = unm.m_variants.at(variant_index);
                     const auto& fld = variant.second;
 
                     if( monomorphise_type_needed(fld.ent) ) {
@@ -1793,8 +1780,8 @@ void MirBuilder::with_val_type(const Span& sp, const ::MIR::LValue& val, ::std::
                 )
             )
             });
-        )
-    )
+        } break;
+    }
 }
 
 bool MirBuilder::lvalue_is_copy(const Span& sp, const ::MIR::LValue& val) const
@@ -1957,25 +1944,33 @@ const VarState& MirBuilder::get_val_state(const Span& sp, const ::MIR::LValue& l
 {
     TODO(sp, "");
 }
-VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
+VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue::CRef& lv)
 {
     TRACE_FUNCTION_F(lv);
-    TU_MATCHA( (lv), (e),
-    (Return,
-        BUG(sp, "Move of return value");
-        return get_slot_state_mut(sp, ~0u, SlotType::Local);
-        ),
-    (Argument,
-        return get_slot_state_mut(sp, e.idx, SlotType::Argument);
-        ),
-    (Local,
-        return get_slot_state_mut(sp, e, SlotType::Local);
-        ),
-    (Static,
-        BUG(sp, "Attempting to mutate state of a static");
-        ),
-    (Field,
-        auto& ivs = get_val_state_mut(sp, *e.val);
+    if( !lv.outer_wrapper() )
+    {
+        TU_MATCHA( (lv.root()), (e),
+        (Return,
+            BUG(sp, "Move of return value");
+            return get_slot_state_mut(sp, ~0u, SlotType::Local);
+            ),
+        (Argument,
+            return get_slot_state_mut(sp, e.idx, SlotType::Argument);
+            ),
+        (Local,
+            return get_slot_state_mut(sp, e, SlotType::Local);
+            ),
+        (Static,
+            BUG(sp, "Attempting to mutate state of a static");
+            )
+        )
+    }
+    const auto inner = lv.inner_ref();
+    switch(lv.outer_wrapper()->tag())
+    {
+    case ::MIR::LValue::Wrapper::TAG_Field: {
+        const auto field_index = lv.outer_wrapper()->as_Field();
+        auto& ivs = get_val_state_mut(sp, inner);
         VarState    tpl;
         TU_MATCHA( (ivs), (ivse),
         (Invalid,
@@ -1997,7 +1992,7 @@ VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
         if( !ivs.is_Partial() )
         {
             size_t n_flds = 0;
-            with_val_type(sp, *e.val, [&](const auto& ty) {
+            with_val_type(sp, inner, [&](const auto& ty) {
                 DEBUG("ty = " << ty);
                 if(const auto* e = ty.m_data.opt_Path()) {
                     ASSERT_BUG(sp, e->binding.is_Struct(), "");
@@ -2029,14 +2024,14 @@ VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
                 inner_vs.push_back( tpl.clone() );
             ivs = VarState::make_Partial({ mv$(inner_vs) });
         }
-        return ivs.as_Partial().inner_states.at(e.field_index);
-        ),
-    (Deref,
+        return ivs.as_Partial().inner_states.at(field_index);
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Deref: {
         // HACK: If the dereferenced type is a Box ("owned_box") then hack in move and shallow drop
         bool is_box = false;
         if( this->m_lang_Box )
         {
-            with_val_type(sp, *e.val, [&](const auto& ty){
+            with_val_type(sp, inner, [&](const auto& ty){
                 DEBUG("ty = " << ty);
                 is_box = this->is_type_owned_box(ty);
                 });
@@ -2045,7 +2040,7 @@ VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
 
         if( is_box )
         {
-            auto& ivs = get_val_state_mut(sp, *e.val);
+            auto& ivs = get_val_state_mut(sp, inner);
             if( ! ivs.is_MovedOut() )
             {
                 ::std::vector<VarState> inner;
@@ -2059,13 +2054,14 @@ VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
         {
             BUG(sp, "Move out of deref with non-Copy values - &move? - " << lv << " : " << FMT_CB(ss, this->with_val_type(sp, lv, [&](const auto& ty){ss<<ty;});) );
         }
-        ),
-    (Index,
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Index: {
         BUG(sp, "Move out of index with non-Copy values - Partial move?");
-        ),
-    (Downcast,
+        } break;
+    case ::MIR::LValue::Wrapper::TAG_Downcast: {
+        const auto variant_index = lv.outer_wrapper()->as_Downcast();
         // TODO: What if the inner is Copy? What if the inner is a hidden pointer?
-        auto& ivs = get_val_state_mut(sp, *e.val);
+        auto& ivs = get_val_state_mut(sp, inner);
         //static VarState ivs; ivs = VarState::make_Valid({});
 
         if( !ivs.is_Partial() )
@@ -2073,7 +2069,7 @@ VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
             ASSERT_BUG(sp, !ivs.is_MovedOut(), "Downcast of a MovedOut value");
 
             size_t var_count = 0;
-            with_val_type(sp, *e.val, [&](const auto& ty){
+            with_val_type(sp, inner, [&](const auto& ty){
                 DEBUG("ty = " << ty);
                 ASSERT_BUG(sp, ty.m_data.is_Path(), "Downcast on non-Path type - " << ty);
                 const auto& pb = ty.m_data.as_Path().binding;
@@ -2100,13 +2096,13 @@ VarState& MirBuilder::get_val_state_mut(const Span& sp, const ::MIR::LValue& lv)
             {
                 inner.push_back( VarState::make_Invalid(InvalidType::Uninit) );
             }
-            inner[e.variant_index] = mv$(ivs);
+            inner[variant_index] = mv$(ivs);
             ivs = VarState::make_Partial({ mv$(inner) });
         }
 
-        return ivs.as_Partial().inner_states.at(e.variant_index);
-        )
-    )
+        return ivs.as_Partial().inner_states.at(variant_index);
+        } break;
+    }
     BUG(sp, "Fell off send of get_val_state_mut");
 }
 
@@ -2125,7 +2121,7 @@ void MirBuilder::drop_value_from_state(const Span& sp, const VarState& vs, ::MIR
             });
         if( is_box )
         {
-            drop_value_from_state(sp, *vse.inner_state, ::MIR::LValue::make_Deref({ box$(lv.clone()) }));
+            drop_value_from_state(sp, *vse.inner_state, ::MIR::LValue::new_Deref(lv.clone()));
             push_stmt_drop_shallow(sp, mv$(lv), vse.outer_flag);
         }
         else
@@ -2145,7 +2141,7 @@ void MirBuilder::drop_value_from_state(const Span& sp, const VarState& vs, ::MIR
             DEBUG("TODO: Switch based on enum value");
             //for(size_t i = 0; i < vse.inner_states.size(); i ++)
             //{
-            //    drop_value_from_state(sp, vse.inner_states[i], ::MIR::LValue::make_Downcast({ box$(lv.clone()), static_cast<unsigned int>(i) }));
+            //    drop_value_from_state(sp, vse.inner_states[i], ::MIR::LValue::new_Downcast(lv.clone(), static_cast<unsigned int>(i)));
             //}
         }
         else if( is_union )
@@ -2156,7 +2152,7 @@ void MirBuilder::drop_value_from_state(const Span& sp, const VarState& vs, ::MIR
         {
             for(size_t i = 0; i < vse.inner_states.size(); i ++)
             {
-                drop_value_from_state(sp, vse.inner_states[i], ::MIR::LValue::make_Field({ box$(lv.clone()), static_cast<unsigned int>(i) }));
+                drop_value_from_state(sp, vse.inner_states[i], ::MIR::LValue::new_Field(lv.clone(), static_cast<unsigned int>(i)));
             }
         }
         ),
@@ -2174,7 +2170,7 @@ void MirBuilder::drop_scope_values(const ScopeDef& sd)
         {
             const auto& vs = get_slot_state(sd.span, idx, SlotType::Local);
             DEBUG("slot" << idx << " - " << vs);
-            drop_value_from_state( sd.span, vs, ::MIR::LValue::make_Local(idx) );
+            drop_value_from_state( sd.span, vs, ::MIR::LValue::new_Local(idx) );
         }
         ),
     (Split,
@@ -2197,18 +2193,18 @@ void MirBuilder::moved_lvalue(const Span& sp, const ::MIR::LValue& lv)
     }
 }
 
-const ::MIR::LValue& MirBuilder::get_ptr_to_dst(const Span& sp, const ::MIR::LValue& lv) const
+::MIR::LValue MirBuilder::get_ptr_to_dst(const Span& sp, const ::MIR::LValue& lv) const
 {
     // Undo field accesses
-    const auto* lvp = &lv;
-    while(lvp->is_Field())
-        lvp = &*lvp->as_Field().val;
+    size_t count = lv.m_wrappers.size();
+    while(count > 0 && lv.m_wrappers[count-1].is_Field())
+        count --;
 
     // TODO: Enum variants?
 
-    ASSERT_BUG(sp, lvp->is_Deref(), "Access of an unsized field without a dereference - " << lv);
+    ASSERT_BUG(sp, count > 0 && lv.m_wrappers[count-1].is_Deref(), "Access of an unsized field without a dereference - " << lv);
 
-    return *lvp->as_Deref().val;
+    return ::MIR::LValue::CRef(lv, count-1).clone();
 }
 
 // --------------------------------------------------------------------
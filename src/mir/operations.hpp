@@ -8,6 +8,8 @@
 #include <hir_typeck/static.hpp>
 #include <hir/item_path.hpp>
 
+// Lower a (fully expanded) HIR expression tree into MIR
+extern ::MIR::FunctionPointer LowerMIR(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, const ::HIR::ExprPtr& ptr, const ::HIR::TypeRef& ret_ty, const ::HIR::Function::args_t& args);
 // Check that the MIR is well-formed
 extern void MIR_Validate(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, const ::MIR::Function& fcn, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type);
 // -
@@ -60,38 +60,53 @@ namespace {
         Borrow, // Any borrow
     };
 
+    // Visit the values contained within the first `count` wrappers of `lv` (i.e. the value that the wrapper at `count-1` applies to)
+    // - Inner values are materialised as temporaries, if the callback changes one it's spliced back into `lv`
+    bool visit_mir_lvalue_mut_inner(::MIR::LValue& lv, size_t count, ValUsage u, const ::std::function<bool(::MIR::LValue& , ValUsage)>& cb)
+    {
+        if( count == 0 )
+            return false;
+        const auto w = lv.m_wrappers[count-1];
+        ValUsage    iu;
+        switch(w.tag())
+        {
+        // HACK: If "moving", use a "Read" value usage (covers some quirks)
+        case ::MIR::LValue::Wrapper::TAG_Field:     iu = (u == ValUsage::Move ? ValUsage::Read : u);    break;
+        case ::MIR::LValue::Wrapper::TAG_Deref:     iu = (u == ValUsage::Borrow ? u : ValUsage::Read);  break;
+        case ::MIR::LValue::Wrapper::TAG_Index:     iu = u; break;
+        case ::MIR::LValue::Wrapper::TAG_Downcast:  iu = u; break;
+        }
+
+        bool rv;
+        auto inner = ::MIR::LValue::CRef(lv, count-1).clone();
+        bool stop = cb(inner, iu);
+        if( inner != ::MIR::LValue::CRef(lv, count-1) )
+        {
+            ::MIR::LValue::MRef inner_ref(lv, count-1);
+            inner_ref.replace(mv$(inner));
+            count = inner_ref.wrapper_count() + 1;
+        }
+        if( stop )
+            rv = true;
+        else
+            rv = visit_mir_lvalue_mut_inner(lv, count-1, iu, cb);
+
+        if( w.is_Index() )
+        {
+            auto idx_lv = ::MIR::LValue::new_Local(w.as_Index());
+            rv |= cb(idx_lv, ValUsage::Read);
+            if( !idx_lv.is_Local() )
+                BUG(Span(), "Index value " << ::MIR::LValue::new_Local(w.as_Index()) << " replaced with non-local " << idx_lv << " in " << lv);
+            lv.m_wrappers[count-1].set_Index(idx_lv.as_Local());
+        }
+        return rv;
+    }
     bool visit_mir_lvalue_mut(::MIR::LValue& lv, ValUsage u, ::std::function<bool(::MIR::LValue& , ValUsage)> cb)
     {
         //TRACE_FUNCTION_F(lv);
         if( cb(lv, u) )
             return true;
-        TU_MATCHA( (lv), (e),
-        (Return,
-            ),
-        (Argument,
-            ),
-        (Local,
-            ),
-        (Static,
-            ),
-        (Field,
-            // HACK: If "moving", use a "Read" value usage (covers some quirks)
-            return visit_mir_lvalue_mut(*e.val, u == ValUsage::Move ? ValUsage::Read : u, cb);
-            ),
-        (Deref,
-            return visit_mir_lvalue_mut(*e.val, u == ValUsage::Borrow ? u : ValUsage::Read, cb);
-            ),
-        (Index,
-            bool rv = false;
-            rv |= visit_mir_lvalue_mut(*e.val, u, cb);
-            rv |= visit_mir_lvalue_mut(*e.idx, ValUsage::Read, cb);
-            return rv;
-            ),
-        (Downcast,
-            return visit_mir_lvalue_mut(*e.val, u, cb);
-            )
-        )
-        return false;
+        return visit_mir_lvalue_mut_inner(lv, lv.m_wrappers.size(), u, cb);
     }
     bool visit_mir_lvalue(const ::MIR::LValue& lv, ValUsage u, ::std::function<bool(const ::MIR::LValue& , ValUsage)> cb)
     {
@@ -774,10 +789,26 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
 
             // TODO: If the function is marked as `inline(never)`, then don't inline
 
+            // Statement count used for the size limit
+            // - Plain copies between locals/arguments (e.g. index temporaries) are cheap, and are removed after inlining
+            auto stmt_cost = [](const ::MIR::BasicBlock& bb)->size_t {
+                size_t rv = 0;
+                for(const auto& stmt : bb.statements)
+                {
+                    if( const auto* se = stmt.opt_Assign() )
+                    {
+                        if( se->dst.is_Local() && se->src.is_Use() && (se->src.as_Use().is_Local() || se->src.as_Use().is_Argument()) )
+                            continue ;
+                    }
+                    rv ++;
+                }
+                return rv;
+                };
+
             // TODO: Allow functions that are just a switch on an input.
             if( fcn.blocks.size() == 1 )
             {
-                return fcn.blocks[0].statements.size() < 10 && ! fcn.blocks[0].terminator.is_Goto();
+                return stmt_cost(fcn.blocks[0]) < 10 && ! fcn.blocks[0].terminator.is_Goto();
             }
             else if( fcn.blocks.size() == 3 && fcn.blocks[0].terminator.is_Call() )
             {
@@ -786,7 +817,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
                     return false;
                 if( !(fcn.blocks[2].terminator.is_Diverge() || fcn.blocks[2].terminator.is_Return()) )
                     return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() + fcn.blocks[2].statements.size() > 10 )
+                if( stmt_cost(fcn.blocks[0]) + stmt_cost(fcn.blocks[1]) + stmt_cost(fcn.blocks[2]) > 10 )
                     return false;
                 // Detect and avoid simple recursion.
                 // - This won't detect mutual recursion - that also needs prevention.
@@ -1022,45 +1053,38 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
 
         ::MIR::LValue clone_lval(const ::MIR::LValue& src) const
         {
-            TU_MATCHA( (src), (se),
+            ::MIR::LValue   rv;
+            TU_MATCHA( (src.m_root), (se),
             (Return,
-                return this->retval.clone();
+                rv = this->retval.clone();
                 ),
             (Argument,
                 const auto& arg = this->te.args.at(se.idx);
                 if( this->copy_args[se.idx] != ~0u )
                 {
-                    return ::MIR::LValue::make_Local(this->copy_args[se.idx]);
+                    rv = ::MIR::LValue::new_Local(this->copy_args[se.idx]);
                 }
                 else
                 {
                     assert( !arg.is_Constant() );   // Should have been handled in the above
-                    return arg.as_LValue().clone();
+                    rv = arg.as_LValue().clone();
                 }
                 ),
             (Local,
-                return ::MIR::LValue::make_Local(this->var_base + se);
+                rv = ::MIR::LValue::new_Local(this->var_base + se);
                 ),
             (Static,
-                return this->monomorph( se );
-                ),
-            (Deref,
-                return ::MIR::LValue::make_Deref({ box$(this->clone_lval(*se.val)) });
-                ),
-            (Field,
-                return ::MIR::LValue::make_Field({ box$(this->clone_lval(*se.val)), se.field_index });
-                ),
-            (Index,
-                return ::MIR::LValue::make_Index({
-                    box$(this->clone_lval(*se.val)),
-                    box$(this->clone_lval(*se.idx))
-                    });
-                ),
-            (Downcast,
-                return ::MIR::LValue::make_Downcast({ box$(this->clone_lval(*se.val)), se.variant_index });
+                rv = ::MIR::LValue::new_Static( this->monomorph(*se) );
                 )
             )
-            throw "";
+            for(auto w : src.m_wrappers)
+            {
+                // NOTE: Index values are always locals in the callee
+                if( w.is_Index() )
+                    w.set_Index(this->var_base + w.as_Index());
+                rv.m_wrappers.push_back(w);
+            }
+            return rv;
         }
         ::MIR::Constant clone_constant(const ::MIR::Constant& src) const
         {
@@ -1176,7 +1200,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
 
             // Allocate a temporary for the return value
             {
-                cloner.retval = ::MIR::LValue::make_Local( fcn.locals.size() );
+                cloner.retval = ::MIR::LValue::new_Local( fcn.locals.size() );
                 DEBUG("- Storing return value in " << cloner.retval);
                 ::HIR::TypeRef  tmp_ty;
                 fcn.locals.push_back( state.get_lvalue_type(tmp_ty, te->ret_val).clone() );
@@ -1220,7 +1244,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
             {
                 ::HIR::TypeRef  tmp;
                 auto ty = val.is_Constant() ? state.get_const_type(val.as_Constant()) : state.get_lvalue_type(tmp, val.as_LValue()).clone();
-                auto lv = ::MIR::LValue::make_Local( static_cast<unsigned>(fcn.locals.size()) );
+                auto lv = ::MIR::LValue::new_Local( static_cast<unsigned>(fcn.locals.size()) );
                 fcn.locals.push_back( mv$(ty) );
                 auto rval = val.is_Constant() ? ::MIR::RValue(mv$(val.as_Constant())) : ::MIR::RValue( mv$(val.as_LValue()) );
                 auto stmt = ::MIR::Statement::make_Assign({ mv$(lv), mv$(rval) });
@@ -1252,6 +1276,13 @@ bool MIR_Optimise_DeTemporary(::MIR::TypeResolve& state, ::MIR::Function& fcn)
     bool changed = false;
     TRACE_FUNCTION_FR("", changed);
 
+    // Locals used to index arrays/slices (these can only be replaced by another local)
+    ::std::vector<bool> index_locals( fcn.locals.size() );
+    visit_mir_lvalues(state, fcn, [&](const ::MIR::LValue& lv, ValUsage ) {
+        lv.for_each_index([&](unsigned idx){ index_locals[idx] = true; });
+        return false;
+        });
+
     for(unsigned int bb_idx = 0; bb_idx < fcn.blocks.size(); bb_idx ++)
     {
         auto& bb = fcn.blocks[bb_idx];
@@ -1382,7 +1413,11 @@ bool MIR_Optimise_DeTemporary(::MIR::TypeResolve& state, ::MIR::Function& fcn)
             // - Check if this is a new assignment
             if( stmt.is_Assign() && stmt.as_Assign().dst.is_Local() && stmt.as_Assign().src.is_Use() )
             {
-                if( visit_mir_lvalue(stmt.as_Assign().src.as_Use(), ValUsage::Read, [&](const auto& lv, auto /*vu*/) {
+                if( index_locals[stmt.as_Assign().dst.as_Local()] && !stmt.as_Assign().src.as_Use().is_Local() )
+                {
+                    DEBUG(state << "> Don't record, used as an index");
+                }
+                else if( visit_mir_lvalue(stmt.as_Assign().src.as_Use(), ValUsage::Read, [&](const auto& lv, auto /*vu*/) {
                         return lv == stmt.as_Assign().dst;
                         }) )
                 {
@@ -1833,19 +1868,19 @@ bool MIR_Optimise_PropagateKnownValues(::MIR::TypeResolve& state, ::MIR::Functio
             state.set_cur_stmt(bb_idx, i);
             DEBUG(state << block.statements[i]);
             visit_mir_lvalues_mut(block.statements[i], [&](::MIR::LValue& lv, auto vu) {
-                    if(const auto* e = lv.opt_Field())
+                    if( lv.is_Field() )
                     {
-                        if(vu == ValUsage::Read && e->val->is_Local() ) {
+                        if(vu == ValUsage::Read && lv.inner_ref().is_Local() ) {
                             // TODO: This value _must_ be Copy for this optimisation to work.
                             // - OR, it has to somehow invalidate the original tuple
                             DEBUG(state << "Locating origin of " << lv);
                             ::HIR::TypeRef  tmp;
-                            if( !state.m_resolve.type_is_copy(state.sp, state.get_lvalue_type(tmp, *e->val)) )
+                            if( !state.m_resolve.type_is_copy(state.sp, state.get_lvalue_type(tmp, lv, 1)) )
                             {
                                 DEBUG(state << "- not Copy, can't optimise");
                                 return false;
                             }
-                            const auto* source_lvalue = get_field(*e->val, e->field_index, bb_idx, i);
+                            const auto* source_lvalue = get_field(lv.clone_unwrapped(), lv.as_Field(), bb_idx, i);
                             if( source_lvalue )
                             {
                                 if( lv != *source_lvalue )
@@ -2276,18 +2311,16 @@ bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::F
         unsigned int    read = 0;
         unsigned int    write = 0;
         unsigned int    borrow = 0;
+        // Index wrappers can only refer to locals, so these can only be replaced by other locals
+        bool    used_as_index = false;
     };
     struct {
         ::std::vector<ValUse> local_uses;
 
         void use_lvalue(const ::MIR::LValue& lv, ValUsage ut) {
-            TU_MATCHA( (lv), (e),
-            (Return,
-                ),
-            (Argument,
-                ),
-            (Local,
-                auto& vu = local_uses[e];
+            if( const auto* e = lv.m_root.opt_Local() )
+            {
+                auto& vu = local_uses[*e];
                 switch(ut)
                 {
                 case ValUsage::Move:
@@ -2295,23 +2328,12 @@ bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::F
                 case ValUsage::Write:   vu.write += 1;  break;
                 case ValUsage::Borrow:  vu.borrow += 1; break;
                 }
-                ),
-            (Static,
-                ),
-            (Field,
-                use_lvalue(*e.val, ut);
-                ),
-            (Deref,
-                use_lvalue(*e.val, ut);
-                ),
-            (Index,
-                use_lvalue(*e.val, ut);
-                use_lvalue(*e.idx, ValUsage::Read);
-                ),
-            (Downcast,
-                use_lvalue(*e.val, ut);
-                )
-            )
+            }
+            lv.for_each_index([&](unsigned idx) {
+                auto& vu = local_uses[idx];
+                vu.read += 1;
+                vu.used_as_index = true;
+                });
         }
     } val_uses = {
         ::std::vector<ValUse>(fcn.locals.size())
@@ -2358,13 +2380,18 @@ bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::F
                 if( e.src.is_Use() )
                 {
                     // Keep the complexity down
-                    const auto* srcp = &e.src.as_Use();
-                    while( srcp->is_Field() )
-                        srcp = &*srcp->as_Field().val;
-                    if( !srcp->is_Local() )
+                    const auto& src = e.src.as_Use();
+                    if( !src.m_root.is_Local() )
                         continue ;
+                    if( !::std::all_of(src.m_wrappers.begin(), src.m_wrappers.end(), [](const ::MIR::LValue::Wrapper& w){ return w.is_Field(); }) )
+                        continue ;
+                    if( !src.is_Local() && val_uses.local_uses[e.dst.as_Local()].used_as_index )
+                    {
+                        DEBUG("> Can't replace, destination is used as an index");
+                        continue;
+                    }
 
-                    if( replacements.find(*srcp) != replacements.end() )
+                    if( replacements.find(::MIR::LValue::new_Local(src.m_root.as_Local())) != replacements.end() )
                     {
                         DEBUG("> Can't replace, source has pending replacement");
                         continue;
@@ -2735,17 +2762,14 @@ bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::F
                     }
 
                     // Remove assignments of locals that are never read
-                    TU_MATCH_DEF( ::MIR::LValue, (se->dst), (de),
-                    (
-                        ),
-                    (Local,
-                        const auto& vu = val_uses.local_uses[de];
+                    if( const auto* de = se->dst.opt_Local() )
+                    {
+                        const auto& vu = val_uses.local_uses[*de];
                         if( vu.write == 1 && vu.read == 0 && vu.borrow == 0 ) {
                             DEBUG(state << se->dst << " only written, removing write");
                             it = block.statements.erase(it)-1;
                         }
-                        )
-                    )
+                    }
                 }
             }
             // NOTE: Calls can write values, but they also have side-effects
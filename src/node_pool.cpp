@@ -0,0 +1,223 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * node_pool.cpp
+ * - Size-class pool allocator for AST/HIR tree nodes
+ */
+#include <node_pool.hpp>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#ifdef _WIN32
+# include <malloc.h>
+#endif
+
+namespace {
+    // All allocations are rounded up to this, which is also the alignment of the returned pointers
+    const ::std::size_t GRANULE = alignof(::std::max_align_t);
+    // Largest size handled by the pool, larger requests go straight to the global allocator
+    const ::std::size_t MAX_SIZE = 512;
+    const ::std::size_t NUM_CLASSES = MAX_SIZE / GRANULE;
+    // NOTE: Chunks are aligned to their size, so the chunk of a node can be found from its address
+    const ::std::size_t CHUNK_SIZE = 64*1024;
+
+    /// Header at the start of each chunk
+    struct Chunk {
+        /// Number of allocated (not freed) nodes in the chunk
+        ::std::atomic<::std::size_t>    live;
+    };
+    const ::std::size_t CHUNK_HEADER_SIZE = (sizeof(Chunk) + GRANULE - 1) / GRANULE * GRANULE;
+
+    Chunk* get_chunk(void* ptr)
+    {
+        return reinterpret_cast<Chunk*>( reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(CHUNK_SIZE - 1) );
+    }
+
+    /// All chunks allocated by any thread (so they can be released by `NodePool::trim`)
+    ::std::mutex    s_chunks_lock;
+    ::std::vector<Chunk*>   s_chunks;
+
+    Chunk* new_chunk()
+    {
+        void* mem;
+#ifdef _WIN32
+        mem = _aligned_malloc(CHUNK_SIZE, CHUNK_SIZE);
+#else
+        if( posix_memalign(&mem, CHUNK_SIZE, CHUNK_SIZE) != 0 )
+            mem = nullptr;
+#endif
+        if( !mem )
+            throw ::std::bad_alloc();
+        auto* c = new(mem) Chunk;
+        c->live = 0;
+        ::std::lock_guard<::std::mutex> lh(s_chunks_lock);
+        s_chunks.push_back(c);
+        return c;
+    }
+    void free_chunk(Chunk* c)
+    {
+        c->~Chunk();
+#ifdef _WIN32
+        _aligned_free(c);
+#else
+        free(c);
+#endif
+    }
+
+    struct FreeEnt {
+        FreeEnt*    next;
+    };
+
+    struct Pool;
+    /// Pools of all live threads (so `NodePool::trim` can prune every free list), protected by `s_chunks_lock`
+    ::std::vector<Pool*>    s_pools;
+
+    struct Pool
+    {
+        FreeEnt*    free_lists[NUM_CLASSES] = {};
+        // Current bump chunk
+        uint8_t*    cur = nullptr;
+        uint8_t*    end = nullptr;
+
+        Pool()
+        {
+            ::std::lock_guard<::std::mutex> lh(s_chunks_lock);
+            s_pools.push_back(this);
+        }
+        ~Pool()
+        {
+            // NOTE: Entries on the free lists are abandoned, the chunks are still released once their nodes are freed
+            ::std::lock_guard<::std::mutex> lh(s_chunks_lock);
+            s_pools.erase( ::std::find(s_pools.begin(), s_pools.end(), this) );
+        }
+        Pool(const Pool&) = delete;
+
+        /// The chunk that is currently being bump-allocated from (if any)
+        const Chunk* bump_chunk() const
+        {
+            return cur ? get_chunk(cur - 1) : nullptr;
+        }
+
+        void* allocate(::std::size_t cls)
+        {
+            void* rv;
+            if( FreeEnt* e = free_lists[cls] )
+            {
+                free_lists[cls] = e->next;
+                rv = e;
+            }
+            else
+            {
+                ::std::size_t   size = (cls + 1) * GRANULE;
+                if( static_cast<::std::size_t>(end - cur) < size )
+                {
+                    // Put the tail of the current chunk onto the free lists (so it's not wasted)
+                    while( static_cast<::std::size_t>(end - cur) >= GRANULE )
+                    {
+                        ::std::size_t   tail_cls = static_cast<::std::size_t>(end - cur) / GRANULE - 1;
+                        if( tail_cls >= NUM_CLASSES )
+                            tail_cls = NUM_CLASSES - 1;
+                        this->push_free(cur, tail_cls);
+                        cur += (tail_cls + 1) * GRANULE;
+                    }
+                    cur = reinterpret_cast<uint8_t*>(new_chunk()) + CHUNK_HEADER_SIZE;
+                    end = reinterpret_cast<uint8_t*>(get_chunk(cur)) + CHUNK_SIZE;
+                }
+                rv = cur;
+                cur += size;
+            }
+            get_chunk(rv)->live.fetch_add(1, ::std::memory_order_relaxed);
+            return rv;
+        }
+        void release(void* ptr, ::std::size_t cls)
+        {
+            get_chunk(ptr)->live.fetch_sub(1, ::std::memory_order_relaxed);
+            this->push_free(ptr, cls);
+        }
+        void push_free(void* ptr, ::std::size_t cls)
+        {
+            auto* e = static_cast<FreeEnt*>(ptr);
+            e->next = free_lists[cls];
+            free_lists[cls] = e;
+        }
+
+        /// Drop free list entries that are within chunks about to be released
+        template<typename F>
+        void remove_entries(F is_released)
+        {
+            for(auto& head : free_lists)
+            {
+                FreeEnt** link = &head;
+                while( *link )
+                {
+                    if( is_released(get_chunk(*link)) )
+                        *link = (*link)->next;
+                    else
+                        link = &(*link)->next;
+                }
+            }
+        }
+    };
+    // Per-thread, so the fast path needs no locking
+    // - Nodes can outlive the thread that allocated them (and be freed by another thread), the chunk's live count
+    //   decides when the memory can be returned.
+    thread_local Pool   s_pool;
+
+    ::std::size_t get_class(::std::size_t size)
+    {
+        return (size + GRANULE - 1) / GRANULE - 1;
+    }
+}
+
+void* NodePool::allocate(::std::size_t size)
+{
+    if( size == 0 )
+        size = 1;
+    if( size > MAX_SIZE )
+        return ::operator new(size);
+    return s_pool.allocate(get_class(size));
+}
+void NodePool::deallocate(void* ptr, ::std::size_t size)
+{
+    if( !ptr )
+        return ;
+    if( size == 0 )
+        size = 1;
+    if( size > MAX_SIZE ) {
+        ::operator delete(ptr);
+        return ;
+    }
+    s_pool.release(ptr, get_class(size));
+}
+
+void NodePool::trim()
+{
+    ::std::lock_guard<::std::mutex> lh(s_chunks_lock);
+    // Each thread's bump chunk is kept (even if empty), it's about to be used again
+    ::std::vector<const Chunk*> bump_chunks;
+    for(const auto* p : s_pools)
+    {
+        if( const auto* c = p->bump_chunk() )
+            bump_chunks.push_back(c);
+    }
+    auto is_released = [&](const Chunk* c) {
+        return c->live.load(::std::memory_order_relaxed) == 0
+            && ::std::find(bump_chunks.begin(), bump_chunks.end(), c) == bump_chunks.end();
+        };
+    // Free list entries of every thread's pool have to go before the chunks they point into
+    for(auto* p : s_pools)
+        p->remove_entries(is_released);
+
+    auto new_end = ::std::remove_if(s_chunks.begin(), s_chunks.end(), [&](Chunk* c) {
+        if( !is_released(c) )
+            return false;
+        free_chunk(c);
+        return true;
+        });
+    s_chunks.erase(new_end, s_chunks.end());
+}
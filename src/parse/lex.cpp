@@ -9,12 +9,15 @@
 #include "tokentree.hpp"
 #include "parseerror.hpp"
 #include "../common.hpp"
+#include <main_bindings.hpp>    // Incremental_AddInput
 #include <cassert>
 #include <iostream>
 #include <cstdlib>  // strtol
 #include <typeinfo>
 #include <algorithm>    // std::count
 #include <cctype>
+#include <cstring>  // memcpy
+#include <fstream>
 //#define TRACE_CHARS
 //#define TRACE_RAW_TOKENS
 
@@ -22,28 +25,38 @@ Lexer::Lexer(const ::std::string& filename):
     m_path(filename.c_str()),
     m_line(1),
     m_line_ofs(0),
-    m_istream(filename.c_str()),
+    m_pos(0),
     m_last_char_valid(false),
     m_hygiene( Ident::Hygiene::new_scope() )
 {
-    if( !m_istream.is_open() )
+    // Read the whole file up-front, the lexer then works directly on the buffer
     {
-        throw ::std::runtime_error("Unable to open file '" + filename + "'");
+        ::std::ifstream is(filename.c_str(), ::std::ios::in | ::std::ios::binary);
+        if( !is.is_open() )
+        {
+            throw ::std::runtime_error("Unable to open file '" + filename + "'");
+        }
+        Incremental_AddInput(filename);
+        is.seekg(0, ::std::ios::end);
+        auto len = is.tellg();
+        is.seekg(0, ::std::ios::beg);
+        if( len > 0 )
+        {
+            m_data.resize(static_cast<size_t>(len));
+            is.read(&m_data[0], len);
+            m_data.resize(static_cast<size_t>(is.gcount()));
+        }
     }
     // Consume the BOM
-    if( this->getc_byte() == '\xef' )
+    if( m_data.size() >= 1 && m_data[0] == '\xef' )
     {
-        if( this->getc_byte() != '\xbb' ) {
+        if( m_data.size() < 2 || m_data[1] != '\xbb' ) {
             throw ::std::runtime_error("Incomplete BOM - missing \\xBB in second position");
         }
-        if( this->getc_byte() != '\xbf' ) {
+        if( m_data.size() < 3 || m_data[2] != '\xbf' ) {
             throw ::std::runtime_error("Incomplete BOM - missing \\xBF in second position");
         }
-        m_line_ofs = 0;
-    }
-    else
-    {
-        m_istream.unget();
+        m_pos = 3;
     }
 }
 
@@ -313,6 +326,7 @@ Token Lexer::getTokenInt()
             return Token(TOK_NEWLINE);
         if( ch.isspace() )
         {
+            this->fast_skip_blanks();
             while( (ch = this->getc()).isspace() && ch != '\n' )
                 ;
             this->ungetc();
@@ -592,6 +606,7 @@ Token Lexer::getTokenInt()
                 while(ch != '\n' && ch != '\r')
                 {
                     str += ch;
+                    this->fast_append_until(str, '\r', '\r', true);
                     ch = this->getc();
                 }
                 this->ungetc();
@@ -654,6 +669,7 @@ Token Lexer::getTokenInt()
                         }
                         else {
                             str += ch;
+                            this->fast_append_until(str, '*', '/', false);
                         }
                     }
                     ch = this->getc();
@@ -719,6 +735,7 @@ Token Lexer::getTokenInt()
                     else
                     {
                         str += ch;
+                        this->fast_append_until(str, '"', '\\', false);
                     }
                 }
                 return Token(TOK_STRING, str);
@@ -796,6 +813,7 @@ Token Lexer::getTokenInt_RawString(bool is_byte)
             }
             else {
                 val += ch;
+                this->fast_append_until(val, static_cast<char>(terminator.v), static_cast<char>(terminator.v), false);
             }
         }
     }
@@ -810,6 +828,7 @@ Token Lexer::getTokenInt_Identifier(Codepoint leader, Codepoint leader2)
     while( issym(ch) )
     {
         str += ch;
+        this->fast_append_ident(str);
         ch = this->getc();
     }
 
@@ -935,9 +954,9 @@ uint32_t Lexer::parseEscape(char enclosing)
 
 char Lexer::getc_byte()
 {
-    int rv = m_istream.get();
-    if( rv == EOF || m_istream.eof() )
+    if( m_pos >= m_data.size() )
         throw Lexer::EndOfFile();
+    char rv = m_data[m_pos++];
 
     if( rv == '\n' )
     {
@@ -947,6 +966,85 @@ char Lexer::getc_byte()
 
     return rv;
 }
+
+namespace {
+    const uint64_t  WORD_ONES  = 0x0101010101010101ull;
+    const uint64_t  WORD_HIGHS = 0x8080808080808080ull;
+    /// Returns true if any byte in `w` is equal to `b` (`w` must not have any high bits set)
+    inline bool word_has_byte(uint64_t w, uint8_t b)
+    {
+        uint64_t x = w ^ (WORD_ONES * b);
+        return ((x - WORD_ONES) & ~x & WORD_HIGHS) != 0;
+    }
+    /// Length of the run of ASCII bytes at the start of `[p, end)` that doesn't contain any of the three stop bytes
+    size_t ascii_run_len(const char* p, const char* end, char s1, char s2, char s3)
+    {
+        const char* start = p;
+        // Word-at-a-time scan (eight bytes per step)
+        while( end - p >= 8 )
+        {
+            uint64_t    w;
+            ::std::memcpy(&w, p, 8);
+            if( (w & WORD_HIGHS) != 0 || word_has_byte(w, s1) || word_has_byte(w, s2) || word_has_byte(w, s3) )
+                break;
+            p += 8;
+        }
+        while( p != end && static_cast<uint8_t>(*p) < 0x80 && *p != s1 && *p != s2 && *p != s3 )
+            p ++;
+        return p - start;
+    }
+}
+
+// Skip spaces, tabs and carriage returns (newlines are tokens)
+void Lexer::fast_skip_blanks()
+{
+    if( m_last_char_valid )
+        return ;
+    while( m_pos < m_data.size() && (m_data[m_pos] == ' ' || m_data[m_pos] == '\t' || m_data[m_pos] == '\r') )
+    {
+        m_pos ++;
+        m_line_ofs ++;
+    }
+}
+// Append any following ASCII identifier characters
+void Lexer::fast_append_ident(::std::string& out)
+{
+    if( m_last_char_valid )
+        return ;
+    size_t start = m_pos;
+    while( m_pos < m_data.size() )
+    {
+        char c = m_data[m_pos];
+        if( !( ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' ) )
+            break;
+        m_pos ++;
+    }
+    out.append(m_data, start, m_pos - start);
+    m_line_ofs += m_pos - start;
+}
+// Append ASCII characters up to (but not including) either stop character
+// - Non-ASCII stops the fast path, so UTF-8 decoding is left to `getc`
+void Lexer::fast_append_until(::std::string& out, char stop1, char stop2, bool stop_at_newline)
+{
+    if( m_last_char_valid )
+        return ;
+    const char* const base = m_data.data();
+    const char* const end = base + m_data.size();
+    for(;;)
+    {
+        size_t len = ascii_run_len(base + m_pos, end, stop1, stop2, '\n');
+        out.append(base + m_pos, len);
+        m_pos += len;
+        m_line_ofs += len;
+        if( stop_at_newline || m_pos == m_data.size() || m_data[m_pos] != '\n' )
+            break;
+        // Newline (not a stop character), consume and keep going
+        out.push_back('\n');
+        m_pos ++;
+        m_line ++;
+        m_line_ofs = 1;
+    }
+}
 Codepoint Lexer::getc()
 {
     if( m_last_char_valid )
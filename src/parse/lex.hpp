@@ -9,7 +9,6 @@
 #define LEX_HPP_INCLUDED
 
 #include <string>
-#include <fstream>
 #include "tokenstream.hpp"
 
 struct Codepoint {
@@ -39,7 +38,9 @@ class Lexer:
     unsigned int m_line;
     unsigned int m_line_ofs;
 
-    ::std::ifstream m_istream;
+    // Entire source file (read in one go), and the current read offset
+    ::std::string   m_data;
+    size_t  m_pos;
     bool    m_last_char_valid;
     Codepoint   m_last_char;
     ::std::vector<Token>    m_next_tokens;
@@ -74,6 +75,11 @@ private:
     Codepoint getc_cp();
     char getc_byte();
 
+    // Fast paths for runs of ASCII (used when no character is pushed back)
+    void fast_skip_blanks();
+    void fast_append_ident(::std::string& out);
+    void fast_append_until(::std::string& out, char stop1, char stop2, bool stop_at_newline);
+
     class EndOfFile {};
 };
 
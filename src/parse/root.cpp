@@ -17,8 +17,12 @@
 #include <hir/hir.hpp>  // ABI_RUST - TODO: Move elsewhere?
 #include <expand/cfg.hpp>   // check_cfg - for `mod nonexistant;`
 #include <fstream>  // Used by directory path
+#include <thread>   // Parallel parsing of module files
+#include <mutex>
+#include <condition_variable>
 #include "lex.hpp"  // New file lexer
 #include <ast/expr.hpp>
+#include <main_bindings.hpp>    // Incremental_AddMissing
 
 template<typename T>
 Spanned<T> get_spanned(TokenStream& lex, ::std::function<T()> f) {
@@ -1808,6 +1812,11 @@ bool Parse_MacroInvocation_Opt(TokenStream& lex,  AST::MacroInvocation& out_inv)
                 DEBUG("newpath_dir = '" << newpath_dir << "', newpath_file = '" << newpath_file << "'");
                 ::std::ifstream ifs_dir (newpath_dir + "mod.rs");
                 ::std::ifstream ifs_file(newpath_file);
+                // The alternative that doesn't exist is a dependency too (creating it would be an error)
+                if( !ifs_dir.is_open() )
+                    Incremental_AddMissing(newpath_dir + "mod.rs");
+                if( !ifs_file.is_open() )
+                    Incremental_AddMissing(newpath_file);
                 if( ifs_dir.is_open() && ifs_file.is_open() )
                 {
                     // Collision
@@ -1828,9 +1837,16 @@ bool Parse_MacroInvocation_Opt(TokenStream& lex,  AST::MacroInvocation& out_inv)
                     ERROR(lex.point_span(), E0000, "Can't find file for '" << name << "' in '" << mod_fileinfo.path << "'");
                 }
                 DEBUG("- path = " << submod.m_file_info.path);
-                Lexer sub_lex(submod.m_file_info.path);
-                Parse_ModRoot(sub_lex, submod, meta_items);
-                GET_CHECK_TOK(tok, sub_lex, TOK_EOF);
+                if( lex.parse_state().defer_mod_files )
+                {
+                    submod.m_file_info.load_pending = true;
+                }
+                else
+                {
+                    Lexer sub_lex(submod.m_file_info.path);
+                    Parse_ModRoot(sub_lex, submod, meta_items);
+                    GET_CHECK_TOK(tok, sub_lex, TOK_EOF);
+                }
             }
             break;
         default:
@@ -1913,7 +1929,128 @@ void Parse_ModRoot(TokenStream& lex, AST::Module& mod, AST::MetaItems& mod_attrs
     Parse_ModRoot_Items(lex, mod);
 }
 
-AST::Crate Parse_Crate(::std::string mainfile)
+namespace {
+    /// A `mod foo;` item whose file is still to be parsed
+    struct PendingModFile
+    {
+        ::AST::Item*    item;
+        // Inner attributes are collected separately, and appended to the item's attributes once all threads are done
+        ::AST::MetaItems    inner_attrs;
+        ::std::exception_ptr    error;
+        // Diagnostics printed while raising `error` (buffered so they're printed in queue order by the main thread)
+        ::std::string   error_output;
+    };
+
+    /// Locate modules marked by `defer_mod_files` within a freshly parsed module (including inline and anon modules)
+    void Parse_CollectPendingMods(::AST::Module& mod, ::std::vector< ::std::unique_ptr<PendingModFile> >& out)
+    {
+        for(auto& i : mod.items())
+        {
+            if( auto* e = i.data.opt_Module() )
+            {
+                if( e->m_file_info.load_pending )
+                {
+                    e->m_file_info.load_pending = false;
+                    out.push_back( ::std::unique_ptr<PendingModFile>(new PendingModFile { &i.data, {}, nullptr }) );
+                }
+                else
+                {
+                    Parse_CollectPendingMods(*e, out);
+                }
+            }
+        }
+        for(auto& am : mod.anon_mods())
+        {
+            if( am )
+                Parse_CollectPendingMods(*am, out);
+        }
+    }
+
+    void Parse_PendingModFile(PendingModFile& pm)
+    {
+        auto& submod = pm.item->as_Module();
+        // `ERROR`/`BUG` would otherwise terminate from this thread, making the reported error depend on scheduling
+        SpanErrorCollector  collect_errors;
+        try
+        {
+            Token   tok;
+            Lexer sub_lex(submod.m_file_info.path);
+            sub_lex.parse_state().defer_mod_files = true;
+            Parse_ModRoot(sub_lex, submod, pm.inner_attrs);
+            GET_CHECK_TOK(tok, sub_lex, TOK_EOF);
+        }
+        catch(...)
+        {
+            pm.error = ::std::current_exception();
+            pm.error_output = collect_errors.take_output();
+        }
+    }
+
+    /// Parse all deferred module files under `root` using a pool of `num_threads` threads
+    /// - Each file only touches its own (pre-allocated) module, so the tree is left in source order
+    void Parse_PendingModFiles(::AST::Module& root, unsigned int num_threads)
+    {
+        TRACE_FUNCTION;
+        ::std::vector< ::std::unique_ptr<PendingModFile> >  jobs;
+        Parse_CollectPendingMods(root, jobs);
+
+        ::std::mutex    lock;
+        ::std::condition_variable   cv;
+        size_t  next_job = 0;
+        unsigned int    num_active = 0;
+        auto worker = [&]() {
+            ::std::unique_lock< ::std::mutex>   lh(lock);
+            for(;;)
+            {
+                // Wait until there's a job, or there's nothing left that could produce one
+                cv.wait(lh, [&](){ return next_job < jobs.size() || num_active == 0; });
+                if( next_job == jobs.size() )
+                    break;
+                auto* job = jobs[next_job++].get();
+                num_active ++;
+                lh.unlock();
+
+                Parse_PendingModFile(*job);
+                ::std::vector< ::std::unique_ptr<PendingModFile> >  new_jobs;
+                if( !job->error )
+                    Parse_CollectPendingMods(job->item->as_Module(), new_jobs);
+
+                lh.lock();
+                num_active --;
+                for(auto& j : new_jobs)
+                    jobs.push_back( mv$(j) );
+                cv.notify_all();
+            }
+            cv.notify_all();
+            };
+
+        ::std::vector< ::std::thread>   threads;
+        for(unsigned int i = 1; i < num_threads; i ++)
+            threads.push_back( ::std::thread(worker) );
+        worker();
+        for(auto& t : threads)
+            t.join();
+        DEBUG(jobs.size() << " module files");
+
+        for(auto& job : jobs)
+        {
+            if( job->error )
+            {
+                ::std::cout << job->error_output << ::std::flush;
+                try {
+                    ::std::rethrow_exception(job->error);
+                }
+                catch(const CollectedError& e) {
+                    e.report();
+                }
+            }
+            for(auto& a : job->inner_attrs.m_items)
+                job->item->attrs.push_back( mv$(a) );
+        }
+    }
+}
+
+AST::Crate Parse_Crate(::std::string mainfile, unsigned int num_threads)
 {
     Token   tok;
 
@@ -1928,7 +2065,16 @@ AST::Crate Parse_Crate(::std::string mainfile)
     crate.root_module().m_file_info.path = mainpath;
     crate.root_module().m_file_info.controls_dir = true;
 
-    Parse_ModRoot(lex, crate.root_module(), crate.m_attrs);
+    if( num_threads > 1 )
+    {
+        lex.parse_state().defer_mod_files = true;
+        Parse_ModRoot(lex, crate.root_module(), crate.m_attrs);
+        Parse_PendingModFiles(crate.root_module(), num_threads);
+    }
+    else
+    {
+        Parse_ModRoot(lex, crate.root_module(), crate.m_attrs);
+    }
 
     return crate;
 }
@@ -125,15 +125,11 @@ ProtoSpan TokenStream::start_span() const
 Span TokenStream::end_span(ProtoSpan ps) const
 {
     auto p = this->getPosition();
-    auto rv = Span( ps.filename,  ps.start_line, ps.start_ofs,  p.line, p.ofs );
-    rv.outer_span = this->outerSpan();
-    return rv;
+    return Span( this->outerSpan(), ps.filename,  ps.start_line, ps.start_ofs,  p.line, p.ofs );
 }
 Span TokenStream::point_span() const
 {
-    Span rv = this->getPosition();
-    rv.outer_span = this->outerSpan();
-    return rv;
+    return Span( this->getPosition(), this->outerSpan() );
 }
 Ident TokenStream::get_ident(Token tok) const
 {
@@ -26,6 +26,8 @@ struct ParseState
     bool disallow_struct_literal = false;
     // A debugging hook that disables expansion of macros
     bool no_expand_macros = false;
+    // Leave `mod foo;` files to be parsed later (by `Parse_Crate`, possibly in parallel) instead of inline
+    bool defer_mod_files = false;
 
     ::AST::Module*  module = nullptr;
     ::AST::MetaItems*   parent_attrs = nullptr;
@@ -74,7 +76,7 @@ public:
 
 protected:
     virtual Position getPosition() const = 0;
-    virtual ::std::shared_ptr<Span> outerSpan() const { return ::std::shared_ptr<Span>(0); }
+    virtual Span outerSpan() const { static const Span s_none; return s_none; }
     virtual Token   realGetToken() = 0;
     virtual Ident::Hygiene realGetHygiene() const = 0;
 private:
@@ -15,7 +15,7 @@ class TTStream:
     public TokenStream
 {
     ::std::vector< ::std::pair<unsigned int, const TokenTree*> > m_stack;
-    ::std::shared_ptr<Span> m_parent_span;
+    Span    m_parent_span;
     const Ident::Hygiene*   m_hygiene_ptr = nullptr;
 public:
     TTStream(Span parent, const TokenTree& input_tt);
@@ -24,7 +24,7 @@ public:
     TTStream& operator=(const TTStream& x) { m_stack = x.m_stack; return *this; }
 
     Position getPosition() const override;
-    ::std::shared_ptr<Span> outerSpan() const override { return m_parent_span; }
+    Span outerSpan() const override { return m_parent_span; }
 
 protected:
     Ident::Hygiene realGetHygiene() const override;
@@ -40,7 +40,7 @@ class TTStreamO:
     ::std::vector< ::std::pair<unsigned int, TokenTree*> > m_stack;
     const Ident::Hygiene*   m_hygiene_ptr = nullptr;
 public:
-    ::std::shared_ptr<Span> m_parent_span;
+    Span    m_parent_span;
     TTStreamO(Span parent, TokenTree input_tt);
     TTStreamO(TTStreamO&& x) = default;
     ~TTStreamO();
@@ -49,7 +49,7 @@ public:
     TTStreamO& operator=(TTStreamO&& x) = default;
 
     Position getPosition() const override;
-    ::std::shared_ptr<Span> outerSpan() const override { return m_parent_span; }
+    Span outerSpan() const override { return m_parent_span; }
 
 protected:
     Ident::Hygiene realGetHygiene() const override;
@@ -7,63 +7,214 @@
  */
 #include <functional>
 #include <iostream>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+#include <vector>
 #include <span.hpp>
+#include <chunked_store.hpp>
 #include <parse/lex.hpp>
 #include <common.hpp>
 
-Span::Span(const Span& x):
-    outer_span(x.outer_span),
-    filename(x.filename),
-    start_line(x.start_line),
-    start_ofs(x.start_ofs),
-    end_line(x.end_line),
-    end_ofs(x.end_ofs)
+namespace {
+    /// Global append-only store of span information, indexed by `Span::m_id`
+    /// - Lookups need no lock (see `ChunkedStore`), `m_lock` serialises adding entries.
+    /// - Identical entries share an id (looked up in `m_index`), which roughly halves the map for typical crates.
+    ///   The index is only useful while spans are created in bulk (parsing/expansion), and is released after lowering.
+    /// - Entries themselves are never freed, as HIR/MIR keep span ids for diagnostics until the end of compilation.
+    class SourceMap
+    {
+        ::std::mutex    m_lock;
+        // NOTE: Id 0 is the empty span
+        ChunkedStore<SpanData, 14, 32>  m_entries;
+        // Open-addressed hash table of ids (0 = empty slot), protected by `m_lock`
+        ::std::vector<uint32_t> m_index;
+        size_t  m_index_count = 0;
+        bool    m_index_released = false;
+
+    public:
+        static SourceMap& get() {
+            static SourceMap    s_map;
+            return s_map;
+        }
+        uint32_t add(SpanData data)
+        {
+            // Spans are often created repeatedly for the same location (e.g. parser point spans), so reuse this thread's
+            // last entry if it's identical.
+            static thread_local uint32_t   tl_last_id = 0;
+            if( tl_last_id != 0 && is_same((*this)[tl_last_id], data) )
+            {
+                return tl_last_id;
+            }
+
+            ::std::lock_guard< ::std::mutex>    lh(m_lock);
+            size_t hash = 0;
+            if( !m_index_released )
+            {
+                hash = hash_of(data);
+                if( uint32_t id = this->find(data, hash) )
+                {
+                    tl_last_id = id;
+                    return id;
+                }
+            }
+
+            uint32_t id = m_entries.push(::std::move(data));
+            if( id == 0 ) {
+                ::std::cerr << "BUG: Source map overflow" << ::std::endl;
+                abort();
+            }
+            if( !m_index_released )
+                this->insert(id, hash);
+            tl_last_id = id;
+            return id;
+        }
+        const SpanData& operator[](uint32_t id) const
+        {
+            return m_entries[id];
+        }
+
+        /// Free the de-duplication index, later spans are always appended
+        void release_index()
+        {
+            ::std::lock_guard< ::std::mutex>    lh(m_lock);
+            m_index_released = true;
+            m_index_count = 0;
+            ::std::vector<uint32_t>().swap(m_index);
+        }
+
+    private:
+        static bool is_same(const SpanData& a, const SpanData& b)
+        {
+            return a.outer_span.m_id == b.outer_span.m_id && a.filename == b.filename
+                && a.start_line == b.start_line && a.start_ofs == b.start_ofs
+                && a.end_line == b.end_line && a.end_ofs == b.end_ofs;
+        }
+        static size_t hash_of(const SpanData& d)
+        {
+            // NOTE: Hashes the filename by pointer (the lexer shares one string per file), so identical names in
+            // different strings just won't be merged.
+            uint64_t h = reinterpret_cast<uintptr_t>(d.filename.c_str());
+            for(uint32_t v : { d.outer_span.m_id, d.start_line, d.start_ofs, d.end_line, d.end_ofs })
+                h = (h ^ v) * 0x100000001b3ull;
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+
+        uint32_t find(const SpanData& data, size_t hash) const
+        {
+            if( m_index.empty() )
+                return 0;
+            size_t mask = m_index.size() - 1;
+            for(size_t i = hash & mask; m_index[i] != 0; i = (i + 1) & mask)
+            {
+                const auto& ent = (*this)[m_index[i]];
+                if( is_same(ent, data) )
+                    return m_index[i];
+            }
+            return 0;
+        }
+        void insert(uint32_t id, size_t hash)
+        {
+            // Keep the load factor at or below 1/2
+            if( (m_index_count + 1) * 2 > m_index.size() )
+            {
+                ::std::vector<uint32_t> old;
+                old.swap(m_index);
+                m_index.resize(old.empty() ? 1024 : old.size() * 2);
+                for(uint32_t old_id : old)
+                    if( old_id != 0 )
+                        this->insert_slot(old_id, hash_of((*this)[old_id]));
+            }
+            this->insert_slot(id, hash);
+            m_index_count += 1;
+        }
+        void insert_slot(uint32_t id, size_t hash)
+        {
+            size_t mask = m_index.size() - 1;
+            size_t i = hash & mask;
+            while( m_index[i] != 0 )
+                i = (i + 1) & mask;
+            m_index[i] = id;
+        }
+    };
+}
+
+Span::Span(RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs):
+    Span(Span(0u), ::std::move(filename), start_line, start_ofs, end_line, end_ofs)
+{
+}
+Span::Span(const Span& outer, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs):
+    m_id( SourceMap::get().add(SpanData { outer, ::std::move(filename), start_line, start_ofs, end_line, end_ofs }) )
 {
 }
 Span::Span(const Position& pos):
-    outer_span(),
-    filename(pos.filename),
-    start_line(pos.line),
-    start_ofs(pos.ofs),
-    end_line(pos.line),
-    end_ofs(pos.ofs)
+    Span(Span(0u), pos.filename, pos.line, pos.ofs, pos.line, pos.ofs)
+{
+}
+Span::Span(const Position& pos, const Span& outer):
+    Span(outer, pos.filename, pos.line, pos.ofs, pos.line, pos.ofs)
 {
 }
 Span::Span():
-    outer_span(),
-    filename("")/*,
-    start_line(0), start_ofs(0),
-    end_line(0), end_ofs(0) // */
+    m_id(0)
 {
     DEBUG("Empty span");
     //filename = FMT(":" << __builtin_return_address(0));
 }
+const SpanData& Span::get() const
+{
+    if( m_id == 0 )
+    {
+        static const SpanData   s_empty { Span(0u), RcString(""), 0, 0, 0, 0 };
+        return s_empty;
+    }
+    return SourceMap::get()[m_id];
+}
 
 namespace {
-    void print_span_message(const Span& sp, ::std::function<void(::std::ostream&)> tag, ::std::function<void(::std::ostream&)> msg)
+    /// Innermost `SpanErrorCollector` on this thread
+    thread_local SpanErrorCollector*    tl_collector = nullptr;
+
+    void print_span_message(::std::ostream& sink, const Span& sp, ::std::function<void(::std::ostream&)> tag, ::std::function<void(::std::ostream&)> msg)
     {
-        auto& sink = ::std::cerr;
-        sink << sp.filename << ":" << sp.start_line << ": ";
+        const auto& data = sp.get();
+        sink << data.filename << ":" << data.start_line << ": ";
         tag(sink);
         sink << ":";
         msg(sink);
         sink << ::std::endl;
-        const auto* parent = sp.outer_span.get();
-        while(parent)
+        for(const auto* parent = &data.outer_span; !parent->is_empty(); parent = &parent->outer_span())
+        {
+            sink << parent->filename() << ":" << parent->start_line() << ": note: From here" << ::std::endl;
+        }
+    }
+    void print_span_message(const Span& sp, ::std::function<void(::std::ostream&)> tag, ::std::function<void(::std::ostream&)> msg)
+    {
+        print_span_message(::std::cerr, sp, tag, msg);
+    }
+    /// Either throws the message as a `CollectedError` (if collecting), or returns so the caller can print it
+    void maybe_collect(const Span& sp, ::std::function<void(::std::ostream&)> tag, ::std::function<void(::std::ostream&)> msg)
+    {
+        if( tl_collector )
         {
-            sink << parent->filename << ":" << parent->start_line << ": note: From here" << ::std::endl;
-            parent = parent->outer_span.get();
+            ::std::stringstream ss;
+            print_span_message(ss, sp, tag, msg);
+            throw CollectedError(ss.str());
         }
     }
 }
 void Span::bug(::std::function<void(::std::ostream&)> msg) const
 {
-    print_span_message(*this, [](auto& os){os << "BUG";}, msg);
+    auto tag = [](auto& os){os << "BUG";};
+    maybe_collect(*this, tag, msg);
+    print_span_message(*this, tag, msg);
     abort();
 }
 
 void Span::error(ErrorType tag, ::std::function<void(::std::ostream&)> msg) const {
-    print_span_message(*this, [&](auto& os){os << "error:" << tag;}, msg);
+    auto tag_fmt = [&](auto& os){os << "error:" << tag;};
+    maybe_collect(*this, tag_fmt, msg);
+    print_span_message(*this, tag_fmt, msg);
 #ifndef _WIN32
     abort();
 #else
@@ -77,8 +228,43 @@ void Span::note(::std::function<void(::std::ostream&)> msg) const {
     print_span_message(*this, [](auto& os){os << "note";}, msg);
 }
 
+void Span::release_dedup_index()
+{
+    SourceMap::get().release_index();
+}
+
+void CollectedError::report() const
+{
+    ::std::cerr << this->what() << ::std::flush;
+#ifndef _WIN32
+    abort();
+#else
+    exit(1);
+#endif
+}
+SpanErrorCollector::SpanErrorCollector():
+    m_saved(tl_collector)
+{
+    tl_collector = this;
+}
+SpanErrorCollector::~SpanErrorCollector()
+{
+    tl_collector = m_saved;
+}
+::std::ostream& SpanErrorCollector::output(::std::ostream& fallback)
+{
+    return tl_collector ? tl_collector->m_output : fallback;
+}
+::std::string SpanErrorCollector::take_output()
+{
+    auto rv = m_output.str();
+    m_output.str("");
+    return rv;
+}
+
 ::std::ostream& operator<<(::std::ostream& os, const Span& sp)
 {
-    os << sp.filename << ":" << sp.start_line;
+    const auto& data = sp.get();
+    os << data.filename << ":" << data.start_line;
     return os;
 }
@@ -18,7 +18,16 @@
 void Trans_Codegen(const ::std::string& outfile, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, bool is_executable)
 {
     static Span sp;
-    auto codegen = Trans_Codegen_GetGeneratorC(crate, outfile);
+    ::std::unique_ptr<CodeGenerator>    codegen;
+    switch(opt.backend)
+    {
+    case CodegenBackend::C:
+        codegen = Trans_Codegen_GetGeneratorC(crate, outfile, opt);
+        break;
+    case CodegenBackend::X86_64:
+        codegen = Trans_Codegen_GetGeneratorX64(crate, outfile, opt);
+        break;
+    }
 
     // 1. Emit structure/type definitions.
     // - Emit in the order they're needed.
@@ -87,9 +96,9 @@ void Trans_Codegen(const ::std::string& outfile, const TransOptions& opt, const
         DEBUG("FUNCTION " << ent.first);
         assert( ent.second->ptr );
         const auto& fcn = *ent.second->ptr;
-        // Extern if there isn't any HIR
-        bool is_extern = ! static_cast<bool>(fcn.m_code);
-        if( fcn.m_code.m_mir ) {
+        // Extern if there isn't any HIR (unless this is the only copy)
+        bool is_extern = !fcn.m_code.has_body() && !opt.whole_program;
+        if( fcn.m_code.m_mir && !ent.second->upstream ) {
             codegen->emit_function_proto(ent.first, fcn, ent.second->pp, is_extern);
         }
     }
@@ -99,7 +108,7 @@ void Trans_Codegen(const ::std::string& outfile, const TransOptions& opt, const
         //DEBUG("FUNCTION " << ent.first);
         assert( ent.second->ptr );
         const auto& fcn = *ent.second->ptr;
-        if( fcn.m_code.m_mir ) {
+        if( fcn.m_code.m_mir && !ent.second->upstream ) {
         }
         else {
             // TODO: Why would an intrinsic be in the queue?
@@ -150,21 +159,22 @@ void Trans_Codegen(const ::std::string& outfile, const TransOptions& opt, const
 
 
     // 4. Emit function code
+    // - A single resolver is used for all functions (no generics are ever set on it, and type properties are shared)
+    ::StaticTraitResolve    resolve { crate };
     for(const auto& ent : list.m_functions)
     {
-        if( ent.second->ptr && ent.second->ptr->m_code.m_mir )
+        if( ent.second->ptr && ent.second->ptr->m_code.m_mir && !ent.second->upstream )
         {
             const auto& path = ent.first;
             const auto& fcn = *ent.second->ptr;
             const auto& pp = ent.second->pp;
             TRACE_FUNCTION_F(path);
             DEBUG("FUNCTION CODE " << path);
-            bool is_extern = ! static_cast<bool>(fcn.m_code);
+            bool is_extern = !fcn.m_code.has_body() && !opt.whole_program;
             // If this is a provided trait method, it needs to be monomorphised too.
             bool is_method = ( fcn.m_args.size() > 0 && visit_ty_with(fcn.m_args[0].second, [&](const auto& x){return x == ::HIR::TypeRef("Self",0xFFFF);}) );
             if( pp.has_types() || is_method )
             {
-                ::StaticTraitResolve    resolve { crate };
                 auto ret_type = pp.monomorph(resolve, fcn.m_return);
                 ::HIR::Function::args_t args;
                 for(const auto& a : fcn.m_args)
@@ -176,12 +186,10 @@ void Trans_Codegen(const ::std::string& outfile, const TransOptions& opt, const
                 MIR_Cleanup(resolve, ip, *mir, args, ret_type);
                 MIR_Optimise(resolve, ip, *mir, args, ret_type);
                 MIR_Validate(resolve, ip, *mir, args, ret_type);
-                // TODO: Flag that this should be a weak (or weak-er) symbol?
-                // - If it's from an external crate, it should be weak
                 codegen->emit_function_code(path, fcn, ent.second->pp, is_extern,  mir);
             }
-            // TODO: Detect if the function was a #[inline] function from another crate, and don't emit if that is the case?
-            // - Emiting is nice, but it should be emitted as a weak symbol
+            // NOTE: Copies of other crates' code (`is_extern`) that their crate doesn't export are emitted locally, the
+            // backend decides if they're weak or `static`
             else {
                 codegen->emit_function_code(path, fcn, pp, is_extern,  fcn.m_code.m_mir);
             }
@@ -55,5 +55,6 @@ public:
 };
 
 
-extern ::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile);
+extern ::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt);
+extern ::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorX64(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt);
 
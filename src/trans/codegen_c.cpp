@@ -10,6 +10,8 @@
 #include <fstream>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <map>
 #include <hir/hir.hpp>
 #include <mir/mir.hpp>
 #include <hir_typeck/static.hpp>
@@ -193,13 +195,28 @@ namespace {
         struct {
             bool emulated_i128 = false;
             bool disallow_empty_structs = false;
+            bool structured_code = false;
+            /// Emit comments describing the source of the generated code
+            bool verbose = false;
+            /// Emit local copies of other crates' functions as weak symbols (instead of `static`)
+            bool weak_local_copies = false;
         } m_options;
 
-        ::std::map<::HIR::GenericPath, ::std::vector<unsigned>> m_enum_repr_cache;
+        /// Mangled names of the paths and types used by the generated code
+        /// - Most are referenced many times over (e.g. struct names in every declaration), so are only formatted once
+        ::std::map< ::HIR::GenericPath, ::std::string>  m_mangled_gpaths;
+        ::std::map< ::HIR::Path, ::std::string> m_mangled_paths;
+        ::std::map< ::HIR::TypeRef, ::std::string>  m_mangled_types;
+
+        /// Drop flags of the current function that are read (and so are declared)
+        ::std::vector<bool> m_used_drop_flags;
+
+        /// Nesting depth of loops emitted by `assign_from_literal` (used to name the loop counters)
+        unsigned    m_literal_loop_depth = 0;
 
         ::std::vector< ::std::pair< ::HIR::GenericPath, const ::HIR::Struct*> >   m_box_glue_todo;
     public:
-        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile):
+        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt):
             m_crate(crate),
             m_resolve(crate),
             m_outfile_path(outfile),
@@ -218,6 +235,11 @@ namespace {
                 m_options.disallow_empty_structs = true;
                 break;
             }
+            m_options.structured_code = opt.structured_c;
+            m_options.verbose = opt.verbose_c;
+            // Lets the linker merge the copies made by each crate, but weak functions can't be inlined so it's only done
+            // for unoptimised builds
+            m_options.weak_local_copies = m_compiler == Compiler::Gcc && opt.opt_level == 0 && Target_GetCurSpec().m_os_name != "windows";
 
             m_of
                 << "/*\n"
@@ -406,13 +428,13 @@ namespace {
                 auto c_start_path = m_resolve.m_crate.get_lang_item_path_opt("mrustc-start");
                 if( c_start_path == ::HIR::SimplePath() )
                 {
-                    m_of << "\treturn " << Trans_Mangle( ::HIR::GenericPath(m_resolve.m_crate.get_lang_item_path(Span(), "start")) ) << "("
-                            << Trans_Mangle( ::HIR::GenericPath(m_resolve.m_crate.get_lang_item_path(Span(), "mrustc-main")) ) << ", argc, (uint8_t**)argv"
+                    m_of << "\treturn " << mangle( ::HIR::GenericPath(m_resolve.m_crate.get_lang_item_path(Span(), "start")) ) << "("
+                            << mangle( ::HIR::GenericPath(m_resolve.m_crate.get_lang_item_path(Span(), "mrustc-main")) ) << ", argc, (uint8_t**)argv"
                             << ");\n";
                 }
                 else
                 {
-                    m_of << "\treturn " << Trans_Mangle(::HIR::GenericPath(c_start_path)) << "(argc, argv);\n";
+                    m_of << "\treturn " << mangle(::HIR::GenericPath(c_start_path)) << "(argc, argv);\n";
                 }
                 m_of << "}\n";
             }
@@ -467,9 +489,14 @@ namespace {
                 args.push_back(m_outfile_path_c.c_str());
                 if( is_executable )
                 {
+                    for(const auto& path : opt.extra_objects)
+                    {
+                        args.push_back(path.c_str());
+                    }
                     for( const auto& crate : m_crate.m_ext_crates )
                     {
-                        args.push_back(crate.second.m_path + ".o");
+                        if( !opt.whole_program )
+                            args.push_back(crate.second.m_path + ".o");
                     }
                     for(const auto& path : link_dirs )
                     {
@@ -492,6 +519,16 @@ namespace {
                     }
                     args.push_back("-Wl,--gc-sections");
                 }
+                else if( !opt.extra_objects.empty() )
+                {
+                    // Objects from other backends are merged into the library's object by the same invocation
+                    args.push_back("-r");
+                    args.push_back("-nostdlib");
+                    for(const auto& path : opt.extra_objects)
+                    {
+                        args.push_back(path.c_str());
+                    }
+                }
                 else
                 {
                     args.push_back("-c");
@@ -525,7 +562,8 @@ namespace {
 
                     for( const auto& crate : m_crate.m_ext_crates )
                     {
-                        args.push_back(crate.second.m_path + ".o");
+                        if( !opt.whole_program )
+                            args.push_back(crate.second.m_path + ".o");
                     }
                     // Crate-specified libraries
                     for(const auto& lib : m_crate.m_ext_libs) {
@@ -561,6 +599,11 @@ namespace {
                 break;
             }
 
+            run_command(args, is_windows);
+        }
+
+        static void run_command(const StringList& args, bool is_windows)
+        {
             ::std::stringstream cmd_ss;
             if (is_windows)
             {
@@ -605,15 +648,15 @@ namespace {
             ::MIR::Function empty_fcn;
             ::MIR::TypeResolve  mir_res { sp, m_resolve, FMT_CB(ss, ss << drop_glue_path;), struct_ty_ptr, args, empty_fcn };
             m_mir_res = &mir_res;
-            m_of << "static void " << Trans_Mangle(drop_glue_path) << "(struct s_" << Trans_Mangle(p) << "* rv) {\n";
+            m_of << "static void " << mangle(drop_glue_path) << "(struct s_" << mangle(p) << "* rv) {\n";
 
             // Obtain inner pointer
             // TODO: This is very specific to the structure of the official liballoc's Box.
             m_of << "\t"; emit_ctype(args[0].second, FMT_CB(ss, ss << "arg0"; ));    m_of << " = rv->_0._0._0;\n";
             // Call destructor of inner data
-            emit_destructor_call( ::MIR::LValue::make_Deref({ box$(::MIR::LValue::make_Argument({0})) }), *ity, true, 1);
+            emit_destructor_call( ::MIR::LValue::new_Deref(::MIR::LValue::new_Argument(0)), *ity, true, 1);
             // Emit a call to box_free for the type
-            m_of << "\t" << Trans_Mangle(box_free) << "(arg0);\n";
+            m_of << "\t" << mangle(box_free) << "(arg0);\n";
 
             m_of << "}\n";
             m_mir_res = nullptr;
@@ -624,10 +667,10 @@ namespace {
             switch(m_compiler)
             {
             case Compiler::Gcc:
-                m_of << "tTYPEID __typeid_" << Trans_Mangle(ty) << " __attribute__((weak));\n";
+                m_of << "tTYPEID __typeid_" << mangle(ty) << " __attribute__((weak));\n";
                 break;
             case Compiler::Msvc:
-                m_of << "__declspec(selectany) tTYPEID __typeid_" << Trans_Mangle(ty) << ";\n";
+                m_of << "__declspec(selectany) tTYPEID __typeid_" << mangle(ty) << ";\n";
                 break;
             }
         }
@@ -651,13 +694,13 @@ namespace {
                 (Unbound,  throw ""; ),
                 (Opaque,  throw ""; ),
                 (Struct,
-                    m_of << "struct s_" << Trans_Mangle(te.path) << ";\n";
+                    m_of << "struct s_" << mangle(te.path) << ";\n";
                     ),
                 (Union,
-                    m_of << "union u_" << Trans_Mangle(te.path) << ";\n";
+                    m_of << "union u_" << mangle(te.path) << ";\n";
                     ),
                 (Enum,
-                    m_of << "struct e_" << Trans_Mangle(te.path) << ";\n";
+                    m_of << "struct e_" << mangle(te.path) << ";\n";
                     )
                 )
             )
@@ -730,19 +773,21 @@ namespace {
                 auto ty_ptr = ::HIR::TypeRef::new_pointer(::HIR::BorrowType::Owned, ty.clone());
                 ::MIR::TypeResolve  mir_res { sp, m_resolve, FMT_CB(ss, ss << drop_glue_path;), ty_ptr, args, empty_fcn };
                 m_mir_res = &mir_res;
-                m_of << "static void " << Trans_Mangle(drop_glue_path) << "("; emit_ctype(ty); m_of << "* rv) {";
-                auto self = ::MIR::LValue::make_Deref({ box$(::MIR::LValue::make_Return({})) });
-                auto fld_lv = ::MIR::LValue::make_Field({ box$(self), 0 });
+                m_of << "static void " << mangle(drop_glue_path) << "("; emit_ctype(ty); m_of << "* rv) {";
+                auto self = ::MIR::LValue::new_Deref(::MIR::LValue::new_Return());
+                auto fld_lv = ::MIR::LValue::new_Field(mv$(self), 0);
                 for(const auto& ity : te)
                 {
                     emit_destructor_call(fld_lv, ity, /*unsized_valid=*/false, 1);
-                    fld_lv.as_Field().field_index ++;
+                    fld_lv.m_wrappers.back().set_Field( fld_lv.as_Field() + 1 );
                 }
                 m_of << "}\n";
             )
             else TU_IFLET( ::HIR::TypeRef::Data, ty.m_data, Function, te,
                 emit_type_fn(ty);
-                m_of << " // " << ty << "\n";
+                if( m_options.verbose )
+                    m_of << " // " << ty;
+                m_of << "\n";
             )
             else TU_IFLET( ::HIR::TypeRef::Data, ty.m_data, Array, te,
                 m_of << "typedef struct "; emit_ctype(ty); m_of << " { "; emit_ctype(*te.inner); m_of << " DATA[" << te.size_val << "]; } "; emit_ctype(ty); m_of << ";\n";
@@ -798,8 +843,9 @@ namespace {
                     emit_ctype( ty, inner );
                 }
                 };
-            m_of << "// struct " << p << "\n";
-            m_of << "struct s_" << Trans_Mangle(p) << " {\n";
+            if( m_options.verbose )
+                m_of << "// struct " << p << "\n";
+            m_of << "struct s_" << mangle(p) << " {\n";
 
             // HACK: For vtables, insert the alignment and size at the start
             if(is_vtable)
@@ -872,26 +918,26 @@ namespace {
                         m_of << "extern ";
                     }
                 }
-                m_of << "tUNIT " << Trans_Mangle( ::HIR::Path(struct_ty.clone(), m_resolve.m_lang_Drop, "drop") ) << "("; emit_ctype(struct_ty_ptr, FMT_CB(ss, ss << "rv";)); m_of << ");\n";
+                m_of << "tUNIT " << mangle( ::HIR::Path(struct_ty.clone(), m_resolve.m_lang_Drop, "drop") ) << "("; emit_ctype(struct_ty_ptr, FMT_CB(ss, ss << "rv";)); m_of << ");\n";
             }
             else if( m_resolve.is_type_owned_box(struct_ty) )
             {
                 m_box_glue_todo.push_back( ::std::make_pair( mv$(struct_ty.m_data.as_Path().path.m_data.as_Generic()), &item ) );
-                m_of << "static void " << Trans_Mangle(drop_glue_path) << "("; emit_ctype(struct_ty_ptr, FMT_CB(ss, ss << "rv";)); m_of << ");\n";
+                m_of << "static void " << mangle(drop_glue_path) << "("; emit_ctype(struct_ty_ptr, FMT_CB(ss, ss << "rv";)); m_of << ");\n";
                 return ;
             }
 
             ::MIR::TypeResolve  mir_res { sp, m_resolve, FMT_CB(ss, ss << drop_glue_path;), struct_ty_ptr, args, empty_fcn };
             m_mir_res = &mir_res;
-            m_of << "static void " << Trans_Mangle(drop_glue_path) << "("; emit_ctype(struct_ty_ptr, FMT_CB(ss, ss << "rv";)); m_of << ") {\n";
+            m_of << "static void " << mangle(drop_glue_path) << "("; emit_ctype(struct_ty_ptr, FMT_CB(ss, ss << "rv";)); m_of << ") {\n";
 
             // If this type has an impl of Drop, call that impl
             if( item.m_markings.has_drop_impl ) {
-                m_of << "\t" << Trans_Mangle( ::HIR::Path(struct_ty.clone(), m_resolve.m_lang_Drop, "drop") ) << "(rv);\n";
+                m_of << "\t" << mangle( ::HIR::Path(struct_ty.clone(), m_resolve.m_lang_Drop, "drop") ) << "(rv);\n";
             }
 
-            auto self = ::MIR::LValue::make_Deref({ box$(::MIR::LValue::make_Return({})) });
-            auto fld_lv = ::MIR::LValue::make_Field({ box$(self), 0 });
+            auto self = ::MIR::LValue::new_Deref(::MIR::LValue::new_Return());
+            auto fld_lv = ::MIR::LValue::new_Field(mv$(self), 0);
             TU_MATCHA( (item.m_data), (e),
             (Unit,
                 ),
@@ -899,7 +945,7 @@ namespace {
                 for(unsigned int i = 0; i < e.size(); i ++)
                 {
                     const auto& fld = e[i];
-                    fld_lv.as_Field().field_index = i;
+                    fld_lv.m_wrappers.back().set_Field(i);
 
                     emit_destructor_call(fld_lv, monomorph(fld.ent), true, 1);
                 }
@@ -908,7 +954,7 @@ namespace {
                 for(unsigned int i = 0; i < e.size(); i ++)
                 {
                     const auto& fld = e[i].second;
-                    fld_lv.as_Field().field_index = i;
+                    fld_lv.m_wrappers.back().set_Field(i);
 
                     emit_destructor_call(fld_lv, monomorph(fld.ent), true, 1);
                 }
@@ -936,7 +982,7 @@ namespace {
                     return x;
                 }
                 };
-            m_of << "union u_" << Trans_Mangle(p) << " {\n";
+            m_of << "union u_" << mangle(p) << " {\n";
             for(unsigned int i = 0; i < item.m_variants.size(); i ++)
             {
                 m_of << "\t"; emit_ctype( monomorph(item.m_variants[i].second.ent), FMT_CB(ss, ss << "var_" << i;) ); m_of << ";\n";
@@ -953,13 +999,13 @@ namespace {
 
             if( item.m_markings.has_drop_impl )
             {
-                m_of << "tUNIT " << Trans_Mangle(drop_impl_path) << "(union u_" << Trans_Mangle(p) << "*rv);\n";
+                m_of << "tUNIT " << mangle(drop_impl_path) << "(union u_" << mangle(p) << "*rv);\n";
             }
 
-            m_of << "static void " << Trans_Mangle(drop_glue_path) << "(union u_" << Trans_Mangle(p) << "* rv) {\n";
+            m_of << "static void " << mangle(drop_glue_path) << "(union u_" << mangle(p) << "* rv) {\n";
             if( item.m_markings.has_drop_impl )
             {
-                m_of << "\t" << Trans_Mangle(drop_impl_path) << "(rv);\n";
+                m_of << "\t" << mangle(drop_impl_path) << "(rv);\n";
             }
             m_of << "}\n";
         }
@@ -1027,6 +1073,11 @@ namespace {
                 )
             )
         }
+        /// Get the NonZero optimisation path for an enum type (nullptr if the enum isn't NonZero optimised)
+        const ::std::vector<unsigned int>* get_enum_nonzero_path(const ::HIR::TypeRef& ty) const {
+            const auto* rv = m_resolve.m_type_props.get_enum_repr(ty);
+            return rv && !rv->empty() ? rv : nullptr;
+        }
         void emit_nonzero_path(const ::std::vector<unsigned int>& nonzero_path) {
             for(const auto v : nonzero_path)
             {
@@ -1084,7 +1135,8 @@ namespace {
                 }
             }
 
-            m_of << "// enum " << p << "\n";
+            if( m_options.verbose )
+                m_of << "// enum " << p << "\n";
             if( nonzero_path.size() > 0 )
             {
                 //MIR_ASSERT(*m_mir_res, item.num_variants() == 2, "");
@@ -1093,13 +1145,13 @@ namespace {
                 //MIR_ASSERT(*m_mir_res, data_var.second.is_Tuple(), "");
                 //MIR_ASSERT(*m_mir_res, data_var.second.as_Tuple().size() == 1, "");
                 const auto& data_type = monomorph(item.m_data.as_Data()[1].type);
-                m_of << "struct e_" << Trans_Mangle(p) << " {\n";
+                m_of << "struct e_" << mangle(p) << " {\n";
                 m_of << "\t"; emit_ctype(data_type, FMT_CB(s, s << "_1";)); m_of << ";\n";
                 m_of << "};\n";
             }
             else if( item.m_data.is_Value() )
             {
-                m_of << "struct e_" << Trans_Mangle(p) << " {\n";
+                m_of << "struct e_" << mangle(p) << " {\n";
                 switch(item.m_data.as_Value().repr)
                 {
                 case ::HIR::Enum::Repr::Rust:
@@ -1127,7 +1179,7 @@ namespace {
             else
             {
                 const auto& variants = item.m_data.as_Data();
-                m_of << "struct e_" << Trans_Mangle(p) << " {\n";
+                m_of << "struct e_" << mangle(p) << " {\n";
                 m_of << "\tunsigned int TAG;\n";
                 if( variants.size() > 0 )
                 {
@@ -1155,33 +1207,33 @@ namespace {
 
             if( item.m_markings.has_drop_impl )
             {
-                m_of << "tUNIT " << Trans_Mangle(drop_impl_path) << "(struct e_" << Trans_Mangle(p) << "*rv);\n";
+                m_of << "tUNIT " << mangle(drop_impl_path) << "(struct e_" << mangle(p) << "*rv);\n";
             }
 
-            m_of << "static void " << Trans_Mangle(drop_glue_path) << "(struct e_" << Trans_Mangle(p) << "* rv) {\n";
+            m_of << "static void " << mangle(drop_glue_path) << "(struct e_" << mangle(p) << "* rv) {\n";
 
             // If this type has an impl of Drop, call that impl
             if( item.m_markings.has_drop_impl )
             {
-                m_of << "\t" << Trans_Mangle(drop_impl_path) << "(rv);\n";
+                m_of << "\t" << mangle(drop_impl_path) << "(rv);\n";
             }
-            auto self = ::MIR::LValue::make_Deref({ box$(::MIR::LValue::make_Return({})) });
+            auto self = ::MIR::LValue::new_Deref(::MIR::LValue::new_Return());
 
             if( nonzero_path.size() > 0 )
             {
                 // TODO: Fat pointers?
                 m_of << "\tif( (*rv)._1"; emit_nonzero_path(nonzero_path); m_of << " ) {\n";
-                emit_destructor_call( ::MIR::LValue::make_Field({ box$(self), 1 }), monomorph(item.m_data.as_Data()[1].type), false, 2 );
+                emit_destructor_call( ::MIR::LValue::new_Field(mv$(self), 1), monomorph(item.m_data.as_Data()[1].type), false, 2 );
                 m_of << "\t}\n";
             }
             else if( const auto* e = item.m_data.opt_Data() )
             {
-                auto var_lv =::MIR::LValue::make_Downcast({ box$(self), 0 });
+                auto var_lv =::MIR::LValue::new_Downcast(mv$(self), 0);
 
                 m_of << "\tswitch(rv->TAG) {\n";
                 for(unsigned int var_idx = 0; var_idx < e->size(); var_idx ++)
                 {
-                    var_lv.as_Downcast().variant_index = var_idx;
+                    var_lv.m_wrappers.back().set_Downcast(var_idx);
                     m_of << "\tcase " << var_idx << ":\n";
                     emit_destructor_call(var_lv, monomorph( (*e)[var_idx].type ), false, 2);
                     m_of << "\tbreak;\n";
@@ -1196,10 +1248,7 @@ namespace {
             m_of << "}\n";
             m_mir_res = nullptr;
 
-            if( nonzero_path.size() )
-            {
-                m_enum_repr_cache.insert( ::std::make_pair( p.clone(), mv$(nonzero_path) ) );
-            }
+            m_resolve.m_type_props.set_enum_repr( ::HIR::TypeRef::new_path(p.clone(), &item), mv$(nonzero_path) );
         }
 
         void emit_constructor_enum(const Span& sp, const ::HIR::GenericPath& path, const ::HIR::Enum& item, size_t var_idx) override
@@ -1228,7 +1277,7 @@ namespace {
             const auto& e = str.m_data.as_Tuple();
 
 
-            m_of << "static struct e_" << Trans_Mangle(p) << " " << Trans_Mangle(path) << "(";
+            m_of << "static struct e_" << mangle(p) << " " << mangle(path) << "(";
             for(unsigned int i = 0; i < e.size(); i ++)
             {
                 if(i != 0)
@@ -1236,14 +1285,13 @@ namespace {
                 emit_ctype( monomorph(e[i].ent), FMT_CB(ss, ss << "_" << i;) );
             }
             m_of << ") {\n";
-            auto it = m_enum_repr_cache.find(p);
-            if( it != m_enum_repr_cache.end() )
+            if( get_enum_nonzero_path(::HIR::TypeRef::new_path(p.clone(), &item)) )
             {
-                m_of << "\tstruct e_" << Trans_Mangle(p) << " rv = { _0 };\n";
+                m_of << "\tstruct e_" << mangle(p) << " rv = { _0 };\n";
             }
             else
             {
-                m_of << "\tstruct e_" << Trans_Mangle(p) << " rv = { .TAG = " << var_idx;
+                m_of << "\tstruct e_" << mangle(p) << " rv = { .TAG = " << var_idx;
 
                 if( e.empty() )
                 {
@@ -1288,7 +1336,7 @@ namespace {
                 };
             // Crate constructor function
             const auto& e = item.m_data.as_Tuple();
-            m_of << "static struct s_" << Trans_Mangle(p) << " " << Trans_Mangle(p) << "(";
+            m_of << "static struct s_" << mangle(p) << " " << mangle(p) << "(";
             for(unsigned int i = 0; i < e.size(); i ++)
             {
                 if(i != 0)
@@ -1296,7 +1344,7 @@ namespace {
                 emit_ctype( monomorph(e[i].ent), FMT_CB(ss, ss << "_" << i;) );
             }
             m_of << ") {\n";
-            m_of << "\tstruct s_" << Trans_Mangle(p) << " rv = {";
+            m_of << "\tstruct s_" << mangle(p) << " rv = {";
             for(unsigned int i = 0; i < e.size(); i ++)
             {
                 if(i != 0)
@@ -1323,24 +1371,25 @@ namespace {
                     // Handled with asm() later
                     break;
                 case Compiler::Msvc:
-                    //m_of << "#pragma comment(linker, \"/alternatename:_" << Trans_Mangle(p) << "=" << item.m_linkage.name << "\")\n";
-                    m_of << "#define " << Trans_Mangle(p) << " " << item.m_linkage.name << "\n";
+                    //m_of << "#pragma comment(linker, \"/alternatename:_" << mangle(p) << "=" << item.m_linkage.name << "\")\n";
+                    m_of << "#define " << mangle(p) << " " << item.m_linkage.name << "\n";
                     break;
                 //case Compiler::Std11:
-                //    m_of << "#define " << Trans_Mangle(p) << " " << item.m_linkage.name << "\n";
+                //    m_of << "#define " << mangle(p) << " " << item.m_linkage.name << "\n";
                 //    break;
                 }
             }
 
             auto type = params.monomorph(m_resolve, item.m_type);
             m_of << "extern ";
-            emit_ctype( type, FMT_CB(ss, ss << Trans_Mangle(p);) );
+            emit_ctype( type, FMT_CB(ss, ss << mangle(p);) );
             if( item.m_linkage.name != "" && m_compiler == Compiler::Gcc)
             {
                 m_of << " asm(\"" << item.m_linkage.name << "\")";
             }
             m_of << ";";
-            m_of << "\t// static " << p << " : " << type;
+            if( m_options.verbose )
+                m_of << "\t// static " << p << " : " << type;
             m_of << "\n";
 
             m_mir_res = nullptr;
@@ -1353,9 +1402,10 @@ namespace {
 
             TRACE_FUNCTION_F(p);
             auto type = params.monomorph(m_resolve, item.m_type);
-            emit_ctype( type, FMT_CB(ss, ss << Trans_Mangle(p);) );
+            emit_ctype( type, FMT_CB(ss, ss << mangle(p);) );
             m_of << ";";
-            m_of << "\t// static " << p << " : " << type;
+            if( m_options.verbose )
+                m_of << "\t// static " << p << " : " << type;
             m_of << "\n";
 
             m_mir_res = nullptr;
@@ -1369,11 +1419,12 @@ namespace {
             TRACE_FUNCTION_F(p);
 
             auto type = params.monomorph(m_resolve, item.m_type);
-            emit_ctype( type, FMT_CB(ss, ss << Trans_Mangle(p);) );
+            emit_ctype( type, FMT_CB(ss, ss << mangle(p);) );
             m_of << " = ";
             emit_literal(type, item.m_value_res, params);
             m_of << ";";
-            m_of << "\t// static " << p << " : " << type;
+            if( m_options.verbose )
+                m_of << "\t// static " << p << " : " << type;
             m_of << "\n";
 
             m_mir_res = nullptr;
@@ -1460,12 +1511,57 @@ namespace {
                 if( ty.m_data.is_Array() )
                     m_of << "}";
                 ),
+            (Repeat,
+                MIR_ASSERT(*m_mir_res, ty.m_data.is_Array(), "Repeat literal for non-array - " << ty);
+                const auto& inner_ty = *ty.m_data.as_Array().inner;
+                // Zero-filled arrays can use C's implicit zero initialisation
+                if( e.val->is_Integer() && e.val->as_Integer() == 0 ) {
+                    m_of << "{{0}}";
+                }
+                else if( e.count == 0 ) {
+                    m_of << "{{ }}";
+                }
+                // GNU range designator, avoids a copy of the value per entry
+                else if( m_compiler == Compiler::Gcc && e.count > 1 ) {
+                    m_of << "{{ [0 ... " << (e.count - 1) << "] = ";
+                    emit_literal(inner_ty, *e.val, params);
+                    m_of << " }}";
+                }
+                else {
+                    m_of << "{{";
+                    for(uint64_t i = 0; i < e.count; i ++) {
+                        if(i != 0)  m_of << ",";
+                        m_of << " ";
+                        emit_literal(inner_ty, *e.val, params);
+                    }
+                    m_of << " }}";
+                }
+                ),
+            (Buffer,
+                MIR_ASSERT(*m_mir_res, ty.m_data.is_Array(), "Buffer literal for non-array - " << ty);
+                const auto& inner_ty = *ty.m_data.as_Array().inner;
+                auto len = lit.list_size();
+                if( this->buffer_as_string(e) ) {
+                    // Byte arrays can be initialised from a string literal (the NUL terminator is dropped if it doesn't fit)
+                    m_of << "{{ ";
+                    this->print_escaped_string(::std::string(e.data.begin(), e.data.end()));
+                    m_of << " }}";
+                }
+                else {
+                    m_of << "{{";
+                    for(size_t i = 0; i < len; i ++) {
+                        if(i != 0)  m_of << ",";
+                        m_of << " ";
+                        emit_literal(inner_ty, lit.list_get(i), params);
+                    }
+                    m_of << " }}";
+                }
+                ),
             (Variant,
                 MIR_ASSERT(*m_mir_res, ty.m_data.is_Path(), "");
                 MIR_ASSERT(*m_mir_res, ty.m_data.as_Path().binding.is_Enum(), "");
                 const auto& enm = *ty.m_data.as_Path().binding.as_Enum();
-                auto it = m_enum_repr_cache.find(ty.m_data.as_Path().path.m_data.as_Generic());
-                if( it != m_enum_repr_cache.end() )
+                if( get_enum_nonzero_path(ty) )
                 {
                     if( e.idx == 0 ) {
                         m_of << "{0}";
@@ -1571,7 +1667,7 @@ namespace {
                             const auto& stat = vi.as_Static();
                             MIR_ASSERT(*m_mir_res, stat.m_type.m_data.is_Array(), "BorrowOf : &[T] of non-array static, " << pe.m_path << " - " << stat.m_type);
                             unsigned int size = stat.m_type.m_data.as_Array().size_val;
-                            m_of << "{ &" << Trans_Mangle( params.monomorph(m_resolve, e)) << ", " << size << "}";
+                            m_of << "{ &" << mangle( params.monomorph(m_resolve, e)) << ", " << size << "}";
                             return ;
                         }
                         else if( TU_TEST1(ty.m_data, Borrow, .inner->m_data.is_TraitObject()) || TU_TEST1(ty.m_data, Pointer, .inner->m_data.is_TraitObject()) )
@@ -1581,7 +1677,7 @@ namespace {
                             MIR_ASSERT(*m_mir_res, vi.is_Static(), "BorrowOf returning &TraitObject not of a static - " << pe.m_path << " is " << vi.tag_str());
                             const auto& stat = vi.as_Static();
                             auto vtable_path = ::HIR::Path(stat.m_type.clone(), trait_path.clone(), "#vtable");
-                            m_of << "{ &" << Trans_Mangle( params.monomorph(m_resolve, e)) << ", &" << Trans_Mangle(vtable_path) << "}";
+                            m_of << "{ &" << mangle( params.monomorph(m_resolve, e)) << ", &" << mangle(vtable_path) << "}";
                             return ;
                         }
                         else
@@ -1600,7 +1696,7 @@ namespace {
                     m_of << "&";
                     )
                 )
-                m_of << Trans_Mangle( params.monomorph(m_resolve, e));
+                m_of << mangle( params.monomorph(m_resolve, e));
                 ),
             (BorrowData,
                 MIR_TODO(*m_mir_res, "Handle BorrowData (emit_literal) - " << *e);
@@ -1613,6 +1709,17 @@ namespace {
             )
         }
 
+        /// Returns true if a Buffer literal can be emitted as a C string literal (byte-sized entries, within MSVC's literal size limit)
+        bool buffer_as_string(const ::HIR::Literal::Data_Buffer& e) const
+        {
+            if( e.ty != ::HIR::CoreType::U8 && e.ty != ::HIR::CoreType::I8 )
+                return false;
+            if( e.data.empty() )
+                return false;
+            if( m_compiler == Compiler::Msvc && e.data.size() > 4000 )
+                return false;
+            return true;
+        }
         //void print_escaped_string(const ::std::string& s)
         template<typename T>
         void print_escaped_string(const T& s)
@@ -1700,7 +1807,7 @@ namespace {
 
                     m_of << "static ";
                     emit_ctype(*te->m_rettype);
-                    m_of << " " << Trans_Mangle(fcn_p) << "("; emit_ctype(type, FMT_CB(ss, ss << "*ptr";)); m_of << ", "; emit_ctype(arg_ty, FMT_CB(ss, ss << "args";)); m_of << ") {\n";
+                    m_of << " " << mangle(fcn_p) << "("; emit_ctype(type, FMT_CB(ss, ss << "*ptr";)); m_of << ", "; emit_ctype(arg_ty, FMT_CB(ss, ss << "args";)); m_of << ") {\n";
                     m_of << "\treturn (*ptr)(";
                         for(unsigned int i = 0; i < te->m_arg_types.size(); i++)
                         {
@@ -1736,7 +1843,7 @@ namespace {
                 }
 
                 emit_ctype(vtable_ty);
-                m_of << " " << Trans_Mangle(p) << " = {\n";
+                m_of << " " << mangle(p) << " = {\n";
             }
 
             auto monomorph_cb_trait = monomorphise_type_get_cb(sp, &type, &trait_path.m_params, nullptr);
@@ -1751,7 +1858,7 @@ namespace {
             }
             else
             {
-                m_of << "(void*)" << Trans_Mangle(::HIR::Path(type.clone(), "#drop_glue")) << ",";
+                m_of << "(void*)" << mangle(::HIR::Path(type.clone(), "#drop_glue")) << ",";
             }
             m_of << "}";    // No newline, added below
 
@@ -1768,7 +1875,7 @@ namespace {
 
                     auto gpath = monomorphise_genericpath_with(sp, m.second.second, monomorph_cb_trait, false);
                     // NOTE: `void*` cast avoids mismatched pointer type errors due to the receiver being &mut()/&() in the vtable
-                    m_of << "\t(void*)" << Trans_Mangle( ::HIR::Path(type.clone(), mv$(gpath), m.first) );
+                    m_of << "\t(void*)" << mangle( ::HIR::Path(type.clone(), mv$(gpath), m.first) );
                 }
             }
             m_of << "\n";
@@ -1784,7 +1891,8 @@ namespace {
             m_mir_res = &top_mir_res;
             TRACE_FUNCTION_F(p);
 
-            m_of << "// EXTERN extern \"" << item.m_abi << "\" " << p << "\n";
+            if( m_options.verbose )
+                m_of << "// EXTERN extern \"" << item.m_abi << "\" " << p << "\n";
             m_of << "extern ";
             emit_function_header(p, item, params);
             if( item.m_linkage.name != "" )
@@ -1822,6 +1930,13 @@ namespace {
 
             m_mir_res = nullptr;
         }
+        void emit_local_copy_linkage()
+        {
+            if( m_options.weak_local_copies )
+                m_of << "__attribute__((weak)) ";
+            else
+                m_of << "static ";
+        }
         void emit_function_proto(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params, bool is_extern_def) override
         {
             ::MIR::Function empty_fcn;
@@ -1829,14 +1944,15 @@ namespace {
             m_mir_res = &top_mir_res;
 
             TRACE_FUNCTION_F(p);
-            m_of << "// PROTO extern \"" << item.m_abi << "\" " << p << "\n";
+            if( m_options.verbose )
+                m_of << "// PROTO extern \"" << item.m_abi << "\" " << p << "\n";
             if( item.m_linkage.name != "" )
             {
-                m_of << "#define " << Trans_Mangle(p) << " " << item.m_linkage.name << "\n";
+                m_of << "#define " << mangle(p) << " " << item.m_linkage.name << "\n";
             }
             if( is_extern_def )
             {
-                m_of << "static ";
+                emit_local_copy_linkage();
             }
             emit_function_header(p, item, params);
             m_of << ";\n";
@@ -1857,25 +1973,77 @@ namespace {
             ::MIR::TypeResolve  mir_res { sp, m_resolve, FMT_CB(ss, ss << p;), ret_type, arg_types, *code };
             m_mir_res = &mir_res;
 
-            m_of << "// " << p << "\n";
+            if( m_options.verbose )
+                m_of << "// " << p << "\n";
             if( is_extern_def ) {
-                m_of << "static ";
+                emit_local_copy_linkage();
             }
             emit_function_header(p, item, params);
             m_of << "\n";
             m_of << "{\n";
             // Variables
+            // - Locals that are never referenced, and drop flags that are never read, aren't emitted (unless in verbose mode)
+            ::std::vector<bool> used_locals( code->locals.size(), m_options.verbose );
+            m_used_drop_flags.clear();
+            m_used_drop_flags.resize( code->drop_flags.size(), m_options.verbose );
+            if( !m_options.verbose )
+            {
+                auto mark_lvalue = [&](const ::MIR::LValue& lv, ::MIR::visit::ValUsage ) {
+                    if( lv.m_root.is_Local() )
+                        used_locals[lv.m_root.as_Local()] = true;
+                    for(const auto& w : lv.m_wrappers)
+                        if( w.is_Index() )
+                            used_locals[w.as_Index()] = true;
+                    return true;
+                    };
+                for(const auto& blk : code->blocks)
+                {
+                    for(const auto& stmt : blk.statements)
+                    {
+                        ::MIR::visit::visit_mir_lvalues(stmt, mark_lvalue);
+                        if( const auto* se = stmt.opt_SetDropFlag() ) {
+                            if( se->other != ~0u )
+                                m_used_drop_flags[se->other] = true;
+                        }
+                        else if( const auto* se = stmt.opt_Drop() ) {
+                            if( se->flag_idx != ~0u )
+                                m_used_drop_flags[se->flag_idx] = true;
+                        }
+                    }
+                    ::MIR::visit::visit_mir_lvalues(blk.terminator, mark_lvalue);
+                }
+            }
             m_of << "\t"; emit_ctype(ret_type, FMT_CB(ss, ss << "rv";)); m_of << ";\n";
             for(unsigned int i = 0; i < code->locals.size(); i ++) {
                 DEBUG("var" << i << " : " << code->locals[i]);
+                if( !used_locals[i] )
+                    continue ;
                 m_of << "\t"; emit_ctype(code->locals[i], FMT_CB(ss, ss << "var" << i;)); m_of << ";";
-                m_of << "\t// " << code->locals[i];
+                if( m_options.verbose )
+                    m_of << "\t// " << code->locals[i];
                 m_of << "\n";
             }
             for(unsigned int i = 0; i < code->drop_flags.size(); i ++) {
+                if( !m_used_drop_flags[i] )
+                    continue ;
                 m_of << "\tbool df" << i << " = " << code->drop_flags[i] << ";\n";
             }
 
+            if( m_options.structured_code )
+            {
+                auto root = MIR_To_Structured(*code);
+                // First pass finds the blocks that need labels (targets of `goto`), second emits the code
+                ::std::vector<bool> labels( code->blocks.size() );
+                StructuredCtx   ctx { SIZE_MAX, SIZE_MAX, SIZE_MAX };
+                emit_fcn_node(mir_res, root, 1, ctx, labels, false);
+                emit_fcn_node(mir_res, root, 1, ctx, labels, true);
+                m_of << "}\n";
+                m_of.flush();
+                m_mir_res = nullptr;
+                return ;
+            }
+
+            // Goto output: Labels are only emitted for blocks that are jumped to from somewhere other than the previous block
             ::std::vector<unsigned> bb_use_counts( code->blocks.size() );
             for(const auto& blk : code->blocks)
             {
@@ -1911,20 +2079,6 @@ namespace {
                 )
             }
 
-            const bool EMIT_STRUCTURED = false; // Saves time.
-            const bool USE_STRUCTURED = false;  // Still not correct.
-            if( EMIT_STRUCTURED )
-            {
-                m_of << "#if " << USE_STRUCTURED << "\n";
-                auto nodes = MIR_To_Structured(*code);
-                for(const auto& node : nodes)
-                {
-                    emit_fcn_node(mir_res, node, 1);
-                }
-
-                m_of << "#else\n";
-            }
-
             for(unsigned int i = 0; i < code->blocks.size(); i ++)
             {
                 TRACE_FUNCTION_F(p << " bb" << i);
@@ -1932,7 +2086,7 @@ namespace {
                 // HACK: Ignore any blocks that only contain `diverge;`
                 if( code->blocks[i].statements.size() == 0 && code->blocks[i].terminator.is_Diverge() ) {
                     DEBUG("- Diverge only, omitting");
-                    m_of << "bb" << i << ": _Unwind_Resume(); // Diverge\n";
+                    m_of << "bb" << i << ": _Unwind_Resume();" << (m_options.verbose ? " // Diverge" : "") << "\n";
                     continue ;
                 }
 
@@ -2023,132 +2177,175 @@ namespace {
                     }
                     )
                 )
-                m_of << "\t// ^ " << code->blocks[i].terminator << "\n";
+                if( m_options.verbose )
+                    m_of << "\t// ^ " << code->blocks[i].terminator << "\n";
             }
 
-            if( EMIT_STRUCTURED )
-            {
-                m_of << "#endif\n";
-            }
             m_of << "}\n";
             m_of.flush();
             m_mir_res = nullptr;
         }
 
-        void emit_fcn_node(::MIR::TypeResolve& mir_res, const Node& node, unsigned indent_level)
+        /// State for emitting a node of a structured function body
+        struct StructuredCtx {
+            /// Block that runs when control reaches the end of the node (SIZE_MAX if it mustn't)
+            size_t  follow;
+            /// Blocks reached by `continue` and `break` (SIZE_MAX if there isn't a suitable loop/switch)
+            size_t  continue_bb;
+            size_t  break_bb;
+        };
+        /// Emit a node from `MIR_To_Structured` (with `emit` false, this just marks the blocks that are `goto` targets)
+        void emit_fcn_node(::MIR::TypeResolve& mir_res, const NodeRef& nr, unsigned indent_level, const StructuredCtx& ctx, ::std::vector<bool>& labels, bool emit)
         {
             auto indent = RepeatLitStr { "\t", static_cast<int>(indent_level) };
-            TU_MATCHA( (node), (e),
+            if( !nr.node )
+            {
+                if( emit )
+                    emit_fcn_block(mir_res, nr.bb_idx, indent_level, labels[nr.bb_idx]);
+                return ;
+            }
+            TU_MATCHA( (*nr.node), (e),
             (Block,
                 for(size_t i = 0; i < e.nodes.size(); i ++)
                 {
-                    const auto& snr = e.nodes[i];
-                    if( snr.node ) {
-                        emit_fcn_node(mir_res, *snr.node, indent_level);
-                    }
-                    else {
-                        DEBUG(mir_res << "BB" << snr.bb_idx);
-                        m_of << indent << "bb" << snr.bb_idx << ":\n";
-                        const auto& bb = mir_res.m_fcn.blocks.at(snr.bb_idx);
-                        for(const auto& stmt : bb.statements)
-                        {
-                            mir_res.set_cur_stmt(snr.bb_idx, (&stmt - &bb.statements.front()));
-                            this->emit_statement(mir_res, stmt, indent_level);
-                        }
-
-                        TU_MATCHA( (bb.terminator), (te),
-                        (Incomplete, ),
-                        (Return,
-                            assert(i == e.nodes.size()-1 && "Return");
-                            m_of << indent << "return rv;\n";
-                            ),
-                        (Goto,
-                            // Ignore (handled by caller)
-                            ),
-                        (Diverge,
-                            m_of << indent << "_Unwind_Resume();\n";
-                            ),
-                        (Panic,
-                            ),
-                        (If,
-                            //assert(i == e.nodes.size()-1 && "If");
-                            ),
-                        (Call,
-                            emit_term_call(mir_res, te, indent_level);
-                            ),
-                        (Switch,
-                            //assert(i == e.nodes.size()-1 && "Switch");
-                            ),
-                        (SwitchValue,
-                            //assert(i == e.nodes.size()-1 && "Switch");
-                            )
-                        )
-                    }
+                    auto sub_ctx = ctx;
+                    if( i + 1 < e.nodes.size() )
+                        sub_ctx.follow = e.nodes[i+1].entry();
+                    emit_fcn_node(mir_res, e.nodes[i], indent_level, sub_ctx, labels, emit);
                 }
                 ),
-            (If,
-                m_of << indent << "if("; emit_lvalue(*e.val); m_of << ") {\n";
-                if( e.arm_true.node ) {
-                    emit_fcn_node(mir_res, *e.arm_true.node, indent_level+1);
+            (Jump,
+                if( e.target == ctx.follow ) {
+                    // Flows on to the target
                 }
-                else {
-                    m_of << indent << "\tgoto bb" << e.arm_true.bb_idx << ";\n";
+                else if( e.target == ctx.continue_bb ) {
+                    if( emit )  m_of << indent << "continue;\n";
                 }
-                m_of << indent << "}\n";
-                m_of << indent << "else {\n";
-                if( e.arm_false.node ) {
-                    emit_fcn_node(mir_res, *e.arm_false.node, indent_level+1);
+                else if( e.target == ctx.break_bb ) {
+                    if( emit )  m_of << indent << "break;\n";
                 }
                 else {
-                    m_of << indent << "\tgoto bb" << e.arm_false.bb_idx << ";\n";
+                    labels[e.target] = true;
+                    if( emit )  m_of << indent << "goto bb" << e.target << ";\n";
+                }
+                ),
+            (If,
+                if( emit ) {
+                    m_of << indent << "if("; emit_lvalue(*e.val); m_of << ") {\n";
+                }
+                emit_fcn_node(mir_res, e.arm_true, indent_level+1, ctx, labels, emit);
+                if( emit ) {
+                    m_of << indent << "}\n";
+                    m_of << indent << "else {\n";
+                }
+                emit_fcn_node(mir_res, e.arm_false, indent_level+1, ctx, labels, emit);
+                if( emit ) {
+                    m_of << indent << "}\n";
                 }
-                m_of << indent << "}\n";
                 ),
             (Switch,
-                this->emit_term_switch(mir_res, *e.val, e.arms.size(), indent_level, [&](auto idx) {
-                    const auto& arm = e.arms.at(idx);
-                    if( arm.node ) {
+                // NonZero optimised enums are emitted as if/else (so `break` doesn't apply, and arms can fall through)
+                ::HIR::TypeRef  tmp;
+                bool is_c_switch = !get_enum_nonzero_path( mir_res.get_lvalue_type(tmp, *e.val) );
+                auto arm_ctx = ctx;
+                if( is_c_switch ) {
+                    arm_ctx.follow = SIZE_MAX;
+                    arm_ctx.break_bb = ctx.follow;
+                }
+                if( emit ) {
+                    this->emit_term_switch(mir_res, *e.val, e.arms.size(), indent_level, [&](size_t idx) {
                         m_of << "{\n";
-                        this->emit_fcn_node(mir_res, *arm.node, indent_level+1);
-                        m_of << indent  << "\t} ";
-                        if( arm.has_target() && arm.target() != e.next_bb ) {
-                            m_of << "goto bb" << arm.target() << ";";
-                        }
-                        else {
-                            m_of << "break;";
-                        }
-                    }
-                    else {
-                        m_of << "goto bb" << arm.bb_idx << ";";
-                    }
-                    });
+                        this->emit_fcn_node(mir_res, e.arms.at(idx), indent_level+1, arm_ctx, labels, true);
+                        m_of << indent << "\t}";
+                        });
+                }
+                else {
+                    for(const auto& arm : e.arms)
+                        emit_fcn_node(mir_res, arm, indent_level+1, arm_ctx, labels, false);
+                }
                 ),
             (SwitchValue,
-                this->emit_term_switchvalue(mir_res, *e.val, *e.vals, indent_level, [&](auto idx) {
-                    const auto& arm = (idx == SIZE_MAX ? e.def_arm : e.arms.at(idx));
-                    if( arm.node ) {
+                auto arm_ctx = ctx;
+                arm_ctx.follow = SIZE_MAX;
+                arm_ctx.break_bb = ctx.follow;
+                if( emit ) {
+                    this->emit_term_switchvalue(mir_res, *e.val, *e.vals, indent_level, [&](size_t idx) {
                         m_of << "{\n";
-                        this->emit_fcn_node(mir_res, *arm.node, indent_level+1);
-                        m_of << indent  << "\t} ";
-                        if( arm.has_target() && arm.target() != e.next_bb ) {
-                            m_of << "goto bb" << arm.target() << ";";
-                        }
-                    }
-                    else {
-                        m_of << "goto bb" << arm.bb_idx << ";";
-                    }
-                    });
+                        this->emit_fcn_node(mir_res, (idx == SIZE_MAX ? e.def_arm : e.arms.at(idx)), indent_level+1, arm_ctx, labels, true);
+                        m_of << indent << "\t}";
+                        });
+                }
+                else {
+                    for(const auto& arm : e.arms)
+                        emit_fcn_node(mir_res, arm, indent_level+1, arm_ctx, labels, false);
+                    emit_fcn_node(mir_res, e.def_arm, indent_level+1, arm_ctx, labels, false);
+                }
                 ),
             (Loop,
-                m_of << indent << "for(;;) {\n";
-                assert(e.code.node);
-                assert(e.code.node->is_Block());
-                this->emit_fcn_node(mir_res, *e.code.node, indent_level+1);
-                m_of << indent << "}\n";
+                // Reaching the end of the body restarts the loop
+                StructuredCtx   body_ctx { e.header_bb, e.header_bb, ctx.follow };
+                if( emit )  m_of << indent << "for(;;) {\n";
+                emit_fcn_node(mir_res, e.code, indent_level+1, body_ctx, labels, emit);
+                if( emit )  m_of << indent << "}\n";
+                )
+            )
+        }
+        /// Emit the statements of a block (and its terminator, if it doesn't branch)
+        void emit_fcn_block(::MIR::TypeResolve& mir_res, size_t bb_idx, unsigned indent_level, bool needs_label)
+        {
+            auto indent = RepeatLitStr { "\t", static_cast<int>(indent_level) };
+            const auto& bb = mir_res.m_fcn.blocks.at(bb_idx);
+            if( needs_label )
+            {
+                m_of << "bb" << bb_idx << ": ;\n";
+            }
+            for(const auto& stmt : bb.statements)
+            {
+                mir_res.set_cur_stmt(bb_idx, (&stmt - &bb.statements.front()));
+                this->emit_statement(mir_res, stmt, indent_level);
+            }
+
+            mir_res.set_cur_stmt_term(bb_idx);
+            DEBUG("- " << bb.terminator);
+            TU_MATCH_DEF( ::MIR::Terminator, (bb.terminator), (te),
+            (
+                // Branching terminators are handled by the structured nodes
+                ),
+            (Incomplete,
+                m_of << indent << "for(;;);\n";
+                ),
+            (Return,
+                m_of << indent << "return rv;\n";
+                ),
+            (Diverge,
+                m_of << indent << "_Unwind_Resume();\n";
+                ),
+            (Call,
+                emit_term_call(mir_res, te, indent_level);
                 )
             )
         }
 
+        template<typename T>
+        static const ::std::string& get_mangled(::std::map<T, ::std::string>& cache, const T& v)
+        {
+            auto it = cache.find(v);
+            if( it == cache.end() )
+            {
+                it = cache.insert(::std::make_pair( v.clone(), FMT(Trans_Mangle(v)) )).first;
+            }
+            return it->second;
+        }
+        const ::std::string& mangle(const ::HIR::GenericPath& p) {
+            return get_mangled(m_mangled_gpaths, p);
+        }
+        const ::std::string& mangle(const ::HIR::Path& p) {
+            return get_mangled(m_mangled_paths, p);
+        }
+        const ::std::string& mangle(const ::HIR::TypeRef& ty) {
+            return get_mangled(m_mangled_types, ty);
+        }
+
         bool type_is_emulated_i128(const ::HIR::TypeRef& ty) const
         {
             return m_options.emulated_i128 && (ty == ::HIR::CoreType::I128 || ty == ::HIR::CoreType::U128);
@@ -2161,10 +2358,14 @@ namespace {
             {
             case ::MIR::Statement::TAGDEAD: throw "";
             case ::MIR::Statement::TAG_ScopeEnd:
-                m_of << indent << "// " << stmt << "\n";
+                if( m_options.verbose )
+                    m_of << indent << "// " << stmt << "\n";
                 break;
             case ::MIR::Statement::TAG_SetDropFlag: {
                 const auto& e = stmt.as_SetDropFlag();
+                // Flags that are never read aren't declared
+                if( !m_used_drop_flags.at(e.idx) )
+                    break;
                 m_of << indent << "df" << e.idx << " = ";
                 if( e.other == ~0u )
                     m_of << e.new_val;
@@ -2189,7 +2390,7 @@ namespace {
                         // Emit a call to box_free for the type
                         ::HIR::GenericPath  box_free { m_crate.get_lang_item_path(sp, "box_free"), { ity->clone() } };
                         // TODO: This is specific to the official liballoc's owned_box
-                        m_of << indent << Trans_Mangle(box_free) << "("; emit_lvalue(e.slot); m_of << "._0._0._0);\n";
+                        m_of << indent << mangle(box_free) << "("; emit_lvalue(e.slot); m_of << "._0._0._0);\n";
                     }
                     else
                     {
@@ -2260,30 +2461,30 @@ namespace {
                     const auto& ty = mir_res.get_lvalue_type(tmp, ve.val);
                     bool special = false;
                     // If the inner value has type [T] or str, create DST based on inner pointer and existing metadata
-                    TU_IFLET(::MIR::LValue, ve.val, Deref, le,
+                    if( ve.val.is_Deref() ) {
                         if( metadata_type(ty) != MetadataType::None ) {
                             emit_lvalue(e.dst);
                             m_of << " = ";
-                            emit_lvalue(*le.val);
+                            emit_lvalue(ve.val.inner_ref());
                             special = true;
                         }
-                    )
+                    }
                     // Magic for taking a &-ptr to unsized field of a struct.
                     // - Needs to get metadata from bottom-level pointer.
-                    else TU_IFLET(::MIR::LValue, ve.val, Field, le,
+                    else if( ve.val.is_Field() ) {
                         if( metadata_type(ty) != MetadataType::None ) {
-                            const ::MIR::LValue* base_val = &*le.val;
-                            while(base_val->is_Field())
-                                base_val = &*base_val->as_Field().val;
-                            MIR_ASSERT(mir_res, base_val->is_Deref(), "DST access must be via a deref");
-                            const ::MIR::LValue& base_ptr = *base_val->as_Deref().val;
+                            auto base_val = ve.val.inner_ref();
+                            while(base_val.is_Field())
+                                base_val = base_val.inner_ref();
+                            MIR_ASSERT(mir_res, base_val.is_Deref(), "DST access must be via a deref");
+                            const auto base_ptr = base_val.inner_ref();
 
                             // Construct the new DST
                             emit_lvalue(e.dst); m_of << ".META = "; emit_lvalue(base_ptr); m_of << ".META;\n" << indent;
                             emit_lvalue(e.dst); m_of << ".PTR = &"; emit_lvalue(ve.val);
                             special = true;
                         }
-                    )
+                    }
                     if( !special )
                     {
                         emit_lvalue(e.dst);
@@ -2528,8 +2729,7 @@ namespace {
                         ::HIR::TypeRef  tmp;
                         const auto& ty = mir_res.get_lvalue_type(tmp, e.dst);
 
-                        auto it = m_enum_repr_cache.find(ty.m_data.as_Path().path.m_data.as_Generic());
-                        if( it != m_enum_repr_cache.end() )
+                        if( get_enum_nonzero_path(ty) )
                         {
                             if( ve.index == 0 ) {
                                 // TODO: Use nonzero_path
@@ -2589,7 +2789,8 @@ namespace {
                     )
                 )
                 m_of << ";";
-                m_of << "\t// " << e.dst << " = " << e.src;
+                if( m_options.verbose )
+                    m_of << "\t// " << e.dst << " = " << e.src;
                 m_of << "\n";
                 break; }
             }
@@ -2761,12 +2962,11 @@ namespace {
             MIR_ASSERT(mir_res, ty.m_data.as_Path().binding.is_Enum(), "Switch over non-enum");
             const auto* enm = ty.m_data.as_Path().binding.as_Enum();
 
-            auto it = m_enum_repr_cache.find( ty.m_data.as_Path().path.m_data.as_Generic() );
-            if( it != m_enum_repr_cache.end() )
+            if( const auto* nonzero_path = get_enum_nonzero_path(ty) )
             {
                 //MIR_ASSERT(mir_res, e.targets.size() == 2, "NonZero optimised representation for an enum without two variants");
                 MIR_ASSERT(mir_res, n_arms == 2, "NonZero optimised switch without two arms");
-                m_of << indent << "if("; emit_lvalue(val); m_of << "._1"; emit_nonzero_path(it->second); m_of << ")\n";
+                m_of << indent << "if("; emit_lvalue(val); m_of << "._1"; emit_nonzero_path(*nonzero_path); m_of << ")\n";
                 m_of << indent;
                 cb(1);
                 m_of << "\n";
@@ -2932,7 +3132,7 @@ namespace {
                         emit_lvalue(e.ret_val); m_of << " = ";
                     }
                 }
-                m_of << Trans_Mangle(e2);
+                m_of << mangle(e2);
                 ),
             (Intrinsic,
                 const auto& name = e.fcn.as_Intrinsic().name;
@@ -3128,7 +3328,7 @@ namespace {
                 {
                     ss << " __stdcall";
                 }
-                ss << " " << Trans_Mangle(p) << "(";
+                ss << " " << mangle(p) << "(";
                 if( item.m_args.size() == 0 )
                 {
                     ss << "void)";
@@ -3395,7 +3595,7 @@ namespace {
             else if( name == "type_id" ) {
                 const auto& ty = params.m_types.at(0);
                 // NOTE: Would define the typeid here, but it has to be public
-                emit_lvalue(e.ret_val); m_of << " = (uintptr_t)&__typeid_" << Trans_Mangle(ty);
+                emit_lvalue(e.ret_val); m_of << " = (uintptr_t)&__typeid_" << mangle(ty);
             }
             else if( name == "type_name" ) {
                 auto s = FMT(params.m_types.at(0));
@@ -3467,7 +3667,7 @@ namespace {
                 // Nothing needs to be done, this just stops the destructor from running.
             }
             else if( name == "drop_in_place" ) {
-                emit_destructor_call( ::MIR::LValue::make_Deref({ box$(e.args.at(0).as_LValue().clone()) }), params.m_types.at(0), true, 1 /* TODO: get from caller */ );
+                emit_destructor_call( ::MIR::LValue::new_Deref(e.args.at(0).as_LValue().clone()), params.m_types.at(0), true, 1 /* TODO: get from caller */ );
             }
             else if( name == "needs_drop" ) {
                 // Returns `true` if the actual type given as `T` requires drop glue;
@@ -3539,10 +3739,9 @@ namespace {
                 const auto& ty = params.m_types.at(0);
                 emit_lvalue(e.ret_val); m_of << " = ";
                 if( ty.m_data.is_Path() && ty.m_data.as_Path().binding.is_Enum() ) {
-                    auto it = m_enum_repr_cache.find( ty.m_data.as_Path().path.m_data.as_Generic() );
-                    if( it != m_enum_repr_cache.end() )
+                    if( const auto* nonzero_path = get_enum_nonzero_path(ty) )
                     {
-                        emit_param(e.args.at(0)); m_of << "->_1"; emit_nonzero_path(it->second); m_of << " != 0";
+                        emit_param(e.args.at(0)); m_of << "->_1"; emit_nonzero_path(*nonzero_path); m_of << " != 0";
                     }
                     else
                     {
@@ -3957,7 +4156,7 @@ namespace {
                 if( te.type == ::HIR::BorrowType::Owned )
                 {
                     // Call drop glue on inner.
-                    emit_destructor_call( ::MIR::LValue::make_Deref({ box$(slot.clone()) }), *te.inner, true, indent_level );
+                    emit_destructor_call( ::MIR::LValue::new_Deref(slot.clone()), *te.inner, true, indent_level );
                 }
                 ),
             (Path,
@@ -3968,16 +4167,16 @@ namespace {
                 switch( metadata_type(ty) )
                 {
                 case MetadataType::None:
-                    m_of << indent << Trans_Mangle(p) << "(&"; emit_lvalue(slot); m_of << ");\n";
+                    m_of << indent << mangle(p) << "(&"; emit_lvalue(slot); m_of << ");\n";
                     break;
                 case MetadataType::Slice:
                     make_fcn = "make_sliceptr"; if(0)
                 case MetadataType::TraitObject:
                     make_fcn = "make_traitobjptr";
-                    m_of << indent << Trans_Mangle(p) << "( " << make_fcn << "(";
+                    m_of << indent << mangle(p) << "( " << make_fcn << "(";
                     if( slot.is_Deref() )
                     {
-                        emit_lvalue(*slot.as_Deref().val);
+                        emit_lvalue(slot.inner_ref());
                         m_of << ".PTR";
                     }
                     else
@@ -3985,10 +4184,10 @@ namespace {
                         m_of << "&"; emit_lvalue(slot);
                     }
                     m_of << ", ";
-                    const auto* lvp = &slot;
-                    while(const auto* le = lvp->opt_Field())  lvp = &*le->val;
-                    MIR_ASSERT(*m_mir_res, lvp->is_Deref(), "Access to unized type without a deref - " << *lvp << " (part of " << slot << ")");
-                    emit_lvalue(*lvp->as_Deref().val); m_of << ".META";
+                    auto lvr = ::MIR::LValue::CRef(slot);
+                    while(lvr.is_Field())   lvr = lvr.inner_ref();
+                    MIR_ASSERT(*m_mir_res, lvr.is_Deref(), "Access to unized type without a deref - " << lvr << " (part of " << slot << ")");
+                    emit_lvalue(lvr.inner_ref()); m_of << ".META";
                     m_of << ") );\n";
                     break;
                 }
@@ -3998,7 +4197,7 @@ namespace {
                 if( te.size_val > 0 )
                 {
                     m_of << indent << "for(unsigned i = 0; i < " << te.size_val << "; i++) {\n";
-                    emit_destructor_call(::MIR::LValue::make_Index({ box$(slot.clone()), box$(::MIR::LValue::make_Local(~0u)) }), *te.inner, false, indent_level+1);
+                    emit_destructor_call(::MIR::LValue::new_Index(slot.clone(), ~0u), *te.inner, false, indent_level+1);
                     m_of << "\n" << indent << "}";
                 }
                 ),
@@ -4006,10 +4205,10 @@ namespace {
                 // Emit destructors for all entries
                 if( te.size() > 0 )
                 {
-                    ::MIR::LValue   lv = ::MIR::LValue::make_Field({ box$(slot.clone()), 0 });
+                    ::MIR::LValue   lv = ::MIR::LValue::new_Field(slot.clone(), 0);
                     for(unsigned int i = 0; i < te.size(); i ++)
                     {
-                        lv.as_Field().field_index = i;
+                        lv.m_wrappers.back().set_Field(i);
                         emit_destructor_call(lv, te[i], unsized_valid && (i == te.size()-1), indent_level);
                     }
                 }
@@ -4017,13 +4216,13 @@ namespace {
             (TraitObject,
                 MIR_ASSERT(*m_mir_res, unsized_valid, "Dropping TraitObject without a pointer");
                 // Call destructor in vtable
-                const auto* lvp = &slot;
-                while(const auto* le = lvp->opt_Field())  lvp = &*le->val;
-                MIR_ASSERT(*m_mir_res, lvp->is_Deref(), "Access to unized type without a deref - " << *lvp << " (part of " << slot << ")");
-                m_of << indent << "((VTABLE_HDR*)"; emit_lvalue(*lvp->as_Deref().val); m_of << ".META)->drop(";
-                if( const auto* ve = slot.opt_Deref() )
+                auto lvr = ::MIR::LValue::CRef(slot);
+                while(lvr.is_Field())   lvr = lvr.inner_ref();
+                MIR_ASSERT(*m_mir_res, lvr.is_Deref(), "Access to unized type without a deref - " << lvr << " (part of " << slot << ")");
+                m_of << indent << "((VTABLE_HDR*)"; emit_lvalue(lvr.inner_ref()); m_of << ".META)->drop(";
+                if( slot.is_Deref() )
                 {
-                    emit_lvalue(*ve->val); m_of << ".PTR";
+                    emit_lvalue(slot.inner_ref()); m_of << ".PTR";
                 }
                 else
                 {
@@ -4033,12 +4232,12 @@ namespace {
                 ),
             (Slice,
                 MIR_ASSERT(*m_mir_res, unsized_valid, "Dropping Slice without a pointer");
-                const auto* lvp = &slot;
-                while(const auto* le = lvp->opt_Field())  lvp = &*le->val;
-                MIR_ASSERT(*m_mir_res, lvp->is_Deref(), "Access to unized type without a deref - " << *lvp << " (part of " << slot << ")");
+                auto lvr = ::MIR::LValue::CRef(slot);
+                while(lvr.is_Field())   lvr = lvr.inner_ref();
+                MIR_ASSERT(*m_mir_res, lvr.is_Deref(), "Access to unized type without a deref - " << lvr << " (part of " << slot << ")");
                 // Call destructor on all entries
-                m_of << indent << "for(unsigned i = 0; i < "; emit_lvalue(*lvp->as_Deref().val); m_of << ".META; i++) {\n";
-                emit_destructor_call(::MIR::LValue::make_Index({ box$(slot.clone()), box$(::MIR::LValue::make_Local(~0u)) }), *te.inner, false, indent_level+1);
+                m_of << indent << "for(unsigned i = 0; i < "; emit_lvalue(lvr.inner_ref()); m_of << ".META; i++) {\n";
+                emit_destructor_call(::MIR::LValue::new_Index(slot.clone(), ~0u), *te.inner, false, indent_level+1);
                 m_of << "\n" << indent << "}";
                 )
             )
@@ -4134,15 +4333,40 @@ namespace {
                     }
                 }
                 ),
+            (Repeat,
+                MIR_ASSERT(*m_mir_res, ty.m_data.is_Array(), "Repeat literal for non-array - " << ty);
+                // Emit a loop instead of unrolling (large zero-filled arrays are common)
+                auto idx_name = FMT("rep" << m_literal_loop_depth);
+                m_of << "for(size_t " << idx_name << " = 0; " << idx_name << " < " << e.count << "; " << idx_name << " ++) {\n\t";
+                m_literal_loop_depth ++;
+                assign_from_literal([&](){ emit_dst(); m_of << ".DATA[" << idx_name << "]"; }, *ty.m_data.as_Array().inner, *e.val);
+                m_literal_loop_depth --;
+                m_of << ";\n\t}";
+                ),
+            (Buffer,
+                MIR_ASSERT(*m_mir_res, ty.m_data.is_Array(), "Buffer literal for non-array - " << ty);
+                auto len = lit.list_size();
+                if( this->buffer_as_string(e) ) {
+                    m_of << "memcpy("; emit_dst(); m_of << ".DATA, ";
+                    this->print_escaped_string(::std::string(e.data.begin(), e.data.end()));
+                    m_of << ", " << len << ")";
+                }
+                else {
+                    for(size_t i = 0; i < len; i ++) {
+                        if(i != 0)  m_of << ";\n\t";
+                        emit_dst(); m_of << ".DATA[" << i << "] = ";
+                        emit_literal(*ty.m_data.as_Array().inner, lit.list_get(i), {});
+                    }
+                }
+                ),
             (Variant,
                 MIR_ASSERT(*m_mir_res, ty.m_data.is_Path(), "");
                 MIR_ASSERT(*m_mir_res, ty.m_data.as_Path().binding.is_Enum(), "");
                 const auto& enm = *ty.m_data.as_Path().binding.as_Enum();
-                auto it = m_enum_repr_cache.find(ty.m_data.as_Path().path.m_data.as_Generic());
-                if( it != m_enum_repr_cache.end() )
+                if( const auto* nonzero_path = get_enum_nonzero_path(ty) )
                 {
                     if( e.idx == 0 ) {
-                        emit_nonzero_path(it->second);
+                        emit_nonzero_path(*nonzero_path);
                         m_of << " = 0";
                     }
                     else {
@@ -4172,7 +4396,7 @@ namespace {
             (BorrowPath,
                 if( ty.m_data.is_Function() )
                 {
-                    emit_dst(); m_of << " = " << Trans_Mangle(e);
+                    emit_dst(); m_of << " = " << mangle(e);
                 }
                 else if( ty.m_data.is_Borrow() )
                 {
@@ -4180,12 +4404,12 @@ namespace {
                     switch( metadata_type(ity) )
                     {
                     case MetadataType::None:
-                        emit_dst(); m_of << " = &" << Trans_Mangle(e);
+                        emit_dst(); m_of << " = &" << mangle(e);
                         break;
                     case MetadataType::Slice:
-                        emit_dst(); m_of << ".PTR = &" << Trans_Mangle(e) << ";\n\t";
+                        emit_dst(); m_of << ".PTR = &" << mangle(e) << ";\n\t";
                         // HACK: Since getting the size is hard, use two sizeofs
-                        emit_dst(); m_of << ".META = sizeof(" << Trans_Mangle(e) << ") / ";
+                        emit_dst(); m_of << ".META = sizeof(" << mangle(e) << ") / ";
                         if( ity.m_data.is_Slice() ) {
                             m_of << "sizeof("; emit_ctype(*ity.m_data.as_Slice().inner); m_of << ")";
                         }
@@ -4194,14 +4418,14 @@ namespace {
                         }
                         break;
                     case MetadataType::TraitObject:
-                        emit_dst(); m_of << ".PTR = &" << Trans_Mangle(e) << ";\n\t";
+                        emit_dst(); m_of << ".PTR = &" << mangle(e) << ";\n\t";
                         emit_dst(); m_of << ".META = /* TODO: Const VTable */";
                         break;
                     }
                 }
                 else
                 {
-                    emit_dst(); m_of << " = &" << Trans_Mangle(e);
+                    emit_dst(); m_of << " = &" << mangle(e);
                 }
                 ),
             (BorrowData,
@@ -4216,61 +4440,67 @@ namespace {
             )
         }
 
-        void emit_lvalue(const ::MIR::LValue& val) {
-            TU_MATCHA( (val), (e),
-            (Return,
-                m_of << "rv";
-                ),
-            (Argument,
-                m_of << "arg" << e.idx;
-                ),
-            (Local,
-                if( e == ~0u )
-                    m_of << "i";
-                else
+        void emit_lvalue(const ::MIR::LValue::CRef& val) {
+            if( !val.outer_wrapper() )
+            {
+                TU_MATCHA( (val.root()), (e),
+                (Return,
+                    m_of << "rv";
+                    ),
+                (Argument,
+                    m_of << "arg" << e.idx;
+                    ),
+                (Local,
                     m_of << "var" << e;
-                ),
-            (Static,
-                m_of << Trans_Mangle(e);
-                ),
-            (Field,
+                    ),
+                (Static,
+                    m_of << mangle(*e);
+                    )
+                )
+                return ;
+            }
+            const auto inner = val.inner_ref();
+            switch(val.outer_wrapper()->tag())
+            {
+            case ::MIR::LValue::Wrapper::TAG_Field: {
+                const auto field_index = val.outer_wrapper()->as_Field();
                 ::HIR::TypeRef  tmp;
-                const auto& ty = m_mir_res->get_lvalue_type(tmp, *e.val);
+                const auto& ty = m_mir_res->get_lvalue_type(tmp, inner);
                 if( ty.m_data.is_Slice() ) {
-                    if( e.val->is_Deref() )
+                    if( inner.is_Deref() )
                     {
                         m_of << "(("; emit_ctype(*ty.m_data.as_Slice().inner); m_of << "*)";
-                        emit_lvalue(*e.val->as_Deref().val);
+                        emit_lvalue(inner.inner_ref());
                         m_of << ".PTR)";
                     }
                     else
                     {
-                        emit_lvalue(*e.val);
+                        emit_lvalue(inner);
                     }
-                    m_of << "[" << e.field_index << "]";
+                    m_of << "[" << field_index << "]";
                 }
                 else if( ty.m_data.is_Array() ) {
-                    emit_lvalue(*e.val);
-                    m_of << ".DATA[" << e.field_index << "]";
+                    emit_lvalue(inner);
+                    m_of << ".DATA[" << field_index << "]";
                 }
-                else if( e.val->is_Deref() ) {
+                else if( inner.is_Deref() ) {
                     auto dst_type = metadata_type(ty);
                     if( dst_type != MetadataType::None )
                     {
-                        m_of << "(("; emit_ctype(ty); m_of << "*)"; emit_lvalue(*e.val->as_Deref().val); m_of << ".PTR)->_" << e.field_index;
+                        m_of << "(("; emit_ctype(ty); m_of << "*)"; emit_lvalue(inner.inner_ref()); m_of << ".PTR)->_" << field_index;
                     }
                     else
                     {
-                        emit_lvalue(*e.val->as_Deref().val);
-                        m_of << "->_" << e.field_index;
+                        emit_lvalue(inner.inner_ref());
+                        m_of << "->_" << field_index;
                     }
                 }
                 else {
-                    emit_lvalue(*e.val);
-                    m_of << "._" << e.field_index;
+                    emit_lvalue(inner);
+                    m_of << "._" << field_index;
                 }
-                ),
-            (Deref,
+                } break;
+            case ::MIR::LValue::Wrapper::TAG_Deref: {
                 // TODO: If the type is unsized, then this pointer is a fat pointer, so we need to cast the data pointer.
                 ::HIR::TypeRef  tmp;
                 const auto& ty = m_mir_res->get_lvalue_type(tmp, val);
@@ -4278,53 +4508,57 @@ namespace {
                 if( dst_type != MetadataType::None )
                 {
                     m_of << "(*("; emit_ctype(ty); m_of << "*)";
-                    emit_lvalue(*e.val);
+                    emit_lvalue(inner);
                     m_of << ".PTR)";
                 }
                 else
                 {
                     m_of << "(*";
-                    emit_lvalue(*e.val);
+                    emit_lvalue(inner);
                     m_of << ")";
                 }
-                ),
-            (Index,
+                } break;
+            case ::MIR::LValue::Wrapper::TAG_Index: {
                 ::HIR::TypeRef  tmp;
-                const auto& ty = m_mir_res->get_lvalue_type(tmp, *e.val);
+                const auto& ty = m_mir_res->get_lvalue_type(tmp, inner);
                 m_of << "(";
                 if( ty.m_data.is_Slice() ) {
-                    if( e.val->is_Deref() )
+                    if( inner.is_Deref() )
                     {
                         m_of << "("; emit_ctype(*ty.m_data.as_Slice().inner); m_of << "*)";
-                        emit_lvalue(*e.val->as_Deref().val);
+                        emit_lvalue(inner.inner_ref());
                         m_of << ".PTR";
                     }
                     else {
-                        emit_lvalue(*e.val);
+                        emit_lvalue(inner);
                     }
                 }
                 else if( ty.m_data.is_Array() ) {
-                    emit_lvalue(*e.val);
+                    emit_lvalue(inner);
                     m_of << ".DATA";
                 }
                 else {
-                    emit_lvalue(*e.val);
+                    emit_lvalue(inner);
                 }
                 m_of << ")[";
-                emit_lvalue(*e.idx);
+                // NOTE: `~0u` is the loop counter in drop glue
+                if( val.as_Index() == ~0u )
+                    m_of << "i";
+                else
+                    m_of << "var" << val.as_Index();
                 m_of << "]";
-                ),
-            (Downcast,
+                } break;
+            case ::MIR::LValue::Wrapper::TAG_Downcast: {
+                const auto variant_index = val.outer_wrapper()->as_Downcast();
                 ::HIR::TypeRef  tmp;
-                const auto& ty = m_mir_res->get_lvalue_type(tmp, *e.val);
-                emit_lvalue(*e.val);
+                const auto& ty = m_mir_res->get_lvalue_type(tmp, inner);
+                emit_lvalue(inner);
                 MIR_ASSERT(*m_mir_res, ty.m_data.is_Path(), "Downcast on non-Path type - " << ty);
                 if( ty.m_data.as_Path().binding.is_Enum() )
                 {
-                    auto it = m_enum_repr_cache.find(ty.m_data.as_Path().path.m_data.as_Generic());
-                    if( it != m_enum_repr_cache.end() )
+                    if( get_enum_nonzero_path(ty) )
                     {
-                        MIR_ASSERT(*m_mir_res, e.variant_index == 1, "");
+                        MIR_ASSERT(*m_mir_res, variant_index == 1, "");
                         // NOTE: Downcast returns a magic tuple
                         m_of << "._1";
                         break ;
@@ -4334,9 +4568,9 @@ namespace {
                         m_of << ".DATA";
                     }
                 }
-                m_of << ".var_" << e.variant_index;
-                )
-            )
+                m_of << ".var_" << variant_index;
+                } break;
+            }
         }
         void emit_constant(const ::MIR::Constant& ve, const ::MIR::LValue* dst_ptr=nullptr)
         {
@@ -4472,7 +4706,7 @@ namespace {
                     m_of << "&";
                     )
                 )
-                m_of << Trans_Mangle(c);
+                m_of << mangle(c);
                 )
             )
         }
@@ -4530,13 +4764,13 @@ namespace {
                 //}
                 TU_MATCHA( (te.binding), (tpb),
                 (Struct,
-                    m_of << "struct s_" << Trans_Mangle(te.path);
+                    m_of << "struct s_" << mangle(te.path);
                     ),
                 (Union,
-                    m_of << "union u_" << Trans_Mangle(te.path);
+                    m_of << "union u_" << mangle(te.path);
                     ),
                 (Enum,
-                    m_of << "struct e_" << Trans_Mangle(te.path);
+                    m_of << "struct e_" << mangle(te.path);
                     ),
                 (Unbound,
                     MIR_BUG(*m_mir_res, "Unbound type path in trans - " << ty);
@@ -4557,7 +4791,7 @@ namespace {
                 MIR_BUG(*m_mir_res, "ErasedType in trans - " << ty);
                 ),
             (Array,
-                m_of << "t_" << Trans_Mangle(ty) << " " << inner;
+                m_of << "t_" << mangle(ty) << " " << inner;
                 //emit_ctype(*te.inner, inner);
                 //m_of << "[" << te.size_val << "]";
                 ),
@@ -4570,7 +4804,7 @@ namespace {
                 else {
                     m_of << "TUP_" << te.size();
                     for(const auto& t : te)
-                        m_of << "_" << Trans_Mangle(t);
+                        m_of << "_" << mangle(t);
                 }
                 m_of << " " << inner;
                 ),
@@ -4581,7 +4815,7 @@ namespace {
                 emit_ctype_ptr(*te.inner, inner);
                 ),
             (Function,
-                m_of << "t_" << Trans_Mangle(ty) << " " << inner;
+                m_of << "t_" << mangle(ty) << " " << inner;
                 ),
             (Closure,
                 MIR_BUG(*m_mir_res, "Closure during trans - " << ty);
@@ -4730,7 +4964,7 @@ namespace {
     Span CodeGenerator_C::sp;
 }
 
-::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile)
+::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt)
 {
-    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile));
+    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile, opt));
 }
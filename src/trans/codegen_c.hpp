@@ -1,4 +1,9 @@
 /*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/codegen_c.hpp
+ * - Structured form of MIR function bodies (used by the C backend)
  */
 #pragma once
 #include <vector>
@@ -6,6 +11,7 @@
 
 class Node;
 
+/// Either a basic block (its statements, and any non-branching terminator action such as a call or return) or a nested node
 struct NodeRef
 {
     ::std::unique_ptr<Node>    node;
@@ -14,41 +20,42 @@ struct NodeRef
     NodeRef(size_t idx): bb_idx(idx) {}
     NodeRef(Node node);
 
-    bool has_target() const;
-    size_t target() const;
-
-    bool operator==(size_t idx) const {
-        return !node && bb_idx == idx;
-    }
+    /// Basic block that is executed first when entering this node (SIZE_MAX if it doesn't start with a block)
+    size_t entry() const;
 };
 
 TAGGED_UNION(Node, Block,
+/// Sequence of nodes, the end of each (if reachable) flows on to the next
 (Block, struct {
-    size_t  next_bb;
     ::std::vector<NodeRef>  nodes;
     }),
+/// Transfer control to the start of a basic block that isn't emitted inline
+/// - Emitted as nothing (if it's the next block anyway), `continue`, `break`, or `goto`
+(Jump, struct {
+    size_t  target;
+    }),
 (If, struct {
-    size_t  next_bb;
     const ::MIR::LValue* val;
-    NodeRef arm_false;
     NodeRef arm_true;
+    NodeRef arm_false;
     }),
 (Switch, struct {
-    size_t  next_bb;
     const ::MIR::LValue* val;
     ::std::vector<NodeRef>  arms;
     }),
 (SwitchValue, struct {
-    size_t  next_bb;
     const ::MIR::LValue* val;
     NodeRef def_arm;
     ::std::vector<NodeRef>  arms;
     const ::MIR::SwitchValues*  vals;
     }),
+/// Infinite loop, entered at (and continuing to) `header_bb` - exited with jumps
 (Loop, struct {
-    size_t  next_bb;
+    size_t  header_bb;
     NodeRef code;
     })
 );
 
-extern ::std::vector<Node> MIR_To_Structured(const ::MIR::Function& fcn);
+/// Convert a function's MIR into a tree of nested nodes
+/// - Each reachable block appears exactly once, all other control flow is a `Jump`
+extern NodeRef MIR_To_Structured(const ::MIR::Function& fcn);
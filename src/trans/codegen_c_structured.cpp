@@ -3,7 +3,15 @@
  * - By John Hodge (Mutabah/thePowersGang)
  *
  * trans/codegen_c_structured.cpp
- * - Converts MIR into a semi-structured form
+ * - Converts MIR into a structured form (nested blocks, conditionals and loops)
+ *
+ * Based on the dominator tree of the CFG (see "Beyond Relooper", N. Ramsey 2022):
+ * - A block with a single forward edge into it is emitted inline at the source of that edge
+ * - A block with multiple forward edges into it (a "merge" block) is emitted after the code of its immediate dominator,
+ *   and reached with jumps.
+ * - The target of a back edge that dominates the source is a loop header, and the code it dominates is wrapped in a loop
+ * Any edge that isn't emitted inline becomes a `Jump`, which the emitter turns into a fall-through, `continue`, `break`
+ * or (as a last resort) `goto`. As such, the output is correct for any CFG, even irreducible ones.
  */
 #include <common.hpp>
 #include <mir/mir.hpp>
@@ -15,336 +23,302 @@ NodeRef::NodeRef(Node node_data):
     bb_idx(SIZE_MAX)
 {
 }
-bool NodeRef::has_target() const
+size_t NodeRef::entry() const
 {
     if( node ) {
         TU_MATCHA( (*this->node), (e),
         (Block,
-            return e.next_bb != SIZE_MAX;
+            return e.nodes.empty() ? SIZE_MAX : e.nodes.front().entry();
+            ),
+        (Jump,
+            return SIZE_MAX;
             ),
         (If,
-            return e.next_bb != SIZE_MAX;
+            return SIZE_MAX;
             ),
         (Switch,
-            return e.next_bb != SIZE_MAX;
+            return SIZE_MAX;
             ),
         (SwitchValue,
-            return e.next_bb != SIZE_MAX;
+            return SIZE_MAX;
             ),
         (Loop,
-            return e.next_bb != SIZE_MAX;
+            return e.header_bb;
             )
         )
         throw "";
     }
     else {
-        return true;
+        return bb_idx;
     }
 }
-size_t NodeRef::target() const
-{
-    if( node ) {
-        TU_MATCHA( (*this->node), (e),
-        (Block,
-            return e.next_bb;
+
+namespace {
+    /// Successors of a block (NOTE: the panic arm of calls is ignored, as the C backend doesn't emit it)
+    ::std::vector<size_t> get_successors(const ::MIR::Terminator& term)
+    {
+        ::std::vector<size_t>   rv;
+        TU_MATCHA( (term), (te),
+        (Incomplete,
+            ),
+        (Return,
+            ),
+        (Diverge,
+            ),
+        (Goto,
+            rv.push_back(te);
+            ),
+        (Panic,
+            rv.push_back(te.dst);
             ),
         (If,
-            return e.next_bb;
+            rv.push_back(te.bb0);
+            rv.push_back(te.bb1);
             ),
         (Switch,
-            return e.next_bb;
+            rv.insert(rv.end(), te.targets.begin(), te.targets.end());
             ),
         (SwitchValue,
-            return e.next_bb;
+            rv.insert(rv.end(), te.targets.begin(), te.targets.end());
+            rv.push_back(te.def_target);
             ),
-        (Loop,
-            return e.next_bb;
+        (Call,
+            rv.push_back(te.ret_block);
             )
         )
-        throw "";
-    }
-    else {
-        return bb_idx;
+        return rv;
     }
-}
-
-class Converter
-{
-    const ::MIR::Function& m_fcn;
-public:
-    ::std::vector<unsigned> m_block_ref_count;
-    ::std::vector<bool> m_blocks_used;
 
-    Converter(const ::MIR::Function& fcn):
-        m_fcn(fcn)
+    class Converter
     {
+        const ::MIR::Function& m_fcn;
 
-    }
-
-    // Returns true if the passed block is the start of a self-contained sequence of blocks
-    bool bb_is_opening(size_t bb_idx)
-    {
-        if( m_blocks_used[bb_idx] ) {
-            return false;
-        }
-        else if( m_block_ref_count[bb_idx] > 1 ) {
-            // TODO: Determine if these multiple references are from the block looping back on itself
-            return false;
-        }
-        else {
-            return true;
-        }
-    }
-    NodeRef process_node_ref(size_t bb_idx)
-    {
-        if( bb_is_opening(bb_idx) ) {
-            return NodeRef( process_node(bb_idx) );
-        }
-        else {
-            return NodeRef(bb_idx);
-        }
-    }
+        ::std::vector< ::std::vector<size_t> >  m_succs;
+        /// Blocks in reverse postorder (only reachable blocks)
+        ::std::vector<size_t>   m_rpo;
+        /// Index of each block in `m_rpo` (SIZE_MAX if unreachable)
+        ::std::vector<size_t>   m_rpo_idx;
+        /// Immediate dominator of each block
+        ::std::vector<size_t>   m_idom;
+        /// Number of forward (non-retreating) edges into each block
+        ::std::vector<unsigned> m_fwd_in;
+        ::std::vector<bool> m_is_loop_header;
+        /// Merge blocks immediately dominated by each block (in reverse postorder)
+        ::std::vector< ::std::vector<size_t> >  m_merge_children;
 
-    Node process_node(size_t bb_idx)
-    {
-        TRACE_FUNCTION_F(bb_idx);
-        ::std::vector<NodeRef> refs;
-        for(;;)
+    public:
+        Converter(const ::MIR::Function& fcn):
+            m_fcn(fcn)
         {
-            DEBUG("bb_idx = " << bb_idx);
-            bool stop = false;
-            assert( !m_blocks_used[bb_idx] );
-            m_blocks_used[bb_idx] = true;
+            size_t n_blocks = fcn.blocks.size();
+            m_succs.reserve(n_blocks);
+            for(const auto& blk : fcn.blocks)
+                m_succs.push_back( get_successors(blk.terminator) );
 
-            refs.push_back( NodeRef(bb_idx) );
+            calculate_rpo();
+            calculate_dominators();
 
-            const auto& blk = m_fcn.blocks.at(bb_idx);
-            DEBUG("> " << blk.terminator);
-            TU_MATCHA( (blk.terminator), (te),
-            (Incomplete,
-                stop = true;
-                ),
-            (Goto,
-                bb_idx = te;
-                ),
-            (Panic,
-                TODO(Span(), "Panic");
-                ),
-            (Diverge,
-                stop = true;
-                ),
-            (Return,
-                stop = true;
-                ),
-            (If,
-                auto arm0 = process_node_ref(te.bb0);
-                auto arm1 = process_node_ref(te.bb1);
-                if( arm0.has_target() && arm1.has_target() ) {
-                    if( arm0.target() == arm1.target() ) {
-                        bb_idx = arm0.target();
+            m_fwd_in.resize(n_blocks);
+            m_is_loop_header.resize(n_blocks);
+            m_merge_children.resize(n_blocks);
+            for(auto bb : m_rpo)
+            {
+                for(auto tgt : m_succs[bb])
+                {
+                    if( m_rpo_idx[tgt] <= m_rpo_idx[bb] ) {
+                        // Retreating edge, if the target dominates the source then it's a natural loop
+                        if( dominates(tgt, bb) )
+                            m_is_loop_header[tgt] = true;
                     }
                     else {
-                        stop = true;
-                    }
-                }
-                else if( arm0.has_target() ) {
-                    bb_idx = arm0.target();
-                }
-                else if( arm1.has_target() ) {
-                    bb_idx = arm1.target();
-                }
-                else {
-                    // No target from either arm
-                    stop = false;
-                }
-                refs.push_back(Node::make_If({ bb_idx, &te.cond, mv$(arm0), mv$(arm1) }));
-                ),
-            (Switch,
-                ::std::vector<NodeRef>  arms;
-                ::std::vector<size_t>   next_blocks;
-                for(auto& tgt : te.targets)
-                {
-                    arms.push_back( process_node_ref(tgt) );
-                    if( arms.back().has_target() )
-                    {
-                        next_blocks.push_back( arms.back().target() );
+                        m_fwd_in[tgt] += 1;
                     }
                 }
-                // TODO: Make the next block common
-                ::std::sort(next_blocks.begin(), next_blocks.end());
-                size_t  exit_bb = SIZE_MAX;
-                if(!next_blocks.empty())
-                {
-                    size_t  cur = next_blocks[0];
-                    size_t  cur_count = 0;
-                    size_t  max_count = 0;
-                    for(auto b : next_blocks)
-                    {
-                        if(cur == b) {
-                            cur_count ++;
-                        }
-                        else {
-                            if( cur_count > max_count ) {
-                                exit_bb = cur;
-                            }
-                            cur = b;
-                            cur_count = 1;
-                        }
-                    }
-                    if( cur_count > max_count ) {
-                        exit_bb = cur;
-                    }
+            }
+            // NOTE: Iterating in RPO ensures that the children lists are sorted
+            for(auto bb : m_rpo)
+            {
+                if( bb != 0 && m_fwd_in[bb] > 1 )
+                    m_merge_children[m_idom[bb]].push_back(bb);
+            }
+        }
+
+        NodeRef process_tree(size_t bb_idx)
+        {
+            TRACE_FUNCTION_F(bb_idx);
+            ::std::vector<NodeRef>  nodes;
+            // Straight-line chains of inlined blocks are flattened (avoiding deep recursion on long functions)
+            ::std::vector<size_t>   chain;
+            for(;;)
+            {
+                chain.push_back(bb_idx);
+                nodes.push_back( NodeRef(bb_idx) );
+                const auto& term = m_fcn.blocks.at(bb_idx).terminator;
+                size_t next = SIZE_MAX;
+                TU_MATCHA( (term), (te),
+                (Incomplete,
+                    ),
+                (Return,
+                    ),
+                (Diverge,
+                    ),
+                (Goto,
+                    next = te;
+                    ),
+                (Panic,
+                    next = te.dst;
+                    ),
+                (Call,
+                    next = te.ret_block;
+                    ),
+                (If,
+                    nodes.push_back(Node::make_If({ &te.cond, process_branch(bb_idx, te.bb0), process_branch(bb_idx, te.bb1) }));
+                    ),
+                (Switch,
+                    ::std::vector<NodeRef>  arms;
+                    for(auto tgt : te.targets)
+                        arms.push_back( process_branch(bb_idx, tgt) );
+                    nodes.push_back(Node::make_Switch({ &te.val, mv$(arms) }));
+                    ),
+                (SwitchValue,
+                    ::std::vector<NodeRef>  arms;
+                    for(auto tgt : te.targets)
+                        arms.push_back( process_branch(bb_idx, tgt) );
+                    auto def_arm = process_branch(bb_idx, te.def_target);
+                    nodes.push_back(Node::make_SwitchValue({ &te.val, mv$(def_arm), mv$(arms), &te.values }));
+                    )
+                )
+                if( next == SIZE_MAX )
+                    break;
+                if( !is_inline_target(bb_idx, next) || m_is_loop_header[next] ) {
+                    nodes.push_back( process_branch(bb_idx, next) );
+                    break;
                 }
-                refs.push_back(Node::make_Switch({ exit_bb, &te.val, mv$(arms) }));
-                // TODO: Continue with the exit bb?
-                stop = true;
-                ),
-            (SwitchValue,
-                ::std::vector<NodeRef>  arms;
-                ::std::vector<size_t>   next_blocks;
-                for(auto& tgt : te.targets)
+                bb_idx = next;
+            }
+            // Merge children of the chain, innermost first (same order as if the chain had been nested)
+            for(auto it = chain.rbegin(); it != chain.rend(); ++it)
+            {
+                for(auto child : m_merge_children[*it])
+                    nodes.push_back( process_tree(child) );
+            }
+
+            auto rv = Node::make_Block({ mv$(nodes) });
+            if( m_is_loop_header[chain.front()] )
+            {
+                DEBUG("Loop " << chain.front());
+                rv = Node::make_Loop({ chain.front(), NodeRef(mv$(rv)) });
+            }
+            return NodeRef(mv$(rv));
+        }
+
+    private:
+        void calculate_rpo()
+        {
+            size_t n_blocks = m_fcn.blocks.size();
+            ::std::vector<bool> visited(n_blocks);
+            ::std::vector<size_t>   postorder;
+            // Stack of (block, index of next successor to visit)
+            ::std::vector< ::std::pair<size_t, size_t> >  stack;
+            stack.push_back(::std::make_pair(0, 0));
+            visited[0] = true;
+            while( !stack.empty() )
+            {
+                auto& top = stack.back();
+                if( top.second < m_succs[top.first].size() )
                 {
-                    arms.push_back( process_node_ref(tgt) );
-                    if( arms.back().has_target() )
-                    {
-                        next_blocks.push_back( arms.back().target() );
+                    auto tgt = m_succs[top.first][top.second++];
+                    if( !visited[tgt] ) {
+                        visited[tgt] = true;
+                        stack.push_back(::std::make_pair(tgt, 0));
                     }
                 }
-                auto def_arm = process_node_ref(te.def_target);
-                if(def_arm.has_target())
+                else
                 {
-                    next_blocks.push_back(def_arm.target());
+                    postorder.push_back(top.first);
+                    stack.pop_back();
                 }
+            }
+            m_rpo.assign(postorder.rbegin(), postorder.rend());
+            m_rpo_idx.assign(n_blocks, SIZE_MAX);
+            for(size_t i = 0; i < m_rpo.size(); i ++)
+                m_rpo_idx[m_rpo[i]] = i;
+        }
+        // "A Simple, Fast Dominance Algorithm" - Cooper, Harvey, Kennedy
+        void calculate_dominators()
+        {
+            size_t n_blocks = m_fcn.blocks.size();
+            ::std::vector< ::std::vector<size_t> >  preds(n_blocks);
+            for(auto bb : m_rpo)
+                for(auto tgt : m_succs[bb])
+                    preds[tgt].push_back(bb);
 
-                // TODO: Make the next block common
-                ::std::sort(next_blocks.begin(), next_blocks.end());
-                size_t  exit_bb = SIZE_MAX;
-                if(!next_blocks.empty())
+            m_idom.assign(n_blocks, SIZE_MAX);
+            m_idom[0] = 0;
+            bool changed = true;
+            while( changed )
+            {
+                changed = false;
+                for(size_t i = 1; i < m_rpo.size(); i ++)
                 {
-                    size_t  cur = next_blocks[0];
-                    size_t  cur_count = 0;
-                    size_t  max_count = 0;
-                    for(auto b : next_blocks)
+                    auto bb = m_rpo[i];
+                    size_t new_idom = SIZE_MAX;
+                    for(auto p : preds[bb])
                     {
-                        if(cur == b) {
-                            cur_count ++;
-                        }
-                        else {
-                            if( cur_count > max_count ) {
-                                exit_bb = cur;
-                            }
-                            cur = b;
-                            cur_count = 1;
-                        }
+                        if( m_idom[p] == SIZE_MAX )
+                            continue ;
+                        new_idom = (new_idom == SIZE_MAX ? p : intersect(p, new_idom));
                     }
-                    if( cur_count > max_count ) {
-                        exit_bb = cur;
+                    if( m_idom[bb] != new_idom ) {
+                        m_idom[bb] = new_idom;
+                        changed = true;
                     }
                 }
-
-                refs.push_back(Node::make_SwitchValue({ exit_bb, &te.val, mv$(def_arm), mv$(arms), &te.values }));
-                stop = true;
-
-                ),
-            (Call,
-                // NOTE: Let the panic arm just be a goto
-                bb_idx = te.ret_block;
-                )
-            )
-
-            if( stop )
-            {
-                break;
-            }
-
-            // If `bb_idx` is in `refs` as a NodeRef
-            auto it = ::std::find(refs.begin(), refs.end(), bb_idx);
-            if( it != refs.end() )
-            {
-                // Wrap ibb_idxms from `it` to `refs.end()` in a `loop` block
-                ::std::vector<NodeRef> loop_blocks;
-                loop_blocks.reserve(refs.end() - it);
-                for(auto it2 = it; it2 != refs.end(); ++it2)
-                    loop_blocks.push_back( mv$(*it2) );
-                auto loop_node = NodeRef( Node::make_Block({ SIZE_MAX, mv$(loop_blocks) }) );
-
-                refs.push_back( Node::make_Loop({ SIZE_MAX, mv$(loop_node) }) );
-                // TODO: If there is only one `goto` in the above loop, assume it's the target
-                DEBUG("Loop");
-                break;
             }
-            else if( bb_is_opening(bb_idx) )
+        }
+        size_t intersect(size_t a, size_t b) const
+        {
+            while( a != b )
             {
-                DEBUG("Destination " << bb_idx << " is unreferenced+unvisited");
+                while( m_rpo_idx[a] > m_rpo_idx[b] )
+                    a = m_idom[a];
+                while( m_rpo_idx[b] > m_rpo_idx[a] )
+                    b = m_idom[b];
             }
-            else
+            return a;
+        }
+        bool dominates(size_t a, size_t b) const
+        {
+            for(;;)
             {
-                break;
+                if( a == b )
+                    return true;
+                if( b == 0 )
+                    return false;
+                b = m_idom[b];
             }
         }
 
-        return Node::make_Block({ bb_idx, mv$(refs) });
-    }
-};
+        /// Returns true if `dst` is emitted inline at the end of `src` (i.e. this is the only forward edge into it)
+        bool is_inline_target(size_t src, size_t dst) const
+        {
+            return m_rpo_idx[dst] > m_rpo_idx[src] && m_fwd_in[dst] == 1;
+        }
+        NodeRef process_branch(size_t src, size_t dst)
+        {
+            if( is_inline_target(src, dst) ) {
+                return process_tree(dst);
+            }
+            else {
+                return NodeRef(Node::make_Jump({ dst }));
+            }
+        }
+    };
+}
 
-::std::vector<Node> MIR_To_Structured(const ::MIR::Function& fcn)
+NodeRef MIR_To_Structured(const ::MIR::Function& fcn)
 {
+    TRACE_FUNCTION;
     Converter   conv(fcn);
-    conv.m_block_ref_count.resize( fcn.blocks.size() );
-    conv.m_block_ref_count[0] += 1;
-    for(const auto& blk : fcn.blocks)
-    {
-        TU_MATCHA( (blk.terminator), (te),
-        (Incomplete,
-            ),
-        (Goto,
-            conv.m_block_ref_count[te] += 1;
-            ),
-        (Panic,
-            conv.m_block_ref_count[te.dst] += 1;
-            ),
-        (Diverge,
-            ),
-        (Return,
-            ),
-        (If,
-            conv.m_block_ref_count[te.bb0] += 1;
-            conv.m_block_ref_count[te.bb1] += 1;
-            ),
-        (Switch,
-            for(auto tgt : te.targets)
-                conv.m_block_ref_count[tgt] += 1;
-            ),
-        (SwitchValue,
-            for(auto tgt : te.targets)
-                conv.m_block_ref_count[tgt] += 1;
-            conv.m_block_ref_count[te.def_target] += 1;
-            ),
-        (Call,
-            conv.m_block_ref_count[te.ret_block] += 1;
-            conv.m_block_ref_count[te.panic_block] += 1;
-            )
-        )
-    }
-
-    // First Block: Becomes a block in structured output
-    // - Terminator selects what the next block will be
-    // - 
-
-    // Find next unvisited block
-    conv.m_blocks_used.resize( fcn.blocks.size() );
-    ::std::vector<Node> nodes;
-    for(size_t bb_idx = 0; bb_idx < fcn.blocks.size(); bb_idx ++)
-    {
-        if( conv.m_blocks_used[bb_idx] )
-            continue;
-
-        nodes.push_back( conv.process_node(bb_idx) );
-    }
-
-
-    // Return.
-    return nodes;
+    return conv.process_tree(0);
 }
-
-
@@ -0,0 +1,1998 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/codegen_x64.cpp
+ * - Code generation emitting x86-64 machine code (as an ELF relocatable object)
+ *
+ * Intended for fast debug builds. Functions are lowered straight from MIR with no optimisation: every MIR slot lives
+ * in the stack frame, and values only pass through a fixed set of scratch registers (so there is no real register
+ * allocation). Generated functions follow the SysV calling convention, using the layouts of the types emitted by the
+ * C backend, so they can call (and be called from) the C code.
+ *
+ * Anything this backend doesn't handle (floating point arithmetic, 128-bit integers, drop glue, atomics, ...) is
+ * handed to the C backend, which also emits all types/statics/vtables and links the generated object into the output.
+ */
+#include "codegen.hpp"
+#include "mangling.hpp"
+#include "target.hpp"
+#include <hir/hir.hpp>
+#include <mir/mir.hpp>
+#include <mir/helpers.hpp>
+#include <hir_typeck/static.hpp>
+#include <fstream>
+#include <cstring>
+#include <functional>
+#include <map>
+
+namespace {
+    /// Raised when a function uses something that can't be lowered (the function is emitted as C instead)
+    struct Unsupported
+    {
+        ::std::string   reason;
+    };
+    #define UNSUPPORTED(msg)    throw Unsupported { FMT(msg) }
+
+    class ByteBuffer
+    {
+    public:
+        ::std::vector<uint8_t>  data;
+
+        size_t pos() const { return data.size(); }
+        void u8(uint8_t v) { data.push_back(v); }
+        void u16(uint16_t v) { u8(v & 0xFF); u8(v >> 8); }
+        void u32(uint32_t v) { u16(v & 0xFFFF); u16(v >> 16); }
+        void u64(uint64_t v) { u32(v & 0xFFFFFFFF); u32(v >> 32); }
+        void bytes(const ::std::vector<uint8_t>& v) { data.insert(data.end(), v.begin(), v.end()); }
+        void bytes(const ::std::string& v) { data.insert(data.end(), v.begin(), v.end()); }
+        void align(size_t a, uint8_t fill=0) {
+            while( data.size() % a != 0 )
+                data.push_back(fill);
+        }
+        void patch_u32(size_t ofs, uint32_t v) {
+            for(int i = 0; i < 4; i ++)
+                data[ofs+i] = (v >> (8*i)) & 0xFF;
+        }
+    };
+
+    // --------------------------------------------------------------------
+    // ELF64 relocatable object writer
+    // --------------------------------------------------------------------
+    class ElfObject
+    {
+    public:
+        /// Reference from a function's code to something outside it (patches the `rel32` at `ofs`)
+        struct Fixup {
+            enum Kind {
+                /// Direct call to a function
+                Call,
+                /// Load of the address of a symbol (from the GOT)
+                GotAddr,
+                /// Address of constant data (placed in `.rodata`)
+                RoData,
+            };
+            size_t  ofs;
+            Kind    kind;
+            /// Symbol name, or the data for `RoData`
+            ::std::string   target;
+        };
+    private:
+        struct Symbol {
+            ::std::string   name;
+            size_t  ofs;
+            size_t  size;
+        };
+        struct Reloc {
+            size_t  ofs;
+            /// Target symbol (empty for the start of `.rodata`)
+            ::std::string   symbol;
+            uint32_t    type;
+            int64_t addend;
+        };
+        ByteBuffer  m_text;
+        ByteBuffer  m_rodata;
+        /// Offsets of data already in `.rodata` (so identical strings are shared)
+        ::std::map< ::std::string, size_t>  m_rodata_ents;
+        ::std::vector<Symbol>   m_symbols;
+        ::std::vector<Reloc>    m_relocs;
+
+        static const uint32_t SHT_PROGBITS = 1;
+        static const uint32_t SHT_SYMTAB = 2;
+        static const uint32_t SHT_STRTAB = 3;
+        static const uint32_t SHT_RELA = 4;
+        static const uint32_t SHT_X86_64_UNWIND = 0x70000001;
+        static const uint32_t R_X86_64_PC32 = 2;
+        static const uint32_t R_X86_64_PLT32 = 4;
+        static const uint32_t R_X86_64_GOTPCREL = 9;
+    public:
+        void add_function(::std::string name, const ::std::vector<uint8_t>& code, const ::std::vector<Fixup>& fixups)
+        {
+            m_text.align(16, 0xCC);
+            size_t base = m_text.pos();
+            m_text.bytes(code);
+            for(const auto& f : fixups)
+            {
+                switch(f.kind)
+                {
+                case Fixup::Call:
+                    m_relocs.push_back(Reloc { base + f.ofs, f.target, R_X86_64_PLT32, -4 });
+                    break;
+                case Fixup::GotAddr:
+                    m_relocs.push_back(Reloc { base + f.ofs, f.target, R_X86_64_GOTPCREL, -4 });
+                    break;
+                case Fixup::RoData: {
+                    auto it = m_rodata_ents.find(f.target);
+                    if( it == m_rodata_ents.end() )
+                    {
+                        it = m_rodata_ents.insert(::std::make_pair( f.target, m_rodata.pos() )).first;
+                        m_rodata.bytes(f.target);
+                        // NUL terminated, like the C backend's string literals
+                        m_rodata.u8(0);
+                    }
+                    m_relocs.push_back(Reloc { base + f.ofs, "", R_X86_64_PC32, static_cast<int64_t>(it->second) - 4 });
+                    break; }
+                }
+            }
+            m_symbols.push_back(Symbol { mv$(name), base, code.size() });
+        }
+        size_t function_count() const {
+            return m_symbols.size();
+        }
+
+        void write(const ::std::string& path) const
+        {
+            // Section indexes
+            enum { SEC_NULL, SEC_TEXT, SEC_RELA_TEXT, SEC_RODATA, SEC_EH_FRAME, SEC_RELA_EH_FRAME, SEC_SYMTAB, SEC_STRTAB, SEC_NOTE_STACK, SEC_SHSTRTAB, SEC_COUNT };
+
+            ByteBuffer  strtab;
+            strtab.u8(0);
+            auto add_str = [](ByteBuffer& tab, const ::std::string& s)->uint32_t {
+                auto rv = tab.pos();
+                tab.bytes(s);
+                tab.u8(0);
+                return static_cast<uint32_t>(rv);
+                };
+
+            // - Local symbols (null, and the .text/.rodata sections) first, then the globals
+            ByteBuffer  symtab;
+            auto add_sym = [&](uint32_t name, uint8_t info, uint16_t shndx, uint64_t value, uint64_t size) {
+                symtab.u32(name);
+                symtab.u8(info);
+                symtab.u8(0);   // st_other (default visibility)
+                symtab.u16(shndx);
+                symtab.u64(value);
+                symtab.u64(size);
+                };
+            add_sym(0, 0, 0, 0, 0);
+            const uint32_t sym_text = 1;
+            add_sym(0, (0 << 4) | 3 /*STB_LOCAL, STT_SECTION*/, SEC_TEXT, 0, 0);
+            const uint32_t sym_rodata = 2;
+            add_sym(0, (0 << 4) | 3 /*STB_LOCAL, STT_SECTION*/, SEC_RODATA, 0, 0);
+            const uint32_t first_global = 3;
+            ::std::map< ::std::string, uint32_t>    sym_idx;
+            for(const auto& s : m_symbols)
+            {
+                sym_idx.insert(::std::make_pair(s.name, first_global + sym_idx.size()));
+                add_sym(add_str(strtab, s.name), (1 << 4) | 2 /*STB_GLOBAL, STT_FUNC*/, SEC_TEXT, s.ofs, s.size);
+            }
+            for(const auto& r : m_relocs)
+            {
+                if( r.symbol != "" && sym_idx.count(r.symbol) == 0 )
+                {
+                    sym_idx.insert(::std::make_pair(r.symbol, first_global + sym_idx.size()));
+                    add_sym(add_str(strtab, r.symbol), (1 << 4) | 0 /*STB_GLOBAL, STT_NOTYPE*/, 0 /*SHN_UNDEF*/, 0, 0);
+                }
+            }
+
+            ByteBuffer  rela;
+            for(const auto& r : m_relocs)
+            {
+                uint64_t    sym = (r.symbol == "" ? sym_rodata : sym_idx.at(r.symbol));
+                rela.u64(r.ofs);
+                rela.u64( (sym << 32) | r.type );
+                rela.u64( static_cast<uint64_t>(r.addend) );
+            }
+
+            // Unwind information (so panics can unwind through the generated functions)
+            // - One CIE, and one FDE per function. Every function starts with `push rbp; mov rbp, rsp`, and the frame
+            //   doesn't change again until the `leave` just before a `ret`, so all FDEs are the same apart from the range.
+            // - There's no personality routine, so an unwind passes straight through (the panic edges of calls are ignored,
+            //   like the C backend does).
+            ByteBuffer  eh_frame;
+            ByteBuffer  rela_eh_frame;
+            {
+                // CIE
+                eh_frame.u32(0);    // length (patched below)
+                eh_frame.u32(0);    // CIE id
+                eh_frame.u8(1);     // version
+                eh_frame.bytes(::std::string("zR"));
+                eh_frame.u8(0);
+                eh_frame.u8(1);     // code alignment factor
+                eh_frame.u8(0x78);  // data alignment factor (-8, SLEB128)
+                eh_frame.u8(16);    // return address register (RIP)
+                eh_frame.u8(1);     // augmentation data length
+                eh_frame.u8(0x1B);  // FDE pointer encoding (DW_EH_PE_pcrel|DW_EH_PE_sdata4)
+                eh_frame.u8(0x0C); eh_frame.u8(7); eh_frame.u8(8);  // DW_CFA_def_cfa rsp+8
+                eh_frame.u8(0x80 | 16); eh_frame.u8(1);  // DW_CFA_offset rip, cfa-8
+                eh_frame.align(8, 0);   // DW_CFA_nop
+                eh_frame.patch_u32(0, static_cast<uint32_t>(eh_frame.pos() - 4));
+            }
+            for(const auto& s : m_symbols)
+            {
+                size_t  fde_ofs = eh_frame.pos();
+                eh_frame.u32(0);    // length (patched below)
+                eh_frame.u32(static_cast<uint32_t>(eh_frame.pos()));    // offset back to the CIE
+                // pc_begin (PC-relative, to the function's offset in .text)
+                rela_eh_frame.u64(eh_frame.pos());
+                rela_eh_frame.u64( (uint64_t(sym_text) << 32) | R_X86_64_PC32 );
+                rela_eh_frame.u64(s.ofs);
+                eh_frame.u32(0);
+                eh_frame.u32(static_cast<uint32_t>(s.size));    // pc_range
+                eh_frame.u8(0);     // augmentation data length
+                eh_frame.u8(0x40 | 1);  // DW_CFA_advance_loc 1 (after `push rbp`)
+                eh_frame.u8(0x0E); eh_frame.u8(16); // DW_CFA_def_cfa_offset 16
+                eh_frame.u8(0x80 | 6); eh_frame.u8(2);  // DW_CFA_offset rbp, cfa-16
+                eh_frame.u8(0x40 | 3);  // DW_CFA_advance_loc 3 (after `mov rbp, rsp`)
+                eh_frame.u8(0x0D); eh_frame.u8(6);  // DW_CFA_def_cfa_register rbp
+                eh_frame.align(8, 0);   // DW_CFA_nop
+                eh_frame.patch_u32(fde_ofs, static_cast<uint32_t>(eh_frame.pos() - fde_ofs - 4));
+            }
+            // Terminator
+            eh_frame.u32(0);
+
+            ByteBuffer  shstrtab;
+            shstrtab.u8(0);
+            uint32_t name_text = add_str(shstrtab, ".text");
+            uint32_t name_rela = add_str(shstrtab, ".rela.text");
+            uint32_t name_rodata = add_str(shstrtab, ".rodata");
+            uint32_t name_eh_frame = add_str(shstrtab, ".eh_frame");
+            uint32_t name_rela_eh_frame = add_str(shstrtab, ".rela.eh_frame");
+            uint32_t name_symtab = add_str(shstrtab, ".symtab");
+            uint32_t name_strtab = add_str(shstrtab, ".strtab");
+            uint32_t name_note = add_str(shstrtab, ".note.GNU-stack");
+            uint32_t name_shstrtab = add_str(shstrtab, ".shstrtab");
+
+            // File layout: header, section contents, section headers
+            ByteBuffer  out;
+            out.data.resize(64);
+            struct Sh { uint32_t name, type; uint64_t flags; size_t ofs, size; uint32_t link, info; uint64_t align, entsize; };
+            ::std::vector<Sh>   shdrs(SEC_COUNT, Sh { 0,0,0, 0,0, 0,0, 0,0 });
+            auto add_section = [&](unsigned idx, uint32_t name, uint32_t type, uint64_t flags, const ByteBuffer& body, uint64_t align, uint64_t entsize, uint32_t link, uint32_t info) {
+                out.align(align);
+                shdrs[idx] = Sh { name, type, flags, out.pos(), body.pos(), link, info, align, entsize };
+                out.bytes(body.data);
+                };
+            add_section(SEC_TEXT, name_text, SHT_PROGBITS, 0x2|0x4 /*ALLOC|EXECINSTR*/, m_text, 16, 0, 0, 0);
+            add_section(SEC_RELA_TEXT, name_rela, SHT_RELA, 0x40 /*INFO_LINK*/, rela, 8, 24, SEC_SYMTAB, SEC_TEXT);
+            add_section(SEC_RODATA, name_rodata, SHT_PROGBITS, 0x2 /*ALLOC*/, m_rodata, 8, 0, 0, 0);
+            add_section(SEC_EH_FRAME, name_eh_frame, SHT_X86_64_UNWIND, 0x2 /*ALLOC*/, eh_frame, 8, 0, 0, 0);
+            add_section(SEC_RELA_EH_FRAME, name_rela_eh_frame, SHT_RELA, 0x40 /*INFO_LINK*/, rela_eh_frame, 8, 24, SEC_SYMTAB, SEC_EH_FRAME);
+            add_section(SEC_SYMTAB, name_symtab, SHT_SYMTAB, 0, symtab, 8, 24, SEC_STRTAB, first_global);
+            add_section(SEC_STRTAB, name_strtab, SHT_STRTAB, 0, strtab, 1, 0, 0, 0);
+            add_section(SEC_NOTE_STACK, name_note, SHT_PROGBITS, 0, ByteBuffer(), 1, 0, 0, 0);
+            add_section(SEC_SHSTRTAB, name_shstrtab, SHT_STRTAB, 0, shstrtab, 1, 0, 0, 0);
+
+            out.align(8);
+            size_t shoff = out.pos();
+            for(const auto& sh : shdrs)
+            {
+                out.u32(sh.name);
+                out.u32(sh.type);
+                out.u64(sh.flags);
+                out.u64(0); // sh_addr
+                out.u64(sh.ofs);
+                out.u64(sh.size);
+                out.u32(sh.link);
+                out.u32(sh.info);
+                out.u64(sh.align);
+                out.u64(sh.entsize);
+            }
+
+            // ELF header
+            ByteBuffer  hdr;
+            hdr.u8(0x7F); hdr.u8('E'); hdr.u8('L'); hdr.u8('F');
+            hdr.u8(2);  // ELFCLASS64
+            hdr.u8(1);  // ELFDATA2LSB
+            hdr.u8(1);  // EV_CURRENT
+            hdr.u8(0);  // ELFOSABI_SYSV
+            hdr.align(16);
+            hdr.u16(1); // ET_REL
+            hdr.u16(62);    // EM_X86_64
+            hdr.u32(1); // EV_CURRENT
+            hdr.u64(0); // e_entry
+            hdr.u64(0); // e_phoff
+            hdr.u64(shoff);
+            hdr.u32(0); // e_flags
+            hdr.u16(64);    // e_ehsize
+            hdr.u16(0); // e_phentsize
+            hdr.u16(0); // e_phnum
+            hdr.u16(64);    // e_shentsize
+            hdr.u16(SEC_COUNT);
+            hdr.u16(SEC_SHSTRTAB);
+            assert(hdr.pos() == 64);
+            ::std::copy(hdr.data.begin(), hdr.data.end(), out.data.begin());
+
+            ::std::ofstream of(path, ::std::ios::binary);
+            if( !of.good() )
+            {
+                ERROR(Span(), E0000, "Unable to open " << path << " for writing");
+            }
+            of.write(reinterpret_cast<const char*>(out.data.data()), out.data.size());
+        }
+    };
+
+    // --------------------------------------------------------------------
+    // Instruction encoding
+    // --------------------------------------------------------------------
+    enum Reg {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11,
+    };
+    /// Integer argument registers (SysV)
+    static const Reg ARG_REGS[] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+    /// Memory operand - `[base + ofs]`
+    struct Mem {
+        Reg base;
+        int32_t ofs;
+    };
+
+    /// Condition codes (low nibble of `Jcc`/`SETcc`)
+    enum Cond {
+        CC_O = 0x0,
+        CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+        CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF,
+    };
+
+    class Assembler:
+        public ByteBuffer
+    {
+        void rex(bool w, unsigned reg, unsigned base, bool force=false) {
+            uint8_t v = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0);
+            if( v != 0x40 || force )
+                u8(v);
+        }
+        void modrm_mem(unsigned reg, const Mem& m) {
+            // NOTE: RSP/R12 as a base would need a SIB byte, they're never used as such
+            assert( (m.base & 7) != RSP );
+            u8(0x80 | ((reg & 7) << 3) | (m.base & 7));
+            u32(static_cast<uint32_t>(m.ofs));
+        }
+        void modrm_reg(unsigned reg, unsigned rm) {
+            u8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+        }
+        /// RIP-relative operand, returns the offset of the `rel32`
+        size_t modrm_rip(unsigned reg) {
+            u8(((reg & 7) << 3) | 5);
+            u32(0);
+            return pos() - 4;
+        }
+    public:
+        /// Load a `size` byte value, extending it to 64 bits
+        void load(Reg dst, const Mem& m, size_t size, bool is_signed) {
+            switch(size)
+            {
+            case 1: rex(is_signed, dst, m.base); u8(0x0F); u8(is_signed ? 0xBE : 0xB6); break;  // movsx/movzx
+            case 2: rex(is_signed, dst, m.base); u8(0x0F); u8(is_signed ? 0xBF : 0xB7); break;  // movsx/movzx
+            case 4: rex(is_signed, dst, m.base); u8(is_signed ? 0x63 : 0x8B);   break;  // movsxd/mov r32
+            case 8: rex(true, dst, m.base); u8(0x8B);   break;
+            default:
+                BUG(Span(), "Bad load size " << size);
+            }
+            modrm_mem(dst, m);
+        }
+        /// Store the low `size` bytes of a register
+        void store(const Mem& m, Reg src, size_t size) {
+            switch(size)
+            {
+            case 1: rex(false, src, m.base, src >= RSP && src < R8); u8(0x88);  break;
+            case 2: u8(0x66); rex(false, src, m.base); u8(0x89);    break;
+            case 4: rex(false, src, m.base); u8(0x89);  break;
+            case 8: rex(true, src, m.base); u8(0x89);   break;
+            default:
+                BUG(Span(), "Bad store size " << size);
+            }
+            modrm_mem(src, m);
+        }
+        void lea(Reg dst, const Mem& m) { rex(true, dst, m.base); u8(0x8D); modrm_mem(dst, m); }
+        /// `lea dst, [rip + rel32]` (returns the offset of the `rel32`)
+        size_t lea_rip(Reg dst) { rex(true, dst, 0); u8(0x8D); return modrm_rip(dst); }
+        /// `mov dst, [rip + rel32]` (returns the offset of the `rel32`)
+        size_t load_rip(Reg dst) { rex(true, dst, 0); u8(0x8B); return modrm_rip(dst); }
+        void mov_imm(Reg dst, uint64_t v) { rex(true, 0, dst); u8(0xB8 + (dst & 7)); u64(v); }
+        void mov(Reg dst, Reg src) { rex(true, src, dst); u8(0x89); modrm_reg(src, dst); }
+
+        /// Two-register ALU operation (`op dst, src`)
+        void alu(uint8_t opcode, Reg dst, Reg src) { rex(true, src, dst); u8(opcode); modrm_reg(src, dst); }
+        // Arithmetic on RAX (and RCX)
+        void add() { alu(0x01, RAX, RCX); }
+        void sub() { alu(0x29, RAX, RCX); }
+        void and_() { alu(0x21, RAX, RCX); }
+        void or_() { alu(0x09, RAX, RCX); }
+        void xor_() { alu(0x31, RAX, RCX); }
+        void cmp() { alu(0x39, RAX, RCX); }
+        void imul() { u8(0x48); u8(0x0F); u8(0xAF); modrm_reg(RAX, RCX); }
+        /// `imul r, r, imm32`
+        void imul_imm(Reg r, int32_t v) { rex(true, r, r); u8(0x69); modrm_reg(r, r); u32(static_cast<uint32_t>(v)); }
+        /// Group 3 (`F7 /n`) on RCX or RAX
+        void grp3(unsigned n, Reg r) { u8(0x48); u8(0xF7); modrm_reg(n, r); }
+        /// Unsigned `RDX:RAX = RAX * RCX`
+        void mul() { grp3(4, RCX); }
+        void div(bool is_signed) {
+            if( is_signed ) {
+                u8(0x48); u8(0x99); // cqo
+                grp3(7, RCX);   // idiv rcx
+            }
+            else {
+                u8(0x31); u8(0xD2); // xor edx, edx
+                grp3(6, RCX);   // div rcx
+            }
+        }
+        void not_() { grp3(2, RAX); }
+        void neg() { grp3(3, RAX); }
+        /// Shift RAX by CL (4 = shl, 5 = shr, 7 = sar)
+        void shift(unsigned n) { u8(0x48); u8(0xD3); modrm_reg(n, RAX); }
+        void xor_al_1() { u8(0x83); u8(0xF0); u8(0x01); }
+        void xor_eax_eax() { u8(0x31); u8(0xC0); }
+        void test_rax() { u8(0x48); u8(0x85); u8(0xC0); }
+        /// RAX = (condition ? 1 : 0)
+        void setcc(Cond cc) { u8(0x0F); u8(0x90 | cc); u8(0xC0); u8(0x0F); u8(0xB6); u8(0xC0); }
+        /// Copy RCX bytes from [RSI] to [RDI]
+        void rep_movsb() { u8(0xF3); u8(0xA4); }
+        /// Fill RCX bytes at [RDI] with AL
+        void rep_stosb() { u8(0xF3); u8(0xAA); }
+
+        // Control flow (these return the offset of the `rel32` to be patched)
+        size_t jmp() { u8(0xE9); u32(0); return pos() - 4; }
+        size_t jcc(Cond cc) { u8(0x0F); u8(0x80 | cc); u32(0); return pos() - 4; }
+        size_t call() { u8(0xE8); u32(0); return pos() - 4; }
+        void call_r10() { u8(0x41); u8(0xFF); u8(0xD2); }
+
+        void prologue(uint32_t frame_size) {
+            u8(0x55);   // push rbp
+            u8(0x48); u8(0x89); u8(0xE5);   // mov rbp, rsp
+            if( frame_size > 0 ) {
+                u8(0x48); u8(0x81); u8(0xEC); u32(frame_size);  // sub rsp, imm32
+            }
+        }
+        void epilogue() {
+            u8(0xC9);   // leave
+            u8(0xC3);   // ret
+        }
+        void ud2() { u8(0x0F); u8(0x0B); }
+    };
+
+    // --------------------------------------------------------------------
+    // Type layouts
+    // --------------------------------------------------------------------
+    /// Memory layout of a type (matching the C type emitted by the C backend)
+    struct TypeLayout
+    {
+        size_t  size = 0;
+        size_t  align = 1;
+        /// Integer/pointer that fits in a register (otherwise an aggregate, or zero-sized)
+        bool    is_scalar = false;
+        bool    is_signed = false;
+        /// Contains a floating point value (so isn't passed in integer registers)
+        bool    has_float = false;
+
+        /// Offsets of the fields of a struct/tuple
+        ::std::vector<size_t>   fields;
+
+        enum class Enum {
+            None,
+            /// `struct { TAG }`
+            Value,
+            /// Option-like enum, variant 0 is stored as a null pointer (`tag_ofs`) in the data of variant 1
+            NonZero,
+            /// `struct { unsigned int TAG; union { ... } DATA; }`
+            Data,
+        };
+        Enum    enum_repr = Enum::None;
+        size_t  tag_ofs = 0;
+        size_t  tag_size = 0;
+        /// Offset of the variant data (data enums)
+        size_t  data_ofs = 0;
+    };
+
+    class LayoutCache
+    {
+        const Span& sp;
+        const StaticTraitResolve&   m_resolve;
+        ::std::map< ::HIR::TypeRef, TypeLayout> m_cache;
+    public:
+        LayoutCache(const Span& sp, const StaticTraitResolve& resolve):
+            sp(sp),
+            m_resolve(resolve)
+        {
+        }
+
+        const TypeLayout& get(const ::HIR::TypeRef& ty)
+        {
+            auto it = m_cache.find(ty);
+            if( it == m_cache.end() )
+            {
+                auto l = compute(ty);
+                it = m_cache.insert(::std::make_pair( ty.clone(), mv$(l) )).first;
+            }
+            return it->second;
+        }
+
+        /// Field types of a struct (with the struct's parameters applied)
+        ::std::vector< ::HIR::TypeRef> get_struct_fields(const ::HIR::GenericPath& p, const ::HIR::Struct& str) const
+        {
+            ::std::vector< ::HIR::TypeRef>  rv;
+            TU_MATCHA( (str.m_data), (se),
+            (Unit,
+                ),
+            (Tuple,
+                for(const auto& f : se)
+                    rv.push_back( monomorph(str.m_params, p.m_params, f.ent) );
+                ),
+            (Named,
+                for(const auto& f : se)
+                    rv.push_back( monomorph(str.m_params, p.m_params, f.second.ent) );
+                )
+            )
+            return rv;
+        }
+        ::HIR::TypeRef monomorph(const ::HIR::GenericParams& params_def, const ::HIR::PathParams& params, const ::HIR::TypeRef& tpl) const
+        {
+            if( !monomorphise_type_needed(tpl) )
+                return tpl.clone();
+            auto rv = monomorphise_type(sp, params_def, params, tpl);
+            m_resolve.expand_associated_types(sp, rv);
+            return rv;
+        }
+
+    private:
+        static TypeLayout scalar(size_t size, bool is_signed)
+        {
+            TypeLayout  rv;
+            rv.size = size;
+            rv.align = size;
+            rv.is_scalar = true;
+            rv.is_signed = is_signed;
+            return rv;
+        }
+        /// Lay out fields in declaration order (as a C struct)
+        void add_fields(TypeLayout& rv, const ::std::vector< ::HIR::TypeRef>& fields)
+        {
+            size_t  ofs = rv.size;
+            for(const auto& fld : fields)
+            {
+                const auto& l = get(fld);
+                ofs = (ofs + l.align - 1) / l.align * l.align;
+                rv.fields.push_back(ofs);
+                ofs += l.size;
+                rv.align = ::std::max(rv.align, l.align);
+                rv.has_float |= l.has_float;
+            }
+            rv.size = (ofs + rv.align - 1) / rv.align * rv.align;
+        }
+
+        TypeLayout compute(const ::HIR::TypeRef& ty)
+        {
+            TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+            (
+                UNSUPPORTED("Type " << ty);
+                ),
+            (Diverge,
+                return TypeLayout();
+                ),
+            (Primitive,
+                switch(te)
+                {
+                case ::HIR::CoreType::Bool:
+                case ::HIR::CoreType::U8:   return scalar(1, false);
+                case ::HIR::CoreType::I8:   return scalar(1, true);
+                case ::HIR::CoreType::U16:  return scalar(2, false);
+                case ::HIR::CoreType::I16:  return scalar(2, true);
+                case ::HIR::CoreType::Char:
+                case ::HIR::CoreType::U32:  return scalar(4, false);
+                case ::HIR::CoreType::I32:  return scalar(4, true);
+                case ::HIR::CoreType::U64:
+                case ::HIR::CoreType::Usize:    return scalar(8, false);
+                case ::HIR::CoreType::I64:
+                case ::HIR::CoreType::Isize:    return scalar(8, true);
+                case ::HIR::CoreType::F32:
+                case ::HIR::CoreType::F64: {
+                    // Only moved around as bytes
+                    TypeLayout  rv;
+                    rv.size = rv.align = (te == ::HIR::CoreType::F32 ? 4 : 8);
+                    rv.has_float = true;
+                    return rv; }
+                case ::HIR::CoreType::Str:
+                    // Only as the unsized tail of a struct
+                    return TypeLayout();
+                default:
+                    UNSUPPORTED("Primitive " << ty);
+                }
+                ),
+            (Borrow,
+                if( m_resolve.is_type_owned_box(ty) )
+                    UNSUPPORTED("Owned box");
+                if( m_resolve.type_is_sized(sp, *te.inner) )
+                    return scalar(8, false);
+                // Fat pointer - `struct { void* PTR; size_t/void* META; }`
+                TypeLayout  rv;
+                rv.size = 16;
+                rv.align = 8;
+                return rv;
+                ),
+            (Pointer,
+                if( m_resolve.type_is_sized(sp, *te.inner) )
+                    return scalar(8, false);
+                TypeLayout  rv;
+                rv.size = 16;
+                rv.align = 8;
+                return rv;
+                ),
+            (Function,
+                return scalar(8, false);
+                ),
+            (Tuple,
+                TypeLayout  rv;
+                add_fields(rv, te);
+                return rv;
+                ),
+            (Array,
+                const auto& inner = get(*te.inner);
+                TypeLayout  rv;
+                rv.size = inner.size * te.size_val;
+                rv.align = inner.align;
+                rv.has_float = inner.has_float;
+                return rv;
+                ),
+            (Slice,
+                // Only as the unsized tail of a struct (a zero-length C array)
+                TypeLayout  rv;
+                rv.align = get(*te.inner).align;
+                return rv;
+                ),
+            (TraitObject,
+                // Only as the unsized tail of a struct (`unsigned char x[0]`)
+                return TypeLayout();
+                ),
+            (Path,
+                if( const auto* str = te.binding.opt_Struct() )
+                    return compute_struct(te.path.m_data.as_Generic(), **str);
+                if( const auto* enm = te.binding.opt_Enum() )
+                    return compute_enum(te.path.m_data.as_Generic(), **enm);
+                if( const auto* unn = te.binding.opt_Union() )
+                {
+                    const auto& p = te.path.m_data.as_Generic();
+                    TypeLayout  rv;
+                    for(const auto& var : (*unn)->m_variants)
+                    {
+                        const auto& l = get( monomorph((*unn)->m_params, p.m_params, var.second.ent) );
+                        rv.size = ::std::max(rv.size, l.size);
+                        rv.align = ::std::max(rv.align, l.align);
+                        rv.has_float |= l.has_float;
+                    }
+                    rv.size = (rv.size + rv.align - 1) / rv.align * rv.align;
+                    return rv;
+                }
+                UNSUPPORTED("Type " << ty);
+                )
+            )
+        }
+        TypeLayout compute_struct(const ::HIR::GenericPath& p, const ::HIR::Struct& str)
+        {
+            if( str.m_repr == ::HIR::Struct::Repr::Packed )
+                UNSUPPORTED("Packed struct " << p);
+            TypeLayout  rv;
+            // Vtables start with `VTABLE_HDR` (size, align, and drop glue)
+            const auto& lc = p.m_path.m_components.back();
+            if( lc.size() > 7 && ::std::strcmp(lc.c_str() + lc.size() - 7, "#vtable") == 0 )
+            {
+                rv.size = 3*8;
+                rv.align = 8;
+            }
+            add_fields(rv, get_struct_fields(p, str));
+            return rv;
+        }
+        TypeLayout compute_enum(const ::HIR::GenericPath& p, const ::HIR::Enum& enm)
+        {
+            TypeLayout  rv;
+            if( const auto* e = enm.m_data.opt_Value() )
+            {
+                rv.enum_repr = TypeLayout::Enum::Value;
+                switch(e->repr)
+                {
+                case ::HIR::Enum::Repr::Rust:
+                case ::HIR::Enum::Repr::C:
+                case ::HIR::Enum::Repr::U32:    rv.tag_size = 4;    break;
+                case ::HIR::Enum::Repr::Usize:
+                case ::HIR::Enum::Repr::U64:    rv.tag_size = 8;    break;
+                case ::HIR::Enum::Repr::U8:     rv.tag_size = 1;    break;
+                case ::HIR::Enum::Repr::U16:    rv.tag_size = 2;    break;
+                }
+                rv.size = rv.align = rv.tag_size;
+                return rv;
+            }
+            const auto& vars = enm.m_data.as_Data();
+            // Option-like enums (see the C backend's `emit_enum`)
+            if( vars.size() == 2 && vars[0].type == ::HIR::TypeRef::new_unit() && vars[1].type != ::HIR::TypeRef::new_unit() )
+            {
+                auto data_ty = monomorph(enm.m_params, p.m_params, vars[1].type);
+                size_t  ofs;
+                if( find_nonzero(data_ty, ofs) )
+                {
+                    rv = get(data_ty);
+                    rv.fields.clear();
+                    rv.is_scalar = false;
+                    rv.enum_repr = TypeLayout::Enum::NonZero;
+                    rv.tag_ofs = ofs;
+                    rv.tag_size = 8;
+                    return rv;
+                }
+            }
+            rv.enum_repr = TypeLayout::Enum::Data;
+            rv.tag_size = 4;
+            size_t  data_size = 0, data_align = 1;
+            for(const auto& var : vars)
+            {
+                const auto& l = get( monomorph(enm.m_params, p.m_params, var.type) );
+                data_size = ::std::max(data_size, l.size);
+                data_align = ::std::max(data_align, l.align);
+                rv.has_float |= l.has_float;
+            }
+            rv.align = ::std::max<size_t>(4, data_align);
+            rv.data_ofs = (4 + data_align - 1) / data_align * data_align;
+            rv.size = (rv.data_ofs + data_size + rv.align - 1) / rv.align * rv.align;
+            return rv;
+        }
+        /// Locate the first non-nullable pointer in a type (matching the C backend's `get_nonzero_path`)
+        bool find_nonzero(const ::HIR::TypeRef& ty, size_t& out_ofs)
+        {
+            if( ty.m_data.is_Borrow() || ty.m_data.is_Function() )
+            {
+                out_ofs = 0;
+                return true;
+            }
+            if( ty.m_data.is_Path() && ty.m_data.as_Path().binding.is_Struct() )
+            {
+                const auto& te = ty.m_data.as_Path();
+                auto fields = get_struct_fields(te.path.m_data.as_Generic(), *te.binding.as_Struct());
+                for(size_t i = 0; i < fields.size(); i ++)
+                {
+                    size_t  ofs;
+                    if( find_nonzero(fields[i], ofs) )
+                    {
+                        out_ofs = get(ty).fields.at(i) + ofs;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    };
+
+    // --------------------------------------------------------------------
+    // MIR lowering
+    // --------------------------------------------------------------------
+    /// SysV classification of a value passed to/from a function
+    enum class PassClass {
+        /// Zero-sized, not passed
+        None,
+        /// In one/two integer registers
+        Int1,
+        Int2,
+        /// On the stack (arguments), or via a hidden pointer (return values)
+        Memory,
+    };
+    /// Location of an argument
+    struct ArgLoc {
+        PassClass   cls;
+        /// First argument register used (`~0u` if on the stack)
+        unsigned    reg;
+        /// Offset within the stack arguments
+        size_t  stack_ofs;
+    };
+    PassClass classify(const TypeLayout& l)
+    {
+        if( l.size == 0 )
+            return PassClass::None;
+        if( l.has_float )
+            UNSUPPORTED("Floating point value passed by value");
+        if( l.size <= 8 )
+            return PassClass::Int1;
+        if( l.size <= 16 )
+            return PassClass::Int2;
+        return PassClass::Memory;
+    }
+    /// Assign registers/stack locations to a function's arguments
+    ::std::vector<ArgLoc> assign_args(const ::std::vector<const TypeLayout*>& args, bool has_ret_ptr, size_t& out_stack_size)
+    {
+        ::std::vector<ArgLoc>   rv;
+        unsigned    next_reg = has_ret_ptr ? 1 : 0;
+        out_stack_size = 0;
+        for(const auto* l : args)
+        {
+            ArgLoc  loc { classify(*l), ~0u, 0 };
+            unsigned    n_regs = (loc.cls == PassClass::Int1 ? 1 : loc.cls == PassClass::Int2 ? 2 : 0);
+            if( loc.cls == PassClass::None ) {
+            }
+            else if( n_regs > 0 && next_reg + n_regs <= 6 ) {
+                loc.reg = next_reg;
+                next_reg += n_regs;
+            }
+            else {
+                // NOTE: If an argument doesn't fit in the remaining registers, all of it goes on the stack
+                loc.stack_ofs = out_stack_size;
+                out_stack_size += (l->size + 7) & ~size_t(7);
+            }
+            rv.push_back(loc);
+        }
+        return rv;
+    }
+
+    class FunctionLowerer
+    {
+        const Span& sp;
+        const StaticTraitResolve&   m_resolve;
+        const ::MIR::TypeResolve&   m_mir_res;
+        const ::MIR::Function&  m_fcn;
+        LayoutCache&    m_layouts;
+        /// Symbols of the functions that can be called directly
+        const ::std::map< ::HIR::Path, ::std::string>&  m_fcn_symbols;
+        /// Symbols of statics (and vtables)
+        const ::std::map< ::HIR::Path, ::std::string>&  m_static_symbols;
+
+        // Stack frame (offsets from RBP)
+        PassClass   m_ret_class = PassClass::None;
+        int32_t m_ret_slot = 0;
+        /// Hidden return pointer (for `PassClass::Memory` returns)
+        int32_t m_ret_ptr_slot = 0;
+        ::std::vector<int32_t>  m_arg_slots;
+        ::std::vector<int32_t>  m_local_slots;
+        ::std::vector<int32_t>  m_df_slots;
+        /// Register values for a call (filled before the registers are loaded)
+        int32_t m_staging_slot = 0;
+        /// Outgoing stack arguments (at the bottom of the frame)
+        int32_t m_outgoing_ofs = 0;
+        uint32_t    m_frame_size = 0;
+
+        size_t  m_cur_bb = 0;
+        ::std::vector<size_t>   m_bb_ofs;
+        /// (offset of `rel32`, target block)
+        ::std::vector< ::std::pair<size_t, size_t> >    m_jumps;
+
+    public:
+        Assembler   m_asm;
+        ::std::vector<ElfObject::Fixup> m_fixups;
+
+        FunctionLowerer(const Span& sp, const StaticTraitResolve& resolve, const ::MIR::TypeResolve& mir_res, LayoutCache& layouts,
+                const ::std::map< ::HIR::Path, ::std::string>& fcn_symbols, const ::std::map< ::HIR::Path, ::std::string>& static_symbols
+                ):
+            sp(sp),
+            m_resolve(resolve),
+            m_mir_res(mir_res),
+            m_fcn(mir_res.m_fcn),
+            m_layouts(layouts),
+            m_fcn_symbols(fcn_symbols),
+            m_static_symbols(static_symbols)
+        {
+        }
+
+        void lower()
+        {
+            const auto& ret_repr = get_repr(m_mir_res.m_ret_type);
+            m_ret_class = classify(ret_repr);
+            ::std::vector<const TypeLayout*>    arg_reprs;
+            for(const auto& a : m_mir_res.m_args)
+                arg_reprs.push_back( &get_repr(a.second) );
+            size_t  in_stack_size;
+            auto arg_locs = assign_args(arg_reprs, m_ret_class == PassClass::Memory, in_stack_size);
+
+            // Stack frame
+            if( m_ret_class == PassClass::Memory )
+                m_ret_ptr_slot = alloc_slot(8);
+            else
+                m_ret_slot = alloc_slot(ret_repr.size);
+            for(size_t i = 0; i < arg_locs.size(); i ++)
+            {
+                // Arguments passed on the stack are used where the caller put them
+                if( arg_locs[i].cls != PassClass::None && arg_locs[i].reg == ~0u )
+                    m_arg_slots.push_back( static_cast<int32_t>(16 + arg_locs[i].stack_ofs) );
+                else
+                    m_arg_slots.push_back( alloc_slot(arg_reprs[i]->size) );
+            }
+            for(const auto& ty : m_fcn.locals)
+            {
+                m_local_slots.push_back( alloc_slot(get_repr(ty).size) );
+            }
+            for(size_t i = 0; i < m_fcn.drop_flags.size(); i ++)
+            {
+                m_df_slots.push_back( alloc_slot(1) );
+            }
+            size_t  out_stack_size = 0;
+            bool    has_calls = false;
+            for(const auto& blk : m_fcn.blocks)
+            {
+                if( const auto* te = blk.terminator.opt_Call() )
+                {
+                    has_calls = true;
+                    if( !te->fcn.is_Intrinsic() )
+                    {
+                        size_t  s;
+                        get_call_locs(*te, s);
+                        out_stack_size = ::std::max(out_stack_size, s);
+                    }
+                }
+            }
+            if( has_calls )
+                m_staging_slot = alloc_slot(6*8);
+            m_frame_size = (m_frame_size + static_cast<uint32_t>(out_stack_size) + 15) & ~15u;
+            m_outgoing_ofs = -static_cast<int32_t>(m_frame_size);
+
+            m_asm.prologue(m_frame_size);
+            if( m_ret_class == PassClass::Memory )
+                m_asm.store(Mem { RBP, m_ret_ptr_slot }, RDI, 8);
+            for(size_t i = 0; i < arg_locs.size(); i ++)
+            {
+                const auto& loc = arg_locs[i];
+                if( loc.reg == ~0u )
+                    continue ;
+                // NOTE: Slots are padded to 8 bytes, so whole registers can be stored
+                m_asm.store(Mem { RBP, m_arg_slots[i] }, ARG_REGS[loc.reg], arg_reprs[i]->is_scalar ? arg_reprs[i]->size : 8);
+                if( loc.cls == PassClass::Int2 )
+                    m_asm.store(Mem { RBP, m_arg_slots[i] + 8 }, ARG_REGS[loc.reg+1], 8);
+            }
+            for(size_t i = 0; i < m_fcn.drop_flags.size(); i ++)
+            {
+                m_asm.mov_imm(RAX, m_fcn.drop_flags[i] ? 1 : 0);
+                m_asm.store(Mem { RBP, m_df_slots[i] }, RAX, 1);
+            }
+
+            m_bb_ofs.resize(m_fcn.blocks.size());
+            for(m_cur_bb = 0; m_cur_bb < m_fcn.blocks.size(); m_cur_bb ++)
+            {
+                const auto& blk = m_fcn.blocks[m_cur_bb];
+                m_bb_ofs[m_cur_bb] = m_asm.pos();
+                for(const auto& stmt : blk.statements)
+                {
+                    lower_statement(stmt);
+                }
+                lower_terminator(blk.terminator, ret_repr);
+            }
+
+            for(const auto& j : m_jumps)
+            {
+                m_asm.patch_u32(j.first, static_cast<uint32_t>( m_bb_ofs.at(j.second) - (j.first + 4) ));
+            }
+        }
+
+    private:
+        int32_t alloc_slot(size_t size)
+        {
+            m_frame_size += static_cast<uint32_t>(size);
+            m_frame_size = (m_frame_size + 7) & ~7u;
+            if( m_frame_size > 0x10000000 )
+                UNSUPPORTED("Stack frame too large");
+            return -static_cast<int32_t>(m_frame_size);
+        }
+
+        const TypeLayout& get_repr(const ::HIR::TypeRef& ty) const
+        {
+            const auto& rv = m_layouts.get(ty);
+            // Slots are only 8-byte aligned
+            if( rv.align > 8 )
+                UNSUPPORTED("Over-aligned type " << ty);
+            return rv;
+        }
+        const TypeLayout& get_lvalue_repr(const ::MIR::LValue& lv) const
+        {
+            ::HIR::TypeRef  tmp;
+            return get_repr(m_mir_res.get_lvalue_type(tmp, lv));
+        }
+        const TypeLayout& get_param_repr(const ::MIR::Param& p) const
+        {
+            ::HIR::TypeRef  tmp;
+            return get_repr(m_mir_res.get_param_type(tmp, p));
+        }
+        static bool is_fat_pointer(const TypeLayout& l) {
+            return l.size == 16 && l.enum_repr == TypeLayout::Enum::None && l.fields.empty() && !l.has_float;
+        }
+
+        /// Location of a lvalue (clobbers R10/R11), ignoring the last `wrapper_skip` wrappers
+        Mem get_lvalue_mem(const ::MIR::LValue& lv, size_t wrapper_skip=0)
+        {
+            Mem rv;
+            TU_MATCHA( (lv.m_root), (e),
+            (Return,
+                if( m_ret_class == PassClass::Memory ) {
+                    m_asm.load(R11, Mem { RBP, m_ret_ptr_slot }, 8, false);
+                    rv = Mem { R11, 0 };
+                }
+                else {
+                    rv = Mem { RBP, m_ret_slot };
+                }
+                ),
+            (Argument,
+                rv = Mem { RBP, m_arg_slots.at(e.idx) };
+                ),
+            (Local,
+                rv = Mem { RBP, m_local_slots.at(e) };
+                ),
+            (Static,
+                auto it = m_static_symbols.find(*e);
+                if( it == m_static_symbols.end() )
+                    UNSUPPORTED("Static " << *e);
+                m_fixups.push_back(ElfObject::Fixup { m_asm.load_rip(R11), ElfObject::Fixup::GotAddr, it->second });
+                rv = Mem { R11, 0 };
+                )
+            )
+
+            for(size_t i = 0; i < lv.m_wrappers.size() - wrapper_skip; i ++)
+            {
+                const auto& w = lv.m_wrappers[i];
+                ::HIR::TypeRef  tmp;
+                const auto& ty = m_mir_res.get_lvalue_type(tmp, lv, lv.m_wrappers.size() - i);
+                if( w.is_Field() )
+                {
+                    rv.ofs += static_cast<int32_t>( get_field_ofs(ty, w.as_Field()) );
+                }
+                else if( w.is_Deref() )
+                {
+                    const auto& r = get_repr(ty);
+                    // NOTE: The data pointer is the first word of a fat pointer
+                    if( !r.is_scalar && !is_fat_pointer(r) )
+                        UNSUPPORTED("Deref of " << ty);
+                    m_asm.load(R11, rv, 8, false);
+                    rv = Mem { R11, 0 };
+                }
+                else if( w.is_Index() )
+                {
+                    size_t  elem_size = get_elem_size(ty);
+                    if( elem_size > 0x7FFFFFFF )
+                        UNSUPPORTED("Array element too large");
+                    m_asm.lea(R11, rv);
+                    m_asm.load(R10, Mem { RBP, m_local_slots.at(w.as_Index()) }, 8, false);
+                    m_asm.imul_imm(R10, static_cast<int32_t>(elem_size));
+                    m_asm.alu(0x01, R11, R10);  // add r11, r10
+                    rv = Mem { R11, 0 };
+                }
+                else
+                {
+                    const auto& r = get_repr(ty);
+                    if( r.enum_repr == TypeLayout::Enum::Data )
+                        rv.ofs += static_cast<int32_t>(r.data_ofs);
+                    else if( r.enum_repr == TypeLayout::Enum::NonZero || (ty.m_data.is_Path() && ty.m_data.as_Path().binding.is_Union()) )
+                        ;
+                    else
+                        UNSUPPORTED("Downcast of " << ty);
+                }
+            }
+            return rv;
+        }
+        size_t get_elem_size(const ::HIR::TypeRef& ty) const
+        {
+            if( const auto* te = ty.m_data.opt_Array() )
+                return get_repr(*te->inner).size;
+            if( const auto* te = ty.m_data.opt_Slice() )
+                return get_repr(*te->inner).size;
+            UNSUPPORTED("Index of " << ty);
+        }
+        size_t get_field_ofs(const ::HIR::TypeRef& ty, unsigned int idx) const
+        {
+            if( ty.m_data.is_Array() || ty.m_data.is_Slice() )
+                return get_elem_size(ty) * idx;
+            const auto& r = get_repr(ty);
+            if( r.enum_repr != TypeLayout::Enum::None || idx >= r.fields.size() )
+                UNSUPPORTED("Field " << idx << " of " << ty);
+            return r.fields[idx];
+        }
+
+        /// Load a scalar into a register
+        void load_lvalue(Reg dst, const ::MIR::LValue& lv)
+        {
+            const auto& r = get_lvalue_repr(lv);
+            if( !r.is_scalar )
+                UNSUPPORTED("Load of non-scalar " << lv);
+            m_asm.load(dst, get_lvalue_mem(lv), r.size, r.is_signed);
+        }
+        void load_rodata_addr(Reg dst, ::std::string data)
+        {
+            m_fixups.push_back(ElfObject::Fixup { m_asm.lea_rip(dst), ElfObject::Fixup::RoData, mv$(data) });
+        }
+        void load_constant(Reg dst, const ::MIR::Constant& c)
+        {
+            TU_MATCH_DEF( ::MIR::Constant, (c), (ce),
+            (
+                UNSUPPORTED("Constant " << c);
+                ),
+            (Int,
+                m_asm.mov_imm(dst, static_cast<uint64_t>(ce.v));
+                ),
+            (Uint,
+                m_asm.mov_imm(dst, ce.v);
+                ),
+            (Bool,
+                m_asm.mov_imm(dst, ce.v ? 1 : 0);
+                ),
+            (Float,
+                // Just the bits (stored to memory by the caller)
+                uint64_t    bits = 0;
+                if( ce.t == ::HIR::CoreType::F32 ) {
+                    float   v = static_cast<float>(ce.v);
+                    uint32_t    b;
+                    ::std::memcpy(&b, &v, 4);
+                    bits = b;
+                }
+                else {
+                    ::std::memcpy(&bits, &ce.v, 8);
+                }
+                m_asm.mov_imm(dst, bits);
+                ),
+            (Bytes,
+                load_rodata_addr(dst, ::std::string(ce.begin(), ce.end()));
+                ),
+            (ItemAddr,
+                auto it = m_fcn_symbols.find(ce);
+                if( it == m_fcn_symbols.end() )
+                {
+                    it = m_static_symbols.find(ce);
+                    if( it == m_static_symbols.end() )
+                        UNSUPPORTED("Address of " << ce);
+                }
+                m_fixups.push_back(ElfObject::Fixup { m_asm.load_rip(dst), ElfObject::Fixup::GotAddr, it->second });
+                )
+            )
+        }
+        void load_param(Reg dst, const ::MIR::Param& p)
+        {
+            if( const auto* e = p.opt_LValue() )
+                load_lvalue(dst, *e);
+            else
+                load_constant(dst, p.as_Constant());
+        }
+        /// Store a scalar (RAX) to a lvalue
+        void store_lvalue(const ::MIR::LValue& lv, size_t size)
+        {
+            if( size > 0 )
+                m_asm.store(get_lvalue_mem(lv), RAX, size);
+        }
+        /// Copy `size` bytes from [RSI] to [RDI]
+        void copy_bytes(size_t size)
+        {
+            if( size > 64 )
+            {
+                m_asm.mov_imm(RCX, size);
+                m_asm.rep_movsb();
+                return ;
+            }
+            size_t ofs = 0;
+            for(size_t chunk : { 8, 4, 2, 1 })
+            {
+                for( ; ofs + chunk <= size; ofs += chunk )
+                {
+                    m_asm.load(RAX, Mem { RSI, static_cast<int32_t>(ofs) }, chunk, false);
+                    m_asm.store(Mem { RDI, static_cast<int32_t>(ofs) }, RAX, chunk);
+                }
+            }
+        }
+        void zero_mem(const Mem& dst, size_t size)
+        {
+            m_asm.lea(RDI, dst);
+            m_asm.xor_eax_eax();
+            if( size > 64 )
+            {
+                m_asm.mov_imm(RCX, size);
+                m_asm.rep_stosb();
+                return ;
+            }
+            size_t ofs = 0;
+            for(size_t chunk : { 8, 4, 2, 1 })
+            {
+                for( ; ofs + chunk <= size; ofs += chunk )
+                    m_asm.store(Mem { RDI, static_cast<int32_t>(ofs) }, RAX, chunk);
+            }
+        }
+        /// Write a value to memory
+        /// - The destination is obtained after the value is loaded (so `get_dst` can clobber R10/R11)
+        /// - `widen` stores scalars as whole (extended) registers, as needed when passing them to functions
+        void write_param(const ::MIR::Param& p, const TypeLayout& r, ::std::function<Mem()> get_dst, bool widen=false)
+        {
+            if( r.size == 0 )
+                return ;
+            if( const auto* e = p.opt_LValue() )
+            {
+                if( r.is_scalar ) {
+                    m_asm.load(RAX, get_lvalue_mem(*e), r.size, r.is_signed);
+                    m_asm.store(get_dst(), RAX, widen ? 8 : r.size);
+                }
+                else {
+                    m_asm.lea(RSI, get_lvalue_mem(*e));
+                    m_asm.lea(RDI, get_dst());
+                    copy_bytes(r.size);
+                }
+            }
+            else if( const auto* ce = p.as_Constant().opt_StaticString() )
+            {
+                load_rodata_addr(RAX, *ce);
+                auto m = get_dst();
+                m_asm.store(m, RAX, 8);
+                m_asm.mov_imm(RAX, ce->size());
+                m.ofs += 8;
+                m_asm.store(m, RAX, 8);
+            }
+            else
+            {
+                if( r.size > 8 )
+                    UNSUPPORTED("Constant " << p << " of size " << r.size);
+                load_constant(RAX, p.as_Constant());
+                m_asm.store(get_dst(), RAX, widen || !r.is_scalar ? r.size : r.size);
+            }
+        }
+        void write_param(const ::MIR::Param& p, const ::MIR::LValue& dst, size_t dst_ofs=0)
+        {
+            write_param(p, get_param_repr(p), [&](){ auto m = get_lvalue_mem(dst); m.ofs += static_cast<int32_t>(dst_ofs); return m; });
+        }
+
+        void lower_statement(const ::MIR::Statement& stmt)
+        {
+            TU_MATCHA( (stmt), (se),
+            (Assign,
+                lower_assign(se.dst, se.src);
+                ),
+            (Asm,
+                UNSUPPORTED("Inline assembly");
+                ),
+            (SetDropFlag,
+                if( se.other == ~0u ) {
+                    m_asm.mov_imm(RAX, se.new_val ? 1 : 0);
+                }
+                else {
+                    m_asm.load(RAX, Mem { RBP, m_df_slots.at(se.other) }, 1, false);
+                    if( se.new_val )
+                        m_asm.xor_al_1();
+                }
+                m_asm.store(Mem { RBP, m_df_slots.at(se.idx) }, RAX, 1);
+                ),
+            (Drop,
+                // NOTE: Drop glue is `static` in the C code, so can't be called from here
+                ::HIR::TypeRef  tmp;
+                const auto& ty = m_mir_res.get_lvalue_type(tmp, se.slot);
+                if( se.kind == ::MIR::eDropKind::SHALLOW || m_resolve.type_needs_drop_glue(sp, ty) )
+                    UNSUPPORTED("Drop of " << ty);
+                ),
+            (ScopeEnd,
+                )
+            )
+        }
+
+        void lower_assign(const ::MIR::LValue& dst, const ::MIR::RValue& src)
+        {
+            ::HIR::TypeRef  tmp;
+            const auto& dst_ty = m_mir_res.get_lvalue_type(tmp, dst);
+            const auto& dst_repr = get_repr(dst_ty);
+            TU_MATCHA( (src), (se),
+            (Use,
+                write_param(::MIR::Param(se.clone()), dst);
+                ),
+            (Constant,
+                write_param(::MIR::Param(se.clone()), dst);
+                ),
+            (SizedArray,
+                if( se.count == 0 || dst_repr.size == 0 )
+                    return ;
+                write_param(se.val, dst);
+                // Replicate the first element (`rep movsb` copies a byte at a time, so the overlap repeats it)
+                size_t  elem_size = dst_repr.size / se.count;
+                if( se.count > 1 )
+                {
+                    auto m = get_lvalue_mem(dst);
+                    m_asm.lea(RSI, m);
+                    m.ofs += static_cast<int32_t>(elem_size);
+                    m_asm.lea(RDI, m);
+                    m_asm.mov_imm(RCX, elem_size * (se.count - 1));
+                    m_asm.rep_movsb();
+                }
+                ),
+            (Borrow,
+                ::HIR::TypeRef  tmp2;
+                const auto& val_ty = m_mir_res.get_lvalue_type(tmp2, se.val);
+                if( dst_repr.is_scalar )
+                {
+                    m_asm.lea(RAX, get_lvalue_mem(se.val));
+                    store_lvalue(dst, dst_repr.size);
+                }
+                else if( is_fat_pointer(dst_repr) && !se.val.m_wrappers.empty() && !m_resolve.type_is_sized(sp, val_ty) )
+                {
+                    // Borrow of an unsized value, the metadata comes from the pointer it was reached through
+                    size_t  n_fields = 0;
+                    while( n_fields < se.val.m_wrappers.size() && se.val.m_wrappers[se.val.m_wrappers.size() - 1 - n_fields].is_Field() )
+                        n_fields ++;
+                    if( n_fields == se.val.m_wrappers.size() || !se.val.m_wrappers[se.val.m_wrappers.size() - 1 - n_fields].is_Deref() )
+                        UNSUPPORTED("Borrow of unsized " << se.val);
+                    size_t  ptr_skip = n_fields + 1;
+                    m_asm.lea(RAX, get_lvalue_mem(se.val));
+                    m_asm.store(get_lvalue_mem(dst), RAX, 8);
+                    auto meta = get_lvalue_mem(se.val, ptr_skip);
+                    meta.ofs += 8;
+                    m_asm.load(RAX, meta, 8, false);
+                    auto m = get_lvalue_mem(dst);
+                    m.ofs += 8;
+                    m_asm.store(m, RAX, 8);
+                }
+                else
+                {
+                    UNSUPPORTED("Borrow to " << dst_ty);
+                }
+                ),
+            (Cast,
+                lower_cast(dst, dst_ty, dst_repr, se);
+                ),
+            (BinOp,
+                lower_binop(se);
+                store_lvalue(dst, dst_repr.size);
+                ),
+            (UniOp,
+                ::HIR::TypeRef  tmp2;
+                const auto& ty = m_mir_res.get_lvalue_type(tmp2, se.val);
+                load_lvalue(RAX, se.val);
+                switch(se.op)
+                {
+                case ::MIR::eUniOp::INV:
+                    if( ty == ::HIR::CoreType::Bool )
+                        m_asm.xor_al_1();
+                    else
+                        m_asm.not_();
+                    break;
+                case ::MIR::eUniOp::NEG:
+                    m_asm.neg();
+                    break;
+                }
+                store_lvalue(dst, dst_repr.size);
+                ),
+            (DstMeta,
+                auto m = get_lvalue_mem(se.val);
+                m.ofs += 8;
+                m_asm.load(RAX, m, 8, false);
+                store_lvalue(dst, dst_repr.size);
+                ),
+            (DstPtr,
+                m_asm.load(RAX, get_lvalue_mem(se.val), 8, false);
+                store_lvalue(dst, dst_repr.size);
+                ),
+            (MakeDst,
+                if( !is_fat_pointer(dst_repr) )
+                    UNSUPPORTED("DST construction of " << dst_ty);
+                write_param(se.ptr_val, dst, 0);
+                write_param(se.meta_val, dst, 8);
+                ),
+            (Tuple,
+                lower_fields(dst, dst_repr, se.vals);
+                ),
+            (Array,
+                for(size_t i = 0; i < se.vals.size(); i ++)
+                {
+                    write_param(se.vals[i], dst, i * (dst_repr.size / se.vals.size()));
+                }
+                ),
+            (Variant,
+                const auto& tyi = m_resolve.m_crate.get_typeitem_by_path(sp, se.path.m_path);
+                if( tyi.is_Union() )
+                {
+                    write_param(se.val, dst);
+                }
+                else
+                {
+                    const auto& enm = tyi.as_Enum();
+                    switch(dst_repr.enum_repr)
+                    {
+                    case TypeLayout::Enum::None:
+                        UNSUPPORTED("Variant of " << dst_ty);
+                    case TypeLayout::Enum::NonZero:
+                        if( se.index == 0 )
+                            zero_mem(get_lvalue_mem(dst), dst_repr.size);
+                        else
+                            write_param(se.val, dst);
+                        break;
+                    case TypeLayout::Enum::Value:
+                        m_asm.mov_imm(RAX, enm.get_value(se.index));
+                        store_lvalue(dst, dst_repr.tag_size);
+                        break;
+                    case TypeLayout::Enum::Data:
+                        m_asm.mov_imm(RAX, se.index);
+                        store_lvalue(dst, 4);
+                        write_param(se.val, dst, dst_repr.data_ofs);
+                        break;
+                    }
+                }
+                ),
+            (Struct,
+                lower_fields(dst, dst_repr, se.vals);
+                )
+            )
+        }
+        void lower_fields(const ::MIR::LValue& dst, const TypeLayout& dst_repr, const ::std::vector< ::MIR::Param>& vals)
+        {
+            if( dst_repr.fields.size() != vals.size() )
+                UNSUPPORTED("Aggregate literal for " << dst);
+            for(unsigned int i = 0; i < vals.size(); i ++)
+            {
+                write_param(vals[i], dst, dst_repr.fields[i]);
+            }
+        }
+        void lower_cast(const ::MIR::LValue& dst, const ::HIR::TypeRef& dst_ty, const TypeLayout& dst_repr, const ::MIR::RValue::Data_Cast& se)
+        {
+            if( m_resolve.is_type_phantom_data(se.type) )
+                return ;
+            ::HIR::TypeRef  tmp;
+            const auto& src_ty = m_mir_res.get_lvalue_type(tmp, se.val);
+            const auto& src_repr = get_repr(src_ty);
+            // Casts between fat pointers (or no-op casts) don't change the representation
+            if( src_ty == se.type || (is_fat_pointer(src_repr) && is_fat_pointer(dst_repr)) )
+            {
+                write_param(::MIR::Param(se.val.clone()), dst);
+            }
+            else if( dst_repr.is_scalar && is_fat_pointer(src_repr) )
+            {
+                m_asm.load(RAX, get_lvalue_mem(se.val), 8, false);
+                store_lvalue(dst, dst_repr.size);
+            }
+            else if( dst_repr.is_scalar && src_repr.enum_repr == TypeLayout::Enum::Value )
+            {
+                m_asm.load(RAX, get_lvalue_mem(se.val), src_repr.tag_size, false);
+                store_lvalue(dst, dst_repr.size);
+            }
+            else if( dst_repr.is_scalar && src_repr.is_scalar )
+            {
+                // Extension is based on the source type, truncation is done by the store
+                load_lvalue(RAX, se.val);
+                store_lvalue(dst, dst_repr.size);
+            }
+            else
+            {
+                UNSUPPORTED("Cast from " << src_ty << " to " << dst_ty);
+            }
+        }
+        /// Evaluate a binary operation into RAX
+        void lower_binop(const ::MIR::RValue::Data_BinOp& se)
+        {
+            ::HIR::TypeRef  tmp;
+            const auto& ty = m_mir_res.get_param_type(tmp, se.val_l);
+            const auto& r = get_repr(ty);
+            // NOTE: Comparisons of `&T` compare the pointed-to slices in C (`slice_cmp`)
+            if( !r.is_scalar || ty.m_data.is_Borrow() )
+                UNSUPPORTED("BinOp on " << ty);
+            load_param(RAX, se.val_l);
+            load_param(RCX, se.val_r);
+            auto cmp = [&](Cond cc_unsigned, Cond cc_signed) {
+                m_asm.cmp();
+                m_asm.setcc(r.is_signed ? cc_signed : cc_unsigned);
+                };
+            switch(se.op)
+            {
+            case ::MIR::eBinOp::ADD:    m_asm.add();    break;
+            case ::MIR::eBinOp::SUB:    m_asm.sub();    break;
+            case ::MIR::eBinOp::MUL:    m_asm.imul();   break;
+            case ::MIR::eBinOp::DIV:    m_asm.div(r.is_signed); break;
+            case ::MIR::eBinOp::MOD:
+                m_asm.div(r.is_signed);
+                m_asm.mov(RAX, RDX);
+                break;
+            case ::MIR::eBinOp::BIT_OR:     m_asm.or_();    break;
+            case ::MIR::eBinOp::BIT_AND:    m_asm.and_();   break;
+            case ::MIR::eBinOp::BIT_XOR:    m_asm.xor_();   break;
+            case ::MIR::eBinOp::BIT_SHL:    m_asm.shift(4); break;
+            case ::MIR::eBinOp::BIT_SHR:    m_asm.shift(r.is_signed ? 7 : 5);   break;
+            case ::MIR::eBinOp::EQ: cmp(CC_E, CC_E);    break;
+            case ::MIR::eBinOp::NE: cmp(CC_NE, CC_NE);  break;
+            case ::MIR::eBinOp::GT: cmp(CC_A, CC_G);    break;
+            case ::MIR::eBinOp::GE: cmp(CC_AE, CC_GE);  break;
+            case ::MIR::eBinOp::LT: cmp(CC_B, CC_L);    break;
+            case ::MIR::eBinOp::LE: cmp(CC_BE, CC_LE);  break;
+            case ::MIR::eBinOp::ADD_OV:
+            case ::MIR::eBinOp::SUB_OV:
+            case ::MIR::eBinOp::MUL_OV:
+            case ::MIR::eBinOp::DIV_OV:
+                // NOTE: Not generated by MIR lowering (the C backend doesn't handle these either)
+                UNSUPPORTED("Overflowing BinOp");
+            }
+        }
+
+        void jump_to(size_t bb)
+        {
+            // Fall through to the next block
+            if( bb == m_cur_bb + 1 )
+                return ;
+            m_jumps.push_back(::std::make_pair( m_asm.jmp(), bb ));
+        }
+        void lower_terminator(const ::MIR::Terminator& term, const TypeLayout& ret_repr)
+        {
+            TU_MATCHA( (term), (te),
+            (Incomplete,
+                m_asm.ud2();
+                ),
+            (Return,
+                switch(m_ret_class)
+                {
+                case PassClass::None:
+                    break;
+                case PassClass::Int1:
+                    m_asm.load(RAX, Mem { RBP, m_ret_slot }, ret_repr.is_scalar ? ret_repr.size : 8, ret_repr.is_signed);
+                    break;
+                case PassClass::Int2:
+                    m_asm.load(RAX, Mem { RBP, m_ret_slot }, 8, false);
+                    m_asm.load(RDX, Mem { RBP, m_ret_slot + 8 }, 8, false);
+                    break;
+                case PassClass::Memory:
+                    m_asm.load(RAX, Mem { RBP, m_ret_ptr_slot }, 8, false);
+                    break;
+                }
+                m_asm.epilogue();
+                ),
+            (Diverge,
+                m_asm.ud2();
+                ),
+            (Goto,
+                jump_to(te);
+                ),
+            (Panic,
+                jump_to(te.dst);
+                ),
+            (If,
+                load_lvalue(RAX, te.cond);
+                m_asm.test_rax();
+                m_jumps.push_back(::std::make_pair( m_asm.jcc(CC_NE), te.bb0 ));
+                jump_to(te.bb1);
+                ),
+            (Switch,
+                ::HIR::TypeRef  tmp;
+                const auto& ty = m_mir_res.get_lvalue_type(tmp, te.val);
+                const auto& r = get_repr(ty);
+                auto m = get_lvalue_mem(te.val);
+                switch(r.enum_repr)
+                {
+                case TypeLayout::Enum::None:
+                    UNSUPPORTED("Switch on " << ty);
+                case TypeLayout::Enum::NonZero:
+                    m.ofs += static_cast<int32_t>(r.tag_ofs);
+                    m_asm.load(RAX, m, 8, false);
+                    m_asm.test_rax();
+                    m_jumps.push_back(::std::make_pair( m_asm.jcc(CC_NE), te.targets.at(1) ));
+                    jump_to(te.targets.at(0));
+                    break;
+                case TypeLayout::Enum::Value:
+                case TypeLayout::Enum::Data: {
+                    const auto& enm = *ty.m_data.as_Path().binding.as_Enum();
+                    m_asm.load(RAX, m, r.tag_size, false);
+                    for(size_t i = 0; i < te.targets.size(); i ++)
+                    {
+                        m_asm.mov_imm(RCX, r.enum_repr == TypeLayout::Enum::Value ? enm.get_value(i) : i);
+                        m_asm.cmp();
+                        m_jumps.push_back(::std::make_pair( m_asm.jcc(CC_E), te.targets[i] ));
+                    }
+                    // Invalid tag (C: `abort()`)
+                    m_asm.ud2();
+                    break; }
+                }
+                ),
+            (SwitchValue,
+                if( te.values.is_String() )
+                    UNSUPPORTED("String switch");
+                load_lvalue(RAX, te.val);
+                for(size_t i = 0; i < te.targets.size(); i ++)
+                {
+                    if( te.values.is_Unsigned() )
+                        m_asm.mov_imm(RCX, te.values.as_Unsigned()[i]);
+                    else
+                        m_asm.mov_imm(RCX, static_cast<uint64_t>(te.values.as_Signed()[i]));
+                    m_asm.cmp();
+                    m_jumps.push_back(::std::make_pair( m_asm.jcc(CC_E), te.targets[i] ));
+                }
+                jump_to(te.def_target);
+                ),
+            (Call,
+                if( const auto* e = te.fcn.opt_Intrinsic() )
+                    lower_intrinsic(te, e->name, e->params);
+                else
+                    lower_call(te);
+                jump_to(te.ret_block);
+                )
+            )
+        }
+
+        ::std::vector<ArgLoc> get_call_locs(const ::MIR::Terminator::Data_Call& te, size_t& out_stack_size) const
+        {
+            ::std::vector<const TypeLayout*>    arg_reprs;
+            for(const auto& a : te.args)
+                arg_reprs.push_back( &get_param_repr(a) );
+            return assign_args(arg_reprs, classify(get_lvalue_repr(te.ret_val)) == PassClass::Memory, out_stack_size);
+        }
+        Mem staging(unsigned idx) const {
+            return Mem { RBP, m_staging_slot + static_cast<int32_t>(8*idx) };
+        }
+        /// Load the argument registers from the staging area, and call
+        void emit_call(unsigned n_regs, const ::std::string* symbol)
+        {
+            for(unsigned i = 0; i < n_regs; i ++)
+                m_asm.load(ARG_REGS[i], staging(i), 8, false);
+            // AL holds the number of vector registers used (for variadic callees)
+            m_asm.xor_eax_eax();
+            if( symbol )
+                m_fixups.push_back(ElfObject::Fixup { m_asm.call(), ElfObject::Fixup::Call, *symbol });
+            else
+                m_asm.call_r10();
+        }
+        void lower_call(const ::MIR::Terminator::Data_Call& te)
+        {
+            const auto& ret_repr = get_lvalue_repr(te.ret_val);
+            auto ret_class = classify(ret_repr);
+            size_t  stack_size;
+            auto locs = get_call_locs(te, stack_size);
+
+            const ::std::string* symbol = nullptr;
+            if( const auto* e = te.fcn.opt_Path() )
+            {
+                // NOTE: Functions not in this list (e.g. constructors, or functions that are `static` in the C code)
+                // can't be called from this object.
+                auto it = m_fcn_symbols.find(*e);
+                if( it == m_fcn_symbols.end() )
+                    UNSUPPORTED("Call to " << *e);
+                symbol = &it->second;
+            }
+
+            // Values for registers are collected in the staging area first (evaluating arguments uses the argument
+            // registers)
+            unsigned    n_regs = 0;
+            if( ret_class == PassClass::Memory )
+            {
+                m_asm.lea(RAX, get_lvalue_mem(te.ret_val));
+                m_asm.store(staging(0), RAX, 8);
+                n_regs = 1;
+            }
+            for(size_t i = 0; i < te.args.size(); i ++)
+            {
+                const auto& loc = locs[i];
+                if( loc.cls == PassClass::None )
+                    continue ;
+                Mem dst;
+                if( loc.reg == ~0u ) {
+                    dst = Mem { RBP, m_outgoing_ofs + static_cast<int32_t>(loc.stack_ofs) };
+                }
+                else {
+                    dst = staging(loc.reg);
+                    n_regs = ::std::max(n_regs, loc.reg + (loc.cls == PassClass::Int2 ? 2 : 1));
+                }
+                write_param(te.args[i], get_param_repr(te.args[i]), [&](){ return dst; }, /*widen=*/true);
+            }
+            if( !symbol )
+                load_lvalue(R10, te.fcn.as_Value());
+            emit_call(n_regs, symbol);
+
+            switch(ret_class)
+            {
+            case PassClass::None:
+            case PassClass::Memory:
+                break;
+            case PassClass::Int1:
+            case PassClass::Int2:
+                if( ret_repr.is_scalar )
+                {
+                    store_lvalue(te.ret_val, ret_repr.size);
+                }
+                else
+                {
+                    m_asm.store(staging(0), RAX, 8);
+                    m_asm.store(staging(1), RDX, 8);
+                    m_asm.lea(RSI, staging(0));
+                    m_asm.lea(RDI, get_lvalue_mem(te.ret_val));
+                    copy_bytes(ret_repr.size);
+                }
+                break;
+            }
+        }
+
+        void lower_intrinsic(const ::MIR::Terminator::Data_Call& te, const ::std::string& name, const ::HIR::PathParams& params)
+        {
+            const auto& ret_repr = get_lvalue_repr(te.ret_val);
+            auto ret_mem = [&](){ return get_lvalue_mem(te.ret_val); };
+            auto type_param = [&]()->const TypeLayout& { return get_repr(params.m_types.at(0)); };
+            /// RAX = args[idx] * size_of::<T>()
+            auto load_scaled = [&](size_t idx) {
+                load_param(RAX, te.args.at(idx));
+                m_asm.mov_imm(RCX, type_param().size);
+                m_asm.imul();
+                };
+            auto libc_call = [&](const char* fcn, ::std::function<void()> load_arg1) {
+                // 0: Destination, 2: Count (in elements)
+                load_param(RAX, te.args.at(0));
+                m_asm.store(staging(0), RAX, 8);
+                load_arg1();
+                m_asm.store(staging(1), RAX, 8);
+                load_scaled(2);
+                m_asm.store(staging(2), RAX, 8);
+                ::std::string   sym = fcn;
+                emit_call(3, &sym);
+                };
+
+            if( name == "size_of" ) {
+                m_asm.mov_imm(RAX, type_param().size);
+                store_lvalue(te.ret_val, ret_repr.size);
+            }
+            else if( name == "min_align_of" || name == "align_of" || name == "pref_align_of" ) {
+                m_asm.mov_imm(RAX, type_param().align);
+                store_lvalue(te.ret_val, ret_repr.size);
+            }
+            else if( name == "needs_drop" ) {
+                m_asm.mov_imm(RAX, m_resolve.type_needs_drop_glue(sp, params.m_types.at(0)) ? 1 : 0);
+                store_lvalue(te.ret_val, ret_repr.size);
+            }
+            else if( name == "forget" || name == "assume" || name == "uninit" ) {
+                // Nothing to do
+            }
+            else if( name == "init" ) {
+                zero_mem(ret_mem(), ret_repr.size);
+            }
+            else if( name == "likely" || name == "unlikely" || name == "transmute" ) {
+                ::HIR::TypeRef  tmp;
+                const auto& src_repr = get_repr(m_mir_res.get_param_type(tmp, te.args.at(0)));
+                if( src_repr.size != ret_repr.size )
+                    UNSUPPORTED("Transmute between different sizes");
+                write_param(te.args.at(0), src_repr, ret_mem);
+            }
+            else if( name == "move_val_init" || name == "volatile_store" ) {
+                write_param(te.args.at(1), type_param(), [&](){ load_param(R11, te.args.at(0)); return Mem { R11, 0 }; });
+            }
+            else if( name == "volatile_load" ) {
+                load_param(RSI, te.args.at(0));
+                m_asm.lea(RDI, ret_mem());
+                copy_bytes(ret_repr.size);
+            }
+            else if( name == "copy_nonoverlapping" || name == "copy" ) {
+                // 0: Source, 1: Destination, 2: Count
+                load_param(RAX, te.args.at(1));
+                m_asm.store(staging(0), RAX, 8);
+                load_param(RAX, te.args.at(0));
+                m_asm.store(staging(1), RAX, 8);
+                load_scaled(2);
+                m_asm.store(staging(2), RAX, 8);
+                ::std::string   sym = (name == "copy" ? "memmove" : "memcpy");
+                emit_call(3, &sym);
+            }
+            else if( name == "write_bytes" ) {
+                // 0: Destination, 1: Value, 2: Count
+                libc_call("memset", [&](){ load_param(RAX, te.args.at(1)); });
+            }
+            else if( name == "offset" || name == "arith_offset" ) {
+                load_scaled(1);
+                load_param(RCX, te.args.at(0));
+                m_asm.add();
+                store_lvalue(te.ret_val, ret_repr.size);
+            }
+            else if( name == "add_with_overflow" || name == "sub_with_overflow" || name == "mul_with_overflow" ) {
+                lower_overflow_op(te, name.substr(0, 3), type_param(), true);
+            }
+            else if( name == "overflowing_add" || name == "overflowing_sub" || name == "overflowing_mul" ) {
+                lower_overflow_op(te, name.substr(name.size() - 3), type_param(), false);
+            }
+            else if( name == "discriminant_value" ) {
+                const auto& r = type_param();
+                load_param(R11, te.args.at(0));
+                switch(r.enum_repr)
+                {
+                case TypeLayout::Enum::None:
+                    m_asm.xor_eax_eax();
+                    break;
+                case TypeLayout::Enum::NonZero:
+                    m_asm.load(RAX, Mem { R11, static_cast<int32_t>(r.tag_ofs) }, 8, false);
+                    m_asm.test_rax();
+                    m_asm.setcc(CC_NE);
+                    break;
+                case TypeLayout::Enum::Value:
+                case TypeLayout::Enum::Data:
+                    m_asm.load(RAX, Mem { R11, 0 }, r.tag_size, false);
+                    break;
+                }
+                store_lvalue(te.ret_val, ret_repr.size);
+            }
+            else if( name == "abort" ) {
+                ::std::string   sym = "abort";
+                emit_call(0, &sym);
+                m_asm.ud2();
+            }
+            else if( name == "unreachable" ) {
+                m_asm.ud2();
+            }
+            else {
+                UNSUPPORTED("Intrinsic " << name);
+            }
+        }
+        /// `{add,sub,mul}_with_overflow` (returning `(T, bool)`) and `overflowing_{add,sub,mul}`
+        void lower_overflow_op(const ::MIR::Terminator::Data_Call& te, const ::std::string& op, const TypeLayout& r, bool report_overflow)
+        {
+            if( !r.is_scalar )
+                UNSUPPORTED("Overflow op on non-scalar");
+            load_param(RAX, te.args.at(0));
+            load_param(RCX, te.args.at(1));
+            if( op == "add" )
+                m_asm.add();
+            else if( op == "sub" )
+                m_asm.sub();
+            else if( r.size == 8 && !r.is_signed )
+                m_asm.mul();
+            else
+                m_asm.imul();
+            if( !report_overflow )
+            {
+                store_lvalue(te.ret_val, r.size);
+                return ;
+            }
+            const auto& ret_repr = get_lvalue_repr(te.ret_val);
+            // NOTE: `mov` and `setcc` leave the flags alone
+            m_asm.mov(RDX, RAX);
+            if( r.size == 8 )
+            {
+                // Carry for unsigned (`mul` sets CF on overflow too), overflow for signed
+                m_asm.setcc(r.is_signed ? CC_O : CC_B);
+                auto m = get_lvalue_mem(te.ret_val);
+                m_asm.store(Mem { m.base, m.ofs + static_cast<int32_t>(ret_repr.fields.at(0)) }, RDX, 8);
+                m_asm.store(Mem { m.base, m.ofs + static_cast<int32_t>(ret_repr.fields.at(1)) }, RAX, 1);
+            }
+            else
+            {
+                // Narrower types are calculated in 64 bits, overflowed if truncating changes the value
+                auto m = get_lvalue_mem(te.ret_val);
+                Mem m_val { m.base, m.ofs + static_cast<int32_t>(ret_repr.fields.at(0)) };
+                m_asm.store(m_val, RDX, r.size);
+                m_asm.load(RCX, m_val, r.size, r.is_signed);
+                m_asm.alu(0x39, RDX, RCX);  // cmp rdx, rcx
+                m_asm.setcc(CC_NE);
+                m_asm.store(Mem { m.base, m.ofs + static_cast<int32_t>(ret_repr.fields.at(1)) }, RAX, 1);
+            }
+        }
+    };
+
+    class CodeGenerator_X64:
+        public CodeGenerator
+    {
+        Span    sp;
+        const ::HIR::Crate& m_crate;
+        ::StaticTraitResolve    m_resolve;
+        LayoutCache m_layouts;
+        /// C backend, used for everything but function bodies (and for the bodies that can't be lowered here)
+        ::std::unique_ptr<CodeGenerator>    m_c;
+
+        ::std::string   m_outfile_path_obj;
+        ElfObject   m_obj;
+        /// Symbols of functions with global linkage (that can be called from the generated code)
+        ::std::map< ::HIR::Path, ::std::string> m_fcn_symbols;
+        /// Symbols of statics and vtables
+        ::std::map< ::HIR::Path, ::std::string> m_static_symbols;
+        unsigned int    m_c_function_count = 0;
+
+    public:
+        CodeGenerator_X64(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt):
+            m_crate(crate),
+            m_resolve(crate),
+            m_layouts(sp, m_resolve),
+            m_c(Trans_Codegen_GetGeneratorC(crate, outfile, opt)),
+            m_outfile_path_obj(outfile + ".x86_64.o")
+        {
+        }
+
+        void finalise(bool is_executable, const TransOptions& opt) override
+        {
+            m_obj.write(m_outfile_path_obj);
+            DEBUG(m_obj.function_count() << " functions lowered, " << m_c_function_count << " emitted as C");
+
+            auto c_opt = opt;
+            c_opt.extra_objects.push_back(m_outfile_path_obj);
+            m_c->finalise(is_executable, c_opt);
+        }
+
+        void emit_type_proto(const ::HIR::TypeRef& ty) override { m_c->emit_type_proto(ty); }
+        void emit_type(const ::HIR::TypeRef& ty) override { m_c->emit_type(ty); }
+        void emit_type_id(const ::HIR::TypeRef& ty) override { m_c->emit_type_id(ty); }
+        void emit_struct(const Span& sp, const ::HIR::GenericPath& p, const ::HIR::Struct& item) override { m_c->emit_struct(sp, p, item); }
+        void emit_union(const Span& sp, const ::HIR::GenericPath& p, const ::HIR::Union& item) override { m_c->emit_union(sp, p, item); }
+        void emit_enum(const Span& sp, const ::HIR::GenericPath& p, const ::HIR::Enum& item) override { m_c->emit_enum(sp, p, item); }
+        void emit_constructor_enum(const Span& sp, const ::HIR::GenericPath& path, const ::HIR::Enum& item, size_t var_idx) override { m_c->emit_constructor_enum(sp, path, item, var_idx); }
+        void emit_constructor_struct(const Span& sp, const ::HIR::GenericPath& path, const ::HIR::Struct& item) override { m_c->emit_constructor_struct(sp, path, item); }
+        void emit_vtable(const ::HIR::Path& p, const ::HIR::Trait& trait) override
+        {
+            m_static_symbols.insert(::std::make_pair( p.clone(), FMT(Trans_Mangle(p)) ));
+            m_c->emit_vtable(p, trait);
+        }
+        void emit_static_ext(const ::HIR::Path& p, const ::HIR::Static& item, const Trans_Params& params) override
+        {
+            m_static_symbols.insert(::std::make_pair( p.clone(), item.m_linkage.name != "" ? item.m_linkage.name : FMT(Trans_Mangle(p)) ));
+            m_c->emit_static_ext(p, item, params);
+        }
+        void emit_static_proto(const ::HIR::Path& p, const ::HIR::Static& item, const Trans_Params& params) override
+        {
+            m_static_symbols.insert(::std::make_pair( p.clone(), FMT(Trans_Mangle(p)) ));
+            m_c->emit_static_proto(p, item, params);
+        }
+        void emit_static_local(const ::HIR::Path& p, const ::HIR::Static& item, const Trans_Params& params) override { m_c->emit_static_local(p, item, params); }
+
+        void emit_function_ext(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params) override
+        {
+            m_fcn_symbols.insert(::std::make_pair( p.clone(), get_symbol(p, item) ));
+            m_c->emit_function_ext(p, item, params);
+        }
+        void emit_function_proto(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params, bool is_extern_def) override
+        {
+            // NOTE: `is_extern_def` functions are local copies emitted by the C code
+            if( !is_extern_def )
+                m_fcn_symbols.insert(::std::make_pair( p.clone(), get_symbol(p, item) ));
+            m_c->emit_function_proto(p, item, params, is_extern_def);
+        }
+        void emit_function_code(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params, bool is_extern_def, const ::MIR::FunctionPointer& code) override
+        {
+            TRACE_FUNCTION_F(p);
+            if( !is_extern_def && !item.m_variadic )
+            {
+                ::MIR::TypeResolve::args_t  arg_types;
+                for(const auto& ent : item.m_args)
+                    arg_types.push_back(::std::make_pair( ::HIR::Pattern{}, params.monomorph(m_resolve, ent.second) ));
+                ::HIR::TypeRef  ret_type_tmp;
+                const auto& ret_type = monomorphise_fcn_return(ret_type_tmp, item, params);
+                ::MIR::TypeResolve  mir_res { sp, m_resolve, FMT_CB(ss, ss << p;), ret_type, arg_types, *code };
+
+                try
+                {
+                    FunctionLowerer lower(sp, m_resolve, mir_res, m_layouts, m_fcn_symbols, m_static_symbols);
+                    lower.lower();
+                    m_obj.add_function(get_symbol(p, item), lower.m_asm.data, lower.m_fixups);
+                    return ;
+                }
+                catch(const Unsupported& e)
+                {
+                    DEBUG("Emitting as C - " << e.reason);
+                }
+            }
+            m_c_function_count ++;
+            m_c->emit_function_code(p, item, params, is_extern_def, code);
+        }
+
+    private:
+        static ::std::string get_symbol(const ::HIR::Path& p, const ::HIR::Function& item)
+        {
+            if( item.m_linkage.name != "" )
+                return item.m_linkage.name;
+            return FMT(Trans_Mangle(p));
+        }
+        const ::HIR::TypeRef& monomorphise_fcn_return(::HIR::TypeRef& tmp, const ::HIR::Function& item, const Trans_Params& params)
+        {
+            if( visit_ty_with(item.m_return, [&](const auto& x){ return x.m_data.is_ErasedType() || x.m_data.is_Generic(); }) )
+            {
+                tmp = clone_ty_with(sp, item.m_return, [&](const auto& tpl, auto& out){
+                    if( const auto* e = tpl.m_data.opt_ErasedType() ) {
+                        out = params.monomorph(m_resolve, item.m_code.m_erased_types.at(e->m_index));
+                        return true;
+                    }
+                    else if( tpl.m_data.is_Generic() ) {
+                        out = params.get_cb()(tpl).clone();
+                        return true;
+                    }
+                    else {
+                        return false;
+                    }
+                    });
+                m_resolve.expand_associated_types(sp, tmp);
+                return tmp;
+            }
+            else
+            {
+                return item.m_return;
+            }
+        }
+    };
+}
+
+::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorX64(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt)
+{
+    const auto& spec = Target_GetCurSpec();
+    if( spec.m_arch.m_name != "x86_64" || spec.m_codegen_mode != CodegenMode::Gnu11 || spec.m_family != "unix" || spec.m_os_name == "macos" )
+    {
+        WARNING(Span(), W0000, "The x86-64 backend only supports x86-64 ELF targets, using the C backend");
+        return Trans_Codegen_GetGeneratorC(crate, outfile, opt);
+    }
+    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_X64(crate, outfile, opt));
+}
@@ -14,7 +14,9 @@
 #include <hir_typeck/common.hpp>    // monomorph
 #include <hir_typeck/static.hpp>    // StaticTraitResolve
 #include <hir/item_path.hpp>
+#include <hir/visitor.hpp>
 #include <deque>
+#include <set>
 #include <algorithm>
 
 namespace {
@@ -27,19 +29,52 @@ namespace {
         ::std::deque<TransList_Function*>  fcn_queue;
         ::std::vector<TransList_Function*> fcns_to_type_visit;
 
+        /// Only emit exported functions (and what they use), the remaining non-generic functions are emitted by
+        /// downstream crates when they're used
+        bool    only_exported = false;
+        /// Non-generic functions that had their code saved for downstream crates
+        ::std::vector<::HIR::Function*> on_demand_fcns;
+        /// All code is emitted by this crate (other crates' objects aren't linked)
+        bool    whole_program = false;
+
         EnumState(const ::HIR::Crate& crate):
             crate(crate)
         {}
 
+        /// Save a non-generic function's code so users of the crate can emit it (as a local copy) when needed
+        void save_on_demand(::HIR::Function& fcn)
+        {
+            if( !fcn.m_save_code )
+            {
+                fcn.m_save_code = true;
+                on_demand_fcns.push_back(&fcn);
+            }
+        }
+
         void enum_fcn(::HIR::Path p, const ::HIR::Function& fcn, Trans_Params pp)
         {
+            // Code from another crate (generic, or saved for on-demand use) might already be in that crate's object
+            bool upstream = !whole_program && fcn.m_code.m_mir && !fcn.m_code.has_body() && is_upstream_instance(p);
             if(auto* e = rv.add_function(mv$(p)))
             {
                 fcns_to_type_visit.push_back(e);
                 e->ptr = &fcn;
                 e->pp = mv$(pp);
-                fcn_queue.push_back(e);
+                e->upstream = upstream;
+                // No need to enumerate the body if it's not emitted
+                if( !upstream )
+                    fcn_queue.push_back(e);
+            }
+        }
+
+        bool is_upstream_instance(const ::HIR::Path& p) const
+        {
+            for(const auto& ec : crate.m_ext_crates)
+            {
+                if( ec.second.m_data->m_exported_instances.count(p) )
+                    return true;
             }
+            return false;
         }
     };
 }
@@ -54,11 +89,12 @@ void Trans_Enumerate_FillFrom_Literal(EnumState& state, const ::HIR::Literal& li
 void Trans_Enumerate_FillFrom_MIR(EnumState& state, const ::MIR::Function& code, const Trans_Params& pp);
 
 /// Enumerate trans items starting from `::main` (binary crate)
-TransList Trans_Enumerate_Main(const ::HIR::Crate& crate)
+TransList Trans_Enumerate_Main(const ::HIR::Crate& crate, bool whole_program)
 {
     static Span sp;
 
     EnumState   state { crate };
+    state.whole_program = whole_program;
 
     auto c_start_path = crate.get_lang_item_path_opt("mrustc-start");
     if( c_start_path == ::HIR::SimplePath() )
@@ -91,6 +127,13 @@ TransList Trans_Enumerate_Main(const ::HIR::Crate& crate)
 }
 
 namespace {
+    /// Returns true if a non-generic function has to be emitted by its own crate (when only emitting exported items)
+    bool is_export_root(const ::HIR::Function& fcn, bool is_public)
+    {
+        // Functions referenced by symbol name (`#[no_mangle]`, foreign ABIs) must exist exactly once
+        return is_public || fcn.m_linkage.name != "" || fcn.m_abi != ABI_RUST;
+    }
+
     void Trans_Enumerate_Public_Mod(EnumState& state, ::HIR::Module& mod, ::HIR::SimplePath mod_path, bool is_visible)
     {
         // TODO: Make this configurable, and debug cases where it breaks
@@ -127,7 +170,14 @@ namespace {
             (Function,
                 if( e.m_params.m_types.size() == 0 )
                 {
-                    if( EMIT_ALL || (is_visible && vi.second->is_public) ) {
+                    if( state.only_exported ) {
+                        // NOTE: Re-exports don't matter here, anything not emitted has its code saved
+                        if( is_export_root(e, is_visible && vi.second->is_public) )
+                            state.enum_fcn(mod_path + vi.first, e, {});
+                        else
+                            state.save_on_demand(const_cast<::HIR::Function&>(e));
+                    }
+                    else if( EMIT_ALL || (is_visible && vi.second->is_public) ) {
                         state.enum_fcn(mod_path + vi.first, e, {});
                     }
                 }
@@ -151,10 +201,13 @@ namespace {
 }
 
 /// Enumerate trans items for all public non-generic items (library crate)
-TransList Trans_Enumerate_Public(::HIR::Crate& crate)
+/// - If `only_exported` is set, only exported functions (and the items they use) are emitted, other non-generic
+///   functions are left for downstream crates to emit on demand.
+TransList Trans_Enumerate_Public(::HIR::Crate& crate, bool only_exported)
 {
     static Span sp;
     EnumState   state { crate };
+    state.only_exported = only_exported;
 
     Trans_Enumerate_Public_Mod(state, crate.m_root_module,  ::HIR::SimplePath(crate.m_crate_name,{}), true);
 
@@ -182,6 +235,13 @@ TransList Trans_Enumerate_Public(::HIR::Crate& crate)
                 // VTable, magic
                 else if( vi.first == "#vtable" )
                     ;
+                // Trait methods are only reachable through the trait, leave them to the users of the impl
+                else if( state.only_exported && vi.second.is_Function() )
+                {
+                    auto it = impl.second.m_methods.find(vi.first);
+                    if( it != impl.second.m_methods.end() )
+                        state.save_on_demand(it->second.data);
+                }
                 else
                 {
                     // Check bounds before queueing for codegen
@@ -237,6 +297,11 @@ TransList Trans_Enumerate_Public(::HIR::Crate& crate)
             {
                 if( fcn.second.data.m_params.m_types.size() == 0 )
                 {
+                    if( state.only_exported && !is_export_root(fcn.second.data, fcn.second.is_pub) )
+                    {
+                        state.save_on_demand(fcn.second.data);
+                        continue ;
+                    }
                     auto p = ::HIR::Path(impl.m_type.clone(), fcn.first);
                     Trans_Enumerate_FillFrom_Path(state, p, {});
                 }
@@ -257,6 +322,26 @@ TransList Trans_Enumerate_Public(::HIR::Crate& crate)
 
     auto rv = Trans_Enumerate_CommonPost(state);
 
+    // Saved functions that ended up being emitted anyway (used by an exported item) don't need to be copied
+    if( !state.on_demand_fcns.empty() )
+    {
+        ::std::set<const ::HIR::Function*>  emitted;
+        for(const auto& ent : rv.m_functions)
+        {
+            if( ent.second->ptr && !ent.second->pp.has_types() )
+                emitted.insert(ent.second->ptr);
+        }
+        size_t  n_saved = 0;
+        for(auto* fcn : state.on_demand_fcns)
+        {
+            if( emitted.count(fcn) )
+                fcn->m_save_code = false;
+            else
+                n_saved ++;
+        }
+        DEBUG(n_saved << " functions left for on-demand emission");
+    }
+
     struct H
     {
         static bool is_generic(const ::HIR::TypeRef& ty)
@@ -318,10 +403,47 @@ TransList Trans_Enumerate_Public(::HIR::Crate& crate)
             ++ it;
         }
     }
+
+    // Record the instances of saved code that this crate emits, so downstream crates can use them instead of making
+    // their own copies
+    for(const auto& ent : rv.m_functions)
+    {
+        const auto* fcn = ent.second->ptr;
+        if( fcn && fcn->m_code.has_body() && fcn->m_code.m_mir && fcn->m_save_code )
+            crate.m_exported_instances.insert( ent.first.clone() );
+    }
+    DEBUG(crate.m_exported_instances.size() << " exported instances");
     return rv;
 }
 
 
+namespace {
+    class SavedCodeLoader:
+        public ::HIR::Visitor
+    {
+    public:
+        void visit_function(::HIR::ItemPath p, ::HIR::Function& item) override
+        {
+            if( !item.m_code.m_mir && item.m_interp_mir )
+                item.m_code.m_mir = mv$(item.m_interp_mir);
+        }
+        void visit_static(::HIR::ItemPath p, ::HIR::Static& item) override
+        {
+            if( item.m_value_res.is_Invalid() && !item.m_interp_value.is_Invalid() )
+                item.m_value_res = mv$(item.m_interp_value);
+        }
+    };
+}
+
+/// Make code saved by `-Z save-all-mir` available to codegen (for whole-program builds)
+void Trans_Enumerate_LoadSavedCode(::HIR::Crate& crate)
+{
+    for(auto& ec : crate.m_ext_crates)
+    {
+        SavedCodeLoader().visit_crate(*ec.second.m_data);
+    }
+}
+
 /// Common post-processing
 void Trans_Enumerate_CommonPost_Run(EnumState& state)
 {
@@ -626,7 +748,7 @@ void Trans_Enumerate_Types(EnumState& state)
             for(const auto& arg : fcn.m_args)
                 tv.visit_type( monomorph(arg.second) );
 
-            if( fcn.m_code.m_mir )
+            if( fcn.m_code.m_mir && !p->upstream )
             {
                 const auto& mir = *fcn.m_code.m_mir;
                 for(const auto& ty : mir.locals)
@@ -636,7 +758,7 @@ void Trans_Enumerate_Types(EnumState& state)
                 for(const auto& block : mir.blocks)
                 {
                     struct H {
-                        static const ::HIR::TypeRef& visit_lvalue(TypeVisitor& tv, const Trans_Params& pp, const ::HIR::Function& fcn, const ::MIR::LValue& lv, ::HIR::TypeRef* tmp_ty_ptr = nullptr) {
+                        static const ::HIR::TypeRef& visit_lvalue(TypeVisitor& tv, const Trans_Params& pp, const ::HIR::Function& fcn, const ::MIR::LValue::CRef& lv, ::HIR::TypeRef* tmp_ty_ptr = nullptr) {
                             static ::HIR::TypeRef   blank;
                             TRACE_FUNCTION_F(lv << (tmp_ty_ptr ? " [type]" : ""));
                             auto monomorph_outer = [&](const auto& tpl)->const auto& {
@@ -649,45 +771,54 @@ void Trans_Enumerate_Types(EnumState& state)
                                 }
                                 };
                             // Recurse, if Deref get the type and add it to the visitor
-                            TU_MATCHA( (lv), (e),
-                            (Return,
-                                if( tmp_ty_ptr ) {
-                                    TODO(Span(), "Get return type for MIR type enumeration");
-                                }
-                                ),
-                            (Argument,
-                                if( tmp_ty_ptr ) {
-                                    return monomorph_outer(fcn.m_args[e.idx].second);
-                                }
-                                ),
-                            (Local,
-                                if( tmp_ty_ptr ) {
-                                    return monomorph_outer(fcn.m_code.m_mir->locals[e]);
-                                }
-                                ),
-                            (Static,
-                                if( tmp_ty_ptr ) {
-                                    const auto& path = e;
-                                    TU_MATCHA( (path.m_data), (pe),
-                                    (Generic,
-                                        ASSERT_BUG(Span(), pe.m_params.m_types.empty(), "Path params on static - " << path);
-                                        const auto& s = tv.m_resolve.m_crate.get_static_by_path(Span(), pe.m_path);
-                                        return s.m_type;
-                                        ),
-                                    (UfcsKnown,
-                                        TODO(Span(), "LValue::Static - UfcsKnown - " << path);
-                                        ),
-                                    (UfcsUnknown,
-                                        BUG(Span(), "Encountered UfcsUnknown in LValue::Static - " << path);
-                                        ),
-                                    (UfcsInherent,
-                                        TODO(Span(), "LValue::Static - UfcsInherent - " << path);
+                            if( !lv.outer_wrapper() )
+                            {
+                                TU_MATCHA( (lv.root()), (e),
+                                (Return,
+                                    if( tmp_ty_ptr ) {
+                                        TODO(Span(), "Get return type for MIR type enumeration");
+                                    }
+                                    ),
+                                (Argument,
+                                    if( tmp_ty_ptr ) {
+                                        return monomorph_outer(fcn.m_args[e.idx].second);
+                                    }
+                                    ),
+                                (Local,
+                                    if( tmp_ty_ptr ) {
+                                        return monomorph_outer(fcn.m_code.m_mir->locals[e]);
+                                    }
+                                    ),
+                                (Static,
+                                    if( tmp_ty_ptr ) {
+                                        const auto& path = *e;
+                                        TU_MATCHA( (path.m_data), (pe),
+                                        (Generic,
+                                            ASSERT_BUG(Span(), pe.m_params.m_types.empty(), "Path params on static - " << path);
+                                            const auto& s = tv.m_resolve.m_crate.get_static_by_path(Span(), pe.m_path);
+                                            return s.m_type;
+                                            ),
+                                        (UfcsKnown,
+                                            TODO(Span(), "LValue::Static - UfcsKnown - " << path);
+                                            ),
+                                        (UfcsUnknown,
+                                            BUG(Span(), "Encountered UfcsUnknown in LValue::Static - " << path);
+                                            ),
+                                        (UfcsInherent,
+                                            TODO(Span(), "LValue::Static - UfcsInherent - " << path);
+                                            )
                                         )
+                                    }
                                     )
-                                }
-                                ),
-                            (Field,
-                                const auto& ity = visit_lvalue(tv,pp,fcn,  *e.val, tmp_ty_ptr);
+                                )
+                                return blank;
+                            }
+                            const auto inner = lv.inner_ref();
+                            switch(lv.outer_wrapper()->tag())
+                            {
+                            case ::MIR::LValue::Wrapper::TAG_Field: {
+                                const auto field_index = lv.outer_wrapper()->as_Field();
+                                const auto& ity = visit_lvalue(tv,pp,fcn,  inner, tmp_ty_ptr);
                                 if( tmp_ty_ptr )
                                 {
                                     TU_MATCH_DEF(::HIR::TypeRef::Data, (ity.m_data), (te),
@@ -695,7 +826,7 @@ void Trans_Enumerate_Types(EnumState& state)
                                         BUG(Span(), "Field access of unexpected type - " << ity);
                                         ),
                                     (Tuple,
-                                        return te[e.field_index];
+                                        return te[field_index];
                                         ),
                                     (Array,
                                         return *te.inner;
@@ -721,23 +852,23 @@ void Trans_Enumerate_Types(EnumState& state)
                                             BUG(Span(), "Field on unit-like struct - " << ity);
                                             ),
                                         (Tuple,
-                                            ASSERT_BUG(Span(), e.field_index < se.size(), "Field index out of range in struct " << te.path);
-                                            return monomorph(se.at(e.field_index).ent);
+                                            ASSERT_BUG(Span(), field_index < se.size(), "Field index out of range in struct " << te.path);
+                                            return monomorph(se.at(field_index).ent);
                                             ),
                                         (Named,
-                                            ASSERT_BUG(Span(), e.field_index < se.size(), "Field index out of range in struct " << te.path);
-                                            return monomorph(se.at(e.field_index).second.ent);
+                                            ASSERT_BUG(Span(), field_index < se.size(), "Field index out of range in struct " << te.path);
+                                            return monomorph(se.at(field_index).second.ent);
                                             )
                                         )
                                         )
                                     )
                                 }
-                                ),
-                            (Deref,
+                                } break;
+                            case ::MIR::LValue::Wrapper::TAG_Deref: {
                                 ::HIR::TypeRef  tmp;
                                 if( !tmp_ty_ptr )   tmp_ty_ptr = &tmp;
 
-                                const auto& ity = visit_lvalue(tv,pp,fcn,  *e.val, tmp_ty_ptr);
+                                const auto& ity = visit_lvalue(tv,pp,fcn,  inner, tmp_ty_ptr);
                                 TU_MATCH_DEF(::HIR::TypeRef::Data, (ity.m_data), (te),
                                 (
                                     BUG(Span(), "Deref of unexpected type - " << ity);
@@ -764,10 +895,10 @@ void Trans_Enumerate_Types(EnumState& state)
                                     return *te.inner;
                                     )
                                 )
-                                ),
-                            (Index,
-                                visit_lvalue(tv,pp,fcn,  *e.idx, tmp_ty_ptr);
-                                const auto& ity = visit_lvalue(tv,pp,fcn,  *e.val, tmp_ty_ptr);
+                                } break;
+                            case ::MIR::LValue::Wrapper::TAG_Index: {
+                                // NOTE: The index is always a local, and local types are visited above
+                                const auto& ity = visit_lvalue(tv,pp,fcn,  inner, tmp_ty_ptr);
                                 if( tmp_ty_ptr )
                                 {
                                     TU_MATCH_DEF(::HIR::TypeRef::Data, (ity.m_data), (te),
@@ -782,9 +913,10 @@ void Trans_Enumerate_Types(EnumState& state)
                                         )
                                     )
                                 }
-                                ),
-                            (Downcast,
-                                const auto& ity = visit_lvalue(tv,pp,fcn,  *e.val, tmp_ty_ptr);
+                                } break;
+                            case ::MIR::LValue::Wrapper::TAG_Downcast: {
+                                const auto variant_index = lv.outer_wrapper()->as_Downcast();
+                                const auto& ity = visit_lvalue(tv,pp,fcn,  inner, tmp_ty_ptr);
                                 if( tmp_ty_ptr )
                                 {
                                     TU_MATCH_DEF( ::HIR::TypeRef::Data, (ity.m_data), (te),
@@ -802,8 +934,8 @@ void Trans_Enumerate_Types(EnumState& state)
                                                 };
                                             ASSERT_BUG(Span(), enm.m_data.is_Data(), "");
                                             const auto& variants = enm.m_data.as_Data();
-                                            ASSERT_BUG(Span(), e.variant_index < variants.size(), "Variant index out of range");
-                                            const auto& raw_ty = variants[e.variant_index].type;
+                                            ASSERT_BUG(Span(), variant_index < variants.size(), "Variant index out of range");
+                                            const auto& raw_ty = variants[variant_index].type;
                                             if( monomorphise_type_needed(raw_ty) ) {
                                                 return *tmp_ty_ptr = monomorph(raw_ty);
                                             }
@@ -814,8 +946,8 @@ void Trans_Enumerate_Types(EnumState& state)
                                         else
                                         {
                                             const auto& unm = *te.binding.as_Union();
-                                            ASSERT_BUG(Span(), e.variant_index < unm.m_variants.size(), "Variant index out of range");
-                                            const auto& variant = unm.m_variants[e.variant_index];
+                                            ASSERT_BUG(Span(), variant_index < unm.m_variants.size(), "Variant index out of range");
+                                            const auto& variant = unm.m_variants[variant_index];
                                             const auto& var_ty = variant.second.ent;
 
                                             if( monomorphise_type_needed(var_ty) ) {
@@ -830,8 +962,8 @@ void Trans_Enumerate_Types(EnumState& state)
                                         )
                                     )
                                 }
-                                )
-                            )
+                                } break;
+                            }
                             return blank;
                         }
 
@@ -1262,30 +1394,65 @@ namespace {
     }
 }
 
-void Trans_Enumerate_FillFrom_Path(EnumState& state, const ::HIR::Path& path, const Trans_Params& pp)
+namespace {
+    /// Parameters used to monomorphise the body of the item pointed to by a (monomorphised) path
+    Trans_Params get_path_params(const Span& sp, const ::HIR::Path& path_mono)
+    {
+        Trans_Params  sub_pp(sp);
+        TU_MATCHA( (path_mono.m_data), (pe),
+        (Generic,
+            sub_pp.pp_method = pe.m_params.clone();
+            ),
+        (UfcsKnown,
+            sub_pp.pp_method = pe.params.clone();
+            sub_pp.self_type = pe.type->clone();
+            ),
+        (UfcsInherent,
+            sub_pp.pp_method = pe.params.clone();
+            sub_pp.pp_impl = pe.impl_params.clone();
+            sub_pp.self_type = pe.type->clone();
+            ),
+        (UfcsUnknown,
+            BUG(sp, "UfcsUnknown - " << path_mono);
+            )
+        )
+        return sub_pp;
+    }
+}
+
+Trans_ResolvedItem Trans_ResolveItem(const ::HIR::Crate& crate, const ::HIR::Path& path)
 {
     TRACE_FUNCTION_F(path);
     Span    sp;
-    auto path_mono = pp.monomorph(state.crate, path);
-    DEBUG("- " << path_mono);
-    Trans_Params  sub_pp(sp);
-    TU_MATCHA( (path_mono.m_data), (pe),
-    (Generic,
-        sub_pp.pp_method = pe.m_params.clone();
+    Trans_ResolvedItem  rv;
+    rv.pp = get_path_params(sp, path);
+    auto item_ref = get_ent_fullpath(sp, crate, path, rv.pp.pp_impl);
+    TU_MATCHA( (item_ref), (e),
+    (NotFound,
+        ),
+    (AutoGenerate,
+        rv.auto_generate = true;
         ),
-    (UfcsKnown,
-        sub_pp.pp_method = pe.params.clone();
-        sub_pp.self_type = pe.type->clone();
+    (Function,
+        rv.fcn = e;
         ),
-    (UfcsInherent,
-        sub_pp.pp_method = pe.params.clone();
-        sub_pp.pp_impl = pe.impl_params.clone();
-        sub_pp.self_type = pe.type->clone();
+    (Static,
+        rv.stat = e;
         ),
-    (UfcsUnknown,
-        BUG(sp, "UfcsUnknown - " << path);
+    (Constant,
+        rv.constant = e;
         )
     )
+    return rv;
+}
+
+void Trans_Enumerate_FillFrom_Path(EnumState& state, const ::HIR::Path& path, const Trans_Params& pp)
+{
+    TRACE_FUNCTION_F(path);
+    Span    sp;
+    auto path_mono = pp.monomorph(state.crate, path);
+    DEBUG("- " << path_mono);
+    Trans_Params  sub_pp = get_path_params(sp, path_mono);
     // Get the item type
     // - Valid types are Function and Static
     auto item_ref = get_ent_fullpath(sp, state.crate, path_mono, sub_pp.pp_impl);
@@ -1341,30 +1508,10 @@ void Trans_Enumerate_FillFrom_Path(EnumState& state, const ::HIR::Path& path, co
 }
 void Trans_Enumerate_FillFrom_MIR_LValue(EnumState& state, const ::MIR::LValue& lv, const Trans_Params& pp)
 {
-    TU_MATCHA( (lv), (e),
-    (Return,
-        ),
-    (Argument,
-        ),
-    (Local,
-        ),
-    (Static,
-        Trans_Enumerate_FillFrom_Path(state, e, pp);
-        ),
-    (Field,
-        Trans_Enumerate_FillFrom_MIR_LValue(state, *e.val, pp);
-        ),
-    (Deref,
-        Trans_Enumerate_FillFrom_MIR_LValue(state, *e.val, pp);
-        ),
-    (Index,
-        Trans_Enumerate_FillFrom_MIR_LValue(state, *e.val, pp);
-        Trans_Enumerate_FillFrom_MIR_LValue(state, *e.idx, pp);
-        ),
-    (Downcast,
-        Trans_Enumerate_FillFrom_MIR_LValue(state, *e.val, pp);
-        )
-    )
+    if( lv.m_root.is_Static() )
+    {
+        Trans_Enumerate_FillFrom_Path(state, *lv.m_root.as_Static(), pp);
+    }
 }
 void Trans_Enumerate_FillFrom_MIR_Constant(EnumState& state, const ::MIR::Constant& c, const Trans_Params& pp)
 {
@@ -1548,6 +1695,11 @@ void Trans_Enumerate_FillFrom_Literal(EnumState& state, const ::HIR::Literal& li
         Trans_Enumerate_FillFrom_Literal(state, *e, pp);
         ),
     (String,
+        ),
+    (Repeat,
+        Trans_Enumerate_FillFrom_Literal(state, *e.val, pp);
+        ),
+    (Buffer,
         )
     )
 }
@@ -1610,6 +1762,10 @@ void Trans_Enumerate_FillFrom(EnumState& state, const ::HIR::Function& function,
                 state.enum_fcn( ::HIR::Path(mv$(path)), *f, Trans_Params(pp.sp) );
             }
         }
+        else if( state.whole_program && function.m_abi == ABI_RUST )
+        {
+            ERROR(pp.sp, E0000, "Function has no MIR - whole-program builds need dependencies built with `-Z save-all-mir`");
+        }
         // External.
     }
 }
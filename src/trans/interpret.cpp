@@ -0,0 +1,2139 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/interpret.cpp
+ * - MIR interpreter (runs a crate's `main` without generating code)
+ *
+ * Values are stored in host memory, using a simple layout (fields in declaration order, enums always tagged), so
+ * pointers are real host pointers and can be passed directly to the small set of shimmed libc functions (which can
+ *   only take and return integers/pointers).
+ * - `main` is called directly, std's runtime setup (`start`) isn't run.
+ * - Function pointers are the address of the interpreter's `FunctionInfo` for the function.
+ * - Unwinding isn't supported, a panic that starts unwinding ends the program with status 101 (like an uncaught
+ *   panic in a compiled program).
+ * - Anything else that can't be interpreted ends the program with `INTERPRET_UNSUPPORTED_STATUS`, so callers can tell
+ *   it apart from the program itself failing (and compile it instead).
+ */
+#include "main_bindings.hpp"
+#include "trans_list.hpp"
+#include "monomorphise.hpp"
+#include <hir/hir.hpp>
+#include <hir_typeck/static.hpp>
+#include <mir/mir.hpp>
+#include <mir/helpers.hpp>
+#include <mir/operations.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#ifndef _WIN32
+# include <unistd.h>
+# include <fcntl.h>
+# include <signal.h>
+# include <pthread.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+namespace {
+    typedef ::std::vector< ::std::pair< ::HIR::Pattern, ::HIR::TypeRef> >   args_t;
+
+    /// Thrown when the program needs something that the interpreter can't do (it might work when compiled)
+    struct Unsupported {
+        ::std::string   msg;
+    };
+    #define UNSUPPORTED(sp, msg)    throw Unsupported { FMT((sp) << " error: " << msg) }
+    /// Thrown when the program panics
+    struct Panicked {};
+
+#ifndef _WIN32
+    // Fixed-arity versions of variadic libc functions (the interpreter can't make variadic calls)
+    int shim_open(const char* path, int flags, unsigned int mode) { return ::open(path, flags, mode); }
+    int shim_fcntl(int fd, int cmd, uintptr_t arg) { return ::fcntl(fd, cmd, arg); }
+#endif
+#ifdef __linux__
+    int shim_open64(const char* path, int flags, unsigned int mode) { return ::open64(path, flags, mode); }
+}
+// The `strerror_r` used by Rust's `libc` crate (not declared when `_GNU_SOURCE` is set)
+extern "C" int __xpg_strerror_r(int errnum, char* buf, size_t buflen);
+namespace {
+#endif
+
+    /// Functions that can be called by interpreted code (through `extern` blocks)
+    /// - All are called through `ffi_fcn_t`, so can only take and return integers/pointers
+    struct FfiShim {
+        const char* name;
+        void*   ptr;
+        /// Set for the fixed-arity wrappers of variadic functions
+        bool    is_varargs_wrapper;
+    };
+    #define SHIM(name)  { #name, reinterpret_cast<void*>(&::name), false }
+    #define SHIM_VA(name)  { #name, reinterpret_cast<void*>(&shim_##name), true }
+    const FfiShim FFI_SHIMS[] = {
+        SHIM(malloc), SHIM(calloc), SHIM(realloc), SHIM(free),
+        SHIM(memcpy), SHIM(memmove), SHIM(memset), SHIM(memcmp),
+        SHIM(strlen), SHIM(strcmp), SHIM(strncmp),
+        SHIM(abort), SHIM(exit), SHIM(getenv),
+        SHIM(putchar), SHIM(puts),
+#ifndef _WIN32
+        SHIM(read), SHIM(write), SHIM(close), SHIM(isatty), SHIM(lseek), SHIM(unlink), SHIM(mkdir), SHIM(rmdir),
+        SHIM_VA(open), SHIM_VA(fcntl),
+        SHIM(getcwd), SHIM(chdir), SHIM(getpid), SHIM(setenv), SHIM(unsetenv), SHIM(strerror), SHIM(strerror_r),
+        SHIM(posix_memalign),
+        // Used by std's runtime setup and locks
+        SHIM(signal), SHIM(sigaction), SHIM(sigaltstack), SHIM(sysconf), SHIM(mmap), SHIM(munmap), SHIM(mprotect),
+        SHIM(pthread_self), SHIM(pthread_attr_init), SHIM(pthread_attr_destroy), SHIM(pthread_attr_getstack), SHIM(pthread_attr_getguardsize),
+        SHIM(pthread_mutex_init), SHIM(pthread_mutex_lock), SHIM(pthread_mutex_trylock), SHIM(pthread_mutex_unlock), SHIM(pthread_mutex_destroy),
+        SHIM(pthread_mutexattr_init), SHIM(pthread_mutexattr_settype), SHIM(pthread_mutexattr_destroy),
+        SHIM(pthread_cond_init), SHIM(pthread_cond_wait), SHIM(pthread_cond_signal), SHIM(pthread_cond_broadcast), SHIM(pthread_cond_destroy),
+        SHIM(pthread_condattr_init), SHIM(pthread_condattr_setclock), SHIM(pthread_condattr_destroy),
+        SHIM(pthread_rwlock_rdlock), SHIM(pthread_rwlock_wrlock), SHIM(pthread_rwlock_unlock), SHIM(pthread_rwlock_destroy),
+        SHIM(pthread_key_create), SHIM(pthread_key_delete), SHIM(pthread_getspecific), SHIM(pthread_setspecific),
+#endif
+#ifdef __linux__
+        SHIM(__errno_location), SHIM(pthread_getattr_np), SHIM(__xpg_strerror_r),
+        SHIM_VA(open64), SHIM(lseek64),
+#endif
+    };
+    #undef SHIM_VA
+    #undef SHIM
+    typedef uint64_t (*ffi_fcn_t)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+    size_t align_up(size_t v, size_t a) {
+        return (v + a - 1) / a * a;
+    }
+    uint64_t read_uint(const uint8_t* p, size_t size) {
+        switch(size)
+        {
+        case 0: return 0;
+        case 1: return *p;
+        case 2: { uint16_t v; memcpy(&v, p, 2); return v; }
+        case 4: { uint32_t v; memcpy(&v, p, 4); return v; }
+        case 8: { uint64_t v; memcpy(&v, p, 8); return v; }
+        }
+        BUG(Span(), "Unsupported integer size " << size);
+    }
+    void write_uint(uint8_t* p, size_t size, uint64_t v) {
+        switch(size)
+        {
+        case 0: return;
+        case 1: *p = static_cast<uint8_t>(v); return;
+        case 2: { auto v2 = static_cast<uint16_t>(v); memcpy(p, &v2, 2); return; }
+        case 4: { auto v2 = static_cast<uint32_t>(v); memcpy(p, &v2, 4); return; }
+        case 8: memcpy(p, &v, 8); return;
+        }
+        BUG(Span(), "Unsupported integer size " << size);
+    }
+    /// Sign-extend the low `size` bytes of `v`
+    int64_t sext(uint64_t v, size_t size) {
+        if( size >= 8 )
+            return static_cast<int64_t>(v);
+        unsigned shift = 64 - size * 8;
+        return static_cast<int64_t>(v << shift) >> shift;
+    }
+    uint64_t mask(size_t size) {
+        return size >= 8 ? ~0ull : (1ull << (size * 8)) - 1;
+    }
+    uint8_t* read_ptr(const uint8_t* p) {
+        uint8_t* rv;
+        memcpy(&rv, p, sizeof(rv));
+        return rv;
+    }
+    void write_ptr(uint8_t* p, const void* v) {
+        memcpy(p, &v, sizeof(v));
+    }
+
+    size_t core_size(::HIR::CoreType ct) {
+        switch(ct)
+        {
+        case ::HIR::CoreType::Bool:
+        case ::HIR::CoreType::U8:
+        case ::HIR::CoreType::I8:
+            return 1;
+        case ::HIR::CoreType::U16:
+        case ::HIR::CoreType::I16:
+            return 2;
+        case ::HIR::CoreType::U32:
+        case ::HIR::CoreType::I32:
+        case ::HIR::CoreType::Char:
+        case ::HIR::CoreType::F32:
+            return 4;
+        case ::HIR::CoreType::U64:
+        case ::HIR::CoreType::I64:
+        case ::HIR::CoreType::Usize:
+        case ::HIR::CoreType::Isize:
+        case ::HIR::CoreType::F64:
+            return 8;
+        case ::HIR::CoreType::U128:
+        case ::HIR::CoreType::I128:
+            return 16;
+        case ::HIR::CoreType::Str:
+            return 0;
+        }
+        throw "";
+    }
+    bool core_is_signed(::HIR::CoreType ct) {
+        switch(ct)
+        {
+        case ::HIR::CoreType::I8:
+        case ::HIR::CoreType::I16:
+        case ::HIR::CoreType::I32:
+        case ::HIR::CoreType::I64:
+        case ::HIR::CoreType::I128:
+        case ::HIR::CoreType::Isize:
+            return true;
+        default:
+            return false;
+        }
+    }
+    bool core_is_float(::HIR::CoreType ct) {
+        return ct == ::HIR::CoreType::F32 || ct == ::HIR::CoreType::F64;
+    }
+    double read_float(const uint8_t* p, ::HIR::CoreType ct) {
+        if( ct == ::HIR::CoreType::F32 ) {
+            float v; memcpy(&v, p, 4); return v;
+        }
+        else {
+            double v; memcpy(&v, p, 8); return v;
+        }
+    }
+    void write_float(uint8_t* p, ::HIR::CoreType ct, double v) {
+        if( ct == ::HIR::CoreType::F32 ) {
+            float v2 = static_cast<float>(v); memcpy(p, &v2, 4);
+        }
+        else {
+            memcpy(p, &v, 8);
+        }
+    }
+
+    /// Host memory layout of a monomorphised type
+    struct TypeLayout
+    {
+        struct Field {
+            size_t  offset;
+            ::HIR::TypeRef  ty;
+        };
+        size_t  size = 0;
+        size_t  align = 1;
+        /// Struct/tuple fields (union variants are all at offset zero)
+        ::std::vector<Field>    fields;
+
+        /// Size of the enum tag (stored at offset zero), zero if this isn't an enum
+        size_t  tag_size = 0;
+        /// Tag value of each variant
+        ::std::vector<uint64_t> tags;
+        /// Data of each variant (data enums only)
+        ::std::vector<Field>    variants;
+    };
+    /// Kind of metadata carried by pointers to a type
+    enum class MetaKind {
+        None,
+        Length,
+        VTable,
+    };
+
+    struct FunctionInfo
+    {
+        enum class Kind {
+            Unresolved,
+            /// Function with a MIR body
+            Mir,
+            /// `extern` function, called through the shim table
+            Extern,
+            /// `extern "rust-intrinsic"` function used by path
+            Intrinsic,
+            /// Tuple struct or tuple variant constructor
+            Constructor,
+            /// `<fn(...) as Fn*>::call*`
+            FnPtrCall,
+            /// Drop glue for `ty` (referenced by vtables)
+            DropGlue,
+        };
+        Kind    kind = Kind::Unresolved;
+        ::HIR::Path path;
+        Span    sp;
+        ::HIR::TypeRef  ret_type;
+        args_t  args;
+
+        // Mir
+        ::MIR::FunctionPointer  mono_mir;
+        const ::MIR::Function*  mir = nullptr;
+        ::std::unique_ptr< ::MIR::TypeResolve>  mir_res;
+        size_t  frame_size = 0;
+        ::std::vector<size_t>   arg_offsets;
+        ::std::vector<size_t>   local_offsets;
+
+        // Extern
+        ::std::string   link_name;
+        ffi_fcn_t   ffi_ptr = nullptr;
+        bool    is_variadic = false;
+        /// The shim is a fixed-arity wrapper (so variadic calls can be made)
+        bool    ffi_accepts_varargs = false;
+
+        // Intrinsic
+        ::std::string   intrinsic_name;
+        ::HIR::PathParams   intrinsic_params;
+
+        // Constructor/DropGlue
+        ::HIR::TypeRef  ty;
+        unsigned int    variant_idx = ~0u;
+
+        // FnPtrCall
+        bool    is_call_once = false;
+
+        FunctionInfo(::HIR::Path p):
+            path( mv$(p) )
+        {}
+    };
+
+    /// Storage for a running MIR function
+    struct Frame
+    {
+        FunctionInfo&   fi;
+        ::std::vector<uint64_t> storage;
+        ::std::vector<bool> drop_flags;
+
+        Frame(FunctionInfo& fi):
+            fi(fi),
+            storage( (fi.frame_size + 7) / 8 ),
+            drop_flags( fi.mir->drop_flags )
+        {}
+        uint8_t* base() { return reinterpret_cast<uint8_t*>(storage.data()); }
+    };
+    /// Location of a MIR lvalue
+    struct Place
+    {
+        uint8_t*    ptr;
+        const ::HIR::TypeRef*   ty;
+        /// Pointer metadata (length or vtable) for unsized places
+        uint64_t    meta;
+    };
+    /// Value of a MIR param (either read in-place, or a constant stored in `storage`)
+    struct ParamValue
+    {
+        const uint8_t*  ptr = nullptr;
+        const ::HIR::TypeRef*   ty = nullptr;
+        ::std::vector<uint64_t> storage;
+        ::std::unique_ptr< ::HIR::TypeRef>  ty_storage;
+
+        uint8_t* alloc(size_t size, ::HIR::TypeRef t) {
+            storage.resize( (size + 7) / 8 + 1 );
+            ty_storage.reset( new ::HIR::TypeRef(mv$(t)) );
+            ty = &*ty_storage;
+            ptr = reinterpret_cast<const uint8_t*>(storage.data());
+            return reinterpret_cast<uint8_t*>(storage.data());
+        }
+    };
+
+    class Interpreter
+    {
+        const ::HIR::Crate& m_crate;
+        StaticTraitResolve  m_resolve;
+        Span    sp;
+
+        ::std::map< ::HIR::TypeRef, ::std::unique_ptr<TypeLayout> > m_layouts;
+        ::std::map< ::HIR::Path, ::std::unique_ptr<FunctionInfo> >   m_functions;
+        ::std::set<const void*> m_function_addrs;
+        ::std::map< ::HIR::TypeRef, FunctionInfo*>  m_drop_glue;
+        /// Resolved targets of `Call` terminators (the path lookup is comparatively slow)
+        ::std::map<const ::MIR::Terminator::Data_Call*, FunctionInfo*>  m_call_cache;
+
+        struct StaticInfo {
+            uint8_t*    ptr;
+            ::HIR::TypeRef  ty;
+        };
+        ::std::map< ::HIR::Path, ::std::unique_ptr<StaticInfo> >  m_statics;
+        ::std::map< ::HIR::Path, uint8_t*>  m_vtables;
+        ::std::map< ::HIR::TypeRef, uint64_t>   m_type_ids;
+        /// Storage for string constants (set nodes are never moved)
+        ::std::set< ::std::string>  m_strings;
+
+    public:
+        Interpreter(const ::HIR::Crate& crate):
+            m_crate(crate),
+            m_resolve(crate)
+        {}
+
+        int run_main(const ::std::string& program_name);
+
+    private:
+        // --- Types ---
+        const TypeLayout& get_layout(const ::HIR::TypeRef& ty);
+        ::std::unique_ptr<TypeLayout> compute_layout(const ::HIR::TypeRef& ty);
+        void place_fields(TypeLayout& l, ::std::vector< ::HIR::TypeRef> tys, bool packed, size_t offset);
+        ::HIR::TypeRef monomorph_field(const ::HIR::GenericParams& params_def, const ::HIR::TypeRef& ty, const ::HIR::TypeRef& tpl);
+        MetaKind get_meta_kind(const ::HIR::TypeRef& ty);
+        size_t pointer_size(const ::HIR::TypeRef& inner) {
+            return get_meta_kind(inner) == MetaKind::None ? 8 : 16;
+        }
+        size_t size_of_val(const ::HIR::TypeRef& ty, uint64_t meta);
+        size_t align_of_val(const ::HIR::TypeRef& ty, uint64_t meta);
+        size_t tail_offset(const TypeLayout& l, uint64_t meta);
+        size_t get_variant(const TypeLayout& l, const uint8_t* ptr);
+
+        // --- Items ---
+        FunctionInfo& get_function(const ::HIR::Path& p);
+        FunctionInfo& get_function_from_addr(const uint8_t* ptr);
+        void resolve_function(FunctionInfo& fi);
+        void layout_frame(FunctionInfo& fi);
+        StaticInfo& get_static(const ::HIR::Path& p);
+        uint8_t* get_vtable(const ::HIR::Path& p);
+        const void* get_item_addr(const ::HIR::Path& p);
+        const char* intern_string(const ::std::string& s) {
+            return m_strings.insert(s).first->c_str();
+        }
+        void write_literal(uint8_t* ptr, const ::HIR::TypeRef& ty, const ::HIR::Literal& lit);
+
+        // --- Execution ---
+        void call_function(FunctionInfo& fi, uint8_t* ret, const ::std::vector<const uint8_t*>& args);
+        void run_mir(FunctionInfo& fi, uint8_t* ret, const ::std::vector<const uint8_t*>& args);
+        void call_extern(FunctionInfo& fi, uint8_t* ret, const ::std::vector<const uint8_t*>& args, const ::std::vector<const ::HIR::TypeRef*>* arg_tys=nullptr);
+        void call_intrinsic(const ::std::string& name, const ::HIR::PathParams& params,
+            uint8_t* ret, const ::HIR::TypeRef& ret_ty,
+            const ::std::vector<const uint8_t*>& args, const ::std::vector<const ::HIR::TypeRef*>& arg_tys
+            );
+        void drop_value(uint8_t* ptr, uint64_t meta, const ::HIR::TypeRef& ty);
+        void call_drop_impl(uint8_t* ptr, uint64_t meta, const ::HIR::TypeRef& ty);
+        void call_box_free(uint8_t* box_ptr, const ::HIR::TypeRef& inner_ty);
+
+        Place get_place(Frame& f, const ::MIR::LValue& lv);
+        void eval_constant(Frame& f, const ::MIR::Constant& c, ParamValue& out);
+        void eval_param(Frame& f, const ::MIR::Param& p, ParamValue& out);
+        void exec_statement(Frame& f, const ::MIR::Statement& stmt);
+        void exec_assign(Frame& f, const ::MIR::LValue& dst, const ::MIR::RValue& src);
+        void exec_cast(const ::MIR::TypeResolve& mir_res, uint8_t* dst, const ::HIR::TypeRef& dst_ty, const Place& src);
+        void exec_binop(const ::MIR::TypeResolve& mir_res, uint8_t* dst, const ParamValue& l, ::MIR::eBinOp op, const ParamValue& r);
+        void exec_call(Frame& f, const ::MIR::Terminator::Data_Call& te);
+    };
+}
+
+// ------------------------------------------------------------------------
+// Types
+// ------------------------------------------------------------------------
+const TypeLayout& Interpreter::get_layout(const ::HIR::TypeRef& ty)
+{
+    auto it = m_layouts.find(ty);
+    if( it != m_layouts.end() )
+        return *it->second;
+    auto l = compute_layout(ty);
+    return *m_layouts.insert( ::std::make_pair(ty.clone(), mv$(l)) ).first->second;
+}
+::HIR::TypeRef Interpreter::monomorph_field(const ::HIR::GenericParams& params_def, const ::HIR::TypeRef& ty, const ::HIR::TypeRef& tpl)
+{
+    if( monomorphise_type_needed(tpl) ) {
+        auto rv = monomorphise_type(sp, params_def, ty.m_data.as_Path().path.m_data.as_Generic().m_params, tpl);
+        m_resolve.expand_associated_types(sp, rv);
+        return rv;
+    }
+    else {
+        return tpl.clone();
+    }
+}
+void Interpreter::place_fields(TypeLayout& l, ::std::vector< ::HIR::TypeRef> tys, bool packed, size_t offset)
+{
+    size_t align = (offset > 0 ? 8 : 1);
+    for(auto& fty : tys)
+    {
+        const auto& fl = get_layout(fty);
+        size_t a = packed ? 1 : fl.align;
+        offset = align_up(offset, a);
+        l.fields.push_back(TypeLayout::Field { offset, mv$(fty) });
+        offset += fl.size;
+        align = ::std::max(align, a);
+    }
+    l.align = align;
+    l.size = align_up(offset, align);
+}
+::std::unique_ptr<TypeLayout> Interpreter::compute_layout(const ::HIR::TypeRef& ty)
+{
+    TRACE_FUNCTION_F(ty);
+    auto rv = ::std::unique_ptr<TypeLayout>(new TypeLayout);
+    TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+    (
+        BUG(sp, "Unexpected type in interpreter - " << ty);
+        ),
+    (Diverge,
+        ),
+    (Primitive,
+        if( te == ::HIR::CoreType::U128 || te == ::HIR::CoreType::I128 )
+            UNSUPPORTED(sp, "128-bit integers aren't supported by the interpreter (" << ty << ")");
+        rv->size = core_size(te);
+        rv->align = ::std::max<size_t>(rv->size, 1);
+        ),
+    (Path,
+        TU_MATCH_DEF( ::HIR::TypeRef::TypePathBinding, (te.binding), (tpb),
+        (
+            BUG(sp, "Unbound type path in interpreter - " << ty);
+            ),
+        (Struct,
+            const auto& str = *tpb;
+            ::std::vector< ::HIR::TypeRef>  tys;
+            TU_MATCHA( (str.m_data), (se),
+            (Unit,
+                ),
+            (Tuple,
+                for(const auto& f : se)
+                    tys.push_back( monomorph_field(str.m_params, ty, f.ent) );
+                ),
+            (Named,
+                for(const auto& f : se)
+                    tys.push_back( monomorph_field(str.m_params, ty, f.second.ent) );
+                )
+            )
+            // VTables have a header of {size, align, drop}
+            const auto& last = te.path.m_data.as_Generic().m_path.m_components.back();
+            bool is_vtable = last.size() > 7 && last.compare(last.size() - 7, 7, "#vtable") == 0;
+            place_fields(*rv, mv$(tys), str.m_repr == ::HIR::Struct::Repr::Packed, is_vtable ? 3*8 : 0);
+            ),
+        (Union,
+            const auto& unn = *tpb;
+            for(const auto& f : unn.m_variants)
+            {
+                auto fty = monomorph_field(unn.m_params, ty, f.second.ent);
+                const auto& fl = get_layout(fty);
+                rv->size = ::std::max(rv->size, fl.size);
+                rv->align = ::std::max(rv->align, fl.align);
+                rv->fields.push_back(TypeLayout::Field { 0, mv$(fty) });
+            }
+            rv->size = align_up(rv->size, rv->align);
+            ),
+        (Enum,
+            const auto& enm = *tpb;
+            if( const auto* e = enm.m_data.opt_Value() )
+            {
+                switch(e->repr)
+                {
+                case ::HIR::Enum::Repr::Rust:
+                case ::HIR::Enum::Repr::C:
+                case ::HIR::Enum::Repr::U32:
+                    rv->tag_size = 4;
+                    break;
+                case ::HIR::Enum::Repr::U8:
+                    rv->tag_size = 1;
+                    break;
+                case ::HIR::Enum::Repr::U16:
+                    rv->tag_size = 2;
+                    break;
+                case ::HIR::Enum::Repr::U64:
+                case ::HIR::Enum::Repr::Usize:
+                    rv->tag_size = 8;
+                    break;
+                }
+                for(size_t i = 0; i < e->variants.size(); i ++)
+                    rv->tags.push_back( enm.get_value(i) );
+                rv->size = rv->tag_size;
+                rv->align = rv->tag_size;
+            }
+            else
+            {
+                const auto& variants = enm.m_data.as_Data();
+                rv->tag_size = 4;
+                size_t data_align = 1, data_size = 0;
+                ::std::vector< ::HIR::TypeRef>  tys;
+                for(size_t i = 0; i < variants.size(); i ++)
+                {
+                    rv->tags.push_back(i);
+                    tys.push_back( monomorph_field(enm.m_params, ty, variants[i].type) );
+                    const auto& vl = get_layout(tys.back());
+                    data_align = ::std::max(data_align, vl.align);
+                    data_size = ::std::max(data_size, vl.size);
+                }
+                size_t data_ofs = align_up(rv->tag_size, data_align);
+                for(auto& t : tys)
+                    rv->variants.push_back(TypeLayout::Field { data_ofs, mv$(t) });
+                rv->align = ::std::max(rv->tag_size, data_align);
+                rv->size = align_up(data_ofs + data_size, rv->align);
+            }
+            )
+        )
+        ),
+    (TraitObject,
+        ),
+    (Array,
+        const auto& il = get_layout(*te.inner);
+        rv->size = il.size * te.size_val;
+        rv->align = il.align;
+        ),
+    (Slice,
+        rv->align = get_layout(*te.inner).align;
+        ),
+    (Tuple,
+        ::std::vector< ::HIR::TypeRef>  tys;
+        for(const auto& t : te)
+            tys.push_back( t.clone() );
+        place_fields(*rv, mv$(tys), false, 0);
+        ),
+    (Borrow,
+        rv->size = pointer_size(*te.inner);
+        rv->align = 8;
+        ),
+    (Pointer,
+        rv->size = pointer_size(*te.inner);
+        rv->align = 8;
+        ),
+    (Function,
+        rv->size = 8;
+        rv->align = 8;
+        )
+    )
+    DEBUG("size=" << rv->size << ", align=" << rv->align);
+    return rv;
+}
+MetaKind Interpreter::get_meta_kind(const ::HIR::TypeRef& ty)
+{
+    TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+    (
+        return MetaKind::None;
+        ),
+    (Primitive,
+        return te == ::HIR::CoreType::Str ? MetaKind::Length : MetaKind::None;
+        ),
+    (Slice,
+        return MetaKind::Length;
+        ),
+    (TraitObject,
+        return MetaKind::VTable;
+        ),
+    (Path,
+        // Structs can have an unsized final field
+        // NOTE: Doesn't use the layout, as that requires the layout of pointers within the struct (which could recurse)
+        if( const auto* str = te.binding.opt_Struct() )
+        {
+            const ::HIR::TypeRef* last = nullptr;
+            TU_MATCHA( ((*str)->m_data), (se),
+            (Unit,
+                ),
+            (Tuple,
+                if( !se.empty() )   last = &se.back().ent;
+                ),
+            (Named,
+                if( !se.empty() )   last = &se.back().second.ent;
+                )
+            )
+            if( last )
+                return get_meta_kind( monomorph_field((*str)->m_params, ty, *last) );
+        }
+        return MetaKind::None;
+        )
+    )
+}
+/// Offset of the final (unsized) field of a struct, accounting for the alignment of trait objects
+size_t Interpreter::tail_offset(const TypeLayout& l, uint64_t meta)
+{
+    const auto& f = l.fields.back();
+    if( get_meta_kind(f.ty) == MetaKind::VTable )
+    {
+        size_t end = (l.fields.size() > 1 ? l.fields[l.fields.size()-2].offset + get_layout(l.fields[l.fields.size()-2].ty).size : 0);
+        return align_up(end, read_uint(reinterpret_cast<const uint8_t*>(meta) + 8, 8));
+    }
+    return f.offset;
+}
+size_t Interpreter::size_of_val(const ::HIR::TypeRef& ty, uint64_t meta)
+{
+    TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+    (
+        return get_layout(ty).size;
+        ),
+    (Primitive,
+        if( te == ::HIR::CoreType::Str )
+            return meta;
+        return core_size(te);
+        ),
+    (Slice,
+        return get_layout(*te.inner).size * meta;
+        ),
+    (TraitObject,
+        return read_uint(reinterpret_cast<const uint8_t*>(meta), 8);
+        ),
+    (Path,
+        if( get_meta_kind(ty) == MetaKind::None )
+            return get_layout(ty).size;
+        const auto& l = get_layout(ty);
+        size_t align = ::std::max(l.align, align_of_val(l.fields.back().ty, meta));
+        return align_up(tail_offset(l, meta) + size_of_val(l.fields.back().ty, meta), align);
+        )
+    )
+}
+size_t Interpreter::align_of_val(const ::HIR::TypeRef& ty, uint64_t meta)
+{
+    if( ty.m_data.is_TraitObject() )
+        return read_uint(reinterpret_cast<const uint8_t*>(meta) + 8, 8);
+    if( ty.m_data.is_Path() && get_meta_kind(ty) != MetaKind::None )
+    {
+        const auto& l = get_layout(ty);
+        return ::std::max(l.align, align_of_val(l.fields.back().ty, meta));
+    }
+    return get_layout(ty).align;
+}
+/// Index of the active variant of an enum
+size_t Interpreter::get_variant(const TypeLayout& l, const uint8_t* ptr)
+{
+    auto tag = read_uint(ptr, l.tag_size);
+    auto it = ::std::find(l.tags.begin(), l.tags.end(), tag);
+    ASSERT_BUG(sp, it != l.tags.end(), "Invalid enum tag " << tag);
+    return it - l.tags.begin();
+}
+
+// ------------------------------------------------------------------------
+// Items
+// ------------------------------------------------------------------------
+FunctionInfo& Interpreter::get_function(const ::HIR::Path& p)
+{
+    auto it = m_functions.find(p);
+    if( it != m_functions.end() )
+        return *it->second;
+    auto* fi = new FunctionInfo(p.clone());
+    m_functions.insert( ::std::make_pair(p.clone(), ::std::unique_ptr<FunctionInfo>(fi)) );
+    m_function_addrs.insert(fi);
+    return *fi;
+}
+FunctionInfo& Interpreter::get_function_from_addr(const uint8_t* ptr)
+{
+    if( m_function_addrs.count(ptr) == 0 )
+        ERROR(sp, E0000, "Call through an invalid function pointer (" << static_cast<const void*>(ptr) << ")");
+    return *reinterpret_cast<FunctionInfo*>(const_cast<uint8_t*>(ptr));
+}
+void Interpreter::resolve_function(FunctionInfo& fi)
+{
+    TRACE_FUNCTION_F(fi.path);
+    const auto& p = fi.path;
+    // `<fn(...) as Fn*>::call*`
+    if( const auto* pe = p.m_data.opt_UfcsKnown() )
+    {
+        const auto& tp = pe->trait.m_path;
+        if( pe->type->m_data.is_Function() && (tp == m_resolve.m_lang_Fn || tp == m_resolve.m_lang_FnMut || tp == m_resolve.m_lang_FnOnce) )
+        {
+            const auto& te = pe->type->m_data.as_Function();
+            fi.kind = FunctionInfo::Kind::FnPtrCall;
+            fi.is_call_once = (tp == m_resolve.m_lang_FnOnce);
+            auto self_ty = fi.is_call_once ? pe->type->clone() : ::HIR::TypeRef::new_borrow(::HIR::BorrowType::Shared, pe->type->clone());
+            fi.args.push_back( ::std::make_pair(::HIR::Pattern{}, mv$(self_ty)) );
+            ::std::vector< ::HIR::TypeRef>  arg_tys;
+            for(const auto& t : te.m_arg_types)
+                arg_tys.push_back( t.clone() );
+            fi.args.push_back( ::std::make_pair(::HIR::Pattern{}, ::HIR::TypeRef(mv$(arg_tys))) );
+            fi.ret_type = te.m_rettype->clone();
+            return ;
+        }
+    }
+
+    auto ri = Trans_ResolveItem(m_crate, p);
+    if( ri.fcn )
+    {
+        const auto& fcn = *ri.fcn;
+        fi.ret_type = ri.pp.monomorph(m_resolve, fcn.m_return);
+        for(const auto& a : fcn.m_args)
+            fi.args.push_back( ::std::make_pair(::HIR::Pattern{}, ri.pp.monomorph(m_resolve, a.second)) );
+
+        const auto& mir = fcn.m_code.m_mir ? fcn.m_code.m_mir : fcn.m_interp_mir;
+        if( mir )
+        {
+            fi.kind = FunctionInfo::Kind::Mir;
+            // Provided trait methods need to be monomorphised too (same as codegen)
+            bool is_method = ( fcn.m_args.size() > 0 && visit_ty_with(fcn.m_args[0].second, [&](const auto& x){return x == ::HIR::TypeRef("Self",0xFFFF);}) );
+            if( ri.pp.has_types() || is_method )
+            {
+                fi.mono_mir = Trans_Monomorphise(m_resolve, ri.pp, mir);
+                ::std::string s = FMT(p);
+                ::HIR::ItemPath ip(s);
+                MIR_Cleanup(m_resolve, ip, *fi.mono_mir, fi.args, fi.ret_type);
+                fi.mir = &*fi.mono_mir;
+            }
+            else
+            {
+                fi.mir = &*mir;
+            }
+            auto* fi_p = &fi;
+            fi.mir_res.reset(new ::MIR::TypeResolve( fi.sp, m_resolve, ::FmtLambda([fi_p](::std::ostream& os){ os << fi_p->path; }), fi.ret_type, fi.args, *fi.mir ));
+            layout_frame(fi);
+        }
+        else if( fcn.m_abi == "rust-intrinsic" )
+        {
+            fi.kind = FunctionInfo::Kind::Intrinsic;
+            fi.intrinsic_name = p.m_data.as_Generic().m_path.m_components.back();
+            fi.intrinsic_params = ri.pp.pp_method.clone();
+        }
+        else if( fcn.m_abi == ABI_RUST )
+        {
+            UNSUPPORTED(sp, "No MIR available for " << p << " - the crate defining it must be built with `-Z save-all-mir`");
+        }
+        else
+        {
+            fi.kind = FunctionInfo::Kind::Extern;
+            fi.link_name = fcn.m_linkage.name != "" ? fcn.m_linkage.name : p.m_data.as_Generic().m_path.m_components.back();
+            fi.is_variadic = fcn.m_variadic;
+            for(const auto& s : FFI_SHIMS)
+            {
+                if( fi.link_name == s.name ) {
+                    fi.ffi_ptr = reinterpret_cast<ffi_fcn_t>(s.ptr);
+                    fi.ffi_accepts_varargs = s.is_varargs_wrapper;
+                }
+            }
+        }
+    }
+    else if( ri.auto_generate && p.m_data.is_Generic() )
+    {
+        // Struct or enum variant constructor
+        const auto& gp = p.m_data.as_Generic();
+        fi.kind = FunctionInfo::Kind::Constructor;
+        const ::HIR::TypeRef* data_ty = nullptr;
+        if( gp.m_path.m_components.size() > 1 && m_crate.get_typeitem_by_path(sp, gp.m_path, false, true).is_Enum() )
+        {
+            const auto& enm = m_crate.get_typeitem_by_path(sp, gp.m_path, false, true).as_Enum();
+            auto enum_path = gp.m_path;
+            enum_path.m_components.pop_back();
+            fi.ty = ::HIR::TypeRef( ::HIR::GenericPath(mv$(enum_path), gp.m_params.clone()), &enm );
+            fi.variant_idx = enm.find_variant(gp.m_path.m_components.back());
+            ASSERT_BUG(sp, fi.variant_idx != SIZE_MAX, "Variant not found for " << p);
+            data_ty = &get_layout(fi.ty).variants.at(fi.variant_idx).ty;
+        }
+        else
+        {
+            const auto& str = m_crate.get_struct_by_path(sp, gp.m_path);
+            fi.ty = ::HIR::TypeRef( gp.clone(), &str );
+            data_ty = &fi.ty;
+        }
+        for(const auto& f : get_layout(*data_ty).fields)
+            fi.args.push_back( ::std::make_pair(::HIR::Pattern{}, f.ty.clone()) );
+        fi.ret_type = fi.ty.clone();
+    }
+    else
+    {
+        ERROR(sp, E0000, "Cannot find function " << p << " for the interpreter");
+    }
+}
+void Interpreter::layout_frame(FunctionInfo& fi)
+{
+    // Return slot, then arguments, then locals
+    size_t ofs = get_layout(fi.ret_type).size;
+    auto add = [&](const ::HIR::TypeRef& ty)->size_t {
+        const auto& l = get_layout(ty);
+        ofs = align_up(ofs, l.align);
+        auto rv = ofs;
+        ofs += l.size;
+        return rv;
+        };
+    for(const auto& a : fi.args)
+        fi.arg_offsets.push_back( add(a.second) );
+    for(const auto& ty : fi.mir->locals)
+        fi.local_offsets.push_back( add(ty) );
+    fi.frame_size = ofs;
+}
+Interpreter::StaticInfo& Interpreter::get_static(const ::HIR::Path& p)
+{
+    auto it = m_statics.find(p);
+    if( it != m_statics.end() )
+        return *it->second;
+    TRACE_FUNCTION_F(p);
+    auto ri = Trans_ResolveItem(m_crate, p);
+    ASSERT_BUG(sp, ri.stat, "Path " << p << " isn't a static");
+    auto* si = new StaticInfo;
+    si->ty = ri.pp.monomorph(m_resolve, ri.stat->m_type);
+    si->ptr = static_cast<uint8_t*>(calloc(::std::max<size_t>(get_layout(si->ty).size, 1), 1));
+    // Registered before the value is written, as it may refer to itself
+    m_statics.insert( ::std::make_pair(p.clone(), ::std::unique_ptr<StaticInfo>(si)) );
+    const auto& value = ri.stat->m_value_res.is_Invalid() ? ri.stat->m_interp_value : ri.stat->m_value_res;
+    if( value.is_Invalid() )
+        UNSUPPORTED(sp, "Static " << p << " has no value (statics from other crates need `-Z save-all-mir`)");
+    write_literal(si->ptr, si->ty, value);
+    return *si;
+}
+uint8_t* Interpreter::get_vtable(const ::HIR::Path& p)
+{
+    auto it = m_vtables.find(p);
+    if( it != m_vtables.end() )
+        return it->second;
+    TRACE_FUNCTION_F(p);
+    const auto& pe = p.m_data.as_UfcsKnown();
+    const auto& type = *pe.type;
+    const auto& trait = m_crate.get_trait_by_path(sp, pe.trait.m_path);
+
+    // Header (matching the C backend's VTABLE_HDR, but size first) then methods
+    auto* vt = static_cast<uint8_t*>(calloc(3 + trait.m_value_indexes.size(), 8));
+    m_vtables.insert( ::std::make_pair(p.clone(), vt) );
+    const auto& l = get_layout(type);
+    write_uint(vt + 0, 8, l.size);
+    write_uint(vt + 8, 8, l.align);
+    if( m_resolve.type_needs_drop_glue(sp, type) )
+    {
+        auto it = m_drop_glue.find(type);
+        if( it == m_drop_glue.end() )
+        {
+            auto& fi = get_function( ::HIR::Path(type.clone(), "#drop_glue") );
+            fi.kind = FunctionInfo::Kind::DropGlue;
+            fi.ty = type.clone();
+            it = m_drop_glue.insert( ::std::make_pair(type.clone(), &fi) ).first;
+        }
+        write_ptr(vt + 16, it->second);
+    }
+
+    auto monomorph_cb_trait = monomorphise_type_get_cb(sp, &type, &pe.trait.m_params, nullptr);
+    for(const auto& m : trait.m_value_indexes)
+    {
+        auto gpath = monomorphise_genericpath_with(sp, m.second.second, monomorph_cb_trait, false);
+        auto& fi = get_function( ::HIR::Path(type.clone(), mv$(gpath), m.first) );
+        write_ptr(vt + 24 + m.second.first * 8, &fi);
+    }
+    return vt;
+}
+const void* Interpreter::get_item_addr(const ::HIR::Path& p)
+{
+    if( p.m_data.is_UfcsKnown() && p.m_data.as_UfcsKnown().item == "#vtable" )
+        return get_vtable(p);
+    auto it = m_functions.find(p);
+    if( it != m_functions.end() )
+        return it->second.get();
+    auto sit = m_statics.find(p);
+    if( sit != m_statics.end() )
+        return sit->second->ptr;
+
+    auto ri = Trans_ResolveItem(m_crate, p);
+    if( ri.stat )
+        return get_static(p).ptr;
+    if( ri.fcn || ri.auto_generate )
+        return &get_function(p);
+    BUG(sp, "Unable to find item for " << p);
+}
+void Interpreter::write_literal(uint8_t* ptr, const ::HIR::TypeRef& ty, const ::HIR::Literal& lit)
+{
+    TU_MATCHA( (lit), (e),
+    (Invalid,
+        ),
+    (List,
+        if( const auto* te = ty.m_data.opt_Array() )
+        {
+            size_t elem_size = get_layout(*te->inner).size;
+            for(size_t i = 0; i < e.size(); i ++)
+                write_literal(ptr + i * elem_size, *te->inner, e[i]);
+        }
+        else
+        {
+            const auto& l = get_layout(ty);
+            ASSERT_BUG(sp, l.fields.size() == e.size(), "Literal size mismatch for " << ty << " - " << lit);
+            for(size_t i = 0; i < e.size(); i ++)
+                write_literal(ptr + l.fields[i].offset, l.fields[i].ty, e[i]);
+        }
+        ),
+    (Variant,
+        const auto& l = get_layout(ty);
+        ASSERT_BUG(sp, l.tag_size > 0, "Variant literal for non-enum " << ty);
+        write_uint(ptr, l.tag_size, l.tags.at(e.idx));
+        if( !l.variants.empty() )
+        {
+            const auto& v = l.variants.at(e.idx);
+            write_literal(ptr + v.offset, v.ty, *e.val);
+        }
+        ),
+    (Integer,
+        write_uint(ptr, get_layout(ty).size, e);
+        ),
+    (Float,
+        write_float(ptr, ty.m_data.as_Primitive(), e);
+        ),
+    (BorrowPath,
+        write_ptr(ptr, get_item_addr(e));
+        const ::HIR::TypeRef* ity = nullptr;
+        if( const auto* te = ty.m_data.opt_Borrow() )
+            ity = &*te->inner;
+        else if( const auto* te = ty.m_data.opt_Pointer() )
+            ity = &*te->inner;
+        if( ity && get_meta_kind(*ity) == MetaKind::Length )
+        {
+            const auto& sty = get_static(e).ty;
+            ASSERT_BUG(sp, sty.m_data.is_Array(), "Borrow of " << e << " as " << ty);
+            write_uint(ptr + 8, 8, sty.m_data.as_Array().size_val);
+        }
+        else if( ity && get_meta_kind(*ity) == MetaKind::VTable )
+        {
+            UNSUPPORTED(sp, "Trait object literals aren't supported by the interpreter (" << lit << " as " << ty << ")");
+        }
+        ),
+    (BorrowData,
+        const auto& ity = ty.m_data.is_Borrow() ? *ty.m_data.as_Borrow().inner : *ty.m_data.as_Pointer().inner;
+        if( const auto* te = ity.m_data.opt_Slice() )
+        {
+            auto count = e->list_size();
+            auto arr_ty = ::HIR::TypeRef::new_array(te->inner->clone(), count);
+            auto* data = static_cast<uint8_t*>(calloc(::std::max<size_t>(get_layout(arr_ty).size, 1), 1));
+            write_literal(data, arr_ty, *e);
+            write_ptr(ptr, data);
+            write_uint(ptr + 8, 8, count);
+        }
+        else
+        {
+            auto* data = static_cast<uint8_t*>(calloc(::std::max<size_t>(get_layout(ity).size, 1), 1));
+            write_literal(data, ity, *e);
+            write_ptr(ptr, data);
+        }
+        ),
+    (String,
+        if( ty.m_data.is_Array() )
+        {
+            memcpy(ptr, e.data(), e.size());
+        }
+        else
+        {
+            write_ptr(ptr, intern_string(e));
+            const auto& ity = ty.m_data.is_Borrow() ? *ty.m_data.as_Borrow().inner : *ty.m_data.as_Pointer().inner;
+            if( ity == ::HIR::CoreType::Str )
+                write_uint(ptr + 8, 8, e.size());
+        }
+        ),
+    (Repeat,
+        const auto& ity = *ty.m_data.as_Array().inner;
+        size_t elem_size = get_layout(ity).size;
+        for(size_t i = 0; i < e.count; i ++)
+            write_literal(ptr + i * elem_size, ity, *e.val);
+        ),
+    (Buffer,
+        // NOTE: Buffers are little-endian, as is the host
+        ASSERT_BUG(sp, e.data.size() == get_layout(ty).size, "Buffer literal size mismatch for " << ty);
+        memcpy(ptr, e.data.data(), e.data.size());
+        )
+    )
+}
+
+// ------------------------------------------------------------------------
+// Execution
+// ------------------------------------------------------------------------
+void Interpreter::call_function(FunctionInfo& fi, uint8_t* ret, const ::std::vector<const uint8_t*>& args)
+{
+    if( fi.kind == FunctionInfo::Kind::Unresolved )
+        resolve_function(fi);
+    switch(fi.kind)
+    {
+    case FunctionInfo::Kind::Unresolved:
+        throw "";
+    case FunctionInfo::Kind::Mir:
+        run_mir(fi, ret, args);
+        break;
+    case FunctionInfo::Kind::Extern:
+        call_extern(fi, ret, args);
+        break;
+    case FunctionInfo::Kind::Intrinsic: {
+        ::std::vector<const ::HIR::TypeRef*>    arg_tys;
+        for(const auto& a : fi.args)
+            arg_tys.push_back(&a.second);
+        call_intrinsic(fi.intrinsic_name, fi.intrinsic_params, ret, fi.ret_type, args, arg_tys);
+        } break;
+    case FunctionInfo::Kind::Constructor: {
+        const auto& l = get_layout(fi.ty);
+        uint8_t* data = ret;
+        const TypeLayout* dl = &l;
+        if( fi.variant_idx != ~0u )
+        {
+            write_uint(ret, l.tag_size, l.tags.at(fi.variant_idx));
+            data = ret + l.variants.at(fi.variant_idx).offset;
+            dl = &get_layout(l.variants.at(fi.variant_idx).ty);
+        }
+        for(size_t i = 0; i < args.size(); i ++)
+            memcpy(data + dl->fields[i].offset, args[i], get_layout(dl->fields[i].ty).size);
+        } break;
+    case FunctionInfo::Kind::FnPtrCall: {
+        const uint8_t* fcn_ptr = fi.is_call_once ? read_ptr(args.at(0)) : read_ptr(read_ptr(args.at(0)));
+        const auto& tl = get_layout(fi.args.at(1).second);
+        ::std::vector<const uint8_t*>   inner_args;
+        for(const auto& f : tl.fields)
+            inner_args.push_back( args.at(1) + f.offset );
+        call_function(get_function_from_addr(fcn_ptr), ret, inner_args);
+        } break;
+    case FunctionInfo::Kind::DropGlue:
+        drop_value(read_ptr(args.at(0)), 0, fi.ty);
+        break;
+    }
+}
+void Interpreter::call_extern(FunctionInfo& fi, uint8_t* ret, const ::std::vector<const uint8_t*>& args, const ::std::vector<const ::HIR::TypeRef*>* arg_tys)
+{
+    if( !fi.ffi_ptr )
+    {
+        // Starting to unwind (the panic message has already been printed)
+        if( fi.link_name == "_Unwind_RaiseException" )
+            throw Panicked();
+        UNSUPPORTED(sp, "Function `" << fi.link_name << "` (" << fi.path << ") isn't available in the interpreter");
+    }
+    // Every shim is called as `ffi_fcn_t`, which is only correct for integer/pointer arguments and return values
+    if( fi.is_variadic && !fi.ffi_accepts_varargs )
+        UNSUPPORTED(sp, "Variadic call to `" << fi.link_name << "` isn't supported by the interpreter");
+    if( args.size() > 6 )
+        UNSUPPORTED(sp, "Call to `" << fi.link_name << "` with more than six arguments isn't supported by the interpreter");
+    if( args.size() > fi.args.size() && !arg_tys )
+        UNSUPPORTED(sp, "Variadic call to `" << fi.link_name << "` through a function pointer isn't supported by the interpreter");
+    auto check_ty = [&](const ::HIR::TypeRef& ty, const char* what) {
+        bool ok;
+        if( const auto* te = ty.m_data.opt_Primitive() )
+            ok = !core_is_float(*te) && core_size(*te) <= 8;
+        else if( ty.m_data.is_Borrow() || ty.m_data.is_Pointer() )
+            ok = get_layout(ty).size <= 8;
+        else
+            ok = ty.m_data.is_Function() || ty.m_data.is_Diverge() || ty == ::HIR::TypeRef::new_unit();
+        if( !ok )
+            UNSUPPORTED(sp, "Call to `" << fi.link_name << "` with " << what << " of type " << ty << " isn't supported by the interpreter (only integers and pointers)");
+        };
+    uint64_t vals[6] = {0,0,0,0,0,0};
+    for(size_t i = 0; i < args.size(); i ++)
+    {
+        const auto& ty = (arg_tys ? *arg_tys->at(i) : fi.args.at(i).second);
+        check_ty(ty, "an argument");
+        const auto& l = get_layout(ty);
+        vals[i] = read_uint(args[i], l.size);
+        if( ty.m_data.is_Primitive() && core_is_signed(ty.m_data.as_Primitive()) )
+            vals[i] = static_cast<uint64_t>(sext(vals[i], l.size));
+    }
+    check_ty(fi.ret_type, "a return value");
+    uint64_t rv = fi.ffi_ptr(vals[0], vals[1], vals[2], vals[3], vals[4], vals[5]);
+    write_uint(ret, get_layout(fi.ret_type).size, rv);
+}
+void Interpreter::run_mir(FunctionInfo& fi, uint8_t* ret, const ::std::vector<const uint8_t*>& args)
+{
+    TRACE_FUNCTION_F(fi.path);
+    const auto& mir = *fi.mir;
+    auto& mir_res = *fi.mir_res;
+    Frame   f(fi);
+    MIR_ASSERT(mir_res, args.size() == fi.args.size(), "Argument count mismatch - " << args.size() << " != " << fi.args.size());
+    for(size_t i = 0; i < args.size(); i ++)
+        memcpy(f.base() + fi.arg_offsets[i], args[i], get_layout(fi.args[i].second).size);
+
+    size_t bb_idx = 0;
+    for(;;)
+    {
+        const auto& bb = mir.blocks.at(bb_idx);
+        for(size_t i = 0; i < bb.statements.size(); i ++)
+        {
+            mir_res.set_cur_stmt(bb_idx, i);
+            exec_statement(f, bb.statements[i]);
+        }
+        mir_res.set_cur_stmt_term(bb_idx);
+        TU_MATCHA( (bb.terminator), (te),
+        (Incomplete,
+            MIR_BUG(mir_res, "Incomplete block");
+            ),
+        (Return,
+            memcpy(ret, f.base(), get_layout(fi.ret_type).size);
+            return ;
+            ),
+        (Diverge,
+            // A panic reached the unwind path, there's nothing to catch it so this ends the program (as a native one would)
+            throw Panicked();
+            ),
+        (Goto,
+            bb_idx = te;
+            ),
+        (Panic,
+            bb_idx = te.dst;
+            ),
+        (If,
+            auto p = get_place(f, te.cond);
+            bb_idx = (*p.ptr ? te.bb0 : te.bb1);
+            ),
+        (Switch,
+            auto p = get_place(f, te.val);
+            const auto& l = get_layout(*p.ty);
+            MIR_ASSERT(mir_res, l.tag_size > 0, "Switch over non-enum " << *p.ty);
+            bb_idx = te.targets.at( get_variant(l, p.ptr) );
+            ),
+        (SwitchValue,
+            auto p = get_place(f, te.val);
+            bb_idx = te.def_target;
+            TU_MATCHA( (te.values), (vals),
+            (Unsigned,
+                auto v = read_uint(p.ptr, get_layout(*p.ty).size);
+                for(size_t i = 0; i < vals.size(); i ++)
+                    if( vals[i] == v ) { bb_idx = te.targets[i]; break; }
+                ),
+            (Signed,
+                auto size = get_layout(*p.ty).size;
+                auto v = sext(read_uint(p.ptr, size), size);
+                for(size_t i = 0; i < vals.size(); i ++)
+                    if( vals[i] == v ) { bb_idx = te.targets[i]; break; }
+                ),
+            (String,
+                const auto* s = read_ptr(p.ptr);
+                auto len = read_uint(p.ptr + 8, 8);
+                for(size_t i = 0; i < vals.size(); i ++)
+                    if( vals[i].size() == len && memcmp(vals[i].data(), s, len) == 0 ) { bb_idx = te.targets[i]; break; }
+                )
+            )
+            ),
+        (Call,
+            exec_call(f, te);
+            bb_idx = te.ret_block;
+            )
+        )
+    }
+}
+void Interpreter::exec_call(Frame& f, const ::MIR::Terminator::Data_Call& te)
+{
+    auto ret = get_place(f, te.ret_val);
+    ::std::vector<ParamValue>   vals(te.args.size());
+    ::std::vector<const uint8_t*>   args;
+    for(size_t i = 0; i < te.args.size(); i ++)
+    {
+        eval_param(f, te.args[i], vals[i]);
+        args.push_back(vals[i].ptr);
+    }
+    // NOTE: Arguments are copied into the callee's frame, so the return value can be written directly
+    TU_MATCHA( (te.fcn), (e),
+    (Value,
+        auto p = get_place(f, e);
+        call_function(get_function_from_addr(read_ptr(p.ptr)), ret.ptr, args);
+        ),
+    (Path,
+        auto it = m_call_cache.find(&te);
+        if( it == m_call_cache.end() )
+            it = m_call_cache.insert( ::std::make_pair(&te, &get_function(e)) ).first;
+        auto& fi = *it->second;
+        if( fi.kind == FunctionInfo::Kind::Unresolved )
+            resolve_function(fi);
+        if( fi.kind == FunctionInfo::Kind::Extern )
+        {
+            // Pass the argument types, as variadic arguments aren't in the function's signature
+            ::std::vector<const ::HIR::TypeRef*>    arg_tys;
+            for(const auto& v : vals)
+                arg_tys.push_back(v.ty);
+            call_extern(fi, ret.ptr, args, &arg_tys);
+        }
+        else
+        {
+            call_function(fi, ret.ptr, args);
+        }
+        ),
+    (Intrinsic,
+        ::std::vector<const ::HIR::TypeRef*>    arg_tys;
+        for(const auto& v : vals)
+            arg_tys.push_back(v.ty);
+        call_intrinsic(e.name, e.params, ret.ptr, *ret.ty, args, arg_tys);
+        )
+    )
+}
+
+Place Interpreter::get_place(Frame& f, const ::MIR::LValue& lv)
+{
+    auto& fi = f.fi;
+    const auto& mir_res = *fi.mir_res;
+    Place   p { nullptr, nullptr, 0 };
+    TU_MATCHA( (lv.m_root), (e),
+    (Return,
+        p.ptr = f.base();
+        p.ty = &fi.ret_type;
+        ),
+    (Argument,
+        p.ptr = f.base() + fi.arg_offsets.at(e.idx);
+        p.ty = &fi.args[e.idx].second;
+        ),
+    (Local,
+        p.ptr = f.base() + fi.local_offsets.at(e);
+        p.ty = &fi.mir->locals[e];
+        ),
+    (Static,
+        auto& si = get_static(*e);
+        p.ptr = si.ptr;
+        p.ty = &si.ty;
+        )
+    )
+    for(const auto& w : lv.m_wrappers)
+    {
+        const auto& ty = *p.ty;
+        switch(w.tag())
+        {
+        case ::MIR::LValue::Wrapper::TAG_Field: {
+            auto idx = w.as_Field();
+            if( ty.m_data.is_Array() || ty.m_data.is_Slice() )
+            {
+                const auto& ity = ty.m_data.is_Array() ? *ty.m_data.as_Array().inner : *ty.m_data.as_Slice().inner;
+                p.ptr += get_layout(ity).size * idx;
+                p.ty = &ity;
+                p.meta = 0;
+            }
+            else
+            {
+                const auto& l = get_layout(ty);
+                MIR_ASSERT(mir_res, idx < l.fields.size(), "Field " << idx << " out of range for " << ty);
+                bool is_tail = (idx == l.fields.size() - 1 && get_meta_kind(l.fields[idx].ty) != MetaKind::None);
+                p.ptr += (is_tail ? tail_offset(l, p.meta) : l.fields[idx].offset);
+                p.ty = &l.fields[idx].ty;
+                if( !is_tail )
+                    p.meta = 0;
+            }
+            } break;
+        case ::MIR::LValue::Wrapper::TAG_Deref: {
+            const ::HIR::TypeRef* ity;
+            if( const auto* te = ty.m_data.opt_Borrow() )
+                ity = &*te->inner;
+            else if( const auto* te = ty.m_data.opt_Pointer() )
+                ity = &*te->inner;
+            else if( const auto* te = m_resolve.is_type_owned_box(ty) )
+                ity = te;
+            else
+                MIR_BUG(mir_res, "Deref of unexpected type " << ty);
+            p.meta = (get_meta_kind(*ity) != MetaKind::None ? read_uint(p.ptr + 8, 8) : 0);
+            p.ptr = read_ptr(p.ptr);
+            p.ty = ity;
+            } break;
+        case ::MIR::LValue::Wrapper::TAG_Index: {
+            const auto& ity = ty.m_data.is_Array() ? *ty.m_data.as_Array().inner : *ty.m_data.as_Slice().inner;
+            auto idx = read_uint(f.base() + fi.local_offsets.at(w.as_Index()), 8);
+            p.ptr += get_layout(ity).size * idx;
+            p.ty = &ity;
+            p.meta = 0;
+            } break;
+        case ::MIR::LValue::Wrapper::TAG_Downcast: {
+            const auto& l = get_layout(ty);
+            auto idx = w.as_Downcast();
+            if( l.tag_size > 0 )
+            {
+                p.ptr += l.variants.at(idx).offset;
+                p.ty = &l.variants[idx].ty;
+            }
+            else
+            {
+                p.ty = &l.fields.at(idx).ty;
+            }
+            p.meta = 0;
+            } break;
+        }
+    }
+    return p;
+}
+void Interpreter::eval_constant(Frame& f, const ::MIR::Constant& c, ParamValue& out)
+{
+    TU_MATCHA( (c), (e),
+    (Int,
+        write_uint(out.alloc(core_size(e.t), e.t), core_size(e.t), static_cast<uint64_t>(e.v));
+        ),
+    (Uint,
+        write_uint(out.alloc(core_size(e.t), e.t), core_size(e.t), e.v);
+        ),
+    (Float,
+        write_float(out.alloc(8, e.t), e.t, e.v);
+        ),
+    (Bool,
+        *out.alloc(1, ::HIR::CoreType::Bool) = e.v;
+        ),
+    (Bytes,
+        auto ty = ::HIR::TypeRef::new_borrow(::HIR::BorrowType::Shared, ::HIR::TypeRef::new_array(::HIR::CoreType::U8, e.size()));
+        write_ptr(out.alloc(8, mv$(ty)), intern_string(::std::string(e.begin(), e.end())));
+        ),
+    (StaticString,
+        auto* p = out.alloc(16, ::HIR::TypeRef::new_borrow(::HIR::BorrowType::Shared, ::HIR::CoreType::Str));
+        write_ptr(p, intern_string(e));
+        write_uint(p + 8, 8, e.size());
+        ),
+    (Const,
+        MonomorphState  params;
+        auto v = m_resolve.get_value(sp, e.p, params);
+        MIR_ASSERT(*f.fi.mir_res, v.is_Constant(), "Const path isn't a constant - " << e.p);
+        const auto& cnst = *v.as_Constant();
+        auto ty = params.monomorph(sp, cnst.m_type);
+        m_resolve.expand_associated_types(sp, ty);
+        auto size = get_layout(ty).size;
+        auto* p = out.alloc(size, mv$(ty));
+        write_literal(p, *out.ty, cnst.m_value_res);
+        ),
+    (ItemAddr,
+        auto ty = ::HIR::TypeRef::new_pointer(::HIR::BorrowType::Shared, ::HIR::TypeRef::new_unit());
+        write_ptr(out.alloc(8, mv$(ty)), get_item_addr(e));
+        )
+    )
+}
+void Interpreter::eval_param(Frame& f, const ::MIR::Param& p, ParamValue& out)
+{
+    TU_MATCHA( (p), (e),
+    (LValue,
+        auto pl = get_place(f, e);
+        out.ptr = pl.ptr;
+        out.ty = pl.ty;
+        ),
+    (Constant,
+        eval_constant(f, e, out);
+        )
+    )
+}
+void Interpreter::exec_statement(Frame& f, const ::MIR::Statement& stmt)
+{
+    const auto& mir_res = *f.fi.mir_res;
+    TU_MATCHA( (stmt), (se),
+    (Assign,
+        exec_assign(f, se.dst, se.src);
+        ),
+    (Asm,
+        UNSUPPORTED(sp, "Inline assembly isn't supported by the interpreter (" << FMT_CB(os, mir_res.fmt_pos(os);) << ")");
+        ),
+    (SetDropFlag,
+        bool v = se.new_val;
+        if( se.other != ~0u )
+            v = (v != f.drop_flags.at(se.other));
+        f.drop_flags.at(se.idx) = v;
+        ),
+    (Drop,
+        if( se.flag_idx != ~0u && !f.drop_flags.at(se.flag_idx) )
+            break;
+        auto p = get_place(f, se.slot);
+        switch(se.kind)
+        {
+        case ::MIR::eDropKind::SHALLOW:
+            if( const auto* ity = m_resolve.is_type_owned_box(*p.ty) )
+                call_box_free(p.ptr, *ity);
+            else
+                MIR_BUG(mir_res, "Shallow drop on non-Box - " << *p.ty);
+            break;
+        case ::MIR::eDropKind::DEEP:
+            drop_value(p.ptr, p.meta, *p.ty);
+            break;
+        }
+        ),
+    (ScopeEnd,
+        )
+    )
+}
+void Interpreter::exec_assign(Frame& f, const ::MIR::LValue& dst_lv, const ::MIR::RValue& src)
+{
+    const auto& mir_res = *f.fi.mir_res;
+    auto dst = get_place(f, dst_lv);
+    const auto& dl = get_layout(*dst.ty);
+    // Aggregates are built in a temporary, in case the destination is also a source
+    ::std::vector<uint64_t> tmp_storage( (dl.size + 7) / 8 );
+    auto* tmp = reinterpret_cast<uint8_t*>(tmp_storage.data());
+    TU_MATCHA( (src), (e),
+    (Use,
+        auto s = get_place(f, e);
+        memmove(dst.ptr, s.ptr, dl.size);
+        ),
+    (Constant,
+        ParamValue  v;
+        eval_constant(f, e, v);
+        memcpy(dst.ptr, v.ptr, dl.size);
+        ),
+    (SizedArray,
+        ParamValue  v;
+        eval_param(f, e.val, v);
+        size_t elem_size = get_layout(*v.ty).size;
+        for(size_t i = 0; i < e.count; i ++)
+            memcpy(tmp + i * elem_size, v.ptr, elem_size);
+        memcpy(dst.ptr, tmp, dl.size);
+        ),
+    (Borrow,
+        auto s = get_place(f, e.val);
+        write_ptr(dst.ptr, s.ptr);
+        if( get_meta_kind(*s.ty) != MetaKind::None )
+            write_uint(dst.ptr + 8, 8, s.meta);
+        ),
+    (Cast,
+        auto s = get_place(f, e.val);
+        exec_cast(mir_res, tmp, e.type, s);
+        memcpy(dst.ptr, tmp, dl.size);
+        ),
+    (BinOp,
+        ParamValue  l, r;
+        eval_param(f, e.val_l, l);
+        eval_param(f, e.val_r, r);
+        exec_binop(mir_res, tmp, l, e.op, r);
+        memcpy(dst.ptr, tmp, dl.size);
+        ),
+    (UniOp,
+        auto s = get_place(f, e.val);
+        MIR_ASSERT(mir_res, s.ty->m_data.is_Primitive(), "UniOp on non-primitive " << *s.ty);
+        auto ct = s.ty->m_data.as_Primitive();
+        switch(e.op)
+        {
+        case ::MIR::eUniOp::INV:
+            if( ct == ::HIR::CoreType::Bool )
+                *dst.ptr = !*s.ptr;
+            else
+                write_uint(dst.ptr, dl.size, ~read_uint(s.ptr, dl.size));
+            break;
+        case ::MIR::eUniOp::NEG:
+            if( core_is_float(ct) )
+                write_float(dst.ptr, ct, -read_float(s.ptr, ct));
+            else
+                write_uint(dst.ptr, dl.size, 0 - read_uint(s.ptr, dl.size));
+            break;
+        }
+        ),
+    (DstMeta,
+        auto s = get_place(f, e.val);
+        const auto& ity = s.ty->m_data.is_Borrow() ? *s.ty->m_data.as_Borrow().inner : *s.ty->m_data.as_Pointer().inner;
+        if( ity.m_data.is_Array() )
+            write_uint(dst.ptr, 8, ity.m_data.as_Array().size_val);
+        else
+            memcpy(dst.ptr, s.ptr + 8, 8);
+        ),
+    (DstPtr,
+        auto s = get_place(f, e.val);
+        memcpy(dst.ptr, s.ptr, 8);
+        ),
+    (MakeDst,
+        ParamValue  p, m;
+        eval_param(f, e.ptr_val, p);
+        eval_param(f, e.meta_val, m);
+        memcpy(tmp, p.ptr, 8);
+        memcpy(tmp + 8, m.ptr, 8);
+        memcpy(dst.ptr, tmp, 16);
+        ),
+    (Tuple,
+        for(size_t i = 0; i < e.vals.size(); i ++)
+        {
+            ParamValue  v;
+            eval_param(f, e.vals[i], v);
+            memcpy(tmp + dl.fields.at(i).offset, v.ptr, get_layout(dl.fields[i].ty).size);
+        }
+        memcpy(dst.ptr, tmp, dl.size);
+        ),
+    (Array,
+        const auto& ity = *dst.ty->m_data.as_Array().inner;
+        size_t elem_size = get_layout(ity).size;
+        for(size_t i = 0; i < e.vals.size(); i ++)
+        {
+            ParamValue  v;
+            eval_param(f, e.vals[i], v);
+            memcpy(tmp + i * elem_size, v.ptr, elem_size);
+        }
+        memcpy(dst.ptr, tmp, dl.size);
+        ),
+    (Variant,
+        ParamValue  v;
+        eval_param(f, e.val, v);
+        if( dl.tag_size > 0 )
+        {
+            write_uint(tmp, dl.tag_size, dl.tags.at(e.index));
+            if( !dl.variants.empty() )
+            {
+                const auto& var = dl.variants.at(e.index);
+                memcpy(tmp + var.offset, v.ptr, get_layout(var.ty).size);
+            }
+        }
+        else
+        {
+            memcpy(tmp, v.ptr, get_layout(dl.fields.at(e.index).ty).size);
+        }
+        memcpy(dst.ptr, tmp, dl.size);
+        ),
+    (Struct,
+        for(size_t i = 0; i < e.vals.size(); i ++)
+        {
+            ParamValue  v;
+            eval_param(f, e.vals[i], v);
+            memcpy(tmp + dl.fields.at(i).offset, v.ptr, get_layout(dl.fields[i].ty).size);
+        }
+        memcpy(dst.ptr, tmp, dl.size);
+        )
+    )
+}
+void Interpreter::exec_cast(const ::MIR::TypeResolve& mir_res, uint8_t* dst, const ::HIR::TypeRef& dst_ty, const Place& src)
+{
+    const auto& sty = *src.ty;
+    auto dst_size = get_layout(dst_ty).size;
+    if( const auto* dte = dst_ty.m_data.opt_Primitive() )
+    {
+        auto dct = *dte;
+        if( core_is_float(dct) )
+        {
+            MIR_ASSERT(mir_res, sty.m_data.is_Primitive(), "Cast to float from " << sty);
+            auto sct = sty.m_data.as_Primitive();
+            double v;
+            if( core_is_float(sct) )
+                v = read_float(src.ptr, sct);
+            else if( core_is_signed(sct) )
+                v = static_cast<double>( sext(read_uint(src.ptr, core_size(sct)), core_size(sct)) );
+            else
+                v = static_cast<double>( read_uint(src.ptr, core_size(sct)) );
+            write_float(dst, dct, v);
+        }
+        else
+        {
+            uint64_t v;
+            if( const auto* ste = sty.m_data.opt_Primitive() )
+            {
+                auto sct = *ste;
+                if( core_is_float(sct) ) {
+                    double d = read_float(src.ptr, sct);
+                    v = core_is_signed(dct) ? static_cast<uint64_t>(static_cast<int64_t>(d)) : static_cast<uint64_t>(d);
+                }
+                else if( core_is_signed(sct) )
+                    v = static_cast<uint64_t>( sext(read_uint(src.ptr, core_size(sct)), core_size(sct)) );
+                else
+                    v = read_uint(src.ptr, core_size(sct));
+            }
+            else if( sty.m_data.is_Pointer() || sty.m_data.is_Borrow() || sty.m_data.is_Function() )
+            {
+                v = read_uint(src.ptr, 8);
+            }
+            else if( sty.m_data.is_Path() && get_layout(sty).tag_size > 0 )
+            {
+                v = read_uint(src.ptr, get_layout(sty).tag_size);
+            }
+            else
+            {
+                MIR_BUG(mir_res, "Unexpected cast from " << sty << " to " << dst_ty);
+            }
+            if( dct == ::HIR::CoreType::Bool )
+                v = (v != 0);
+            write_uint(dst, dst_size, v);
+        }
+    }
+    else if( dst_ty.m_data.is_Pointer() || dst_ty.m_data.is_Borrow() || dst_ty.m_data.is_Function() )
+    {
+        if( sty.m_data.is_Primitive() )
+        {
+            write_uint(dst, 8, read_uint(src.ptr, core_size(sty.m_data.as_Primitive())));
+        }
+        else
+        {
+            auto src_size = get_layout(sty).size;
+            MIR_ASSERT(mir_res, src_size >= dst_size, "Cast from thin to fat pointer - " << sty << " to " << dst_ty);
+            memcpy(dst, src.ptr, dst_size);
+        }
+    }
+    else
+    {
+        MIR_BUG(mir_res, "Unexpected cast from " << sty << " to " << dst_ty);
+    }
+}
+
+namespace {
+    /// Integer binary operation on the low `size` bytes of the operands (comparisons return 0/1)
+    uint64_t int_binop(::MIR::eBinOp op, size_t size, bool is_signed, uint64_t a, uint64_t b, bool& div_zero)
+    {
+        int64_t sa = sext(a, size), sb = sext(b, size);
+        a &= mask(size);
+        b &= mask(size);
+        div_zero = false;
+        switch(op)
+        {
+        case ::MIR::eBinOp::ADD:
+        case ::MIR::eBinOp::ADD_OV:
+            return a + b;
+        case ::MIR::eBinOp::SUB:
+        case ::MIR::eBinOp::SUB_OV:
+            return a - b;
+        case ::MIR::eBinOp::MUL:
+        case ::MIR::eBinOp::MUL_OV:
+            return a * b;
+        case ::MIR::eBinOp::DIV:
+        case ::MIR::eBinOp::DIV_OV:
+            if( b == 0 ) { div_zero = true; return 0; }
+            if( is_signed )
+                return (sb == -1 ? 0 - a : static_cast<uint64_t>(sa / sb));
+            return a / b;
+        case ::MIR::eBinOp::MOD:
+            if( b == 0 ) { div_zero = true; return 0; }
+            if( is_signed )
+                return (sb == -1 ? 0 : static_cast<uint64_t>(sa % sb));
+            return a % b;
+        case ::MIR::eBinOp::BIT_OR:
+            return a | b;
+        case ::MIR::eBinOp::BIT_AND:
+            return a & b;
+        case ::MIR::eBinOp::BIT_XOR:
+            return a ^ b;
+        case ::MIR::eBinOp::BIT_SHR:
+            b &= size * 8 - 1;
+            return is_signed ? static_cast<uint64_t>(sa >> b) : a >> b;
+        case ::MIR::eBinOp::BIT_SHL:
+            b &= size * 8 - 1;
+            return a << b;
+        case ::MIR::eBinOp::EQ: return a == b;
+        case ::MIR::eBinOp::NE: return a != b;
+        case ::MIR::eBinOp::GT: return is_signed ? sa >  sb : a >  b;
+        case ::MIR::eBinOp::GE: return is_signed ? sa >= sb : a >= b;
+        case ::MIR::eBinOp::LT: return is_signed ? sa <  sb : a <  b;
+        case ::MIR::eBinOp::LE: return is_signed ? sa <= sb : a <= b;
+        }
+        throw "";
+    }
+    bool is_comparison(::MIR::eBinOp op)
+    {
+        switch(op)
+        {
+        case ::MIR::eBinOp::EQ: case ::MIR::eBinOp::NE:
+        case ::MIR::eBinOp::GT: case ::MIR::eBinOp::GE:
+        case ::MIR::eBinOp::LT: case ::MIR::eBinOp::LE:
+            return true;
+        default:
+            return false;
+        }
+    }
+    /// Returns true if `a op b` (for ADD/SUB/MUL) overflows the integer type
+    bool int_overflows(::MIR::eBinOp op, size_t size, bool is_signed, uint64_t a, uint64_t b)
+    {
+        bool dz;
+        uint64_t r = int_binop(op, size, is_signed, a, b, dz);
+        if( size < 8 )
+        {
+            // The exact result fits in 64 bits, check that truncation doesn't change it
+            if( is_signed )
+                return sext(r, size) != static_cast<int64_t>(r);
+            return (r & ~mask(size)) != 0;
+        }
+        int64_t sa = static_cast<int64_t>(a), sb = static_cast<int64_t>(b), sr = static_cast<int64_t>(r);
+        switch(op)
+        {
+        case ::MIR::eBinOp::ADD:
+            return is_signed ? ((sa ^ sr) & (sb ^ sr)) < 0 : r < a;
+        case ::MIR::eBinOp::SUB:
+            return is_signed ? ((sa ^ sb) & (sa ^ sr)) < 0 : a < b;
+        case ::MIR::eBinOp::MUL:
+            if( a == 0 || b == 0 )
+                return false;
+            if( is_signed )
+                return (sa == -1 && sb == INT64_MIN) || (sb == -1 && sa == INT64_MIN) || (sa != -1 && sr / sa != sb);
+            return r / a != b;
+        default:
+            throw "";
+        }
+    }
+}
+void Interpreter::exec_binop(const ::MIR::TypeResolve& mir_res, uint8_t* dst, const ParamValue& l, ::MIR::eBinOp op, const ParamValue& r)
+{
+    const auto& ty = *l.ty;
+    if( const auto* te = ty.m_data.opt_Primitive() )
+    {
+        auto ct = *te;
+        if( core_is_float(ct) )
+        {
+            double a = read_float(l.ptr, ct), b = read_float(r.ptr, ct);
+            switch(op)
+            {
+            case ::MIR::eBinOp::ADD: case ::MIR::eBinOp::ADD_OV:  write_float(dst, ct, a + b);  break;
+            case ::MIR::eBinOp::SUB: case ::MIR::eBinOp::SUB_OV:  write_float(dst, ct, a - b);  break;
+            case ::MIR::eBinOp::MUL: case ::MIR::eBinOp::MUL_OV:  write_float(dst, ct, a * b);  break;
+            case ::MIR::eBinOp::DIV: case ::MIR::eBinOp::DIV_OV:  write_float(dst, ct, a / b);  break;
+            case ::MIR::eBinOp::MOD:  write_float(dst, ct, ::std::fmod(a, b));  break;
+            case ::MIR::eBinOp::EQ: *dst = (a == b);  break;
+            case ::MIR::eBinOp::NE: *dst = (a != b);  break;
+            case ::MIR::eBinOp::GT: *dst = (a >  b);  break;
+            case ::MIR::eBinOp::GE: *dst = (a >= b);  break;
+            case ::MIR::eBinOp::LT: *dst = (a <  b);  break;
+            case ::MIR::eBinOp::LE: *dst = (a <= b);  break;
+            default:
+                MIR_BUG(mir_res, "Invalid float operation");
+            }
+            return ;
+        }
+        auto size = core_size(ct);
+        if( size > 8 )
+            UNSUPPORTED(sp, "128-bit integers aren't supported by the interpreter (" << FMT_CB(os, mir_res.fmt_pos(os);) << ")");
+        bool is_signed = core_is_signed(ct);
+        uint64_t a = read_uint(l.ptr, size);
+        uint64_t b;
+        if( op == ::MIR::eBinOp::BIT_SHR || op == ::MIR::eBinOp::BIT_SHL )
+        {
+            // Shift amounts can be a different type
+            MIR_ASSERT(mir_res, r.ty->m_data.is_Primitive(), "Shift by non-primitive " << *r.ty);
+            b = read_uint(r.ptr, core_size(r.ty->m_data.as_Primitive()));
+        }
+        else
+        {
+            b = read_uint(r.ptr, size);
+        }
+        bool div_zero;
+        auto v = int_binop(op, size, is_signed, a, b, div_zero);
+        if( div_zero )
+            MIR_BUG(mir_res, "Division by zero");
+        if( is_comparison(op) )
+            *dst = static_cast<uint8_t>(v);
+        else
+            write_uint(dst, size, v);
+    }
+    else if( ty.m_data.is_Pointer() || ty.m_data.is_Borrow() || ty.m_data.is_Function() )
+    {
+        MIR_ASSERT(mir_res, is_comparison(op), "Invalid operation on pointers");
+        auto size = get_layout(ty).size;
+        if( op == ::MIR::eBinOp::EQ || op == ::MIR::eBinOp::NE ) {
+            bool eq = memcmp(l.ptr, r.ptr, size) == 0;
+            *dst = (op == ::MIR::eBinOp::EQ ? eq : !eq);
+        }
+        else {
+            bool dz;
+            *dst = static_cast<uint8_t>( int_binop(op, 8, false, read_uint(l.ptr, 8), read_uint(r.ptr, 8), dz) );
+        }
+    }
+    else
+    {
+        MIR_BUG(mir_res, "BinOp on unexpected type " << ty);
+    }
+}
+
+void Interpreter::call_drop_impl(uint8_t* ptr, uint64_t meta, const ::HIR::TypeRef& ty)
+{
+    auto& fi = get_function( ::HIR::Path(ty.clone(), ::HIR::GenericPath(m_resolve.m_lang_Drop), "drop") );
+    uint8_t arg[16];
+    write_ptr(arg, ptr);
+    write_uint(arg + 8, 8, meta);
+    uint8_t ret[8];
+    call_function(fi, ret, { arg });
+}
+void Interpreter::call_box_free(uint8_t* box_ptr, const ::HIR::TypeRef& inner_ty)
+{
+    // NOTE: The pointer is at the start of the box (matches the C backend)
+    ::HIR::GenericPath  box_free { m_crate.get_lang_item_path(sp, "box_free"), { inner_ty.clone() } };
+    auto& fi = get_function( ::HIR::Path(mv$(box_free)) );
+    uint8_t ret[8];
+    call_function(fi, ret, { box_ptr });
+}
+void Interpreter::drop_value(uint8_t* ptr, uint64_t meta, const ::HIR::TypeRef& ty)
+{
+    if( !m_resolve.type_needs_drop_glue(sp, ty) )
+        return ;
+    TRACE_FUNCTION_F(ty);
+    TU_MATCH_DEF( ::HIR::TypeRef::Data, (ty.m_data), (te),
+    (
+        ),
+    (Borrow,
+        if( te.type == ::HIR::BorrowType::Owned )
+        {
+            auto imeta = (get_meta_kind(*te.inner) != MetaKind::None ? read_uint(ptr + 8, 8) : 0);
+            drop_value(read_ptr(ptr), imeta, *te.inner);
+        }
+        ),
+    (Path,
+        if( const auto* ity = m_resolve.is_type_owned_box(ty) )
+        {
+            auto imeta = (get_meta_kind(*ity) != MetaKind::None ? read_uint(ptr + 8, 8) : 0);
+            drop_value(read_ptr(ptr), imeta, *ity);
+            call_box_free(ptr, *ity);
+            return ;
+        }
+        bool has_drop_impl = false;
+        TU_MATCH_DEF( ::HIR::TypeRef::TypePathBinding, (te.binding), (tpb),
+        (
+            BUG(sp, "Unbound type path in interpreter - " << ty);
+            ),
+        (Struct, has_drop_impl = tpb->m_markings.has_drop_impl; ),
+        (Union,  has_drop_impl = tpb->m_markings.has_drop_impl; ),
+        (Enum,   has_drop_impl = tpb->m_markings.has_drop_impl; )
+        )
+        if( has_drop_impl )
+            call_drop_impl(ptr, meta, ty);
+
+        const auto& l = get_layout(ty);
+        if( te.binding.is_Struct() )
+        {
+            for(size_t i = 0; i < l.fields.size(); i ++)
+            {
+                bool is_tail = (i == l.fields.size() - 1 && get_meta_kind(l.fields[i].ty) != MetaKind::None);
+                if( is_tail )
+                    drop_value(ptr + tail_offset(l, meta), meta, l.fields[i].ty);
+                else
+                    drop_value(ptr + l.fields[i].offset, 0, l.fields[i].ty);
+            }
+        }
+        else if( te.binding.is_Enum() && !l.variants.empty() )
+        {
+            const auto& var = l.variants.at( get_variant(l, ptr) );
+            drop_value(ptr + var.offset, 0, var.ty);
+        }
+        ),
+    (Tuple,
+        const auto& l = get_layout(ty);
+        for(const auto& f : l.fields)
+            drop_value(ptr + f.offset, 0, f.ty);
+        ),
+    (Array,
+        size_t elem_size = get_layout(*te.inner).size;
+        for(size_t i = 0; i < te.size_val; i ++)
+            drop_value(ptr + i * elem_size, 0, *te.inner);
+        ),
+    (Slice,
+        size_t elem_size = get_layout(*te.inner).size;
+        for(size_t i = 0; i < meta; i ++)
+            drop_value(ptr + i * elem_size, 0, *te.inner);
+        ),
+    (TraitObject,
+        const auto* drop_fcn = read_ptr(reinterpret_cast<const uint8_t*>(meta) + 16);
+        if( drop_fcn )
+        {
+            uint8_t arg[8];
+            write_ptr(arg, ptr);
+            uint8_t ret[8];
+            call_function(get_function_from_addr(drop_fcn), ret, { arg });
+        }
+        )
+    )
+}
+
+void Interpreter::call_intrinsic(const ::std::string& name, const ::HIR::PathParams& params,
+    uint8_t* ret, const ::HIR::TypeRef& ret_ty,
+    const ::std::vector<const uint8_t*>& args, const ::std::vector<const ::HIR::TypeRef*>& arg_tys
+    )
+{
+    TRACE_FUNCTION_F(name << params);
+    auto ty0 = [&]()->const ::HIR::TypeRef& { return params.m_types.at(0); };
+    auto arg_meta = [&](size_t i)->uint64_t {
+        return get_layout(*arg_tys.at(i)).size > 8 ? read_uint(args[i] + 8, 8) : 0;
+        };
+    // Integer type of an intrinsic's first parameter
+    auto int_info = [&](size_t& size, bool& is_signed) {
+        const auto& t = ty0();
+        ASSERT_BUG(sp, t.m_data.is_Primitive(), "Integer intrinsic " << name << " on " << t);
+        size = core_size(t.m_data.as_Primitive());
+        if( size > 8 )
+            UNSUPPORTED(sp, "128-bit integers aren't supported by the interpreter (intrinsic " << name << ")");
+        is_signed = core_is_signed(t.m_data.as_Primitive());
+        };
+
+    if( name == "size_of" ) {
+        write_uint(ret, 8, get_layout(ty0()).size);
+    }
+    else if( name == "min_align_of" || name == "align_of" || name == "pref_align_of" ) {
+        write_uint(ret, 8, get_layout(ty0()).align);
+    }
+    else if( name == "size_of_val" ) {
+        write_uint(ret, 8, size_of_val(ty0(), arg_meta(0)));
+    }
+    else if( name == "min_align_of_val" || name == "align_of_val" ) {
+        write_uint(ret, 8, align_of_val(ty0(), arg_meta(0)));
+    }
+    else if( name == "type_id" ) {
+        auto it = m_type_ids.find(ty0());
+        if( it == m_type_ids.end() )
+            it = m_type_ids.insert( ::std::make_pair(ty0().clone(), m_type_ids.size() + 1) ).first;
+        write_uint(ret, 8, it->second);
+    }
+    else if( name == "type_name" ) {
+        auto s = FMT(ty0());
+        write_ptr(ret, intern_string(s));
+        write_uint(ret + 8, 8, s.size());
+    }
+    else if( name == "transmute" ) {
+        memcpy(ret, args.at(0), get_layout(ret_ty).size);
+    }
+    else if( name == "copy" || name == "copy_nonoverlapping" ) {
+        // (src, dst, count)
+        memmove(read_ptr(args.at(1)), read_ptr(args.at(0)), read_uint(args.at(2), 8) * get_layout(ty0()).size);
+    }
+    else if( name == "write_bytes" ) {
+        memset(read_ptr(args.at(0)), *args.at(1), read_uint(args.at(2), 8) * get_layout(ty0()).size);
+    }
+    else if( name == "forget" || name == "assume" || name == "uninit" ) {
+    }
+    else if( name == "init" ) {
+        memset(ret, 0, get_layout(ret_ty).size);
+    }
+    else if( name == "move_val_init" ) {
+        memcpy(read_ptr(args.at(0)), args.at(1), get_layout(ty0()).size);
+    }
+    else if( name == "drop_in_place" ) {
+        drop_value(read_ptr(args.at(0)), arg_meta(0), ty0());
+    }
+    else if( name == "needs_drop" ) {
+        *ret = m_resolve.type_needs_drop_glue(sp, ty0());
+    }
+    else if( name == "abort" ) {
+        fflush(stdout);
+        abort();
+    }
+    else if( name == "unreachable" ) {
+        ERROR(sp, E0000, "Interpreted code reached `unreachable`");
+    }
+    else if( name == "likely" || name == "unlikely" ) {
+        *ret = *args.at(0);
+    }
+    else if( name == "try" ) {
+        // (f: fn(*mut u8), data: *mut u8, local_ptr: *mut u8) - Unwinding isn't supported, so this always succeeds
+        uint8_t inner_ret[8];
+        call_function(get_function_from_addr(read_ptr(args.at(0))), inner_ret, { args.at(1) });
+        write_uint(ret, 4, 0);
+    }
+    else if( name == "offset" || name == "arith_offset" ) {
+        const auto& ity = *arg_tys.at(0)->m_data.as_Pointer().inner;
+        auto ofs = static_cast<int64_t>(read_uint(args.at(1), 8));
+        write_ptr(ret, read_ptr(args.at(0)) + ofs * static_cast<int64_t>(get_layout(ity).size));
+    }
+    else if( name == "bswap" ) {
+        auto size = get_layout(ty0()).size;
+        for(size_t i = 0; i < size; i ++)
+            ret[i] = args.at(0)[size - 1 - i];
+    }
+    else if( name == "ctpop" || name == "ctlz" || name == "cttz" || name == "ctlz_nonzero" || name == "cttz_nonzero" ) {
+        size_t size; bool is_signed;
+        int_info(size, is_signed);
+        uint64_t v = read_uint(args.at(0), size);
+        unsigned bits = size * 8;
+        uint64_t rv = 0;
+        if( name == "ctpop" ) {
+            for(unsigned i = 0; i < bits; i ++)
+                rv += (v >> i) & 1;
+        }
+        else if( name.compare(0, 4, "ctlz") == 0 ) {
+            while( rv < bits && !(v & (1ull << (bits - 1 - rv))) )
+                rv ++;
+        }
+        else {
+            while( rv < bits && !(v & (1ull << rv)) )
+                rv ++;
+        }
+        write_uint(ret, size, rv);
+    }
+    else if( name == "discriminant_value" ) {
+        const auto& l = get_layout(ty0());
+        write_uint(ret, 8, l.tag_size > 0 ? read_uint(read_ptr(args.at(0)), l.tag_size) : 0);
+    }
+    else if( name == "add_with_overflow" || name == "sub_with_overflow" || name == "mul_with_overflow" ) {
+        size_t size; bool is_signed;
+        int_info(size, is_signed);
+        auto op = (name[0] == 'a' ? ::MIR::eBinOp::ADD : name[0] == 's' ? ::MIR::eBinOp::SUB : ::MIR::eBinOp::MUL);
+        uint64_t a = read_uint(args.at(0), size), b = read_uint(args.at(1), size);
+        const auto& rl = get_layout(ret_ty);
+        bool dz;
+        write_uint(ret + rl.fields.at(0).offset, size, int_binop(op, size, is_signed, a, b, dz));
+        ret[rl.fields.at(1).offset] = int_overflows(op, size, is_signed, is_signed ? sext(a, size) : a, is_signed ? sext(b, size) : b);
+    }
+    else if( name == "overflowing_add" || name == "overflowing_sub" || name == "overflowing_mul"
+          || name == "unchecked_div" || name == "unchecked_rem" || name == "exact_div"
+          || name == "unchecked_shl" || name == "unchecked_shr" )
+    {
+        size_t size; bool is_signed;
+        int_info(size, is_signed);
+        ::MIR::eBinOp   op;
+        if( name == "overflowing_add" ) op = ::MIR::eBinOp::ADD;
+        else if( name == "overflowing_sub" ) op = ::MIR::eBinOp::SUB;
+        else if( name == "overflowing_mul" ) op = ::MIR::eBinOp::MUL;
+        else if( name == "unchecked_rem" ) op = ::MIR::eBinOp::MOD;
+        else if( name == "unchecked_shl" ) op = ::MIR::eBinOp::BIT_SHL;
+        else if( name == "unchecked_shr" ) op = ::MIR::eBinOp::BIT_SHR;
+        else op = ::MIR::eBinOp::DIV;
+        bool div_zero;
+        auto v = int_binop(op, size, is_signed, read_uint(args.at(0), size), read_uint(args.at(1), size), div_zero);
+        if( div_zero )
+            ERROR(sp, E0000, "Division by zero in interpreted code");
+        write_uint(ret, size, v);
+    }
+    else if( name == "volatile_load" ) {
+        memcpy(ret, read_ptr(args.at(0)), get_layout(ty0()).size);
+    }
+    else if( name == "volatile_store" ) {
+        memcpy(read_ptr(args.at(0)), args.at(1), get_layout(ty0()).size);
+    }
+    else if( name.compare(0, 7, "atomic_") == 0 ) {
+        // The interpreter is single-threaded, so the ordering can be ignored
+        auto op = name.substr(7, name.find('_', 7) - 7);
+        if( op == "fence" || op == "singlethreadfence" ) {
+            return ;
+        }
+        size_t size = get_layout(ty0()).size;
+        bool is_signed = ty0().m_data.is_Primitive() && core_is_signed(ty0().m_data.as_Primitive());
+        uint8_t* ptr = read_ptr(args.at(0));
+        uint64_t cur = read_uint(ptr, size);
+        if( op == "load" ) {
+            write_uint(ret, size, cur);
+        }
+        else if( op == "store" ) {
+            memcpy(ptr, args.at(1), size);
+        }
+        else if( op == "cxchg" || op == "cxchgweak" ) {
+            // Returns (old, success)
+            const auto& rl = get_layout(ret_ty);
+            bool ok = (cur == read_uint(args.at(1), size));
+            if( ok )
+                memcpy(ptr, args.at(2), size);
+            write_uint(ret + rl.fields.at(0).offset, size, cur);
+            ret[rl.fields.at(1).offset] = ok;
+        }
+        else {
+            uint64_t v = read_uint(args.at(1), size);
+            uint64_t nv;
+            bool dz;
+            if( op == "xchg" )  nv = v;
+            else if( op == "xadd" ) nv = cur + v;
+            else if( op == "xsub" ) nv = cur - v;
+            else if( op == "and" )  nv = cur & v;
+            else if( op == "nand" ) nv = ~(cur & v);
+            else if( op == "or" )   nv = cur | v;
+            else if( op == "xor" )  nv = cur ^ v;
+            else if( op == "max" || op == "umax" )
+                nv = int_binop(::MIR::eBinOp::GT, size, op == "max" && is_signed, cur, v, dz) ? cur : v;
+            else if( op == "min" || op == "umin" )
+                nv = int_binop(::MIR::eBinOp::LT, size, op == "min" && is_signed, cur, v, dz) ? cur : v;
+            else
+                UNSUPPORTED(sp, "Atomic intrinsic " << name << " isn't supported by the interpreter");
+            write_uint(ptr, size, nv);
+            write_uint(ret, size, cur);
+        }
+    }
+    else if( name.size() > 3 && (name.compare(name.size() - 3, 3, "f32") == 0 || name.compare(name.size() - 3, 3, "f64") == 0) ) {
+        auto ct = (name.compare(name.size() - 3, 3, "f32") == 0 ? ::HIR::CoreType::F32 : ::HIR::CoreType::F64);
+        auto op = name.substr(0, name.size() - 3);
+        double a = read_float(args.at(0), ct);
+        auto b = [&]()->double { return read_float(args.at(1), ct); };
+        double v;
+        if( op == "sqrt" )  v = ::std::sqrt(a);
+        else if( op == "powi" ) v = ::std::pow(a, static_cast<int32_t>(read_uint(args.at(1), 4)));
+        else if( op == "pow" )  v = ::std::pow(a, b());
+        else if( op == "sin" )  v = ::std::sin(a);
+        else if( op == "cos" )  v = ::std::cos(a);
+        else if( op == "exp" )  v = ::std::exp(a);
+        else if( op == "exp2" ) v = ::std::exp2(a);
+        else if( op == "log" )  v = ::std::log(a);
+        else if( op == "log10" )    v = ::std::log10(a);
+        else if( op == "log2" ) v = ::std::log2(a);
+        else if( op == "fabs" ) v = ::std::fabs(a);
+        else if( op == "copysign" ) v = ::std::copysign(a, b());
+        else if( op == "floor" )    v = ::std::floor(a);
+        else if( op == "ceil" ) v = ::std::ceil(a);
+        else if( op == "trunc" )    v = ::std::trunc(a);
+        else if( op == "round" )    v = ::std::round(a);
+        else if( op == "fma" )  v = ::std::fma(a, b(), read_float(args.at(2), ct));
+        else
+            UNSUPPORTED(sp, "Float intrinsic " << name << " isn't supported by the interpreter");
+        write_float(ret, ct, v);
+    }
+    else {
+        UNSUPPORTED(sp, "Intrinsic " << name << " isn't supported by the interpreter");
+    }
+}
+
+int Interpreter::run_main(const ::std::string& program_name)
+{
+    ::std::vector<char*>    argv;
+    argv.push_back( const_cast<char*>(intern_string(program_name)) );
+    argv.push_back( nullptr );
+    int64_t argc = 1;
+    char** argv_p = argv.data();
+
+    uint8_t ret[16] = {};
+    const ::HIR::TypeRef* ret_ty;
+    auto c_start_path = m_crate.get_lang_item_path_opt("mrustc-start");
+    if( c_start_path == ::HIR::SimplePath() )
+    {
+        // `fn main()` - Called directly, skipping std's `start` (its runtime setup uses signal handlers and stack
+        // guards, which the interpreter doesn't support)
+        auto& main_fcn = get_function( ::HIR::GenericPath(m_crate.get_lang_item_path(sp, "mrustc-main")) );
+        resolve_function(main_fcn);
+        call_function(main_fcn, ret, {});
+        ret_ty = &main_fcn.ret_type;
+    }
+    else
+    {
+        // `#[start]` function
+        auto& start = get_function( ::HIR::GenericPath(c_start_path) );
+        resolve_function(start);
+        uint8_t argc_v[8];
+        write_uint(argc_v, get_layout(start.args.at(0).second).size, argc);
+        call_function(start, ret, { argc_v, reinterpret_cast<const uint8_t*>(&argv_p) });
+        ret_ty = &start.ret_type;
+    }
+    fflush(stdout);
+    auto size = get_layout(*ret_ty).size;
+    return static_cast<int>( sext(read_uint(ret, size), size) );
+}
+
+int Trans_Interpret_Main(const ::HIR::Crate& crate, const ::std::string& program_name)
+{
+    ::std::cout.flush();
+    Interpreter interp(crate);
+    try
+    {
+        return interp.run_main(program_name);
+    }
+    catch(const Unsupported& e)
+    {
+        ::std::cerr << e.msg << ::std::endl;
+        return INTERPRET_UNSUPPORTED_STATUS;
+    }
+    catch(const Panicked& )
+    {
+        return 101;
+    }
+}
@@ -13,18 +13,44 @@ namespace HIR {
 class Crate;
 }
 
+enum class CodegenBackend
+{
+    /// Emit C and compile it with the target's C compiler
+    C,
+    /// Lower functions directly to an x86-64 object (falling back to C for anything unsupported)
+    X86_64,
+};
+
 struct TransOptions
 {
     unsigned int opt_level = 0;
     bool emit_debug_info = false;
+    /// Emit function bodies as nested if/switch/loop statements instead of a flat list of labels and `goto`s
+    bool structured_c = false;
+    /// Annotate the generated C with the source paths, local types and MIR of each item (for debugging the backend)
+    bool verbose_c = false;
+    CodegenBackend  backend = CodegenBackend::C;
 
     ::std::vector< ::std::string>   library_search_dirs;
     ::std::vector< ::std::string>   libraries;
+    /// Additional object files to link into the output
+    ::std::vector< ::std::string>   extra_objects;
+    /// All code is in the executable's own object (other crates' objects aren't linked)
+    bool whole_program = false;
 };
 
-extern TransList Trans_Enumerate_Main(const ::HIR::Crate& crate);
+extern TransList Trans_Enumerate_Main(const ::HIR::Crate& crate, bool whole_program=false);
+/// Whole-program builds: move the MIR and static values saved by `-Z save-all-mir` where codegen expects them
+extern void Trans_Enumerate_LoadSavedCode(::HIR::Crate& crate);
 extern TransList Trans_Enumerate_Test(const ::HIR::Crate& crate);
 // NOTE: This also sets the saveout flags
-extern TransList Trans_Enumerate_Public(::HIR::Crate& crate);
+extern TransList Trans_Enumerate_Public(::HIR::Crate& crate, bool only_exported=false);
+
+/// Exit status of `-Z interpret` when the program needed something the interpreter doesn't support
+/// NOTE: Also known by minicargo (which then compiles the program instead)
+const int INTERPRET_UNSUPPORTED_STATUS = 125;
+/// Run the crate's `main` using the MIR interpreter, returning the exit code
+/// - Functions from other crates are only available if they were built with `-Z save-all-mir` (or are generic/inline)
+extern int Trans_Interpret_Main(const ::HIR::Crate& crate, const ::std::string& program_name);
 
 extern void Trans_Codegen(const ::std::string& outfile, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, bool is_executable);
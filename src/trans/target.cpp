@@ -27,6 +27,7 @@ TargetSpec  g_target;
 
 
 bool Target_GetSizeAndAlignOf(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty, size_t& out_size, size_t& out_align);
+static bool get_size_and_align_inner(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty, size_t& out_size, size_t& out_align);
 
 namespace
 {
@@ -225,23 +226,33 @@ namespace {
 }
 const StructRepr* Target_GetStructRepr(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty)
 {
-    // TODO: Thread safety
-    // Map of generic paths to struct representations.
-    static ::std::map<::HIR::TypeRef, ::std::unique_ptr<StructRepr>>  s_cache;
-
-    auto it = s_cache.find(ty);
-    if( it != s_cache.end() )
+    if( const auto* rv = resolve.m_type_props.get_struct_repr(ty) )
     {
-        return it->second.get();
+        return rv;
     }
-
-    auto ires = s_cache.insert(::std::make_pair( ty.clone(), make_struct_repr(sp, resolve, ty) ));
-    return ires.first->second.get();
+    // NOTE: Struct types passed here are always concrete, so the result can be shared
+    ::std::shared_ptr<const StructRepr> repr( make_struct_repr(sp, resolve, ty) );
+    return resolve.m_type_props.set_struct_repr(ty, mv$(repr));
 }
 
 // TODO: Include NonZero and other repr optimisations here
 
 bool Target_GetSizeAndAlignOf(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty, size_t& out_size, size_t& out_align)
+{
+    if( !TypePropertyCache::is_cacheable(ty) )
+    {
+        return get_size_and_align_inner(sp, resolve, ty, out_size, out_align);
+    }
+    bool rv;
+    if( resolve.m_type_props.get_layout(ty, rv, out_size, out_align) )
+    {
+        return rv;
+    }
+    rv = get_size_and_align_inner(sp, resolve, ty, out_size, out_align);
+    resolve.m_type_props.set_layout(ty, rv, rv ? out_size : 0, rv ? out_align : 0);
+    return rv;
+}
+static bool get_size_and_align_inner(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty, size_t& out_size, size_t& out_align)
 {
     TU_MATCHA( (ty.m_data), (te),
     (Infer,
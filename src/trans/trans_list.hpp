@@ -16,6 +16,7 @@ namespace HIR {
 class Crate;
 class Function;
 class Static;
+class Constant;
 }
 
 struct Trans_Params
@@ -45,6 +46,8 @@ struct TransList_Function
 {
     const ::HIR::Function*  ptr;
     Trans_Params    pp;
+    /// Instance is exported by the crate that defines it (so is referenced instead of emitted)
+    bool    upstream = false;
 };
 struct TransList_Static
 {
@@ -52,6 +55,20 @@ struct TransList_Static
     Trans_Params    pp;
 };
 
+/// Item pointed to by a monomorphised value path
+struct Trans_ResolvedItem
+{
+    /// Set for items that have no HIR definition (constructors, vtables, and methods on trait objects or function pointers)
+    bool    auto_generate = false;
+    const ::HIR::Function*  fcn = nullptr;
+    const ::HIR::Static*    stat = nullptr;
+    const ::HIR::Constant*  constant = nullptr;
+    /// Parameters for monomorphising the item's body
+    Trans_Params    pp;
+};
+/// Locate the item for a monomorphised path (all pointers null if it wasn't found)
+extern Trans_ResolvedItem Trans_ResolveItem(const ::HIR::Crate& crate, const ::HIR::Path& path);
+
 class TransList
 {
 public:
@@ -24,6 +24,8 @@
 # include <sys/stat.h>
 # include <sys/wait.h>
 # include <fcntl.h>
+# include <sys/socket.h>
+# include <sys/un.h>
 #endif
 
 #ifdef _WIN32
@@ -147,6 +149,13 @@ public:
         m_keys(::std::move(x.m_keys))
     {
     }
+    StringListKV clone() const
+    {
+        StringListKV    rv;
+        for(auto kv : *this)
+            rv.push_back(kv.first, ::std::string(kv.second));
+        return rv;
+    }
 
     void push_back(const char* k, ::std::string v)
     {
@@ -788,6 +797,9 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     if( true /*this->enable_optimise*/ ) {
         args.push_back("-O");
     }
+    if( m_opts.interpret_build_scripts ) {
+        args.push_back("-Z"); args.push_back("save-all-mir");
+    }
     args.push_back("-o"); args.push_back(outfile);
     args.push_back("-L"); args.push_back(m_opts.output_dir.str().c_str());
     for(const auto& dir : manifest.build_script_output().rustc_link_search) {
@@ -853,32 +865,39 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
 
     return this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt");
 }
-::std::string Builder::build_build_script(const PackageManifest& manifest) const
+StringList Builder::get_build_script_args(const PackageManifest& manifest) const
 {
-    auto outfile = m_opts.output_dir / manifest.name() + "_build" EXESUF;
-
     StringList  args;
-    args.push_back( ::helpers::path(manifest.manifest_path()).parent() / ::helpers::path(manifest.build_script()) );
+    // NOTE: Paths are absolute, as interpreted scripts are run from the package directory
+    args.push_back( (::helpers::path(manifest.manifest_path()).parent() / ::helpers::path(manifest.build_script())).to_absolute() );
     args.push_back("--crate-name"); args.push_back("build");
     args.push_back("--crate-type"); args.push_back("bin");
-    args.push_back("-o"); args.push_back(outfile);
-    args.push_back("-L"); args.push_back(m_opts.output_dir.str().c_str());
+    args.push_back("-L"); args.push_back(m_opts.output_dir.to_absolute().str());
     for(const auto& d : m_opts.lib_search_dirs)
     {
         args.push_back("-L");
-        args.push_back(d.str().c_str());
+        args.push_back(d.to_absolute().str());
     }
     for(const auto& dep : manifest.build_dependencies())
     {
         if( ! dep.is_disabled() )
         {
             const auto& m = dep.get_package();
-            auto path = this->get_crate_path(m, m.get_library(), nullptr, nullptr);
+            auto path = this->get_crate_path(m, m.get_library(), nullptr, nullptr).to_absolute();
             args.push_back("--extern");
             args.push_back(::format(m.get_library().m_name, "=", path));
         }
     }
 
+    return args;
+}
+::std::string Builder::build_build_script(const PackageManifest& manifest) const
+{
+    auto outfile = m_opts.output_dir / manifest.name() + "_build" EXESUF;
+
+    auto args = this->get_build_script_args(manifest);
+    args.push_back("-o"); args.push_back(outfile);
+
     StringListKV    env;
     env.push_back("CARGO_MANIFEST_DIR", manifest.directory().to_absolute());
     env.push_back("CARGO_PKG_VERSION", ::format(manifest.version()));
@@ -928,12 +947,6 @@ bool Builder::build_library(const PackageManifest& manifest) const
                 // Compile and run build script
                 // - Load dependencies for the build script
                 //  - TODO: Should this have already been done
-                // - Build the script itself
-                auto script_exe = this->build_build_script( manifest );
-                if( script_exe == "" )
-                    return false;
-                auto script_exe_abs = ::helpers::path(script_exe).to_absolute();
-
                 auto output_dir_abs = m_opts.output_dir.to_absolute();
 
                 // - Run the script and put output in the right dir
@@ -975,20 +988,59 @@ bool Builder::build_library(const PackageManifest& manifest) const
                     }
                 }
 
-                #if _WIN32
-                #else
-                auto fd_cwd = open(".", O_DIRECTORY);
-                chdir(manifest.directory().str().c_str());
-                #endif
-                if( !this->spawn_process(script_exe_abs.str().c_str(), {}, env, out_file) )
+                // Scripts are run from the package directory
+                auto run_script = [&](const char* exe, const StringList& args, const StringListKV& script_env, int* out_exit_code)->bool {
+                    #if _WIN32
+                    #else
+                    auto fd_cwd = open(".", O_DIRECTORY);
+                    chdir(manifest.directory().str().c_str());
+                    #endif
+                    bool rv;
+                    if( exe )
+                        rv = this->spawn_process(exe, args, script_env, out_file, out_exit_code);
+                    else
+                        rv = this->spawn_process_mrustc(args, script_env.clone(), out_file, out_exit_code);
+                    #if _WIN32
+                    #else
+                    fchdir(fd_cwd);
+                    close(fd_cwd);
+                    #endif
+                    return rv;
+                    };
+                // NOTE: Exit status used by `mrustc -Z interpret` when the script needs something the interpreter can't do
+                // (see `INTERPRET_UNSUPPORTED_STATUS` in mrustc)
+                const int INTERPRET_UNSUPPORTED_STATUS = 125;
+                bool script_ok = false;
+                bool compile_script = true;
+                if( m_opts.interpret_build_scripts )
+                {
+                    auto args = this->get_build_script_args(manifest);
+                    args.push_back("-Z"); args.push_back("interpret");
+                    int exit_code = -1;
+                    script_ok = run_script(nullptr, args, env, &exit_code);
+                    // Only an unsupported operation is retried natively, a script that failed by itself would just fail
+                    // again (after repeating any side effects)
+                    compile_script = !script_ok && exit_code == INTERPRET_UNSUPPORTED_STATUS;
+                    if( compile_script )
+                    {
+                        // The interpreter doesn't support everything (e.g. FFI calls with floats), so build it normally
+                        ::std::cerr << "The build script of " << manifest.name() << " can't be interpreted, compiling it instead (see " << out_file << "_interp_failed)" << ::std::endl;
+                        rename(out_file.str().c_str(), (out_file+"_interp_failed").str().c_str());
+                    }
+                }
+                if( compile_script )
+                {
+                    auto script_exe = this->build_build_script( manifest );
+                    if( script_exe == "" )
+                        return false;
+                    auto script_exe_abs = ::helpers::path(script_exe).to_absolute();
+                    script_ok = run_script(script_exe_abs.str().c_str(), {}, env, nullptr);
+                }
+                if( !script_ok )
                 {
                     rename(out_file.str().c_str(), (out_file+"_failed").str().c_str());
                     return false;
                 }
-                #if _WIN32
-                #else
-                fchdir(fd_cwd);
-                #endif
             }
             // - Load
             const_cast<PackageManifest&>(manifest).load_build_script( out_file.str() );
@@ -997,12 +1049,107 @@ bool Builder::build_library(const PackageManifest& manifest) const
 
     return this->build_target(manifest, manifest.get_library());
 }
-bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile) const
+bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile, int* out_exit_code) const
 {
     //env.push_back("MRUSTC_DEBUG", "");
-    return spawn_process(m_compiler_path.str().c_str(), args, env, logfile);
+    if( m_opts.compile_server.is_valid() )
+        return send_to_compile_server(args, env, logfile, out_exit_code);
+    return spawn_process(m_compiler_path.str().c_str(), args, env, logfile, out_exit_code);
+}
+bool Builder::send_to_compile_server(const StringList& args, const StringListKV& env, const ::helpers::path& logfile, int* out_exit_code) const
+{
+#ifdef _WIN32
+    // The compile server needs `fork`, so there isn't one on windows - run the compiler directly
+    return spawn_process(m_compiler_path.str().c_str(), args, env, logfile, out_exit_code);
+#else
+    // Request: argc, envc, and data length - then cwd, argv, and env as NUL-terminated strings
+    // - The log file and stderr are passed as the compiler's stdout/stderr
+    ::std::string   data;
+    char    cwd[PATH_MAX];
+    if( !getcwd(cwd, sizeof(cwd)) )
+        return false;
+    data += cwd; data += '\0';
+    data += m_compiler_path.str(); data += '\0';
+    for(const auto& a : args.get_vec()) {
+        data += a; data += '\0';
+    }
+    // The server replaces the compiler's environment with this one, so send all of it (with `env` overriding it)
+    uint32_t envc = 0;
+    extern char **environ;
+    for(auto p = environ; *p; p++) {
+        data += *p; data += '\0';
+        envc ++;
+    }
+    for(auto kv : env) {
+        data += ::format(kv.first, "=", kv.second); data += '\0';
+        envc ++;
+    }
+    uint32_t    hdr[3] = { static_cast<uint32_t>(args.get_vec().size() + 1), envc, static_cast<uint32_t>(data.size()) };
+
+    Debug_Print([&](auto& os){
+        os << "Calling (server)";
+        for(const auto& p : args.get_vec())
+            os << " " << p;
+        });
+    mkdir(static_cast<::std::string>(logfile.parent()).c_str(), 0755);
+    int fds[2] = { open(logfile.str().c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0644), 2 };
+    if( fds[0] < 0 ) {
+        perror("open");
+        return false;
+    }
+
+    struct sockaddr_un  addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, m_opts.compile_server.str().c_str(), sizeof(addr.sun_path) - 1);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( sock < 0 || connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ) {
+        perror("Connecting to compile server");
+        close(fds[0]);
+        if( sock >= 0 )
+            close(sock);
+        return false;
+    }
+
+    struct iovec    iov = { hdr, sizeof(hdr) };
+    char    cmsg_buf[CMSG_SPACE(sizeof(fds))] = {};
+    struct msghdr   msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg_buf;
+    msg.msg_controllen = sizeof(cmsg_buf);
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    int32_t status = -1;
+    bool ok = sendmsg(sock, &msg, 0) == sizeof(hdr)
+        && write(sock, data.data(), data.size()) == static_cast<ssize_t>(data.size())
+        && recv(sock, &status, sizeof(status), MSG_WAITALL) == sizeof(status);
+    close(sock);
+    close(fds[0]);
+    if( !ok ) {
+        DEBUG("Lost connection to the compile server");
+        return false;
+    }
+    if( out_exit_code )
+        *out_exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    if( status != 0 )
+    {
+        if( WIFEXITED(status) )
+            DEBUG("Compiler exited with non-zero exit status " << WEXITSTATUS(status));
+        else if( WIFSIGNALED(status) )
+            DEBUG("Compiler was terminated with signal " << WTERMSIG(status));
+        else
+            DEBUG("Compiler terminated for unknown reason, status=" << status);
+        DEBUG("See " << logfile << " for the compiler output");
+        return false;
+    }
+    return true;
+#endif
 }
-bool Builder::spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile) const
+bool Builder::spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, int* out_exit_code) const
 {
 #ifdef _WIN32
     ::std::stringstream cmdline;
@@ -1051,6 +1198,8 @@ bool Builder::spawn_process(const char* exe_name, const StringList& args, const
     WaitForSingleObject(pi.hProcess, INFINITE);
     DWORD status = 1;
     GetExitCodeProcess(pi.hProcess, &status);
+    if( out_exit_code )
+        *out_exit_code = static_cast<int>(status);
     if (status != 0)
     {
         DEBUG("Compiler exited with non-zero exit status " << status);
@@ -1110,6 +1259,8 @@ bool Builder::spawn_process(const char* exe_name, const StringList& args, const
     posix_spawn_file_actions_destroy(&fa);
     int status = -1;
     waitpid(pid, &status, 0);
+    if( out_exit_code )
+        *out_exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
     if( status != 0 )
     {
         if( WIFEXITED(status) )
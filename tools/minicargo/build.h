@@ -12,6 +12,11 @@ struct BuildOptions
     ::helpers::path output_dir;
     ::helpers::path build_script_overrides;
     ::std::vector<::helpers::path>  lib_search_dirs;
+    /// Run build scripts with mrustc's MIR interpreter (instead of compiling them)
+    /// - Libraries are built with `-Z save-all-mir` so the interpreter can call into them
+    bool interpret_build_scripts = false;
+    /// Socket of a running `mrustc --server` to send compilations to (instead of spawning the compiler)
+    ::helpers::path compile_server;
 };
 
 class Builder
@@ -27,9 +32,14 @@ public:
     ::std::string build_build_script(const PackageManifest& manifest) const;
 
 private:
+    /// Compiler arguments for the package's build script (excluding the output)
+    StringList get_build_script_args(const PackageManifest& manifest) const;
     ::helpers::path get_crate_path(const PackageManifest& manifest, const PackageTarget& target, const char** crate_type, ::std::string* out_crate_suffix) const;
-    bool spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile) const;
-    bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile) const;
+    /// Run a process with stdout going to `logfile`, returns true if it succeeded
+    /// - `out_exit_code` is set to the exit code (or -1 if the process didn't exit normally)
+    bool spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile, int* out_exit_code=nullptr) const;
+    bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, int* out_exit_code=nullptr) const;
+    bool send_to_compile_server(const StringList& args, const StringListKV& env, const ::helpers::path& logfile, int* out_exit_code) const;
 
 
     Timestamp get_timestamp(const ::helpers::path& path) const;
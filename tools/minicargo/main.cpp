@@ -35,6 +35,12 @@ struct ProgramOptions
 
     bool pause_before_quit = false;
 
+    // Run build scripts with the compiler's interpreter instead of building them
+    bool interpret_build_scripts = false;
+
+    // Socket of a running compile server (`mrustc --server <socket>`)
+    const char* compile_server = nullptr;
+
     int parse(int argc, const char* argv[]);
     void usage() const;
     void help() const;
@@ -78,6 +84,9 @@ int main(int argc, const char* argv[])
         // TODO: Split creating the build list away from actually running it
         BuildOptions    build_opts;
         build_opts.build_script_overrides = ::std::move(bs_override_dir);
+        build_opts.interpret_build_scripts = opts.interpret_build_scripts;
+        if( opts.compile_server )
+            build_opts.compile_server = ::helpers::path(opts.compile_server);
         build_opts.output_dir = opts.output_directory ? ::helpers::path(opts.output_directory) : ::helpers::path("output");
         build_opts.lib_search_dirs.reserve(opts.lib_search_dirs.size());
         for(const auto* d : opts.lib_search_dirs)
@@ -189,6 +198,16 @@ int ProgramOptions::parse(int argc, const char* argv[])
                 }
                 this->vendor_dir = argv[++i];
             }
+            else if( ::std::strcmp(arg, "--compile-server") == 0 ) {
+                if(i+1 == argc) {
+                    ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
+                    return 1;
+                }
+                this->compile_server = argv[++i];
+            }
+            else if( ::std::strcmp(arg, "--interpret-build-scripts") == 0 ) {
+                this->interpret_build_scripts = true;
+            }
             else if( ::std::strcmp(arg, "--output-dir") == 0 ) {
                 if(i+1 == argc) {
                     ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
@@ -230,6 +249,8 @@ void ProgramOptions::help() const
         << "--script-overrides <dir> : Directory containing <package>.txt files containing the build script output\n"
         << "--vendor-dir <dir>       : Directory containing vendored packages (from `cargo vendor`)\n"
         << "--output-dir,-o <dir>    : Specify the compiler output directory\n"
+        << "--interpret-build-scripts : Run build scripts with mrustc's MIR interpreter instead of compiling them\n"
+        << "--compile-server <socket> : Send compilations to a running `mrustc --server <socket>`\n"
         << "-L <dir>                 : Search for pre-built crates (e.g. libstd) in the specified directory\n"
         << "-j <count>               : Run at most <count> build tasks at once (default is to run only one)\n"
         << "-n                       : Don't build any packages, just list the packages that would be built\n"